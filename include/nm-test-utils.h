@@ -719,6 +719,47 @@ nmtst_rand_perm (GRand *rand, void *dst, const void *src, gsize elmt_size, gsize
 	return dst;
 }
 
+#ifdef __NETWORKMANAGER_UTILS_H__
+/* Timing for the bench-* programs. Each measurement is printed as one line,
+ * so that the output of the different benchmarks lines up. */
+
+typedef struct {
+	const char *name;
+	const char *per;
+	guint n;
+	gint64 start_ns;
+} NMTstBench;
+
+inline static void
+nmtst_bench_print (const char *name, double value, const char *unit)
+{
+	g_print ("  %-36s %10.1f%s%s\n", name, value, unit ? " " : "", unit ? unit : "");
+}
+
+/* @n: the number of operations the measured time is split over
+ * @per: what one operation is, for the printed "ns/@per" unit */
+inline static void
+nmtst_bench_start (NMTstBench *b, const char *name, guint n, const char *per)
+{
+	g_assert (b);
+	g_assert (n > 0);
+
+	b->name = name;
+	b->per = per;
+	b->n = n;
+	b->start_ns = nm_utils_get_monotonic_timestamp_ns ();
+}
+
+inline static void
+nmtst_bench_stop (NMTstBench *b)
+{
+	gint64 elapsed = nm_utils_get_monotonic_timestamp_ns () - b->start_ns;
+	char unit[64];
+
+	nmtst_bench_print (b->name, (double) elapsed / b->n, nm_sprintf_buf (unit, "ns/%s", b->per));
+}
+#endif
+
 inline static const char *
 nmtst_get_sudo_cmd (void)
 {
@@ -3065,14 +3065,16 @@ _get_property_path (const char *ifname,
 	int len;
 
 	ifname = ASSERT_VALID_PATH_COMPONENT (ifname);
-	property = ASSERT_VALID_PATH_COMPONENT (property);
+	if (property)
+		property = ASSERT_VALID_PATH_COMPONENT (property);
 
 	len = g_snprintf (path,
 	                  sizeof (path),
-	                  "%s%s/%s",
+	                  "%s%s%s%s",
 	                  ipv6 ? IPV6_PROPERTY_DIR : IPV4_PROPERTY_DIR,
 	                  ifname,
-	                  property);
+	                  property ? "/" : "",
+	                  property ? property : "");
 	g_assert (len < sizeof (path) - 1);
 
 	return path;
@@ -3092,6 +3094,19 @@ nm_utils_ip6_property_path (const char *ifname, const char *property)
 	return _get_property_path (ifname, property, TRUE);
 }
 
+/**
+ * nm_utils_ip6_property_dir:
+ * @ifname: an interface name
+ *
+ * Returns the path to the directory of the IPv6 properties of @ifname.
+ * Note that this uses the same static buffer as nm_utils_ip6_property_path().
+ */
+const char *
+nm_utils_ip6_property_dir (const char *ifname)
+{
+	return _get_property_path (ifname, NULL, TRUE);
+}
+
 /**
  * nm_utils_ip4_property_path:
  * @ifname: an interface name
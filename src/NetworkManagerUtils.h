@@ -253,6 +253,7 @@ gint64 nm_utils_monotonic_timestamp_as_boottime (gint64 timestamp, gint64 timest
 gboolean    nm_utils_is_valid_path_component (const char *name);
 const char *ASSERT_VALID_PATH_COMPONENT (const char *name);
 const char *nm_utils_ip6_property_path (const char *ifname, const char *property);
+const char *nm_utils_ip6_property_dir (const char *ifname);
 const char *nm_utils_ip4_property_path (const char *ifname, const char *property);
 
 gboolean nm_utils_is_specific_hostname (const char *name);
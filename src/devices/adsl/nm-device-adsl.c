@@ -591,6 +591,7 @@ nm_device_adsl_init (NMDeviceAdsl *self)
 static void
 nm_device_adsl_class_init (NMDeviceAdslClass *klass)
 {
+	static const char *const connection_types[] = { NM_SETTING_ADSL_SETTING_NAME, NULL };
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMDeviceClass *parent_class = NM_DEVICE_CLASS (klass);
 
@@ -602,6 +603,7 @@ nm_device_adsl_class_init (NMDeviceAdslClass *klass)
 	parent_class->get_generic_capabilities = get_generic_capabilities;
 
 	parent_class->check_connection_compatible = check_connection_compatible;
+	parent_class->compatible_connection_types = connection_types;
 	parent_class->complete_connection = complete_connection;
 
 	parent_class->act_stage2_config = act_stage2_config;
@@ -1137,6 +1137,7 @@ finalize (GObject *object)
 static void
 nm_device_bt_class_init (NMDeviceBtClass *klass)
 {
+	static const char *const connection_types[] = { NM_SETTING_BLUETOOTH_SETTING_NAME, NULL };
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMDeviceClass *device_class = NM_DEVICE_CLASS (klass);
 
@@ -1155,6 +1156,7 @@ nm_device_bt_class_init (NMDeviceBtClass *klass)
 	device_class->act_stage3_ip4_config_start = act_stage3_ip4_config_start;
 	device_class->act_stage3_ip6_config_start = act_stage3_ip6_config_start;
 	device_class->check_connection_compatible = check_connection_compatible;
+	device_class->compatible_connection_types = connection_types;
 	device_class->check_connection_available = check_connection_available;
 	device_class->complete_connection = complete_connection;
 	device_class->is_available = is_available;
@@ -524,6 +524,7 @@ set_property (GObject *object, guint prop_id,
 static void
 nm_device_bond_class_init (NMDeviceBondClass *klass)
 {
+	static const char *const connection_types[] = { NM_SETTING_BOND_SETTING_NAME, NULL };
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMDeviceClass *parent_class = NM_DEVICE_CLASS (klass);
 
@@ -538,6 +539,7 @@ nm_device_bond_class_init (NMDeviceBondClass *klass)
 	parent_class->get_generic_capabilities = get_generic_capabilities;
 	parent_class->is_available = is_available;
 	parent_class->check_connection_compatible = check_connection_compatible;
+	parent_class->compatible_connection_types = connection_types;
 	parent_class->check_connection_available = check_connection_available;
 	parent_class->complete_connection = complete_connection;
 
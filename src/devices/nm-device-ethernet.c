@@ -1701,6 +1701,7 @@ set_property (GObject *object, guint prop_id,
 static void
 nm_device_ethernet_class_init (NMDeviceEthernetClass *klass)
 {
+	static const char *const connection_types[] = { NM_SETTING_WIRED_SETTING_NAME, NM_SETTING_PPPOE_SETTING_NAME, NULL };
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMDeviceClass *parent_class = NM_DEVICE_CLASS (klass);
 
@@ -1718,6 +1719,8 @@ nm_device_ethernet_class_init (NMDeviceEthernetClass *klass)
 	parent_class->get_generic_capabilities = get_generic_capabilities;
 	parent_class->setup = setup;
 	parent_class->check_connection_compatible = check_connection_compatible;
+	parent_class->compatible_connection_types = connection_types;
+	parent_class->compatible_match_perm_hw_address = TRUE;
 	parent_class->complete_connection = complete_connection;
 	parent_class->new_default_connection = new_default_connection;
 
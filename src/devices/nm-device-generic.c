@@ -191,6 +191,7 @@ set_property (GObject *object, guint prop_id,
 static void
 nm_device_generic_class_init (NMDeviceGenericClass *klass)
 {
+	static const char *const connection_types[] = { NM_SETTING_GENERIC_SETTING_NAME, NULL };
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMDeviceClass *parent_class = NM_DEVICE_CLASS (klass);
 
@@ -207,6 +208,7 @@ nm_device_generic_class_init (NMDeviceGenericClass *klass)
 	parent_class->get_generic_capabilities = get_generic_capabilities;
 	parent_class->get_type_description = get_type_description;
 	parent_class->check_connection_compatible = check_connection_compatible;
+	parent_class->compatible_connection_types = connection_types;
 	parent_class->update_connection = update_connection;
 
 	/* properties */
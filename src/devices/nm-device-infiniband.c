@@ -322,6 +322,7 @@ set_property (GObject *object, guint prop_id,
 static void
 nm_device_infiniband_class_init (NMDeviceInfinibandClass *klass)
 {
+	static const char *const connection_types[] = { NM_SETTING_INFINIBAND_SETTING_NAME, NULL };
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMDeviceClass *parent_class = NM_DEVICE_CLASS (klass);
 
@@ -334,6 +335,7 @@ nm_device_infiniband_class_init (NMDeviceInfinibandClass *klass)
 	parent_class->create_and_realize = create_and_realize;
 	parent_class->get_generic_capabilities = get_generic_capabilities;
 	parent_class->check_connection_compatible = check_connection_compatible;
+	parent_class->compatible_connection_types = connection_types;
 	parent_class->complete_connection = complete_connection;
 	parent_class->update_connection = update_connection;
 
@@ -521,6 +521,12 @@ nm_device_ipv6_sysctl_set (NMDevice *self, const char *property, const char *val
 	return nm_platform_sysctl_set (NM_PLATFORM_GET, nm_utils_ip6_property_path (nm_device_get_ip_iface (self), property), value);
 }
 
+static gboolean
+nm_device_ipv6_sysctl_set_multiple (NMDevice *self, const char *const *keys_values)
+{
+	return nm_platform_sysctl_set_multiple (NM_PLATFORM_GET, nm_utils_ip6_property_dir (nm_device_get_ip_iface (self)), keys_values);
+}
+
 static guint32
 nm_device_ipv6_sysctl_get_int32 (NMDevice *self, const char *property, gint32 fallback)
 {
@@ -2656,6 +2662,40 @@ nm_device_check_connection_compatible (NMDevice *self, NMConnection *connection)
 	return NM_DEVICE_GET_CLASS (self)->check_connection_compatible (self, connection);
 }
 
+/**
+ * nm_device_get_compatible_connection_types:
+ * @self: an #NMDevice
+ *
+ * Returns: the %NULL terminated list of connection types that can be
+ *   compatible with @self, or %NULL if @self doesn't restrict the type.
+ *   See nm_device_check_connection_compatible().
+ */
+const char *const *
+nm_device_get_compatible_connection_types (NMDevice *self)
+{
+	g_return_val_if_fail (NM_IS_DEVICE (self), NULL);
+
+	return NM_DEVICE_GET_CLASS (self)->compatible_connection_types;
+}
+
+/**
+ * nm_device_get_compatible_hw_address:
+ * @self: an #NMDevice
+ *
+ * Returns: the address that the MAC address of a wired or wireless
+ *   connection must match for the connection to be compatible with
+ *   @self, or %NULL if @self doesn't check it.
+ */
+const char *
+nm_device_get_compatible_hw_address (NMDevice *self)
+{
+	g_return_val_if_fail (NM_IS_DEVICE (self), NULL);
+
+	if (!NM_DEVICE_GET_CLASS (self)->compatible_match_perm_hw_address)
+		return NULL;
+	return NM_DEVICE_GET_PRIVATE (self)->perm_hw_addr;
+}
+
 /**
  * nm_device_can_assume_connections:
  * @self: #NMDevice instance
@@ -3465,12 +3505,12 @@ _device_get_default_route_from_platform (NMDevice *self, int addr_family, NMPlat
 {
 	gboolean success = FALSE;
 	int ifindex = nm_device_get_ip_ifindex (self);
-	GArray *routes;
+	GPtrArray *routes;
 
 	if (addr_family == AF_INET)
-		routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+		routes = nm_platform_ip4_route_lookup_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
 	else
-		routes = nm_platform_ip6_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+		routes = nm_platform_ip6_route_lookup_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
 
 	if (routes) {
 		guint route_metric = G_MAXUINT32, m;
@@ -3479,13 +3519,11 @@ _device_get_default_route_from_platform (NMDevice *self, int addr_family, NMPlat
 
 		/* if there are several default routes, find the one with the best metric */
 		for (i = 0; i < routes->len; i++) {
-			if (addr_family == AF_INET) {
-				r = (const NMPlatformIPRoute *) &g_array_index (routes, NMPlatformIP4Route, i);
+			r = routes->pdata[i];
+			if (addr_family == AF_INET)
 				m = r->metric;
-			} else {
-				r = (const NMPlatformIPRoute *) &g_array_index (routes, NMPlatformIP6Route, i);
+			else
 				m = nm_utils_ip6_route_metric_normalize (r->metric);
-			}
 			if (!route || m < route_metric) {
 				route = r;
 				route_metric = m;
@@ -3499,7 +3537,7 @@ _device_get_default_route_from_platform (NMDevice *self, int addr_family, NMPlat
 				*((NMPlatformIP6Route *) out_route) = *((NMPlatformIP6Route *) route);
 			success = TRUE;
 		}
-		g_array_free (routes, TRUE);
+		g_ptr_array_unref (routes);
 	}
 	return success;
 }
@@ -3928,6 +3966,17 @@ dhcp4_get_timeout (NMDevice *self, NMSettingIP4Config *s_ip4)
 	return priv->dhcp_timeout;
 }
 
+static gboolean
+dhcp4_get_rapid_commit (NMDevice *self)
+{
+	gs_free char *value = NULL;
+
+	value = nm_config_data_get_connection_default (NM_CONFIG_GET_DATA,
+	                                               "ipv4.dhcp-rapid-commit",
+	                                               self);
+	return _nm_utils_ascii_str_to_int64 (value, 10, 0, 1, 0);
+}
+
 static NMActStageReturn
 dhcp4_start (NMDevice *self,
              NMConnection *connection,
@@ -3964,6 +4013,7 @@ dhcp4_start (NMDevice *self,
 	                                                nm_setting_ip4_config_get_dhcp_fqdn (NM_SETTING_IP4_CONFIG (s_ip4)),
 	                                                nm_setting_ip4_config_get_dhcp_client_id (NM_SETTING_IP4_CONFIG (s_ip4)),
 	                                                dhcp4_get_timeout (self, NM_SETTING_IP4_CONFIG (s_ip4)),
+	                                                dhcp4_get_rapid_commit (self),
 	                                                priv->dhcp_anycast_address,
 	                                                NULL);
 
@@ -5212,10 +5262,13 @@ addrconf6_start_with_link_ready (NMDevice *self)
 	if (!ip6_config_merge_and_apply (self, TRUE, NULL))
 		_LOGW (LOGD_IP6, "failed to apply manual IPv6 configuration");
 
-	nm_device_ipv6_sysctl_set (self, "accept_ra", "1");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_defrtr", "0");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_pinfo", "0");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_rtr_pref", "0");
+	nm_device_ipv6_sysctl_set_multiple (self, (const char *const []) {
+	                                        "accept_ra", "1",
+	                                        "accept_ra_defrtr", "0",
+	                                        "accept_ra_pinfo", "0",
+	                                        "accept_ra_rtr_pref", "0",
+	                                        NULL,
+	                                    });
 
 	priv->rdisc_changed_id = g_signal_connect (priv->rdisc,
 	                                           NM_RDISC_CONFIG_CHANGED,
@@ -8781,8 +8834,11 @@ nm_device_cleanup (NMDevice *self, NMDeviceStateReason reason, CleanupType clean
 	/* Turn off kernel IPv6 */
 	if (cleanup_type == CLEANUP_TYPE_DECONFIGURE) {
 		set_disable_ipv6 (self, "1");
-		nm_device_ipv6_sysctl_set (self, "accept_ra", "0");
-		nm_device_ipv6_sysctl_set (self, "use_tempaddr", "0");
+		nm_device_ipv6_sysctl_set_multiple (self, (const char *const []) {
+		                                        "accept_ra", "0",
+		                                        "use_tempaddr", "0",
+		                                        NULL,
+		                                    });
 	}
 
 	/* Call device type-specific deactivation */
@@ -9018,10 +9074,13 @@ ip6_managed_setup (NMDevice *self)
 {
 	set_nm_ipv6ll (self, TRUE);
 	set_disable_ipv6 (self, "1");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_defrtr", "0");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_pinfo", "0");
-	nm_device_ipv6_sysctl_set (self, "accept_ra_rtr_pref", "0");
-	nm_device_ipv6_sysctl_set (self, "use_tempaddr", "0");
+	nm_device_ipv6_sysctl_set_multiple (self, (const char *const []) {
+	                                        "accept_ra_defrtr", "0",
+	                                        "accept_ra_pinfo", "0",
+	                                        "accept_ra_rtr_pref", "0",
+	                                        "use_tempaddr", "0",
+	                                        NULL,
+	                                    });
 }
 
 static void
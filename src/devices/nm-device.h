@@ -123,6 +123,15 @@ typedef struct {
 
 	const char *connection_type;
 
+	/* If check_connection_compatible() only accepts a fixed set of
+	 * connection types, the %NULL terminated list of them. Used to
+	 * prefilter autoconnect candidates; %NULL means any type. */
+	const char *const *compatible_connection_types;
+
+	/* Whether check_connection_compatible() rejects connections whose
+	 * wired or wireless MAC address differs from the permanent address. */
+	gboolean compatible_match_perm_hw_address;
+
 	void (*state_changed) (NMDevice *device,
 	                       NMDeviceState new_state,
 	                       NMDeviceState old_state,
@@ -392,6 +401,9 @@ gboolean nm_device_complete_connection (NMDevice *device,
 
 gboolean nm_device_check_connection_compatible (NMDevice *device, NMConnection *connection);
 
+const char *const *nm_device_get_compatible_connection_types (NMDevice *device);
+const char *nm_device_get_compatible_hw_address (NMDevice *device);
+
 gboolean nm_device_uses_assumed_connection (NMDevice *device);
 
 gboolean nm_device_can_assume_active_connection (NMDevice *device);
@@ -797,6 +797,7 @@ dispose (GObject *object)
 static void
 nm_device_team_class_init (NMDeviceTeamClass *klass)
 {
+	static const char *const connection_types[] = { NM_SETTING_TEAM_SETTING_NAME, NULL };
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMDeviceClass *parent_class = NM_DEVICE_CLASS (klass);
 
@@ -814,6 +815,7 @@ nm_device_team_class_init (NMDeviceTeamClass *klass)
 	parent_class->get_generic_capabilities = get_generic_capabilities;
 	parent_class->is_available = is_available;
 	parent_class->check_connection_compatible = check_connection_compatible;
+	parent_class->compatible_connection_types = connection_types;
 	parent_class->check_connection_available = check_connection_available;
 	parent_class->complete_connection = complete_connection;
 	parent_class->update_connection = update_connection;
@@ -2995,6 +2995,7 @@ set_property (GObject *object, guint prop_id,
 static void
 nm_device_wifi_class_init (NMDeviceWifiClass *klass)
 {
+	static const char *const connection_types[] = { NM_SETTING_WIRELESS_SETTING_NAME, NULL };
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMDeviceClass *parent_class = NM_DEVICE_CLASS (klass);
 
@@ -3011,6 +3012,8 @@ nm_device_wifi_class_init (NMDeviceWifiClass *klass)
 	parent_class->can_auto_connect = can_auto_connect;
 	parent_class->is_available = is_available;
 	parent_class->check_connection_compatible = check_connection_compatible;
+	parent_class->compatible_connection_types = connection_types;
+	parent_class->compatible_match_perm_hw_address = TRUE;
 	parent_class->check_connection_available = check_connection_available;
 	parent_class->complete_connection = complete_connection;
 	parent_class->set_enabled = set_enabled;
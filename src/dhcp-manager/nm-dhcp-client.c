@@ -44,6 +44,7 @@ typedef struct {
 	char *       uuid;
 	guint32      priority;
 	guint32      timeout;
+	gboolean     rapid_commit;
 	GByteArray * duid;
 	GBytes *     client_id;
 	char *       hostname;
@@ -77,6 +78,7 @@ enum {
 	PROP_UUID,
 	PROP_PRIORITY,
 	PROP_TIMEOUT,
+	PROP_RAPID_COMMIT,
 	LAST_PROP
 };
 
@@ -185,6 +187,14 @@ nm_dhcp_client_get_fqdn (NMDhcpClient *self)
 	return NM_DHCP_CLIENT_GET_PRIVATE (self)->fqdn;
 }
 
+gboolean
+nm_dhcp_client_get_rapid_commit (NMDhcpClient *self)
+{
+	g_return_val_if_fail (NM_IS_DHCP_CLIENT (self), FALSE);
+
+	return NM_DHCP_CLIENT_GET_PRIVATE (self)->rapid_commit;
+}
+
 /********************************************/
 
 static const char *state_table[NM_DHCP_STATE_MAX + 1] = {
@@ -864,6 +874,9 @@ get_property (GObject *object, guint prop_id,
 	case PROP_TIMEOUT:
 		g_value_set_uint (value, priv->timeout);
 		break;
+	case PROP_RAPID_COMMIT:
+		g_value_set_boolean (value, priv->rapid_commit);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -905,6 +918,10 @@ set_property (GObject *object, guint prop_id,
 	case PROP_TIMEOUT:
 		priv->timeout = g_value_get_uint (value);
 		break;
+	case PROP_RAPID_COMMIT:
+		/* construct-only */
+		priv->rapid_commit = g_value_get_boolean (value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -1005,6 +1022,13 @@ nm_dhcp_client_class_init (NMDhcpClientClass *client_class)
 		                    G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
 		                    G_PARAM_STATIC_STRINGS));
 
+	g_object_class_install_property
+		(object_class, PROP_RAPID_COMMIT,
+		 g_param_spec_boolean (NM_DHCP_CLIENT_RAPID_COMMIT, "", "",
+		                       FALSE,
+		                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+		                       G_PARAM_STATIC_STRINGS));
+
 	/* signals */
 	signals[SIGNAL_STATE_CHANGED] =
 		g_signal_new (NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED,
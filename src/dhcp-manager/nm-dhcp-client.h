@@ -40,6 +40,7 @@
 #define NM_DHCP_CLIENT_UUID      "uuid"
 #define NM_DHCP_CLIENT_PRIORITY  "priority"
 #define NM_DHCP_CLIENT_TIMEOUT   "timeout"
+#define NM_DHCP_CLIENT_RAPID_COMMIT "rapid-commit"
 
 #define NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED "state-changed"
 
@@ -133,6 +134,8 @@ const char *nm_dhcp_client_get_hostname (NMDhcpClient *self);
 
 const char *nm_dhcp_client_get_fqdn (NMDhcpClient *self);
 
+gboolean nm_dhcp_client_get_rapid_commit (NMDhcpClient *self);
+
 gboolean nm_dhcp_client_start_ip4 (NMDhcpClient *self,
                                    const char *dhcp_client_id,
                                    const char *dhcp_anycast_addr,
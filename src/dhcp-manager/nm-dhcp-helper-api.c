@@ -0,0 +1,111 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "nm-default.h"
+#include "nm-dhcp-helper-api.h"
+
+static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
+
+gboolean
+nm_dhcp_helper_is_dhcp_variable (const char *item)
+{
+	const char *val, **p;
+
+	val = strchr (item, '=');
+	if (!val || val == item)
+		return FALSE;
+
+	/* Ignore non-DCHP-related environment variables */
+	for (p = ignore; *p; p++) {
+		if (strncmp (item, *p, strlen (*p)) == 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * nm_dhcp_helper_event_message_build:
+ * @env: a %NULL terminated environment, like environ
+ *
+ * Returns: the message for the event socket with the DHCP variables
+ * of @env, or %NULL if it would exceed %NM_DHCP_HELPER_EVENT_MAX_SIZE.
+ * Free it with g_string_free().
+ */
+GString *
+nm_dhcp_helper_event_message_build (char **env)
+{
+	GString *msg;
+	char **item;
+
+	msg = g_string_sized_new (4096);
+	for (item = env; *item; item++) {
+		if (nm_dhcp_helper_is_dhcp_variable (*item))
+			g_string_append_len (msg, *item, strlen (*item) + 1);
+	}
+
+	if (msg->len > NM_DHCP_HELPER_EVENT_MAX_SIZE) {
+		g_string_free (msg, TRUE);
+		return NULL;
+	}
+	return msg;
+}
+
+/**
+ * nm_dhcp_helper_event_message_parse:
+ * @buf: a message from the event socket
+ * @len: the length of @buf
+ *
+ * Parses @buf into the same a{sv} of byte arrays that nm-dhcp-helper
+ * sends over D-Bus. Entries without a name and a trailing entry without
+ * its terminating NUL are skipped.
+ *
+ * Returns: (transfer full): the options
+ */
+GVariant *
+nm_dhcp_helper_event_message_parse (const char *buf, gsize len)
+{
+	GVariantBuilder builder;
+	const char *item, *end, *val;
+	char *name;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+	for (item = buf; item < buf + len; item = end + 1) {
+		end = memchr (item, '\0', buf + len - item);
+		if (!end)
+			break;
+
+		val = memchr (item, '=', end - item);
+		if (!val || val == item)
+			continue;
+
+		name = g_strndup (item, val - item);
+		val++;
+		g_variant_builder_add (&builder, "{sv}",
+		                       name,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  val, end - val, 1));
+		g_free (name);
+	}
+
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
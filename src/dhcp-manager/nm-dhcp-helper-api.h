@@ -0,0 +1,44 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifndef __NM_DHCP_HELPER_API_H__
+#define __NM_DHCP_HELPER_API_H__
+
+/* Shared between NMDhcpListener and nm-dhcp-helper. */
+
+#define NM_DHCP_CLIENT_DBUS_IFACE        "org.freedesktop.nm_dhcp_client"
+
+/* Private D-Bus socket; events are "Event" signals with an a{sv} of
+ * byte array values. */
+#define NM_DHCP_HELPER_DBUS_SOCKET_PATH  NMRUNDIR "/private-dhcp"
+
+/* SOCK_SEQPACKET socket taking one event per message. A message is a
+ * sequence of "NAME=VALUE" entries, each terminated by a NUL byte, as in
+ * the environment of the DHCP client script. A connection may be kept
+ * open to send any number of events. */
+#define NM_DHCP_HELPER_EVENT_SOCKET_PATH NMRUNDIR "/private-dhcp-events"
+
+#define NM_DHCP_HELPER_EVENT_MAX_SIZE    65536
+
+gboolean nm_dhcp_helper_is_dhcp_variable (const char *item);
+
+GString *nm_dhcp_helper_event_message_build (char **env);
+
+GVariant *nm_dhcp_helper_event_message_parse (const char *buf, gsize len);
+
+#endif /* __NM_DHCP_HELPER_API_H__ */
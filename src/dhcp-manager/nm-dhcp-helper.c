@@ -24,12 +24,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "nm-default.h"
-
-#define NM_DHCP_CLIENT_DBUS_IFACE   "org.freedesktop.nm_dhcp_client"
-
-static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
+#include "nm-dhcp-helper-api.h"
 
 static GVariant *
 build_signal_parameters (void)
@@ -41,21 +41,16 @@ build_signal_parameters (void)
 
 	/* List environment and format for dbus dict */
 	for (item = environ; *item; item++) {
-		char *name, *val, **p;
+		char *name, *val;
+
+		if (!nm_dhcp_helper_is_dhcp_variable (*item))
+			continue;
 
 		/* Split on the = */
 		name = g_strdup (*item);
 		val = strchr (name, '=');
-		if (!val || val == name)
-			goto next;
 		*val++ = '\0';
 
-		/* Ignore non-DCHP-related environment variables */
-		for (p = (char **) ignore; *p; p++) {
-			if (strncmp (name, *p, strlen (*p)) == 0)
-				goto next;
-		}
-
 		/* Value passed as a byte array rather than a string, because there are
 		 * no character encoding guarantees with DHCP, and D-Bus requires
 		 * strings to be UTF-8.
@@ -67,14 +62,48 @@ build_signal_parameters (void)
 		                       name,
 		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
 		                                                  val, strlen (val), 1));
-
-	next:
 		g_free (name);
 	}
 
 	return g_variant_new ("(a{sv})", &builder);
 }
 
+/* Send the event as a single message on the event socket. That avoids
+ * setting up a D-Bus connection, which needs several round trips for
+ * authentication, for every event. Returns FALSE if NetworkManager
+ * does not provide the socket. */
+static gboolean
+send_event_message (void)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	GString *msg;
+	ssize_t n;
+	int fd;
+
+	msg = nm_dhcp_helper_event_message_build (environ);
+	if (!msg)
+		return FALSE;
+
+	fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		g_string_free (msg, TRUE);
+		return FALSE;
+	}
+
+	g_strlcpy (addr.sun_path, NM_DHCP_HELPER_EVENT_SOCKET_PATH, sizeof (addr.sun_path));
+	if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0)
+		n = -1;
+	else {
+		do {
+			n = send (fd, msg->str, msg->len, MSG_NOSIGNAL);
+		} while (n < 0 && errno == EINTR);
+	}
+
+	close (fd);
+	g_string_free (msg, TRUE);
+	return n >= 0;
+}
+
 static void
 fatal_error (void)
 {
@@ -97,9 +126,12 @@ main (int argc, char *argv[])
 	GDBusConnection *connection;
 	GError *error = NULL;
 
+	if (send_event_message ())
+		return 0;
+
 	nm_g_type_init ();
 
-	connection = g_dbus_connection_new_for_address_sync ("unix:path=" NMRUNDIR "/private-dhcp",
+	connection = g_dbus_connection_new_for_address_sync ("unix:path=" NM_DHCP_HELPER_DBUS_SOCKET_PATH,
 	                                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
 	                                                     NULL, NULL, &error);
 	if (!connection) {
@@ -20,6 +20,8 @@
 #include "config.h"
 
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <string.h>
@@ -29,21 +31,34 @@
 
 #include "nm-default.h"
 #include "nm-dhcp-listener.h"
+#include "nm-dhcp-helper-api.h"
 #include "nm-core-internal.h"
 #include "nm-bus-manager.h"
 #include "NetworkManagerUtils.h"
 
-#define NM_DHCP_CLIENT_DBUS_IFACE "org.freedesktop.nm_dhcp_client"
-#define PRIV_SOCK_PATH            NMRUNDIR "/private-dhcp"
 #define PRIV_SOCK_TAG             "dhcp"
 
+/* Events read from one connection before returning to the main loop */
+#define EVENT_BATCH               32
+
 typedef struct {
 	NMBusManager *      dbus_mgr;
 	guint               new_conn_id;
 	guint               dis_conn_id;
 	GHashTable *        signal_handlers;
+
+	GIOChannel *        event_channel;
+	guint               event_id;
+	GSList *            event_conns;
+	char *              event_buf;
 } NMDhcpListenerPrivate;
 
+typedef struct {
+	NMDhcpListener *self;
+	GIOChannel *channel;
+	guint watch_id;
+} EventConnection;
+
 #define NM_DHCP_LISTENER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DHCP_LISTENER, NMDhcpListenerPrivate))
 
 G_DEFINE_TYPE (NMDhcpListener, nm_dhcp_listener, G_TYPE_OBJECT)
@@ -89,26 +104,13 @@ get_option (GVariant *options, const char *key)
 }
 
 static void
-handle_event (GDBusConnection  *connection,
-              const char       *sender_name,
-              const char       *object_path,
-              const char       *interface_name,
-              const char       *signal_name,
-              GVariant         *parameters,
-              gpointer          user_data)
+process_event (NMDhcpListener *self, GVariant *options)
 {
-	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
 	char *iface = NULL;
 	char *pid_str = NULL;
 	char *reason = NULL;
 	gint pid;
 	gboolean handled = FALSE;
-	GVariant *options;
-
-	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
-		return;
-
-	g_variant_get (parameters, "(@a{sv})", &options);
 
 	iface = get_option (options, "interface");
 	if (iface == NULL) {
@@ -142,6 +144,25 @@ out:
 	g_free (iface);
 	g_free (pid_str);
 	g_free (reason);
+}
+
+static void
+handle_event (GDBusConnection  *connection,
+              const char       *sender_name,
+              const char       *object_path,
+              const char       *interface_name,
+              const char       *signal_name,
+              GVariant         *parameters,
+              gpointer          user_data)
+{
+	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
+	GVariant *options;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
+		return;
+
+	g_variant_get (parameters, "(@a{sv})", &options);
+	process_event (self, options);
 	g_variant_unref (options);
 }
 
@@ -182,6 +203,129 @@ dis_connection_cb (NMBusManager *mgr,
 
 /***************************************************/
 
+static void
+event_connection_free (EventConnection *conn)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (conn->self);
+
+	priv->event_conns = g_slist_remove (priv->event_conns, conn);
+	nm_clear_g_source (&conn->watch_id);
+	g_io_channel_unref (conn->channel);
+	g_slice_free (EventConnection, conn);
+}
+
+static gboolean
+event_connection_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	EventConnection *conn = user_data;
+	NMDhcpListener *self = conn->self;
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	int fd = g_io_channel_unix_get_fd (channel);
+	GVariant *options;
+	ssize_t len;
+	guint i;
+
+	/* Clients may queue several events on one connection */
+	for (i = 0; i < EVENT_BATCH; i++) {
+		len = recv (fd, priv->event_buf, NM_DHCP_HELPER_EVENT_MAX_SIZE, MSG_DONTWAIT | MSG_TRUNC);
+		if (len < 0) {
+			if (errno == EAGAIN || errno == EINTR)
+				return G_SOURCE_CONTINUE;
+			nm_log_dbg (LOGD_DHCP, "DHCP event: failed to receive: %s", g_strerror (errno));
+			break;
+		}
+		if (len == 0) {
+			/* peer closed the connection */
+			break;
+		}
+		if (len > NM_DHCP_HELPER_EVENT_MAX_SIZE) {
+			nm_log_warn (LOGD_DHCP, "DHCP event: message too large (%zd bytes)", len);
+			continue;
+		}
+
+		options = nm_dhcp_helper_event_message_parse (priv->event_buf, len);
+		process_event (self, options);
+		g_variant_unref (options);
+	}
+
+	if (i < EVENT_BATCH) {
+		conn->watch_id = 0;
+		event_connection_free (conn);
+		return G_SOURCE_REMOVE;
+	}
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+event_listen_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	EventConnection *conn;
+	struct ucred cred;
+	socklen_t cred_len = sizeof (cred);
+	int fd;
+
+	fd = accept4 (g_io_channel_unix_get_fd (channel), NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+	if (fd < 0)
+		return G_SOURCE_CONTINUE;
+
+	/* Only accept events from our own user, like the private D-Bus socket */
+	if (   getsockopt (fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) < 0
+	    || cred.uid != geteuid ()) {
+		nm_log_warn (LOGD_DHCP, "DHCP event: rejected connection from unauthorized peer");
+		close (fd);
+		return G_SOURCE_CONTINUE;
+	}
+
+	conn = g_slice_new0 (EventConnection);
+	conn->self = self;
+	conn->channel = g_io_channel_unix_new (fd);
+	g_io_channel_set_close_on_unref (conn->channel, TRUE);
+	g_io_channel_set_encoding (conn->channel, NULL, NULL);
+	g_io_channel_set_buffered (conn->channel, FALSE);
+	conn->watch_id = g_io_add_watch (conn->channel, G_IO_IN | G_IO_ERR | G_IO_HUP,
+	                                 event_connection_cb, conn);
+	priv->event_conns = g_slist_prepend (priv->event_conns, conn);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+event_socket_setup (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd;
+
+	fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (fd < 0) {
+		nm_log_warn (LOGD_DHCP, "DHCP event: failed to create socket: %s", g_strerror (errno));
+		return;
+	}
+
+	g_strlcpy (addr.sun_path, NM_DHCP_HELPER_EVENT_SOCKET_PATH, sizeof (addr.sun_path));
+	unlink (addr.sun_path);
+
+	if (   bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0
+	    || chmod (addr.sun_path, 0600) < 0
+	    || listen (fd, SOMAXCONN) < 0) {
+		nm_log_warn (LOGD_DHCP, "DHCP event: failed to listen on %s: %s",
+		             addr.sun_path, g_strerror (errno));
+		close (fd);
+		return;
+	}
+
+	priv->event_buf = g_malloc (NM_DHCP_HELPER_EVENT_MAX_SIZE);
+	priv->event_channel = g_io_channel_unix_new (fd);
+	g_io_channel_set_close_on_unref (priv->event_channel, TRUE);
+	g_io_channel_set_encoding (priv->event_channel, NULL, NULL);
+	g_io_channel_set_buffered (priv->event_channel, FALSE);
+	priv->event_id = g_io_add_watch (priv->event_channel, G_IO_IN, event_listen_cb, self);
+}
+
+/***************************************************/
+
 NM_DEFINE_SINGLETON_GETTER (NMDhcpListener, nm_dhcp_listener_get, NM_TYPE_DHCP_LISTENER);
 
 static void
@@ -194,8 +338,9 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 
 	priv->dbus_mgr = nm_bus_manager_get ();
 
-	/* Register the socket our DHCP clients will return lease info on */
-	nm_bus_manager_private_server_register (priv->dbus_mgr, PRIV_SOCK_PATH, PRIV_SOCK_TAG);
+	/* Register the sockets our DHCP clients will return lease info on */
+	event_socket_setup (self);
+	nm_bus_manager_private_server_register (priv->dbus_mgr, NM_DHCP_HELPER_DBUS_SOCKET_PATH, PRIV_SOCK_TAG);
 	priv->new_conn_id = g_signal_connect (priv->dbus_mgr,
 	                                      NM_BUS_MANAGER_PRIVATE_CONNECTION_NEW "::" PRIV_SOCK_TAG,
 	                                      G_CALLBACK (new_connection_cb),
@@ -223,6 +368,15 @@ dispose (GObject *object)
 
 	g_clear_pointer (&priv->signal_handlers, g_hash_table_destroy);
 
+	while (priv->event_conns)
+		event_connection_free (priv->event_conns->data);
+	nm_clear_g_source (&priv->event_id);
+	if (priv->event_channel) {
+		g_clear_pointer (&priv->event_channel, g_io_channel_unref);
+		unlink (NM_DHCP_HELPER_EVENT_SOCKET_PATH);
+	}
+	g_clear_pointer (&priv->event_buf, g_free);
+
 	G_OBJECT_CLASS (nm_dhcp_listener_parent_class)->dispose (object);
 }
 
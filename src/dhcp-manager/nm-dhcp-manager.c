@@ -219,6 +219,7 @@ client_start (NMDhcpManager *self,
               const struct in6_addr *ipv6_ll_addr,
               const char *dhcp_client_id,
               guint32 timeout,
+              gboolean rapid_commit,
               const char *dhcp_anycast_addr,
               const char *hostname,
               const char *fqdn,
@@ -258,6 +259,7 @@ client_start (NMDhcpManager *self,
 	                       NM_DHCP_CLIENT_UUID, uuid,
 	                       NM_DHCP_CLIENT_PRIORITY, priority,
 	                       NM_DHCP_CLIENT_TIMEOUT, timeout ? timeout : DHCP_TIMEOUT,
+	                       NM_DHCP_CLIENT_RAPID_COMMIT, rapid_commit,
 	                       NULL);
 	g_hash_table_insert (NM_DHCP_MANAGER_GET_PRIVATE (self)->clients, client, g_object_ref (client));
 	g_signal_connect (client, NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED, G_CALLBACK (client_state_changed), self);
@@ -297,6 +299,7 @@ nm_dhcp_manager_start_ip4 (NMDhcpManager *self,
                            const char *dhcp_fqdn,
                            const char *dhcp_client_id,
                            guint32 timeout,
+                           gboolean rapid_commit,
                            const char *dhcp_anycast_addr,
                            const char *last_ip_address)
 {
@@ -310,7 +313,7 @@ nm_dhcp_manager_start_ip4 (NMDhcpManager *self,
 		fqdn = dhcp_fqdn;
 	}
 	return client_start (self, iface, ifindex, hwaddr, uuid, priority, FALSE, NULL,
-	                     dhcp_client_id, timeout, dhcp_anycast_addr, hostname,
+	                     dhcp_client_id, timeout, rapid_commit, dhcp_anycast_addr, hostname,
 	                     fqdn, FALSE, 0, last_ip_address);
 }
 
@@ -337,7 +340,7 @@ nm_dhcp_manager_start_ip6 (NMDhcpManager *self,
 	if (send_hostname)
 		hostname = get_send_hostname (self, dhcp_hostname);
 	return client_start (self, iface, ifindex, hwaddr, uuid, priority, TRUE,
-	                     ll_addr, NULL, timeout, dhcp_anycast_addr, hostname, NULL, info_only,
+	                     ll_addr, NULL, timeout, FALSE, dhcp_anycast_addr, hostname, NULL, info_only,
 	                     privacy, NULL);
 }
 
@@ -61,6 +61,7 @@ NMDhcpClient * nm_dhcp_manager_start_ip4     (NMDhcpManager *manager,
                                               const char *dhcp_fqdn,
                                               const char *dhcp_client_id,
                                               guint32 timeout,
+                                              gboolean rapid_commit,
                                               const char *dhcp_anycast_addr,
                                               const char *last_ip_address);
 
@@ -583,6 +583,14 @@ ip4_start (NMDhcpClient *client, const char *dhcp_anycast_addr, const char *last
 		goto error;
 	}
 
+	r = sd_dhcp_client_set_rapid_commit (priv->client4, nm_dhcp_client_get_rapid_commit (client));
+	if (r < 0) {
+		nm_log_warn (LOGD_DHCP4, "(%s): failed to set DHCP rapid commit (%d)", iface, r);
+		goto error;
+	}
+
+	/* With an address to ask for, the client starts in INIT-REBOOT and
+	 * sends a REQUEST right away instead of going through DISCOVER. */
 	dhcp_lease_load (&lease, priv->lease_file);
 
 	if (last_ip4_address)
@@ -0,0 +1,176 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* bench-dhcp-clients.c - Measure the cost of many internal DHCP clients
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+/* Usage: bench-dhcp-clients IFACE [NUM_CLIENTS...]
+ *
+ * For each number of clients (default 10, 100 and 500) starts that many
+ * DHCPv4 clients on the Ethernet interface IFACE, each acting as a separate
+ * interface with its own MAC address, and prints the time to start them,
+ * the file descriptors they hold and the cost of an idle main loop iteration
+ * while they wait for an offer. Use an interface without a DHCP server, like
+ * one created with "ip link add bench0 type dummy". This needs CAP_NET_RAW
+ * for the packet sockets.
+ */
+
+#include "config.h"
+
+#include <net/if.h>
+#include <net/if_arp.h>
+
+#include "nm-default.h"
+#include "NetworkManagerUtils.h"
+
+#include "sd-dhcp-client.h"
+
+#include "nm-test-utils.h"
+
+/* main loop iterations to average over */
+#define NUM_ITERATIONS 10000
+
+/******************************************************************/
+
+static guint
+_count_fds (void)
+{
+	GDir *dir;
+	guint n = 0;
+
+	dir = g_dir_open ("/proc/self/fd", 0, NULL);
+	g_assert (dir);
+	while (g_dir_read_name (dir))
+		n++;
+	g_dir_close (dir);
+	return n;
+}
+
+static sd_dhcp_client *
+_client_start (int ifindex, guint i)
+{
+	sd_dhcp_client *client = NULL;
+	guint8 mac[ETH_ALEN] = { 0x02, 0x00, i >> 24, i >> 16, i >> 8, i };
+	int r;
+
+	r = sd_dhcp_client_new (&client);
+	g_assert_cmpint (r, ==, 0);
+	r = sd_dhcp_client_attach_event (client, NULL, 0);
+	g_assert_cmpint (r, ==, 0);
+	r = sd_dhcp_client_set_index (client, ifindex);
+	g_assert_cmpint (r, ==, 0);
+	r = sd_dhcp_client_set_mac (client, mac, ETH_ALEN, ARPHRD_ETHER);
+	g_assert_cmpint (r, ==, 0);
+
+	r = sd_dhcp_client_start (client);
+	if (r < 0) {
+		g_printerr ("failed to start DHCP client: %s\n", g_strerror (-r));
+		exit (77);
+	}
+	return client;
+}
+
+static void
+bench_clients (int ifindex, guint n)
+{
+	gs_unref_ptrarray GPtrArray *clients = NULL;
+	NMTstBench b;
+	guint fds, i;
+
+	fds = _count_fds ();
+	clients = g_ptr_array_new_full (n, (GDestroyNotify) sd_dhcp_client_unref);
+
+	nmtst_bench_start (&b, "sd_dhcp_client_start()", n, "client");
+	for (i = 0; i < n; i++)
+		g_ptr_array_add (clients, _client_start (ifindex, i));
+	nmtst_bench_stop (&b);
+
+	nmtst_bench_print ("file descriptors", _count_fds () - fds, NULL);
+
+	nmtst_bench_start (&b, "idle main loop iteration", NUM_ITERATIONS, "op");
+	for (i = 0; i < NUM_ITERATIONS; i++)
+		g_main_context_iteration (NULL, FALSE);
+	nmtst_bench_stop (&b);
+
+	nmtst_bench_start (&b, "sd_dhcp_client_stop()", n, "client");
+	for (i = 0; i < n; i++)
+		sd_dhcp_client_stop (clients->pdata[i]);
+	nmtst_bench_stop (&b);
+}
+
+/* The clients send as ARPHRD_ETHER, which the loopback device is not */
+static gboolean
+_iface_is_ethernet (const char *iface)
+{
+	gs_free char *path = NULL;
+	gs_free char *contents = NULL;
+
+	path = g_strdup_printf ("/sys/class/net/%s/type", iface);
+	if (!g_file_get_contents (path, &contents, NULL, NULL))
+		return FALSE;
+	return _nm_utils_ascii_str_to_int64 (g_strstrip (contents), 10, 0, G_MAXINT32, -1) == ARPHRD_ETHER;
+}
+
+/******************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	static const guint default_sizes[] = { 10, 100, 500 };
+	gs_free guint *sizes = NULL;
+	const char *iface;
+	guint n_sizes, i;
+	int ifindex;
+
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	if (argc < 2) {
+		g_printerr ("usage: %s IFACE [NUM_CLIENTS...]\n", argv[0]);
+		return 1;
+	}
+	iface = argv[1];
+
+	if (argc > 2) {
+		n_sizes = argc - 2;
+		sizes = g_new (guint, n_sizes);
+		for (i = 0; i < n_sizes; i++) {
+			sizes[i] = _nm_utils_ascii_str_to_int64 (argv[i + 2], 10, 1, G_MAXINT32, 0);
+			if (!sizes[i]) {
+				g_printerr ("invalid number of clients '%s'\n", argv[i + 2]);
+				return 1;
+			}
+		}
+	} else {
+		n_sizes = G_N_ELEMENTS (default_sizes);
+		sizes = g_memdup (default_sizes, sizeof (default_sizes));
+	}
+
+	ifindex = if_nametoindex (iface);
+	if (ifindex <= 0 || !_iface_is_ethernet (iface)) {
+		g_printerr ("'%s' is not an Ethernet interface\n", iface);
+		return 1;
+	}
+
+	for (i = 0; i < n_sizes; i++) {
+		g_print ("%u DHCP clients:\n", sizes[i]);
+		bench_clients (ifindex, sizes[i]);
+	}
+
+	return 0;
+}
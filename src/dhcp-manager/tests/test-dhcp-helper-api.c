@@ -0,0 +1,167 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "nm-default.h"
+#include "nm-dhcp-helper-api.h"
+
+#include "nm-test-utils.h"
+
+/* Asserts that @options holds @value for @name, compared as bytes */
+static void
+_assert_option (GVariant *options, const char *name, const char *value, gsize value_len)
+{
+	gs_unref_variant GVariant *v = NULL;
+	gconstpointer data;
+	gsize len;
+
+	v = g_variant_lookup_value (options, name, G_VARIANT_TYPE ("ay"));
+	g_assert (v);
+	data = g_variant_get_fixed_array (v, &len, 1);
+	g_assert_cmpint (len, ==, value_len);
+	g_assert (len == 0 || memcmp (data, value, len) == 0);
+}
+
+static void
+test_roundtrip (void)
+{
+	char *env[] = {
+		"reason=BOUND",
+		"PATH=/usr/bin:/bin",
+		"interface=eth0",
+		"new_ip_address=192.168.1.10",
+		"new_domain_search=a.example.com b.example.com",
+		"empty=",
+		"=nameless",
+		"noequals",
+		"binary=\xff\xfe\x01",
+		"equals=a=b",
+		"pid=4242",
+		NULL,
+	};
+	GString *msg;
+	gs_unref_variant GVariant *options = NULL;
+
+	msg = nm_dhcp_helper_event_message_build (env);
+	g_assert (msg);
+	g_assert (msg->len <= NM_DHCP_HELPER_EVENT_MAX_SIZE);
+	g_assert (msg->str[msg->len - 1] == '\0');
+
+	options = nm_dhcp_helper_event_message_parse (msg->str, msg->len);
+	g_string_free (msg, TRUE);
+
+	g_assert (g_variant_is_of_type (options, G_VARIANT_TYPE_VARDICT));
+	g_assert_cmpint (g_variant_n_children (options), ==, 8);
+	_assert_option (options, "reason", "BOUND", 5);
+	_assert_option (options, "interface", "eth0", 4);
+	_assert_option (options, "new_ip_address", "192.168.1.10", 12);
+	_assert_option (options, "new_domain_search", "a.example.com b.example.com", 27);
+	_assert_option (options, "empty", "", 0);
+	_assert_option (options, "binary", "\xff\xfe\x01", 3);
+	_assert_option (options, "equals", "a=b", 3);
+	_assert_option (options, "pid", "4242", 4);
+	g_assert (!g_variant_lookup_value (options, "PATH", NULL));
+}
+
+static void
+test_parse_truncated (void)
+{
+	static const char buf[] = "reason=BOUND\0interface=eth0\0new_ip_address=192.168.1.10";
+	gs_unref_variant GVariant *options = NULL;
+	gs_unref_variant GVariant *options2 = NULL;
+
+	/* the last entry lacks its terminating NUL and is dropped */
+	options = nm_dhcp_helper_event_message_parse (buf, sizeof (buf) - 1);
+	g_assert_cmpint (g_variant_n_children (options), ==, 2);
+	_assert_option (options, "reason", "BOUND", 5);
+	_assert_option (options, "interface", "eth0", 4);
+
+	/* cut in the middle of the second entry */
+	options2 = nm_dhcp_helper_event_message_parse (buf, strlen ("reason=BOUND") + 1 + 5);
+	g_assert_cmpint (g_variant_n_children (options2), ==, 1);
+	_assert_option (options2, "reason", "BOUND", 5);
+}
+
+static void
+test_parse_empty (void)
+{
+	static const char buf[] = "\0\0=x\0y";
+	gs_unref_variant GVariant *options = NULL;
+	gs_unref_variant GVariant *options2 = NULL;
+
+	options = nm_dhcp_helper_event_message_parse (buf, 0);
+	g_assert (g_variant_is_of_type (options, G_VARIANT_TYPE_VARDICT));
+	g_assert_cmpint (g_variant_n_children (options), ==, 0);
+
+	/* empty, nameless and unterminated entries only */
+	options2 = nm_dhcp_helper_event_message_parse (buf, sizeof (buf) - 1);
+	g_assert_cmpint (g_variant_n_children (options2), ==, 0);
+}
+
+static void
+test_build_oversized (void)
+{
+	gs_free char *large = NULL;
+	gs_free char *fits = NULL;
+	char *env[] = { NULL, NULL };
+	GString *msg;
+
+	/* exactly NM_DHCP_HELPER_EVENT_MAX_SIZE with the terminating NUL */
+	fits = g_strnfill (NM_DHCP_HELPER_EVENT_MAX_SIZE - 1, 'a');
+	fits[0] = 'x';
+	fits[1] = '=';
+	env[0] = fits;
+	msg = nm_dhcp_helper_event_message_build (env);
+	g_assert (msg);
+	g_assert_cmpint (msg->len, ==, NM_DHCP_HELPER_EVENT_MAX_SIZE);
+	g_string_free (msg, TRUE);
+
+	large = g_strnfill (NM_DHCP_HELPER_EVENT_MAX_SIZE, 'a');
+	large[0] = 'x';
+	large[1] = '=';
+	env[0] = large;
+	g_assert (!nm_dhcp_helper_event_message_build (env));
+
+	/* nothing to send yields an empty message */
+	env[0] = NULL;
+	msg = nm_dhcp_helper_event_message_build (env);
+	g_assert (msg);
+	g_assert_cmpint (msg->len, ==, 0);
+	g_string_free (msg, TRUE);
+}
+
+/*******************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	g_test_add_func ("/dhcp/helper-api/roundtrip", test_roundtrip);
+	g_test_add_func ("/dhcp/helper-api/parse-truncated", test_parse_truncated);
+	g_test_add_func ("/dhcp/helper-api/parse-empty", test_parse_empty);
+	g_test_add_func ("/dhcp/helper-api/build-oversized", test_build_oversized);
+
+	return g_test_run ();
+}
@@ -0,0 +1,117 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include "sd-dhcp-client.c"
+
+#include "nm-test-utils.h"
+
+#define ACK_OPTLEN 64
+
+/*****************************************************************************/
+
+static DHCPMessage *
+_ack_new (gboolean rapid_commit, size_t *out_len)
+{
+	DHCPMessage *ack;
+	size_t optoffset;
+	be32_t server = htobe32 (0xC0000201);  /* 192.0.2.1 */
+	be32_t lifetime = htobe32 (3600);
+	int r;
+
+	ack = g_malloc0 (sizeof (DHCPMessage) + ACK_OPTLEN);
+
+	r = dhcp_message_init (ack, BOOTREPLY, 42, DHCP_ACK, ARPHRD_ETHER, ACK_OPTLEN, &optoffset);
+	g_assert_cmpint (r, ==, 0);
+	ack->yiaddr = htobe32 (0xC000020A);  /* 192.0.2.10 */
+
+	r = dhcp_option_append (ack, ACK_OPTLEN, &optoffset, 0, DHCP_OPTION_SERVER_IDENTIFIER, 4, &server);
+	g_assert_cmpint (r, ==, 0);
+	r = dhcp_option_append (ack, ACK_OPTLEN, &optoffset, 0, DHCP_OPTION_IP_ADDRESS_LEASE_TIME, 4, &lifetime);
+	g_assert_cmpint (r, ==, 0);
+	if (rapid_commit) {
+		r = dhcp_option_append (ack, ACK_OPTLEN, &optoffset, 0, DHCP_OPTION_RAPID_COMMIT, 0, NULL);
+		g_assert_cmpint (r, ==, 0);
+	}
+	r = dhcp_option_append (ack, ACK_OPTLEN, &optoffset, 0, DHCP_OPTION_END, 0, NULL);
+	g_assert_cmpint (r, ==, 0);
+
+	*out_len = sizeof (DHCPMessage) + optoffset;
+	return ack;
+}
+
+static void
+test_rapid_commit (void)
+{
+	sd_dhcp_client *client = NULL;
+	gs_free DHCPMessage *ack = NULL;
+	gs_free DHCPMessage *ack_rapid = NULL;
+	size_t len, len_rapid;
+	struct in_addr addr;
+	int r;
+
+	ack = _ack_new (FALSE, &len);
+	ack_rapid = _ack_new (TRUE, &len_rapid);
+
+	r = sd_dhcp_client_new (&client);
+	g_assert_cmpint (r, ==, 0);
+	r = sd_dhcp_client_set_rapid_commit (client, TRUE);
+	g_assert_cmpint (r, ==, 0);
+
+	/* in SELECTING state, only an ACK answering a rapid commit
+	 * DISCOVER is accepted. */
+	client->state = DHCP_STATE_SELECTING;
+	r = client_handle_ack (client, ack, len);
+	g_assert_cmpint (r, ==, -ENOMSG);
+	g_assert (!client->lease);
+
+	r = client_handle_ack (client, ack_rapid, len_rapid);
+	g_assert_cmpint (r, ==, SD_DHCP_CLIENT_EVENT_IP_ACQUIRE);
+	g_assert (client->lease);
+	g_assert (client->lease->rapid_commit);
+	r = sd_dhcp_lease_get_address (client->lease, &addr);
+	g_assert_cmpint (r, ==, 0);
+	nmtst_assert_ip4_address (addr.s_addr, "192.0.2.10");
+
+	/* the regular ACK after a REQUEST doesn't need the option. */
+	client->lease = sd_dhcp_lease_unref (client->lease);
+	client->state = DHCP_STATE_REQUESTING;
+	r = client_handle_ack (client, ack, len);
+	g_assert_cmpint (r, ==, SD_DHCP_CLIENT_EVENT_IP_ACQUIRE);
+	g_assert (client->lease);
+	g_assert (!client->lease->rapid_commit);
+
+	sd_dhcp_client_unref (client);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	g_test_add_func ("/sd-dhcp-client/rapid-commit", test_rapid_commit);
+
+	return g_test_run ();
+}
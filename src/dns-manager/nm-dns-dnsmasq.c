@@ -34,6 +34,7 @@
 #include "nm-ip6-config.h"
 #include "nm-dns-utils.h"
 #include "NetworkManagerUtils.h"
+#include "nm-bus-manager.h"
 
 G_DEFINE_TYPE (NMDnsDnsmasq, nm_dns_dnsmasq, NM_TYPE_DNS_PLUGIN)
 
@@ -43,14 +44,41 @@ G_DEFINE_TYPE (NMDnsDnsmasq, nm_dns_dnsmasq, NM_TYPE_DNS_PLUGIN)
 #define CONFFILE NMRUNDIR "/dnsmasq.conf"
 #define CONFDIR NMCONFDIR "/dnsmasq.d"
 
+#define DNSMASQ_DBUS_SERVICE "org.freedesktop.NetworkManager.dnsmasq"
+#define DNSMASQ_DBUS_PATH "/uk/org/thekelleys/dnsmasq"
+#define DNSMASQ_DBUS_INTERFACE "uk.org.thekelleys.dnsmasq"
+
+/* restarts after failed updates before giving up on D-Bus */
+#define MAX_UPDATE_FAILURES 3
+
 typedef struct {
-	guint32 foo;
+	/* Without D-Bus, the servers are passed in a config file and dnsmasq
+	 * has to be restarted on every change. */
+	gboolean use_dbus;
+
+	GDBusProxy *dnsmasq;
+	GCancellable *cancellable;
+
+	/* the servers as argument for SetServersEx, "aas" */
+	GVariant *servers;
+	gboolean servers_pending;
+	guint update_failures;
 } NMDnsDnsmasqPrivate;
 
 /*******************************************/
 
+static void
+add_dnsmasq_nameserver (GVariantBuilder *servers, const char *ip, const char *domain)
+{
+	g_variant_builder_open (servers, G_VARIANT_TYPE ("as"));
+	g_variant_builder_add (servers, "s", ip);
+	if (domain)
+		g_variant_builder_add (servers, "s", domain);
+	g_variant_builder_close (servers);
+}
+
 static gboolean
-add_ip4_config (GString *str, NMIP4Config *ip4, gboolean split)
+add_ip4_config (GVariantBuilder *servers, NMIP4Config *ip4, gboolean split)
 {
 	char buf[INET_ADDRSTRLEN];
 	in_addr_t addr;
@@ -72,9 +100,7 @@ add_ip4_config (GString *str, NMIP4Config *ip4, gboolean split)
 			/* searches are preferred over domains */
 			n = nm_ip4_config_get_num_searches (ip4);
 			for (i = 0; i < n; i++) {
-				g_string_append_printf (str, "server=/%s/%s\n",
-				                        nm_ip4_config_get_search (ip4, i),
-				                        buf);
+				add_dnsmasq_nameserver (servers, buf, nm_ip4_config_get_search (ip4, i));
 				added = TRUE;
 			}
 
@@ -82,9 +108,7 @@ add_ip4_config (GString *str, NMIP4Config *ip4, gboolean split)
 				/* If not searches, use any domains */
 				n = nm_ip4_config_get_num_domains (ip4);
 				for (i = 0; i < n; i++) {
-					g_string_append_printf (str, "server=/%s/%s\n",
-					                        nm_ip4_config_get_domain (ip4, i),
-					                        buf);
+					add_dnsmasq_nameserver (servers, buf, nm_ip4_config_get_domain (ip4, i));
 					added = TRUE;
 				}
 			}
@@ -95,7 +119,7 @@ add_ip4_config (GString *str, NMIP4Config *ip4, gboolean split)
 			domains = nm_dns_utils_get_ip4_rdns_domains (ip4);
 			if (domains) {
 				for (iter = domains; iter && *iter; iter++)
-					g_string_append_printf (str, "server=/%s/%s\n", *iter, buf);
+					add_dnsmasq_nameserver (servers, buf, *iter);
 				g_strfreev (domains);
 				added = TRUE;
 			}
@@ -106,7 +130,7 @@ add_ip4_config (GString *str, NMIP4Config *ip4, gboolean split)
 	if (!added) {
 		for (i = 0; i < nnameservers; i++) {
 			addr = nm_ip4_config_get_nameserver (ip4, i);
-			g_string_append_printf (str, "server=%s\n", nm_utils_inet4_ntop (addr, NULL));
+			add_dnsmasq_nameserver (servers, nm_utils_inet4_ntop (addr, NULL), NULL);
 		}
 	}
 
@@ -136,7 +160,7 @@ ip6_addr_to_string (const struct in6_addr *addr, const char *iface)
 }
 
 static void
-add_global_config (GString *str, const NMGlobalDnsConfig *config)
+add_global_config (GVariantBuilder *servers, const NMGlobalDnsConfig *config)
 {
 	guint i, j;
 
@@ -144,23 +168,20 @@ add_global_config (GString *str, const NMGlobalDnsConfig *config)
 
 	for (i = 0; i < nm_global_dns_config_get_num_domains (config); i++) {
 		NMGlobalDnsDomain *domain = nm_global_dns_config_get_domain (config, i);
-		const char *const *servers = nm_global_dns_domain_get_servers (domain);
-
-		for (j = 0; servers && servers[j]; j++) {
-			if (!strcmp (servers[j], "*"))
-				g_string_append_printf (str, "server=%s\n", servers[j]);
-			else {
-				g_string_append_printf (str, "server=/%s/%s\n",
-				                        nm_global_dns_domain_get_name (domain),
-				                        servers[j]);
-			}
+		const char *const *domain_servers = nm_global_dns_domain_get_servers (domain);
+		const char *name = nm_global_dns_domain_get_name (domain);
+
+		for (j = 0; domain_servers && domain_servers[j]; j++) {
+			add_dnsmasq_nameserver (servers,
+			                        domain_servers[j],
+			                        strcmp (name, "*") ? name : NULL);
 		}
 
 	}
 }
 
 static gboolean
-add_ip6_config (GString *str, NMIP6Config *ip6, gboolean split)
+add_ip6_config (GVariantBuilder *servers, NMIP6Config *ip6, gboolean split)
 {
 	const struct in6_addr *addr;
 	char *buf = NULL;
@@ -184,9 +205,7 @@ add_ip6_config (GString *str, NMIP6Config *ip6, gboolean split)
 			/* searches are preferred over domains */
 			n = nm_ip6_config_get_num_searches (ip6);
 			for (i = 0; i < n; i++) {
-				g_string_append_printf (str, "server=/%s/%s\n",
-				                        nm_ip6_config_get_search (ip6, i),
-				                        buf);
+				add_dnsmasq_nameserver (servers, buf, nm_ip6_config_get_search (ip6, i));
 				added = TRUE;
 			}
 
@@ -194,9 +213,7 @@ add_ip6_config (GString *str, NMIP6Config *ip6, gboolean split)
 				/* If not searches, use any domains */
 				n = nm_ip6_config_get_num_domains (ip6);
 				for (i = 0; i < n; i++) {
-					g_string_append_printf (str, "server=/%s/%s\n",
-					                        nm_ip6_config_get_domain (ip6, i),
-					                        buf);
+					add_dnsmasq_nameserver (servers, buf, nm_ip6_config_get_domain (ip6, i));
 					added = TRUE;
 				}
 			}
@@ -211,7 +228,7 @@ add_ip6_config (GString *str, NMIP6Config *ip6, gboolean split)
 			addr = nm_ip6_config_get_nameserver (ip6, i);
 			buf = ip6_addr_to_string (addr, iface);
 			if (buf) {
-				g_string_append_printf (str, "server=%s\n", buf);
+				add_dnsmasq_nameserver (servers, buf, NULL);
 				g_free (buf);
 			}
 		}
@@ -220,66 +237,40 @@ add_ip6_config (GString *str, NMIP6Config *ip6, gboolean split)
 	return TRUE;
 }
 
+static void
+add_configs (GVariantBuilder *servers, const GSList *configs, gboolean split)
+{
+	const GSList *iter;
+
+	for (iter = configs; iter; iter = g_slist_next (iter)) {
+		if (NM_IS_IP4_CONFIG (iter->data))
+			add_ip4_config (servers, NM_IP4_CONFIG (iter->data), split);
+		else if (NM_IS_IP6_CONFIG (iter->data))
+			add_ip6_config (servers, NM_IP6_CONFIG (iter->data), split);
+	}
+}
+
+/*******************************************/
+
 static gboolean
-update (NMDnsPlugin *plugin,
-        const GSList *vpn_configs,
-        const GSList *dev_configs,
-        const GSList *other_configs,
-        const NMGlobalDnsConfig *global_config,
-        const char *hostname)
+write_conf_file (GVariant *servers)
 {
-	NMDnsDnsmasq *self = NM_DNS_DNSMASQ (plugin);
-	const char *dm_binary;
 	GString *conf;
-	GSList *iter;
-	const char *argv[15];
+	GVariantIter iter;
+	const char **server;
 	GError *error = NULL;
+	gboolean success = TRUE;
 	int ignored;
-	GPid pid = 0;
-	guint idx = 0;
-
-	/* Kill the old dnsmasq; there doesn't appear to be a way to get dnsmasq
-	 * to reread the config file using SIGHUP or similar.  This is a small race
-	 * here when restarting dnsmasq when DNS requests could go to the upstream
-	 * servers instead of to dnsmasq.
-	 */
-	nm_dns_plugin_child_kill (plugin);
-
-	dm_binary = nm_utils_find_helper ("dnsmasq", DNSMASQ_PATH, NULL);
-	if (!dm_binary) {
-		nm_log_warn (LOGD_DNS, "Could not find dnsmasq binary");
-		return FALSE;
-	}
 
 	/* Build up the new dnsmasq config file */
 	conf = g_string_sized_new (150);
-
-	if (global_config)
-		add_global_config (conf, global_config);
-	else {
-		/* Use split DNS for VPN configs */
-		for (iter = (GSList *) vpn_configs; iter; iter = g_slist_next (iter)) {
-			if (NM_IS_IP4_CONFIG (iter->data))
-				add_ip4_config (conf, NM_IP4_CONFIG (iter->data), TRUE);
-			else if (NM_IS_IP6_CONFIG (iter->data))
-				add_ip6_config (conf, NM_IP6_CONFIG (iter->data), TRUE);
-		}
-
-		/* Now add interface configs without split DNS */
-		for (iter = (GSList *) dev_configs; iter; iter = g_slist_next (iter)) {
-			if (NM_IS_IP4_CONFIG (iter->data))
-				add_ip4_config (conf, NM_IP4_CONFIG (iter->data), FALSE);
-			else if (NM_IS_IP6_CONFIG (iter->data))
-				add_ip6_config (conf, NM_IP6_CONFIG (iter->data), FALSE);
-		}
-
-		/* And any other random configs */
-		for (iter = (GSList *) other_configs; iter; iter = g_slist_next (iter)) {
-			if (NM_IS_IP4_CONFIG (iter->data))
-				add_ip4_config (conf, NM_IP4_CONFIG (iter->data), FALSE);
-			else if (NM_IS_IP6_CONFIG (iter->data))
-				add_ip6_config (conf, NM_IP6_CONFIG (iter->data), FALSE);
-		}
+	g_variant_iter_init (&iter, servers);
+	while (g_variant_iter_next (&iter, "^a&s", &server)) {
+		if (server[0] && server[1])
+			g_string_append_printf (conf, "server=/%s/%s\n", server[1], server[0]);
+		else if (server[0])
+			g_string_append_printf (conf, "server=%s\n", server[0]);
+		g_free (server);
 	}
 
 	/* Write out the config file */
@@ -289,6 +280,7 @@ update (NMDnsPlugin *plugin,
 		             error ? error->code : -1,
 		             error && error->message ? error->message : "(unknown)");
 		g_clear_error (&error);
+		success = FALSE;
 		goto out;
 	}
 	ignored = chmod (CONFFILE, 0644);
@@ -296,6 +288,25 @@ update (NMDnsPlugin *plugin,
 	nm_log_dbg (LOGD_DNS, "dnsmasq local caching DNS configuration:");
 	nm_log_dbg (LOGD_DNS, "%s", conf->str);
 
+out:
+	g_string_free (conf, TRUE);
+	return success;
+}
+
+static GPid
+start_dnsmasq (NMDnsDnsmasq *self)
+{
+	NMDnsDnsmasqPrivate *priv = NM_DNS_DNSMASQ_GET_PRIVATE (self);
+	const char *dm_binary;
+	const char *argv[15];
+	guint idx = 0;
+
+	dm_binary = nm_utils_find_helper ("dnsmasq", DNSMASQ_PATH, NULL);
+	if (!dm_binary) {
+		nm_log_warn (LOGD_DNS, "Could not find dnsmasq binary");
+		return 0;
+	}
+
 	argv[idx++] = dm_binary;
 	argv[idx++] = "--no-resolv";  /* Use only commandline */
 	argv[idx++] = "--keep-in-foreground";
@@ -303,10 +314,16 @@ update (NMDnsPlugin *plugin,
 	argv[idx++] = "--bind-interfaces";
 	argv[idx++] = "--pid-file=" PIDFILE;
 	argv[idx++] = "--listen-address=127.0.0.1"; /* Should work for both 4 and 6 */
-	argv[idx++] = "--conf-file=" CONFFILE;
 	argv[idx++] = "--cache-size=400";
 	argv[idx++] = "--proxy-dnssec"; /* Allow DNSSEC to pass through */
 
+	if (priv->use_dbus) {
+		/* avoid loading /etc/dnsmasq.conf, the servers come over D-Bus */
+		argv[idx++] = "--conf-file=/dev/null";
+		argv[idx++] = "--enable-dbus=" DNSMASQ_DBUS_SERVICE;
+	} else
+		argv[idx++] = "--conf-file=" CONFFILE;
+
 	/* dnsmasq exits if the conf dir is not present */
 	if (g_file_test (CONFDIR, G_FILE_TEST_IS_DIR))
 		argv[idx++] = "--conf-dir=" CONFDIR;
@@ -315,11 +332,202 @@ update (NMDnsPlugin *plugin,
 	g_warn_if_fail (idx <= G_N_ELEMENTS (argv));
 
 	/* And finally spawn dnsmasq */
-	pid = nm_dns_plugin_child_spawn (NM_DNS_PLUGIN (self), argv, PIDFILE, "bin/dnsmasq");
+	return nm_dns_plugin_child_spawn (NM_DNS_PLUGIN (self), argv, PIDFILE, "bin/dnsmasq");
+}
 
-out:
-	g_string_free (conf, TRUE);
-	return pid ? TRUE : FALSE;
+/* Restarts dnsmasq with the servers in the config file and stops
+ * using D-Bus for good. */
+static void
+fall_back_to_conf_file (NMDnsDnsmasq *self)
+{
+	NMDnsDnsmasqPrivate *priv = NM_DNS_DNSMASQ_GET_PRIVATE (self);
+
+	priv->use_dbus = FALSE;
+	priv->servers_pending = FALSE;
+	nm_dns_plugin_child_kill (NM_DNS_PLUGIN (self));
+	if (   !priv->servers
+	    || !write_conf_file (priv->servers)
+	    || !start_dnsmasq (self))
+		g_signal_emit_by_name (self, NM_DNS_PLUGIN_FAILED);
+}
+
+static void
+dnsmasq_update_done (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	NMDnsDnsmasq *self;
+	NMDnsDnsmasqPrivate *priv;
+	gs_unref_variant GVariant *response = NULL;
+	gs_free_error GError *error = NULL;
+
+	response = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), res, &error);
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+
+	self = NM_DNS_DNSMASQ (user_data);
+	priv = NM_DNS_DNSMASQ_GET_PRIVATE (self);
+	if (response) {
+		nm_log_dbg (LOGD_DNS, "dnsmasq update successful");
+		priv->update_failures = 0;
+		return;
+	}
+
+	if (++priv->update_failures >= MAX_UPDATE_FAILURES) {
+		/* A dnsmasq that rejects the servers every time would otherwise
+		 * be restarted on every update. */
+		nm_log_warn (LOGD_DNS, "dnsmasq update failed %u times: %s; passing the servers in the config file from now on",
+		             priv->update_failures, error->message);
+		fall_back_to_conf_file (self);
+		return;
+	}
+
+	/* Fall back to a fresh instance, which gets the servers
+	 * once it shows up on the bus. */
+	nm_log_warn (LOGD_DNS, "dnsmasq update failed: %s; restarting dnsmasq", error->message);
+	priv->servers_pending = TRUE;
+	nm_dns_plugin_child_kill (NM_DNS_PLUGIN (self));
+	if (!start_dnsmasq (self))
+		g_signal_emit_by_name (self, NM_DNS_PLUGIN_FAILED);
+}
+
+static void
+send_dnsmasq_update (NMDnsDnsmasq *self)
+{
+	NMDnsDnsmasqPrivate *priv = NM_DNS_DNSMASQ_GET_PRIVATE (self);
+	gs_free char *owner = NULL;
+
+	if (!priv->servers || !priv->dnsmasq)
+		return;
+
+	owner = g_dbus_proxy_get_name_owner (priv->dnsmasq);
+	if (!owner) {
+		/* not yet up; sent as soon as it appears on the bus */
+		priv->servers_pending = TRUE;
+		return;
+	}
+
+	nm_log_dbg (LOGD_DNS, "trying to update dnsmasq nameservers");
+	priv->servers_pending = FALSE;
+	g_dbus_proxy_call (priv->dnsmasq,
+	                   "SetServersEx",
+	                   g_variant_new ("(@aas)", priv->servers),
+	                   G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                   -1,
+	                   priv->cancellable,
+	                   dnsmasq_update_done,
+	                   self);
+}
+
+static void
+name_owner_changed (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	NMDnsDnsmasq *self = NM_DNS_DNSMASQ (user_data);
+	NMDnsDnsmasqPrivate *priv = NM_DNS_DNSMASQ_GET_PRIVATE (self);
+
+	if (priv->servers_pending)
+		send_dnsmasq_update (self);
+}
+
+static void
+dnsmasq_proxy_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	NMDnsDnsmasq *self;
+	NMDnsDnsmasqPrivate *priv;
+	gs_free_error GError *error = NULL;
+	GDBusProxy *proxy;
+
+	proxy = g_dbus_proxy_new_finish (res, &error);
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+
+	self = NM_DNS_DNSMASQ (user_data);
+	priv = NM_DNS_DNSMASQ_GET_PRIVATE (self);
+
+	if (!proxy) {
+		/* Restart with the servers in the config file */
+		nm_log_warn (LOGD_DNS, "failed to connect to dnsmasq via D-Bus: %s", error->message);
+		fall_back_to_conf_file (self);
+		return;
+	}
+
+	priv->dnsmasq = proxy;
+	g_signal_connect (priv->dnsmasq, "notify::g-name-owner",
+	                  G_CALLBACK (name_owner_changed), self);
+
+	if (priv->servers_pending)
+		send_dnsmasq_update (self);
+}
+
+static gboolean
+update (NMDnsPlugin *plugin,
+        const GSList *vpn_configs,
+        const GSList *dev_configs,
+        const GSList *other_configs,
+        const NMGlobalDnsConfig *global_config,
+        const char *hostname)
+{
+	NMDnsDnsmasq *self = NM_DNS_DNSMASQ (plugin);
+	NMDnsDnsmasqPrivate *priv = NM_DNS_DNSMASQ_GET_PRIVATE (self);
+	GVariantBuilder servers;
+	GDBusConnection *connection;
+
+	g_variant_builder_init (&servers, G_VARIANT_TYPE ("aas"));
+
+	if (global_config)
+		add_global_config (&servers, global_config);
+	else {
+		/* Use split DNS for VPN configs */
+		add_configs (&servers, vpn_configs, TRUE);
+
+		/* Now add interface configs without split DNS */
+		add_configs (&servers, dev_configs, FALSE);
+
+		/* And any other random configs */
+		add_configs (&servers, other_configs, FALSE);
+	}
+
+	g_clear_pointer (&priv->servers, g_variant_unref);
+	priv->servers = g_variant_ref_sink (g_variant_builder_end (&servers));
+
+	if (!priv->cancellable) {
+		/* first update, set up the D-Bus connection to dnsmasq */
+		priv->cancellable = g_cancellable_new ();
+		connection = nm_bus_manager_get_connection (nm_bus_manager_get ());
+		if (connection) {
+			priv->use_dbus = TRUE;
+			g_dbus_proxy_new (connection,
+			                  G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+			                      G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS |
+			                      G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+			                  NULL,
+			                  DNSMASQ_DBUS_SERVICE,
+			                  DNSMASQ_DBUS_PATH,
+			                  DNSMASQ_DBUS_INTERFACE,
+			                  priv->cancellable,
+			                  dnsmasq_proxy_cb,
+			                  self);
+		}
+	}
+
+	if (!priv->use_dbus) {
+		/* Kill the old dnsmasq; there doesn't appear to be a way to get dnsmasq
+		 * to reread the config file using SIGHUP or similar.  This is a small race
+		 * here when restarting dnsmasq when DNS requests could go to the upstream
+		 * servers instead of to dnsmasq.
+		 */
+		nm_dns_plugin_child_kill (plugin);
+		if (!write_conf_file (priv->servers))
+			return FALSE;
+		return start_dnsmasq (self) != 0;
+	}
+
+	/* Keep the running instance and its cache, just hand it the new servers */
+	priv->servers_pending = TRUE;
+	if (!nm_dns_plugin_child_get_pid (plugin)) {
+		if (!start_dnsmasq (self))
+			return FALSE;
+	}
+	send_dnsmasq_update (self);
+	return TRUE;
 }
 
 /****************************************************************/
@@ -400,6 +608,18 @@ nm_dns_dnsmasq_init (NMDnsDnsmasq *self)
 static void
 dispose (GObject *object)
 {
+	NMDnsDnsmasqPrivate *priv = NM_DNS_DNSMASQ_GET_PRIVATE (object);
+
+	if (priv->cancellable) {
+		g_cancellable_cancel (priv->cancellable);
+		g_clear_object (&priv->cancellable);
+	}
+	if (priv->dnsmasq) {
+		g_signal_handlers_disconnect_by_func (priv->dnsmasq, name_owner_changed, object);
+		g_clear_object (&priv->dnsmasq);
+	}
+	g_clear_pointer (&priv->servers, g_variant_unref);
+
 	unlink (CONFFILE);
 
 	G_OBJECT_CLASS (nm_dns_dnsmasq_parent_class)->dispose (object);
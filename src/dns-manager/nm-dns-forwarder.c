@@ -0,0 +1,1508 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+/* A small caching DNS forwarder running inside NetworkManager.
+ *
+ * It listens on 127.0.0.1:53 and forwards queries to the nameservers of
+ * the active configurations, using the same split DNS rules as the dnsmasq
+ * plugin. Answers to UDP queries are kept in a LRU cache and served with
+ * their TTLs decreased by the time they spent in the cache. Queries over
+ * TCP are routed one by one and relayed to the upstream server without
+ * caching.
+ *
+ * Contrary to dnsmasq, an update only replaces the routing table. The cache
+ * survives it; entries are dropped lazily when the servers responsible for
+ * their name changed.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "nm-default.h"
+#include "nm-dns-forwarder.h"
+#include "nm-utils.h"
+#include "nm-ip4-config.h"
+#include "nm-ip6-config.h"
+#include "nm-dns-utils.h"
+#include "NetworkManagerUtils.h"
+
+G_DEFINE_TYPE (NMDnsForwarder, nm_dns_forwarder, NM_TYPE_DNS_PLUGIN)
+
+#define NM_DNS_FORWARDER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DNS_FORWARDER, NMDnsForwarderPrivate))
+
+#define DNS_PORT            53
+#define DNS_HEADER_LEN      12
+#define DNS_MAX_NAME_LEN    255
+#define DNS_MAX_LABEL_LEN   63
+#define DNS_MAX_UDP_LEN     512
+#define DNS_MAX_MSG_LEN     65535
+
+#define DNS_FLAG_QR         0x8000
+#define DNS_FLAG_TC         0x0200
+#define DNS_FLAG_RD         0x0100
+#define DNS_FLAG_RA         0x0080
+#define DNS_FLAG_CD         0x0010
+#define DNS_FLAGS_OPCODE(f) (((f) >> 11) & 0xF)
+#define DNS_FLAGS_RCODE(f)  ((f) & 0xF)
+
+#define DNS_RCODE_NOERROR   0
+#define DNS_RCODE_FORMERR   1
+#define DNS_RCODE_SERVFAIL  2
+#define DNS_RCODE_NXDOMAIN  3
+#define DNS_RCODE_REFUSED   5
+
+#define DNS_TYPE_OPT        41
+#define DNS_EDNS_FLAG_DO    0x8000
+
+/* Same as the --cache-size we pass to dnsmasq */
+#define CACHE_SIZE          400
+#define CACHE_MAX_TTL       3600
+
+#define QUERY_TIMEOUT_MS    2000
+#define MAX_PENDING         150
+#define MAX_READS_PER_WAKEUP 50
+
+#define MAX_TCP_CLIENTS     20
+#define TCP_IDLE_TIMEOUT_S  10
+
+typedef union {
+	struct sockaddr sa;
+	struct sockaddr_in in;
+	struct sockaddr_in6 in6;
+} SockAddr;
+
+typedef struct {
+	SockAddr addr;
+	socklen_t addr_len;
+} Server;
+
+typedef struct {
+	guint refcount;
+	GArray *servers;
+	/* index of the server that answered last, tried first */
+	guint preferred;
+	/* identifies the set of servers. Cached answers are only valid
+	 * as long as the same servers are responsible for the name. */
+	guint hash;
+} Route;
+
+typedef struct {
+	GList lru_link;
+	GBytes *key;
+	guint8 *reply;
+	gsize reply_len;
+	gint32 added_at;
+	gint32 expires_at;
+	guint route_hash;
+} CacheEntry;
+
+typedef struct {
+	guint16 id;
+	guint16 flags;
+	char name[DNS_MAX_NAME_LEN + 1];
+	guint16 qtype;
+	guint16 qclass;
+	gsize question_end;
+	gsize max_reply_len;
+	gboolean dnssec_ok;
+} Query;
+
+typedef struct {
+	NMDnsForwarder *self;
+	Route *route;
+	GBytes *key;
+	guint8 *query;
+	gsize query_len;
+	gsize question_end;
+	guint16 client_id;
+	SockAddr client;
+	socklen_t client_len;
+	guint server_idx;
+	guint tries;
+	int fd;
+	GIOChannel *channel;
+	guint watch_id;
+	guint timeout_id;
+} Pending;
+
+typedef struct {
+	/* only valid as long as @cancellable is not cancelled */
+	NMDnsForwarder *self;
+	GCancellable *cancellable;
+	GSocketConnection *client;
+	/* only set while a query is forwarded */
+	GSocketConnection *upstream;
+	Route *route;
+	guint8 *query;
+	gsize query_len;
+	gsize question_end;
+	guint server_idx;
+	guint tries;
+	guint8 *buf;
+	gsize len;
+	gsize done;
+} TcpRequest;
+
+typedef struct {
+	/* domain (lower-case, "" for the default route) => Route */
+	GHashTable *routes;
+
+	GHashTable *cache;
+	GQueue cache_lru;
+
+	GHashTable *pending;
+	GRand *rand;
+	guint8 *buf;
+
+	int listen_fd;
+	GIOChannel *listen_channel;
+	guint listen_id;
+
+	GSocketService *tcp_service;
+	GCancellable *tcp_cancellable;
+	guint tcp_clients;
+} NMDnsForwarderPrivate;
+
+/*******************************************/
+
+static inline guint16
+get16 (const guint8 *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static inline guint32
+get32 (const guint8 *p)
+{
+	return ((guint32) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static inline void
+put16 (guint8 *p, guint16 v)
+{
+	p[0] = v >> 8;
+	p[1] = v & 0xFF;
+}
+
+static inline void
+put32 (guint8 *p, guint32 v)
+{
+	p[0] = v >> 24;
+	p[1] = (v >> 16) & 0xFF;
+	p[2] = (v >> 8) & 0xFF;
+	p[3] = v & 0xFF;
+}
+
+static gboolean
+skip_name (const guint8 *buf, gsize len, gsize *pos)
+{
+	gsize p = *pos;
+	guint c;
+
+	for (;;) {
+		if (p >= len)
+			return FALSE;
+		c = buf[p];
+		if (c == 0) {
+			p++;
+			break;
+		}
+		if ((c & 0xC0) == 0xC0) {
+			/* compression pointer, terminates the name */
+			p += 2;
+			break;
+		}
+		if (c > DNS_MAX_LABEL_LEN)
+			return FALSE;
+		p += 1 + c;
+		/* leave room for the terminating zero */
+		if (p - *pos >= DNS_MAX_NAME_LEN)
+			return FALSE;
+	}
+	if (p > len)
+		return FALSE;
+	*pos = p;
+	return TRUE;
+}
+
+static gboolean
+parse_query (const guint8 *buf, gsize len, Query *q)
+{
+	gsize pos = DNS_HEADER_LEN, name_len = 0;
+	guint arcount, label_len, i;
+
+	if (len < DNS_HEADER_LEN)
+		return FALSE;
+
+	q->id = get16 (&buf[0]);
+	q->flags = get16 (&buf[2]);
+	if (   (q->flags & DNS_FLAG_QR)
+	    || DNS_FLAGS_OPCODE (q->flags) != 0)
+		return FALSE;
+	if (   get16 (&buf[4]) != 1
+	    || get16 (&buf[6]) != 0
+	    || get16 (&buf[8]) != 0)
+		return FALSE;
+	arcount = get16 (&buf[10]);
+
+	/* The name in the question of a query is never compressed. Keep it in
+	 * presentation form, for the routing and as part of the cache key. */
+	for (;;) {
+		if (pos >= len)
+			return FALSE;
+		label_len = buf[pos++];
+		if (label_len == 0)
+			break;
+		if (   label_len > DNS_MAX_LABEL_LEN
+		    || pos + label_len > len
+		    || pos + label_len - DNS_HEADER_LEN >= DNS_MAX_NAME_LEN)
+			return FALSE;
+		if (name_len)
+			q->name[name_len++] = '.';
+		for (i = 0; i < label_len; i++) {
+			char c = buf[pos + i];
+
+			/* we cannot route such names */
+			if (c == '.' || c == '\0')
+				return FALSE;
+			q->name[name_len++] = g_ascii_tolower (c);
+		}
+		pos += label_len;
+	}
+	q->name[name_len] = '\0';
+
+	if (pos + 4 > len)
+		return FALSE;
+	q->qtype = get16 (&buf[pos]);
+	q->qclass = get16 (&buf[pos + 2]);
+	pos += 4;
+	q->question_end = pos;
+
+	q->max_reply_len = DNS_MAX_UDP_LEN;
+	q->dnssec_ok = FALSE;
+	for (i = 0; i < arcount; i++) {
+		if (!skip_name (buf, len, &pos) || pos + 10 > len)
+			return FALSE;
+		if (get16 (&buf[pos]) == DNS_TYPE_OPT) {
+			q->max_reply_len = MAX (DNS_MAX_UDP_LEN, get16 (&buf[pos + 2]));
+			q->dnssec_ok = NM_FLAGS_HAS (get32 (&buf[pos + 4]), DNS_EDNS_FLAG_DO);
+		}
+		pos += 10 + get16 (&buf[pos + 8]);
+		if (pos > len)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Returns the smallest TTL of the resource records in @buf, after
+ * decreasing all of them by @age. */
+static gboolean
+reply_age_ttls (guint8 *buf, gsize len, guint32 age, guint32 *out_min_ttl)
+{
+	gsize pos = DNS_HEADER_LEN;
+	guint32 ttl, min_ttl = G_MAXUINT32;
+	guint n, i;
+
+	if (len < DNS_HEADER_LEN)
+		return FALSE;
+
+	n = get16 (&buf[4]);
+	for (i = 0; i < n; i++) {
+		if (!skip_name (buf, len, &pos) || pos + 4 > len)
+			return FALSE;
+		pos += 4;
+	}
+
+	n = get16 (&buf[6]) + get16 (&buf[8]) + get16 (&buf[10]);
+	for (i = 0; i < n; i++) {
+		if (!skip_name (buf, len, &pos) || pos + 10 > len)
+			return FALSE;
+
+		/* the TTL field of OPT records carries flags */
+		if (get16 (&buf[pos]) != DNS_TYPE_OPT) {
+			ttl = get32 (&buf[pos + 4]);
+			if (ttl > G_MAXINT32)
+				ttl = 0;
+			if (age) {
+				ttl = ttl > age ? ttl - age : 0;
+				put32 (&buf[pos + 4], ttl);
+			}
+			min_ttl = MIN (min_ttl, ttl);
+		}
+
+		pos += 10 + get16 (&buf[pos + 8]);
+		if (pos > len)
+			return FALSE;
+	}
+
+	if (out_min_ttl)
+		*out_min_ttl = min_ttl;
+	return TRUE;
+}
+
+/*******************************************/
+
+static Route *
+route_new (void)
+{
+	Route *route;
+
+	route = g_slice_new0 (Route);
+	route->refcount = 1;
+	route->servers = g_array_new (FALSE, FALSE, sizeof (Server));
+	return route;
+}
+
+static Route *
+route_ref (Route *route)
+{
+	route->refcount++;
+	return route;
+}
+
+static void
+route_unref (Route *route)
+{
+	if (--route->refcount == 0) {
+		g_array_unref (route->servers);
+		g_slice_free (Route, route);
+	}
+}
+
+static void
+route_update_hash (Route *route)
+{
+	guint h = 5381, i;
+	gsize j;
+
+	for (i = 0; i < route->servers->len; i++) {
+		const Server *server = &g_array_index (route->servers, Server, i);
+		const guint8 *p = (const guint8 *) &server->addr;
+
+		for (j = 0; j < server->addr_len; j++)
+			h = (h << 5) + h + p[j];
+	}
+	route->hash = h;
+}
+
+static void
+route_add_server (GHashTable *routes, const char *domain, const Server *server)
+{
+	gs_free char *key = NULL;
+	Route *route;
+	gsize len;
+	guint i;
+
+	domain = domain ? domain : "";
+	while (domain[0] == '.')
+		domain++;
+	key = g_ascii_strdown (domain, -1);
+	len = strlen (key);
+	while (len && key[len - 1] == '.')
+		key[--len] = '\0';
+
+	route = g_hash_table_lookup (routes, key);
+	if (!route) {
+		route = route_new ();
+		g_hash_table_insert (routes, key, route);
+		key = NULL;
+	}
+
+	for (i = 0; i < route->servers->len; i++) {
+		const Server *s = &g_array_index (route->servers, Server, i);
+
+		if (   s->addr_len == server->addr_len
+		    && memcmp (&s->addr, &server->addr, s->addr_len) == 0)
+			return;
+	}
+	g_array_append_val (route->servers, *server);
+}
+
+static Route *
+route_lookup (NMDnsForwarder *self, const char *name)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	Route *route;
+
+	if (!priv->routes)
+		return NULL;
+
+	/* the longest matching domain wins */
+	while (name && name[0]) {
+		route = g_hash_table_lookup (priv->routes, name);
+		if (route)
+			return route;
+		name = strchr (name, '.');
+		if (name)
+			name++;
+	}
+	return g_hash_table_lookup (priv->routes, "");
+}
+
+static void
+server_init_ip4 (Server *server, in_addr_t addr)
+{
+	memset (server, 0, sizeof (*server));
+	server->addr.in.sin_family = AF_INET;
+	server->addr.in.sin_port = htons (DNS_PORT);
+	server->addr.in.sin_addr.s_addr = addr;
+	server->addr_len = sizeof (struct sockaddr_in);
+}
+
+static gboolean
+server_init_ip6 (Server *server, const struct in6_addr *addr, const char *iface)
+{
+	if (IN6_IS_ADDR_V4MAPPED (addr)) {
+		server_init_ip4 (server, addr->s6_addr32[3]);
+		return TRUE;
+	}
+
+	memset (server, 0, sizeof (*server));
+	server->addr.in6.sin6_family = AF_INET6;
+	server->addr.in6.sin6_port = htons (DNS_PORT);
+	server->addr.in6.sin6_addr = *addr;
+	server->addr_len = sizeof (struct sockaddr_in6);
+
+	if (IN6_IS_ADDR_LINKLOCAL (addr)) {
+		if (!iface || !iface[0])
+			return FALSE;
+		server->addr.in6.sin6_scope_id = if_nametoindex (iface);
+		if (!server->addr.in6.sin6_scope_id)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+server_init_from_string (Server *server, const char *str)
+{
+	struct in6_addr addr6;
+	in_addr_t addr4;
+
+	if (inet_pton (AF_INET, str, &addr4) == 1) {
+		server_init_ip4 (server, addr4);
+		return TRUE;
+	}
+	if (inet_pton (AF_INET6, str, &addr6) == 1)
+		return server_init_ip6 (server, &addr6, NULL);
+	return FALSE;
+}
+
+static void
+add_ip4_config (GHashTable *routes, NMIP4Config *ip4, gboolean split)
+{
+	char **rdns_domains = NULL, **iter;
+	Server server;
+	guint nnameservers, n, i, j;
+	gboolean added = FALSE;
+
+	nnameservers = nm_ip4_config_get_num_nameservers (ip4);
+
+	if (split && nnameservers)
+		rdns_domains = nm_dns_utils_get_ip4_rdns_domains (ip4);
+
+	for (i = 0; split && i < nnameservers; i++) {
+		server_init_ip4 (&server, nm_ip4_config_get_nameserver (ip4, i));
+
+		/* searches are preferred over domains */
+		n = nm_ip4_config_get_num_searches (ip4);
+		for (j = 0; j < n; j++) {
+			route_add_server (routes, nm_ip4_config_get_search (ip4, j), &server);
+			added = TRUE;
+		}
+
+		if (n == 0) {
+			n = nm_ip4_config_get_num_domains (ip4);
+			for (j = 0; j < n; j++) {
+				route_add_server (routes, nm_ip4_config_get_domain (ip4, j), &server);
+				added = TRUE;
+			}
+		}
+
+		/* Ensure reverse-DNS works by directing queries for in-addr.arpa
+		 * domains to the split domain's nameserver.
+		 */
+		for (iter = rdns_domains; iter && *iter; iter++) {
+			route_add_server (routes, *iter, &server);
+			added = TRUE;
+		}
+	}
+	g_strfreev (rdns_domains);
+
+	if (!added) {
+		for (i = 0; i < nnameservers; i++) {
+			server_init_ip4 (&server, nm_ip4_config_get_nameserver (ip4, i));
+			route_add_server (routes, NULL, &server);
+		}
+	}
+}
+
+static void
+add_ip6_config (GHashTable *routes, NMIP6Config *ip6, gboolean split)
+{
+	const char *iface;
+	Server server;
+	guint nnameservers, n, i, j;
+	gboolean added = FALSE;
+
+	nnameservers = nm_ip6_config_get_num_nameservers (ip6);
+	iface = g_object_get_data (G_OBJECT (ip6), IP_CONFIG_IFACE_TAG);
+
+	for (i = 0; split && i < nnameservers; i++) {
+		if (!server_init_ip6 (&server, nm_ip6_config_get_nameserver (ip6, i), iface))
+			continue;
+
+		/* searches are preferred over domains */
+		n = nm_ip6_config_get_num_searches (ip6);
+		for (j = 0; j < n; j++) {
+			route_add_server (routes, nm_ip6_config_get_search (ip6, j), &server);
+			added = TRUE;
+		}
+
+		if (n == 0) {
+			n = nm_ip6_config_get_num_domains (ip6);
+			for (j = 0; j < n; j++) {
+				route_add_server (routes, nm_ip6_config_get_domain (ip6, j), &server);
+				added = TRUE;
+			}
+		}
+	}
+
+	if (!added) {
+		for (i = 0; i < nnameservers; i++) {
+			if (server_init_ip6 (&server, nm_ip6_config_get_nameserver (ip6, i), iface))
+				route_add_server (routes, NULL, &server);
+		}
+	}
+}
+
+static void
+add_global_config (GHashTable *routes, const NMGlobalDnsConfig *config)
+{
+	Server server;
+	guint i, j;
+
+	for (i = 0; i < nm_global_dns_config_get_num_domains (config); i++) {
+		NMGlobalDnsDomain *domain = nm_global_dns_config_get_domain (config, i);
+		const char *const *servers = nm_global_dns_domain_get_servers (domain);
+		const char *name = nm_global_dns_domain_get_name (domain);
+
+		if (!strcmp (name, "*"))
+			name = NULL;
+
+		for (j = 0; servers && servers[j]; j++) {
+			if (server_init_from_string (&server, servers[j]))
+				route_add_server (routes, name, &server);
+			else
+				nm_log_warn (LOGD_DNS, "forwarder: ignoring invalid server '%s'", servers[j]);
+		}
+	}
+}
+
+static void
+add_configs (GHashTable *routes, const GSList *configs, gboolean split)
+{
+	const GSList *iter;
+
+	for (iter = configs; iter; iter = g_slist_next (iter)) {
+		if (NM_IS_IP4_CONFIG (iter->data))
+			add_ip4_config (routes, NM_IP4_CONFIG (iter->data), split);
+		else if (NM_IS_IP6_CONFIG (iter->data))
+			add_ip6_config (routes, NM_IP6_CONFIG (iter->data), split);
+	}
+}
+
+/*******************************************/
+
+static void
+cache_remove (NMDnsForwarder *self, CacheEntry *entry)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+
+	g_hash_table_remove (priv->cache, entry->key);
+	g_queue_unlink (&priv->cache_lru, &entry->lru_link);
+	g_bytes_unref (entry->key);
+	g_free (entry->reply);
+	g_slice_free (CacheEntry, entry);
+}
+
+static void
+cache_clear (NMDnsForwarder *self)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+
+	while (priv->cache_lru.head)
+		cache_remove (self, priv->cache_lru.head->data);
+}
+
+static CacheEntry *
+cache_lookup (NMDnsForwarder *self, GBytes *key, const Route *route, gint32 now)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	CacheEntry *entry;
+
+	entry = g_hash_table_lookup (priv->cache, key);
+	if (!entry)
+		return NULL;
+
+	if (   now >= entry->expires_at
+	    || entry->route_hash != route->hash) {
+		cache_remove (self, entry);
+		return NULL;
+	}
+
+	g_queue_unlink (&priv->cache_lru, &entry->lru_link);
+	g_queue_push_head_link (&priv->cache_lru, &entry->lru_link);
+	return entry;
+}
+
+static void
+cache_add (NMDnsForwarder *self, GBytes *key, const guint8 *reply, gsize len, const Route *route)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	CacheEntry *entry, *old;
+	guint16 flags;
+	guint32 ttl;
+	gint32 now;
+
+	flags = get16 (&reply[2]);
+	if (   (flags & DNS_FLAG_TC)
+	    || (   DNS_FLAGS_RCODE (flags) != DNS_RCODE_NOERROR
+	        && DNS_FLAGS_RCODE (flags) != DNS_RCODE_NXDOMAIN))
+		return;
+
+	entry = g_slice_new0 (CacheEntry);
+	entry->reply = g_memdup (reply, len);
+	entry->reply_len = len;
+
+	/* Negative answers carry the SOA in the authority section, whose
+	 * TTL limits the time they may be cached. Without any record
+	 * there is nothing telling how long the answer is valid. */
+	if (   !reply_age_ttls (entry->reply, len, 0, &ttl)
+	    || ttl == 0
+	    || ttl == G_MAXUINT32) {
+		g_free (entry->reply);
+		g_slice_free (CacheEntry, entry);
+		return;
+	}
+
+	now = nm_utils_get_monotonic_timestamp_s ();
+	entry->key = g_bytes_ref (key);
+	entry->added_at = now;
+	entry->expires_at = now + MIN (ttl, CACHE_MAX_TTL);
+	entry->route_hash = route->hash;
+	entry->lru_link.data = entry;
+
+	old = g_hash_table_lookup (priv->cache, key);
+	if (old)
+		cache_remove (self, old);
+	while (priv->cache_lru.length >= CACHE_SIZE)
+		cache_remove (self, priv->cache_lru.tail->data);
+
+	g_hash_table_insert (priv->cache, entry->key, entry);
+	g_queue_push_head_link (&priv->cache_lru, &entry->lru_link);
+}
+
+static GBytes *
+cache_key_new (const Query *q)
+{
+	gsize name_len = strlen (q->name);
+	guint8 *key;
+
+	/* the flags that change the content of the answer */
+	key = g_malloc (5 + name_len);
+	key[0] =   (NM_FLAGS_HAS (q->flags, DNS_FLAG_RD) ? 0x1 : 0)
+	         | (NM_FLAGS_HAS (q->flags, DNS_FLAG_CD) ? 0x2 : 0)
+	         | (q->dnssec_ok ? 0x4 : 0);
+	put16 (&key[1], q->qtype);
+	put16 (&key[3], q->qclass);
+	memcpy (&key[5], q->name, name_len);
+	return g_bytes_new_take (key, 5 + name_len);
+}
+
+/*******************************************/
+
+static void
+send_to_client (NMDnsForwarder *self,
+                guint8 *msg,
+                gsize len,
+                guint16 id,
+                const SockAddr *client,
+                socklen_t client_len)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+
+	put16 (&msg[0], id);
+	if (sendto (priv->listen_fd, msg, len, 0, &client->sa, client_len) < 0) {
+		nm_log_dbg (LOGD_DNS, "forwarder: failed to send reply: %s",
+		            g_strerror (errno));
+	}
+}
+
+/* Turns the query in @buf into an empty response, keeping the
+ * question if there is one. Returns the length of the response. */
+static gsize
+error_reply_init (guint8 *buf, gsize question_end, guint rcode)
+{
+	guint16 flags;
+
+	flags = get16 (&buf[2]);
+	flags = (flags & (DNS_FLAG_RD | DNS_FLAG_CD)) | DNS_FLAG_QR | DNS_FLAG_RA | rcode;
+	put16 (&buf[2], flags);
+	put16 (&buf[4], question_end > DNS_HEADER_LEN ? 1 : 0);
+	put16 (&buf[6], 0);
+	put16 (&buf[8], 0);
+	put16 (&buf[10], 0);
+	return MAX (question_end, DNS_HEADER_LEN);
+}
+
+static void
+send_error (NMDnsForwarder *self,
+            guint8 *buf,
+            gsize question_end,
+            guint rcode,
+            const SockAddr *client,
+            socklen_t client_len)
+{
+	gsize len;
+
+	len = error_reply_init (buf, question_end, rcode);
+	send_to_client (self, buf, len, get16 (&buf[0]), client, client_len);
+}
+
+static void
+pending_close_socket (Pending *p)
+{
+	nm_clear_g_source (&p->watch_id);
+	nm_clear_g_source (&p->timeout_id);
+	g_clear_pointer (&p->channel, g_io_channel_unref);
+	if (p->fd >= 0) {
+		close (p->fd);
+		p->fd = -1;
+	}
+}
+
+static void
+pending_free (Pending *p)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (p->self);
+
+	g_hash_table_remove (priv->pending, p);
+	pending_close_socket (p);
+	route_unref (p->route);
+	if (p->key)
+		g_bytes_unref (p->key);
+	g_free (p->query);
+	g_slice_free (Pending, p);
+}
+
+static gboolean pending_send (Pending *p);
+
+static void
+pending_fail (Pending *p)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (p->self);
+
+	if (pending_send (p))
+		return;
+
+	nm_log_dbg (LOGD_DNS, "forwarder: no server answered");
+	memcpy (priv->buf, p->query, p->question_end);
+	put16 (&priv->buf[0], p->client_id);
+	send_error (p->self, priv->buf, p->question_end, DNS_RCODE_SERVFAIL, &p->client, p->client_len);
+	pending_free (p);
+}
+
+static gboolean
+pending_timeout_cb (gpointer user_data)
+{
+	Pending *p = user_data;
+
+	p->timeout_id = 0;
+	pending_fail (p);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+pending_reply_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	Pending *p = user_data;
+	NMDnsForwarder *self = p->self;
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	guint16 flags;
+	ssize_t len;
+	guint i;
+
+	for (i = 0; i < MAX_READS_PER_WAKEUP; i++) {
+		/* The socket is connected, so everything we get is from
+		 * the server we sent the query to. */
+		len = recv (p->fd, priv->buf, DNS_MAX_MSG_LEN, 0);
+		if (len < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return G_SOURCE_CONTINUE;
+			if (errno == EINTR)
+				continue;
+
+			/* e.g. ECONNREFUSED */
+			nm_log_dbg (LOGD_DNS, "forwarder: server failed: %s", g_strerror (errno));
+			p->watch_id = 0;
+			pending_fail (p);
+			return G_SOURCE_REMOVE;
+		}
+
+		if (   (gsize) len < p->question_end
+		    || get16 (&priv->buf[0]) != get16 (&p->query[0])
+		    || !NM_FLAGS_HAS (get16 (&priv->buf[2]), DNS_FLAG_QR)
+		    || get16 (&priv->buf[4]) != 1
+		    || memcmp (&priv->buf[DNS_HEADER_LEN],
+		               &p->query[DNS_HEADER_LEN],
+		               p->question_end - DNS_HEADER_LEN) != 0)
+			continue;
+
+		flags = get16 (&priv->buf[2]);
+		if (   DNS_FLAGS_RCODE (flags) == DNS_RCODE_SERVFAIL
+		    || DNS_FLAGS_RCODE (flags) == DNS_RCODE_REFUSED) {
+			p->watch_id = 0;
+			pending_fail (p);
+			return G_SOURCE_REMOVE;
+		}
+
+		p->route->preferred = p->server_idx;
+		if (p->key)
+			cache_add (self, p->key, priv->buf, len, p->route);
+		send_to_client (self, priv->buf, len, p->client_id, &p->client, p->client_len);
+
+		p->watch_id = 0;
+		pending_free (p);
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+pending_send (Pending *p)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (p->self);
+	GArray *servers = p->route->servers;
+	const Server *server;
+
+	pending_close_socket (p);
+
+	while (p->tries < servers->len) {
+		p->server_idx = (p->route->preferred + p->tries) % servers->len;
+		p->tries++;
+		server = &g_array_index (servers, Server, p->server_idx);
+
+		/* A new socket for each query gives each one a random source
+		 * port, and the kernel drops datagrams from other sources. */
+		p->fd = socket (server->addr.sa.sa_family, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+		if (p->fd < 0) {
+			nm_log_warn (LOGD_DNS, "forwarder: cannot create socket: %s", g_strerror (errno));
+			return FALSE;
+		}
+
+		put16 (&p->query[0], g_rand_int_range (priv->rand, 0, 0x10000));
+		if (   connect (p->fd, &server->addr.sa, server->addr_len) < 0
+		    || send (p->fd, p->query, p->query_len, 0) < 0) {
+			nm_log_dbg (LOGD_DNS, "forwarder: cannot send query: %s", g_strerror (errno));
+			close (p->fd);
+			p->fd = -1;
+			continue;
+		}
+
+		p->channel = g_io_channel_unix_new (p->fd);
+		p->watch_id = g_io_add_watch (p->channel, G_IO_IN | G_IO_ERR | G_IO_HUP, pending_reply_cb, p);
+		p->timeout_id = g_timeout_add (QUERY_TIMEOUT_MS, pending_timeout_cb, p);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void
+handle_query (NMDnsForwarder *self, gsize len, const SockAddr *client, socklen_t client_len)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	guint8 *buf = priv->buf;
+	Query q;
+	Route *route;
+	CacheEntry *entry;
+	gs_unref_bytes GBytes *key = NULL;
+	Pending *p;
+	gint32 now;
+
+	if (len < DNS_HEADER_LEN || NM_FLAGS_HAS (get16 (&buf[2]), DNS_FLAG_QR))
+		return;
+
+	if (!parse_query (buf, len, &q)) {
+		send_error (self, buf, DNS_HEADER_LEN, DNS_RCODE_FORMERR, client, client_len);
+		return;
+	}
+
+	route = route_lookup (self, q.name);
+	if (!route || !route->servers->len) {
+		send_error (self, buf, q.question_end, DNS_RCODE_REFUSED, client, client_len);
+		return;
+	}
+
+	key = cache_key_new (&q);
+	now = nm_utils_get_monotonic_timestamp_s ();
+	entry = cache_lookup (self, key, route, now);
+	if (entry && entry->reply_len <= q.max_reply_len) {
+		memcpy (buf, entry->reply, entry->reply_len);
+		reply_age_ttls (buf, entry->reply_len, now - entry->added_at, NULL);
+		send_to_client (self, buf, entry->reply_len, q.id, client, client_len);
+		return;
+	}
+
+	if (g_hash_table_size (priv->pending) >= MAX_PENDING) {
+		nm_log_dbg (LOGD_DNS, "forwarder: too many pending queries");
+		return;
+	}
+
+	p = g_slice_new0 (Pending);
+	p->self = self;
+	p->fd = -1;
+	p->route = route_ref (route);
+	p->key = key;
+	key = NULL;
+	p->query = g_memdup (buf, len);
+	p->query_len = len;
+	p->question_end = q.question_end;
+	p->client_id = q.id;
+	p->client = *client;
+	p->client_len = client_len;
+	g_hash_table_add (priv->pending, p);
+
+	if (!pending_send (p)) {
+		send_error (self, buf, q.question_end, DNS_RCODE_SERVFAIL, client, client_len);
+		pending_free (p);
+	}
+}
+
+static gboolean
+listen_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	NMDnsForwarder *self = user_data;
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	SockAddr client;
+	socklen_t client_len;
+	ssize_t len;
+	guint i;
+
+	for (i = 0; i < MAX_READS_PER_WAKEUP; i++) {
+		client_len = sizeof (client);
+		len = recvfrom (priv->listen_fd, priv->buf, DNS_MAX_MSG_LEN, 0, &client.sa, &client_len);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				nm_log_dbg (LOGD_DNS, "forwarder: receive failed: %s", g_strerror (errno));
+			break;
+		}
+		handle_query (self, len, &client, client_len);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/*******************************************/
+
+static void
+tcp_forward_done (TcpRequest *r)
+{
+	g_clear_object (&r->upstream);
+	g_clear_pointer (&r->route, route_unref);
+	g_clear_pointer (&r->query, g_free);
+}
+
+static void
+tcp_request_free (TcpRequest *r)
+{
+	if (!g_cancellable_is_cancelled (r->cancellable))
+		NM_DNS_FORWARDER_GET_PRIVATE (r->self)->tcp_clients--;
+	tcp_forward_done (r);
+	g_clear_object (&r->client);
+	g_object_unref (r->cancellable);
+	g_free (r->buf);
+	g_slice_free (TcpRequest, r);
+}
+
+static void tcp_read_cb (GObject *source, GAsyncResult *result, gpointer user_data);
+static void tcp_write_cb (GObject *source, GAsyncResult *result, gpointer user_data);
+
+/* Reads one length-prefixed message into @r->buf. The buffer only grows
+ * to the size announced by the prefix. */
+static void
+tcp_read_message (TcpRequest *r, GSocketConnection *from)
+{
+	r->buf = g_realloc (r->buf, 2);
+	r->len = 2;
+	r->done = 0;
+	g_input_stream_read_async (g_io_stream_get_input_stream (G_IO_STREAM (from)),
+	                           r->buf, r->len,
+	                           G_PRIORITY_DEFAULT, r->cancellable,
+	                           tcp_read_cb, r);
+}
+
+static void
+tcp_write_message (TcpRequest *r, GSocketConnection *to)
+{
+	r->done = 0;
+	g_output_stream_write_async (g_io_stream_get_output_stream (G_IO_STREAM (to)),
+	                             r->buf, r->len,
+	                             G_PRIORITY_DEFAULT, r->cancellable,
+	                             tcp_write_cb, r);
+}
+
+static void
+tcp_connect_cb (GObject *source, GAsyncResult *result, gpointer user_data);
+
+/* Sends the query to the next server of the route, like pending_send()
+ * does for UDP. When all servers failed, answers with SERVFAIL. */
+static void
+tcp_forward_next (TcpRequest *r)
+{
+	GSocketClient *client;
+	GSocketAddress *address;
+	const Server *server;
+	GArray *servers = r->route->servers;
+
+	g_clear_object (&r->upstream);
+
+	if (r->tries >= servers->len) {
+		nm_log_dbg (LOGD_DNS, "forwarder: no server answered");
+		r->buf = g_realloc (r->buf, 2 + MAX (r->question_end, DNS_HEADER_LEN));
+		memcpy (r->buf, r->query, 2 + r->question_end);
+		r->len = error_reply_init (&r->buf[2], r->question_end, DNS_RCODE_SERVFAIL);
+		put16 (r->buf, r->len);
+		r->len += 2;
+		tcp_write_message (r, r->client);
+		return;
+	}
+
+	r->server_idx = (r->route->preferred + r->tries) % servers->len;
+	r->tries++;
+	server = &g_array_index (servers, Server, r->server_idx);
+	address = g_socket_address_new_from_native ((gpointer) &server->addr, server->addr_len);
+
+	client = g_socket_client_new ();
+	g_socket_client_set_timeout (client, QUERY_TIMEOUT_MS / 1000);
+	g_socket_client_connect_async (client, G_SOCKET_CONNECTABLE (address),
+	                               r->cancellable, tcp_connect_cb, r);
+	g_object_unref (client);
+	g_object_unref (address);
+}
+
+/* The upstream server failed, or didn't answer in time. */
+static void
+tcp_upstream_failed (TcpRequest *r, GError *error)
+{
+	if (g_cancellable_is_cancelled (r->cancellable)) {
+		tcp_request_free (r);
+		return;
+	}
+	nm_log_dbg (LOGD_DNS, "forwarder: server failed: %s", error ? error->message : "closed connection");
+	tcp_forward_next (r);
+}
+
+static void
+tcp_connect_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	TcpRequest *r = user_data;
+	GError *error = NULL;
+
+	r->upstream = g_socket_client_connect_finish (G_SOCKET_CLIENT (source), result, &error);
+	if (!r->upstream || g_cancellable_is_cancelled (r->cancellable)) {
+		tcp_upstream_failed (r, error);
+		g_clear_error (&error);
+		return;
+	}
+
+	/* g_socket_client_set_timeout() only applies to connecting. A server
+	 * that doesn't answer fails the pending read with G_IO_ERROR_TIMED_OUT. */
+	g_socket_set_timeout (g_socket_connection_get_socket (r->upstream), QUERY_TIMEOUT_MS / 1000);
+
+	r->buf = g_realloc (r->buf, r->query_len);
+	memcpy (r->buf, r->query, r->query_len);
+	r->len = r->query_len;
+	tcp_write_message (r, r->upstream);
+}
+
+static void
+tcp_forward_query (TcpRequest *r)
+{
+	Route *route;
+	Query q;
+
+	if (   !parse_query (&r->buf[2], r->len - 2, &q)
+	    || !(route = route_lookup (r->self, q.name))
+	    || !route->servers->len) {
+		tcp_request_free (r);
+		return;
+	}
+
+	/* keep the query to send it again to the next server */
+	r->route = route_ref (route);
+	r->query = g_memdup (r->buf, r->len);
+	r->query_len = r->len;
+	r->question_end = q.question_end;
+	r->tries = 0;
+	tcp_forward_next (r);
+}
+
+static gboolean
+tcp_is_upstream (TcpRequest *r, GObject *stream)
+{
+	return    r->upstream
+	       && (   stream == G_OBJECT (g_io_stream_get_input_stream (G_IO_STREAM (r->upstream)))
+	           || stream == G_OBJECT (g_io_stream_get_output_stream (G_IO_STREAM (r->upstream))));
+}
+
+static void
+tcp_write_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	TcpRequest *r = user_data;
+	GError *error = NULL;
+	gssize n;
+
+	n = g_output_stream_write_finish (G_OUTPUT_STREAM (source), result, &error);
+	if (n <= 0 || g_cancellable_is_cancelled (r->cancellable)) {
+		if (tcp_is_upstream (r, source))
+			tcp_upstream_failed (r, error);
+		else
+			tcp_request_free (r);
+		g_clear_error (&error);
+		return;
+	}
+
+	r->done += n;
+	if (r->done < r->len) {
+		g_output_stream_write_async (G_OUTPUT_STREAM (source),
+		                             &r->buf[r->done], r->len - r->done,
+		                             G_PRIORITY_DEFAULT, r->cancellable,
+		                             tcp_write_cb, r);
+		return;
+	}
+
+	if (tcp_is_upstream (r, source))
+		tcp_read_message (r, r->upstream);
+	else {
+		/* The answer is out. The next query on the connection may be
+		 * for another domain, so it gets routed on its own. */
+		tcp_forward_done (r);
+		tcp_read_message (r, r->client);
+	}
+}
+
+static void
+tcp_read_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	TcpRequest *r = user_data;
+	GError *error = NULL;
+	gssize n;
+
+	n = g_input_stream_read_finish (G_INPUT_STREAM (source), result, &error);
+	if (n <= 0 || g_cancellable_is_cancelled (r->cancellable)) {
+		if (tcp_is_upstream (r, source))
+			tcp_upstream_failed (r, error);
+		else
+			tcp_request_free (r);
+		g_clear_error (&error);
+		return;
+	}
+
+	r->done += n;
+	if (r->done == 2 && r->len == 2) {
+		/* got the length prefix */
+		r->len += get16 (r->buf);
+		if (r->len == 2) {
+			if (tcp_is_upstream (r, source))
+				tcp_upstream_failed (r, NULL);
+			else
+				tcp_request_free (r);
+			return;
+		}
+		r->buf = g_realloc (r->buf, r->len);
+	}
+	if (r->done < r->len) {
+		g_input_stream_read_async (G_INPUT_STREAM (source),
+		                           &r->buf[r->done], r->len - r->done,
+		                           G_PRIORITY_DEFAULT, r->cancellable,
+		                           tcp_read_cb, r);
+		return;
+	}
+
+	if (r->upstream) {
+		r->route->preferred = r->server_idx;
+		g_clear_object (&r->upstream);
+		tcp_write_message (r, r->client);
+	} else
+		tcp_forward_query (r);
+}
+
+static gboolean
+tcp_incoming_cb (GSocketService *service,
+                 GSocketConnection *connection,
+                 GObject *source_object,
+                 gpointer user_data)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (user_data);
+	TcpRequest *r;
+
+	/* Returning without taking a reference closes the connection */
+	if (priv->tcp_clients >= MAX_TCP_CLIENTS) {
+		nm_log_dbg (LOGD_DNS, "forwarder: too many TCP clients");
+		return TRUE;
+	}
+	priv->tcp_clients++;
+
+	/* Idle clients fail the pending read with G_IO_ERROR_TIMED_OUT */
+	g_socket_set_timeout (g_socket_connection_get_socket (connection), TCP_IDLE_TIMEOUT_S);
+
+	r = g_slice_new0 (TcpRequest);
+	r->self = user_data;
+	r->cancellable = g_object_ref (priv->tcp_cancellable);
+	r->client = g_object_ref (connection);
+	tcp_read_message (r, r->client);
+	return TRUE;
+}
+
+/*******************************************/
+
+static void
+stop_listening (NMDnsForwarder *self)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	GList *pending, *iter;
+
+	nm_clear_g_source (&priv->listen_id);
+	g_clear_pointer (&priv->listen_channel, g_io_channel_unref);
+	if (priv->listen_fd >= 0) {
+		close (priv->listen_fd);
+		priv->listen_fd = -1;
+	}
+
+	if (priv->tcp_service) {
+		g_signal_handlers_disconnect_by_func (priv->tcp_service, tcp_incoming_cb, self);
+		g_socket_service_stop (priv->tcp_service);
+		g_socket_listener_close (G_SOCKET_LISTENER (priv->tcp_service));
+		g_clear_object (&priv->tcp_service);
+	}
+	if (priv->tcp_cancellable) {
+		g_cancellable_cancel (priv->tcp_cancellable);
+		g_clear_object (&priv->tcp_cancellable);
+	}
+	priv->tcp_clients = 0;
+
+	pending = g_hash_table_get_keys (priv->pending);
+	for (iter = pending; iter; iter = iter->next)
+		pending_free (iter->data);
+	g_list_free (pending);
+}
+
+static gboolean
+start_listening (NMDnsForwarder *self)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	struct sockaddr_in sin;
+	GSocketAddress *address;
+	GError *error = NULL;
+	int one = 1;
+
+	if (priv->listen_fd >= 0)
+		return TRUE;
+
+	memset (&sin, 0, sizeof (sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons (DNS_PORT);
+	sin.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+	priv->listen_fd = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (priv->listen_fd < 0) {
+		nm_log_warn (LOGD_DNS, "forwarder: cannot create socket: %s", g_strerror (errno));
+		return FALSE;
+	}
+	setsockopt (priv->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one));
+	if (bind (priv->listen_fd, (struct sockaddr *) &sin, sizeof (sin)) < 0) {
+		nm_log_warn (LOGD_DNS, "forwarder: cannot listen on 127.0.0.1:%d: %s",
+		             DNS_PORT, g_strerror (errno));
+		close (priv->listen_fd);
+		priv->listen_fd = -1;
+		return FALSE;
+	}
+
+	priv->listen_channel = g_io_channel_unix_new (priv->listen_fd);
+	priv->listen_id = g_io_add_watch (priv->listen_channel, G_IO_IN, listen_cb, self);
+
+	/* Resolvers retry truncated answers over TCP */
+	priv->tcp_cancellable = g_cancellable_new ();
+	priv->tcp_service = g_socket_service_new ();
+	address = g_socket_address_new_from_native (&sin, sizeof (sin));
+	if (!g_socket_listener_add_address (G_SOCKET_LISTENER (priv->tcp_service), address,
+	                                    G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP,
+	                                    NULL, NULL, &error)) {
+		nm_log_warn (LOGD_DNS, "forwarder: cannot listen on TCP port %d: %s",
+		             DNS_PORT, error->message);
+		g_clear_error (&error);
+		g_clear_object (&priv->tcp_service);
+	} else {
+		g_signal_connect (priv->tcp_service, "incoming", G_CALLBACK (tcp_incoming_cb), self);
+		g_socket_service_start (priv->tcp_service);
+	}
+	g_object_unref (address);
+
+	nm_log_dbg (LOGD_DNS, "forwarder: listening on 127.0.0.1:%d", DNS_PORT);
+	return TRUE;
+}
+
+/*******************************************/
+
+static gboolean
+update (NMDnsPlugin *plugin,
+        const GSList *vpn_configs,
+        const GSList *dev_configs,
+        const GSList *other_configs,
+        const NMGlobalDnsConfig *global_config,
+        const char *hostname)
+{
+	NMDnsForwarder *self = NM_DNS_FORWARDER (plugin);
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	GHashTable *routes;
+	GHashTableIter iter;
+	const char *domain;
+	Route *route, *old;
+
+	if (!start_listening (self))
+		return FALSE;
+
+	routes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) route_unref);
+
+	if (global_config)
+		add_global_config (routes, global_config);
+	else {
+		/* Use split DNS for VPN configs */
+		add_configs (routes, vpn_configs, TRUE);
+		add_configs (routes, dev_configs, FALSE);
+		add_configs (routes, other_configs, FALSE);
+	}
+
+	nm_log_dbg (LOGD_DNS, "forwarder: new DNS routing table:");
+	g_hash_table_iter_init (&iter, routes);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &domain, (gpointer *) &route)) {
+		route_update_hash (route);
+
+		/* keep using the server that worked last */
+		old = priv->routes ? g_hash_table_lookup (priv->routes, domain) : NULL;
+		if (old && old->hash == route->hash)
+			route->preferred = old->preferred;
+
+		nm_log_dbg (LOGD_DNS, "forwarder:   %s: %u server(s)",
+		            domain[0] ? domain : "(default)", route->servers->len);
+	}
+
+	/* Pending queries keep a reference to their route */
+	if (priv->routes)
+		g_hash_table_unref (priv->routes);
+	priv->routes = routes;
+	return TRUE;
+}
+
+static gboolean
+is_caching (NMDnsPlugin *plugin)
+{
+	return TRUE;
+}
+
+static const char *
+get_name (NMDnsPlugin *plugin)
+{
+	return "forwarder";
+}
+
+/****************************************************************/
+
+NMDnsPlugin *
+nm_dns_forwarder_new (void)
+{
+	return g_object_new (NM_TYPE_DNS_FORWARDER, NULL);
+}
+
+static void
+nm_dns_forwarder_init (NMDnsForwarder *self)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+
+	priv->listen_fd = -1;
+	priv->cache = g_hash_table_new (g_bytes_hash, g_bytes_equal);
+	g_queue_init (&priv->cache_lru);
+	priv->pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->rand = g_rand_new ();
+	priv->buf = g_malloc (DNS_MAX_MSG_LEN);
+}
+
+static void
+dispose (GObject *object)
+{
+	NMDnsForwarder *self = NM_DNS_FORWARDER (object);
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+
+	stop_listening (self);
+	cache_clear (self);
+	g_clear_pointer (&priv->routes, g_hash_table_unref);
+
+	G_OBJECT_CLASS (nm_dns_forwarder_parent_class)->dispose (object);
+}
+
+static void
+finalize (GObject *object)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (object);
+
+	g_hash_table_unref (priv->cache);
+	g_hash_table_unref (priv->pending);
+	g_rand_free (priv->rand);
+	g_free (priv->buf);
+
+	G_OBJECT_CLASS (nm_dns_forwarder_parent_class)->finalize (object);
+}
+
+static void
+nm_dns_forwarder_class_init (NMDnsForwarderClass *klass)
+{
+	NMDnsPluginClass *plugin_class = NM_DNS_PLUGIN_CLASS (klass);
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (NMDnsForwarderPrivate));
+
+	object_class->dispose = dispose;
+	object_class->finalize = finalize;
+
+	plugin_class->is_caching = is_caching;
+	plugin_class->update = update;
+	plugin_class->get_name = get_name;
+}
@@ -46,6 +46,7 @@
 
 #include "nm-dns-plugin.h"
 #include "nm-dns-dnsmasq.h"
+#include "nm-dns-forwarder.h"
 #include "nm-dns-unbound.h"
 
 #if WITH_LIBSOUP
@@ -70,6 +71,10 @@ G_DEFINE_TYPE (NMDnsManager, nm_dns_manager, G_TYPE_OBJECT)
 
 #define HASH_LEN 20
 
+/* Changes are committed on idle. Further changes within this interval after
+ * a commit are coalesced and committed together at the end of it. */
+#define UPDATE_RATELIMIT_MS 1000
+
 #ifdef RESOLVCONF_PATH
 #define RESOLVCONF_SELECTED
 #else
@@ -120,6 +125,9 @@ typedef struct {
 	char *hostname;
 	guint updates_queue;
 
+	guint update_id;
+	gint64 last_update_ms;
+
 	guint8 hash[HASH_LEN];  /* SHA1 hash of current DNS config */
 	guint8 prev_hash[HASH_LEN];  /* Hash when begin_updates() was called */
 
@@ -666,6 +674,27 @@ update_resolv_conf (NMDnsManager *self,
 	return SR_SUCCESS;
 }
 
+static void
+hash_config (GChecksum *sum, gpointer config)
+{
+	const char *iface;
+
+	/* the per-config digests are cached by the configs, so that only
+	 * configs that changed get hashed again. */
+	if (NM_IS_IP4_CONFIG (config)) {
+		g_checksum_update (sum, nm_ip4_config_get_dns_digest (config),
+		                   NM_IP4_CONFIG_DNS_DIGEST_LEN);
+	} else {
+		g_checksum_update (sum, nm_ip6_config_get_dns_digest (config),
+		                   NM_IP6_CONFIG_DNS_DIGEST_LEN);
+	}
+
+	/* plugins use the interface name for split DNS */
+	iface = g_object_get_data (G_OBJECT (config), IP_CONFIG_IFACE_TAG);
+	if (iface)
+		g_checksum_update (sum, (const guint8 *) iface, strlen (iface) + 1);
+}
+
 static void
 compute_hash (NMDnsManager *self, const NMGlobalDnsConfig *global, guint8 buffer[HASH_LEN])
 {
@@ -681,29 +710,30 @@ compute_hash (NMDnsManager *self, const NMGlobalDnsConfig *global, guint8 buffer
 		nm_global_dns_config_update_checksum (global, sum);
 
 	if (priv->ip4_vpn_config)
-		nm_ip4_config_hash (priv->ip4_vpn_config, sum, TRUE);
+		hash_config (sum, priv->ip4_vpn_config);
 	if (priv->ip4_device_config)
-		nm_ip4_config_hash (priv->ip4_device_config, sum, TRUE);
+		hash_config (sum, priv->ip4_device_config);
 
 	if (priv->ip6_vpn_config)
-		nm_ip6_config_hash (priv->ip6_vpn_config, sum, TRUE);
+		hash_config (sum, priv->ip6_vpn_config);
 	if (priv->ip6_device_config)
-		nm_ip6_config_hash (priv->ip6_device_config, sum, TRUE);
+		hash_config (sum, priv->ip6_device_config);
 
 	/* add any other configs we know about */
 	for (iter = priv->configs; iter; iter = g_slist_next (iter)) {
 		if (   (iter->data == priv->ip4_vpn_config)
-		    && (iter->data == priv->ip4_device_config)
-		    && (iter->data == priv->ip6_vpn_config)
-		    && (iter->data == priv->ip6_device_config))
+		    || (iter->data == priv->ip4_device_config)
+		    || (iter->data == priv->ip6_vpn_config)
+		    || (iter->data == priv->ip6_device_config))
 			continue;
 
-		if (NM_IS_IP4_CONFIG (iter->data))
-			nm_ip4_config_hash (NM_IP4_CONFIG (iter->data), sum, TRUE);
-		else if (NM_IS_IP6_CONFIG (iter->data))
-			nm_ip6_config_hash (NM_IP6_CONFIG (iter->data), sum, TRUE);
+		hash_config (sum, iter->data);
 	}
 
+	/* the domain of the hostname ends up in the searches */
+	if (priv->hostname)
+		g_checksum_update (sum, (const guint8 *) priv->hostname, strlen (priv->hostname));
+
 	g_checksum_get_digest (sum, buffer, &len);
 	g_checksum_free (sum);
 }
@@ -800,6 +830,10 @@ update_dns (NMDnsManager *self,
 
 	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 
+	/* this commits whatever was scheduled */
+	nm_clear_g_source (&priv->update_id);
+	priv->last_update_ms = nm_utils_get_monotonic_timestamp_ms ();
+
 	if (priv->resolv_conf_mode == NM_DNS_MANAGER_RESOLV_CONF_UNMANAGED) {
 		update = FALSE;
 		_LOGD ("update-dns: not updating resolv.conf");
@@ -1002,9 +1036,59 @@ update_dns (NMDnsManager *self,
 	if (nis_servers)
 		g_strfreev (nis_servers);
 
+	if (update && result != SR_SUCCESS) {
+		/* forget the hash, so that the next change retries. */
+		memset (priv->hash, 0, sizeof (priv->hash));
+	}
+
 	return !update || result == SR_SUCCESS;
 }
 
+static gboolean
+update_dns_cb (gpointer user_data)
+{
+	NMDnsManager *self = user_data;
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	GError *error = NULL;
+	guint8 new[HASH_LEN];
+
+	priv->update_id = 0;
+
+	/* a batch started meanwhile. end_updates() commits it. */
+	if (priv->updates_queue)
+		return G_SOURCE_REMOVE;
+
+	compute_hash (self, nm_config_data_get_global_dns_config (nm_config_get_data (priv->config)), new);
+	if (memcmp (new, priv->hash, sizeof (new)) == 0) {
+		_LOGD ("update-dns: DNS configuration did not change");
+		return G_SOURCE_REMOVE;
+	}
+
+	if (!update_dns (self, FALSE, &error)) {
+		_LOGW ("could not commit DNS changes: %s", error->message);
+		g_clear_error (&error);
+	}
+	return G_SOURCE_REMOVE;
+}
+
+static void
+schedule_update_dns (NMDnsManager *self)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	gint64 elapsed;
+
+	if (priv->update_id)
+		return;
+
+	elapsed = nm_utils_get_monotonic_timestamp_ms () - priv->last_update_ms;
+	if (!priv->last_update_ms || elapsed >= UPDATE_RATELIMIT_MS)
+		priv->update_id = g_idle_add (update_dns_cb, self);
+	else {
+		_LOGD ("update-dns: rate limited, commit in %u ms", (guint) (UPDATE_RATELIMIT_MS - elapsed));
+		priv->update_id = g_timeout_add (UPDATE_RATELIMIT_MS - elapsed, update_dns_cb, self);
+	}
+}
+
 static void
 plugin_failed (NMDnsPlugin *plugin, gpointer user_data)
 {
@@ -1045,7 +1129,6 @@ nm_dns_manager_add_ip4_config (NMDnsManager *self,
                                NMDnsIPConfigType cfg_type)
 {
 	NMDnsManagerPrivate *priv;
-	GError *error = NULL;
 
 	g_return_val_if_fail (self != NULL, FALSE);
 	g_return_val_if_fail (config != NULL, FALSE);
@@ -1069,10 +1152,8 @@ nm_dns_manager_add_ip4_config (NMDnsManager *self,
 	if (!g_slist_find (priv->configs, config))
 		priv->configs = g_slist_append (priv->configs, g_object_ref (config));
 
-	if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	if (!priv->updates_queue)
+		schedule_update_dns (self);
 
 	return TRUE;
 }
@@ -1081,7 +1162,6 @@ gboolean
 nm_dns_manager_remove_ip4_config (NMDnsManager *self, NMIP4Config *config)
 {
 	NMDnsManagerPrivate *priv;
-	GError *error = NULL;
 
 	g_return_val_if_fail (self != NULL, FALSE);
 	g_return_val_if_fail (config != NULL, FALSE);
@@ -1101,10 +1181,8 @@ nm_dns_manager_remove_ip4_config (NMDnsManager *self, NMIP4Config *config)
 
 	g_object_unref (config);
 
-	if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	if (!priv->updates_queue)
+		schedule_update_dns (self);
 
 	g_object_set_data (G_OBJECT (config), IP_CONFIG_IFACE_TAG, NULL);
 
@@ -1118,7 +1196,6 @@ nm_dns_manager_add_ip6_config (NMDnsManager *self,
                                NMDnsIPConfigType cfg_type)
 {
 	NMDnsManagerPrivate *priv;
-	GError *error = NULL;
 
 	g_return_val_if_fail (self != NULL, FALSE);
 	g_return_val_if_fail (config != NULL, FALSE);
@@ -1142,10 +1219,8 @@ nm_dns_manager_add_ip6_config (NMDnsManager *self,
 	if (!g_slist_find (priv->configs, config))
 		priv->configs = g_slist_append (priv->configs, g_object_ref (config));
 
-	if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	if (!priv->updates_queue)
+		schedule_update_dns (self);
 
 	return TRUE;
 }
@@ -1154,7 +1229,6 @@ gboolean
 nm_dns_manager_remove_ip6_config (NMDnsManager *self, NMIP6Config *config)
 {
 	NMDnsManagerPrivate *priv;
-	GError *error = NULL;
 
 	g_return_val_if_fail (self != NULL, FALSE);
 	g_return_val_if_fail (config != NULL, FALSE);
@@ -1174,10 +1248,8 @@ nm_dns_manager_remove_ip6_config (NMDnsManager *self, NMIP6Config *config)
 
 	g_object_unref (config);
 
-	if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	if (!priv->updates_queue)
+		schedule_update_dns (self);
 
 	g_object_set_data (G_OBJECT (config), IP_CONFIG_IFACE_TAG, NULL);
 
@@ -1198,7 +1270,6 @@ nm_dns_manager_set_hostname (NMDnsManager *self,
                              const char *hostname)
 {
 	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
-	GError *error = NULL;
 	const char *filtered = NULL;
 
 	/* Certain hostnames we don't want to include in resolv.conf 'searches' */
@@ -1216,10 +1287,8 @@ nm_dns_manager_set_hostname (NMDnsManager *self,
 	g_free (priv->hostname);
 	priv->hostname = g_strdup (filtered);
 
-	if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	if (!priv->updates_queue)
+		schedule_update_dns (self);
 }
 
 NMDnsManagerResolvConfMode
@@ -1249,7 +1318,6 @@ void
 nm_dns_manager_end_updates (NMDnsManager *self, const char *func)
 {
 	NMDnsManagerPrivate *priv;
-	GError *error = NULL;
 	gboolean changed;
 	guint8 new[HASH_LEN];
 
@@ -1270,10 +1338,7 @@ nm_dns_manager_end_updates (NMDnsManager *self, const char *func)
 
 	/* Commit all the outstanding changes */
 	_LOGD ("(%s): committing DNS changes (%d)", func, priv->updates_queue);
-	if (!update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	schedule_update_dns (self);
 
 	memset (priv->prev_hash, 0, sizeof (priv->prev_hash));
 }
@@ -1316,6 +1381,9 @@ init_resolv_conf_mode (NMDnsManager *self)
 	} else if (!g_strcmp0 (mode, "unbound")) {
 		priv->resolv_conf_mode = NM_DNS_MANAGER_RESOLV_CONF_PROXY;
 		priv->plugin = nm_dns_unbound_new ();
+	} else if (!g_strcmp0 (mode, "forwarder")) {
+		priv->resolv_conf_mode = NM_DNS_MANAGER_RESOLV_CONF_PROXY;
+		priv->plugin = nm_dns_forwarder_new ();
 	} else {
 		priv->resolv_conf_mode = NM_DNS_MANAGER_RESOLV_CONF_EXPLICIT;
 		if (mode && g_strcmp0 (mode, "default") != 0) {
@@ -1427,9 +1495,13 @@ dispose (GObject *object)
 	NMDnsManager *self = NM_DNS_MANAGER (object);
 	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 	GError *error = NULL;
+	gboolean update_pending;
 
 	_LOGT ("disposing");
 
+	/* a scheduled update is committed below, together with the final one. */
+	update_pending = nm_clear_g_source (&priv->update_id);
+
 	if (priv->plugin) {
 		g_signal_handlers_disconnect_by_func (priv->plugin, plugin_failed, self);
 		g_signal_handlers_disconnect_by_func (priv->plugin, plugin_child_quit, self);
@@ -1441,7 +1513,8 @@ dispose (GObject *object)
 	 * DNS after disposing of all plugins.  But if we haven't done any
 	 * DNS updates yet, there's no reason to touch resolv.conf on shutdown.
 	 */
-	if (priv->dns_touched && !update_dns (self, TRUE, &error)) {
+	if (   (priv->dns_touched || update_pending)
+	    && !update_dns (self, TRUE, &error)) {
 		_LOGW ("could not commit DNS changes on shutdown: %s", error->message);
 		g_clear_error (&error);
 		priv->dns_touched = FALSE;
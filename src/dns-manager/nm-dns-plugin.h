@@ -113,5 +113,8 @@ GPid nm_dns_plugin_child_spawn (NMDnsPlugin *self,
 
 gboolean nm_dns_plugin_child_kill (NMDnsPlugin *self);
 
+/* Returns the PID of the running child, or 0 */
+GPid nm_dns_plugin_child_get_pid (NMDnsPlugin *self);
+
 #endif /* __NETWORKMANAGER_DNS_PLUGIN_H__ */
 
@@ -0,0 +1,682 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include "nm-dns-forwarder.c"
+
+#include "nm-test-utils.h"
+
+#define TYPE_A   1
+#define CLASS_IN 1
+
+static void
+_append16 (GByteArray *msg, guint16 v)
+{
+	guint8 b[2];
+
+	put16 (b, v);
+	g_byte_array_append (msg, b, 2);
+}
+
+static void
+_append32 (GByteArray *msg, guint32 v)
+{
+	guint8 b[4];
+
+	put32 (b, v);
+	g_byte_array_append (msg, b, 4);
+}
+
+static void
+_append_name (GByteArray *msg, const char *name)
+{
+	gs_strfreev char **labels = g_strsplit (name, ".", -1);
+	guint8 len;
+	guint i;
+
+	for (i = 0; labels[i]; i++) {
+		len = strlen (labels[i]);
+		if (!len)
+			continue;
+		g_byte_array_append (msg, &len, 1);
+		g_byte_array_append (msg, (guint8 *) labels[i], len);
+	}
+	len = 0;
+	g_byte_array_append (msg, &len, 1);
+}
+
+static GByteArray *
+_msg_new (guint16 flags, const char *name, guint16 qtype)
+{
+	GByteArray *msg = g_byte_array_new ();
+
+	_append16 (msg, 0x1234);
+	_append16 (msg, flags);
+	_append16 (msg, 1);
+	_append16 (msg, 0);
+	_append16 (msg, 0);
+	_append16 (msg, 0);
+	_append_name (msg, name);
+	_append16 (msg, qtype);
+	_append16 (msg, CLASS_IN);
+	return msg;
+}
+
+/* @count_offset selects the section: 6 answer, 8 authority, 10 additional */
+static void
+_msg_add_a (GByteArray *msg, guint count_offset, guint32 ttl)
+{
+	/* the owner is a pointer to the question */
+	_append16 (msg, 0xC000 | DNS_HEADER_LEN);
+	_append16 (msg, TYPE_A);
+	_append16 (msg, CLASS_IN);
+	_append32 (msg, ttl);
+	_append16 (msg, 4);
+	_append32 (msg, 0x01020304);
+	put16 (&msg->data[count_offset], get16 (&msg->data[count_offset]) + 1);
+}
+
+static void
+_msg_add_opt (GByteArray *msg, guint16 payload, gboolean dnssec_ok)
+{
+	_append_name (msg, "");
+	_append16 (msg, DNS_TYPE_OPT);
+	_append16 (msg, payload);
+	_append32 (msg, dnssec_ok ? DNS_EDNS_FLAG_DO : 0);
+	_append16 (msg, 0);
+	put16 (&msg->data[10], get16 (&msg->data[10]) + 1);
+}
+
+static guint32
+_rr_ttl (GByteArray *msg, guint idx)
+{
+	gsize pos = DNS_HEADER_LEN;
+	guint i;
+
+	g_assert (skip_name (msg->data, msg->len, &pos));
+	pos += 4;
+	for (i = 0; i < idx; i++) {
+		g_assert (skip_name (msg->data, msg->len, &pos));
+		pos += 10 + get16 (&msg->data[pos + 8]);
+	}
+	g_assert (skip_name (msg->data, msg->len, &pos));
+	return get32 (&msg->data[pos + 4]);
+}
+
+/*******************************************/
+
+static void
+test_skip_name (void)
+{
+	GByteArray *msg = g_byte_array_new ();
+	guint8 buf[2 * DNS_MAX_NAME_LEN];
+	gsize pos;
+	guint i;
+
+	_append_name (msg, "www.example.com");
+	pos = 0;
+	g_assert (skip_name (msg->data, msg->len, &pos));
+	g_assert_cmpint (pos, ==, msg->len);
+
+	/* truncated label or missing terminator */
+	for (i = 0; i < msg->len; i++) {
+		pos = 0;
+		g_assert (!skip_name (msg->data, i, &pos));
+		g_assert_cmpint (pos, ==, 0);
+	}
+
+	/* Pointers are not followed, so a pointer to itself cannot loop */
+	buf[0] = 0xC0;
+	buf[1] = 0x00;
+	pos = 0;
+	g_assert (skip_name (buf, 2, &pos));
+	g_assert_cmpint (pos, ==, 2);
+
+	/* ... and a label followed by a pointer back to it neither */
+	buf[0] = 1;
+	buf[1] = 'a';
+	buf[2] = 0xC0;
+	buf[3] = 0x00;
+	pos = 0;
+	g_assert (skip_name (buf, 4, &pos));
+	g_assert_cmpint (pos, ==, 4);
+
+	/* truncated pointer */
+	pos = 0;
+	g_assert (!skip_name (buf, 3, &pos));
+
+	/* reserved label types */
+	buf[0] = 0x40;
+	pos = 0;
+	g_assert (!skip_name (buf, sizeof (buf), &pos));
+	buf[0] = 0x80;
+	pos = 0;
+	g_assert (!skip_name (buf, sizeof (buf), &pos));
+
+	/* 4 labels of 63 bytes plus terminator: 257 bytes */
+	memset (buf, 'a', sizeof (buf));
+	for (i = 0; i < 4; i++)
+		buf[i * 64] = 63;
+	buf[4 * 64] = 0;
+	pos = 0;
+	g_assert (!skip_name (buf, sizeof (buf), &pos));
+
+	/* 3 labels of 63 and one of 61 bytes: 255 bytes */
+	buf[3 * 64] = 61;
+	buf[3 * 64 + 62] = 0;
+	pos = 0;
+	g_assert (skip_name (buf, sizeof (buf), &pos));
+	g_assert_cmpint (pos, ==, DNS_MAX_NAME_LEN);
+
+	g_byte_array_unref (msg);
+}
+
+static void
+test_parse_query (void)
+{
+	GByteArray *msg;
+	Query q;
+	gsize len;
+
+	msg = _msg_new (DNS_FLAG_RD, "WWW.Example.com.", TYPE_A);
+	g_assert (parse_query (msg->data, msg->len, &q));
+	g_assert_cmpint (q.id, ==, 0x1234);
+	g_assert_cmpstr (q.name, ==, "www.example.com");
+	g_assert_cmpint (q.qtype, ==, TYPE_A);
+	g_assert_cmpint (q.qclass, ==, CLASS_IN);
+	g_assert_cmpint (q.question_end, ==, msg->len);
+	g_assert_cmpint (q.max_reply_len, ==, DNS_MAX_UDP_LEN);
+	g_assert (!q.dnssec_ok);
+
+	/* truncated header or question */
+	for (len = 0; len < msg->len; len++)
+		g_assert (!parse_query (msg->data, len, &q));
+
+	_msg_add_opt (msg, 4096, TRUE);
+	g_assert (parse_query (msg->data, msg->len, &q));
+	g_assert_cmpint (q.max_reply_len, ==, 4096);
+	g_assert (q.dnssec_ok);
+
+	/* truncated additional section */
+	for (len = q.question_end; len < msg->len; len++)
+		g_assert (!parse_query (msg->data, len, &q));
+
+	/* replies and multiple questions are rejected */
+	put16 (&msg->data[2], DNS_FLAG_QR);
+	g_assert (!parse_query (msg->data, msg->len, &q));
+	put16 (&msg->data[2], 0);
+	put16 (&msg->data[4], 2);
+	g_assert (!parse_query (msg->data, msg->len, &q));
+	g_byte_array_unref (msg);
+
+	/* the root */
+	msg = _msg_new (0, "", TYPE_A);
+	g_assert (parse_query (msg->data, msg->len, &q));
+	g_assert_cmpstr (q.name, ==, "");
+	g_byte_array_unref (msg);
+
+	/* a compressed question, pointing to itself */
+	msg = _msg_new (0, "", TYPE_A);
+	g_byte_array_set_size (msg, DNS_HEADER_LEN);
+	_append16 (msg, 0xC000 | DNS_HEADER_LEN);
+	_append16 (msg, TYPE_A);
+	_append16 (msg, CLASS_IN);
+	g_assert (!parse_query (msg->data, msg->len, &q));
+	g_byte_array_unref (msg);
+
+	/* 253 characters is the longest name */
+	msg = _msg_new (0,
+	                "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa."
+	                "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb."
+	                "ccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc."
+	                "ddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddd",
+	                TYPE_A);
+	g_assert (parse_query (msg->data, msg->len, &q));
+	g_assert_cmpint (strlen (q.name), ==, 253);
+	g_byte_array_unref (msg);
+
+	msg = _msg_new (0,
+	                "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa."
+	                "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb."
+	                "ccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc."
+	                "ddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddd",
+	                TYPE_A);
+	g_assert (!parse_query (msg->data, msg->len, &q));
+	g_byte_array_unref (msg);
+
+	/* labels are limited to 63 bytes */
+	msg = _msg_new (0,
+	                "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.com",
+	                TYPE_A);
+	g_assert (!parse_query (msg->data, msg->len, &q));
+	g_byte_array_unref (msg);
+}
+
+static void
+test_reply_age_ttls (void)
+{
+	GByteArray *msg;
+	guint32 ttl;
+	gsize len;
+
+	msg = _msg_new (DNS_FLAG_QR, "example.com", TYPE_A);
+
+	/* no records, no TTL */
+	g_assert (reply_age_ttls (msg->data, msg->len, 0, &ttl));
+	g_assert_cmpint (ttl, ==, G_MAXUINT32);
+
+	_msg_add_a (msg, 6, 300);
+	_msg_add_a (msg, 6, 60);
+	_msg_add_opt (msg, 4096, TRUE);
+
+	g_assert (reply_age_ttls (msg->data, msg->len, 0, &ttl));
+	g_assert_cmpint (ttl, ==, 60);
+	g_assert_cmpint (_rr_ttl (msg, 0), ==, 300);
+	g_assert_cmpint (_rr_ttl (msg, 1), ==, 60);
+
+	g_assert (reply_age_ttls (msg->data, msg->len, 30, &ttl));
+	g_assert_cmpint (ttl, ==, 30);
+	g_assert_cmpint (_rr_ttl (msg, 0), ==, 270);
+	g_assert_cmpint (_rr_ttl (msg, 1), ==, 30);
+	/* the flags in the OPT record are left alone */
+	g_assert_cmpint (_rr_ttl (msg, 2), ==, DNS_EDNS_FLAG_DO);
+
+	/* TTLs don't wrap */
+	g_assert (reply_age_ttls (msg->data, msg->len, 100, &ttl));
+	g_assert_cmpint (ttl, ==, 0);
+	g_assert_cmpint (_rr_ttl (msg, 0), ==, 170);
+	g_assert_cmpint (_rr_ttl (msg, 1), ==, 0);
+
+	/* truncated records */
+	for (len = DNS_HEADER_LEN; len < msg->len; len++)
+		g_assert (!reply_age_ttls (msg->data, len, 0, NULL));
+	g_byte_array_unref (msg);
+
+	/* TTLs with the highest bit set count as zero */
+	msg = _msg_new (DNS_FLAG_QR, "example.com", TYPE_A);
+	_msg_add_a (msg, 8, 0x80000000);
+	g_assert (reply_age_ttls (msg->data, msg->len, 0, &ttl));
+	g_assert_cmpint (ttl, ==, 0);
+	g_byte_array_unref (msg);
+}
+
+/*******************************************/
+
+static Route *
+_route_new (const char *server)
+{
+	Route *route = route_new ();
+	Server s;
+
+	g_assert (server_init_from_string (&s, server));
+	g_array_append_val (route->servers, s);
+	route_update_hash (route);
+	return route;
+}
+
+static GBytes *
+_cache_add (NMDnsForwarder *self, const Route *route, const char *name, guint16 flags, guint32 ttl)
+{
+	GByteArray *msg;
+	GBytes *key;
+	Query q;
+
+	msg = _msg_new (0, name, TYPE_A);
+	g_assert (parse_query (msg->data, msg->len, &q));
+	key = cache_key_new (&q);
+
+	put16 (&msg->data[2], DNS_FLAG_QR | flags);
+	if (ttl)
+		_msg_add_a (msg, 6, ttl);
+	cache_add (self, key, msg->data, msg->len, route);
+	g_byte_array_unref (msg);
+	return key;
+}
+
+static void
+test_cache (void)
+{
+	NMDnsForwarder *self = NM_DNS_FORWARDER (nm_dns_forwarder_new ());
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	Route *route, *other;
+	CacheEntry *entry;
+	GBytes *key;
+	gint32 now;
+
+	route = _route_new ("192.0.2.1");
+	other = _route_new ("192.0.2.2");
+	g_assert_cmpint (route->hash, !=, other->hash);
+
+	now = nm_utils_get_monotonic_timestamp_s ();
+	key = _cache_add (self, route, "example.com", 0, 60);
+	entry = cache_lookup (self, key, route, now);
+	g_assert (entry);
+	g_assert_cmpint (entry->expires_at - entry->added_at, ==, 60);
+	g_assert (cache_lookup (self, key, route, now + 59));
+
+	/* expired */
+	g_assert (!cache_lookup (self, key, route, now + 61));
+	g_assert_cmpint (g_hash_table_size (priv->cache), ==, 0);
+	g_assert_cmpint (priv->cache_lru.length, ==, 0);
+	g_bytes_unref (key);
+
+	/* other servers are responsible for the name now */
+	key = _cache_add (self, route, "example.com", 0, 60);
+	g_assert (!cache_lookup (self, key, other, now));
+	g_assert (!cache_lookup (self, key, route, now));
+	g_bytes_unref (key);
+
+	/* TTLs are capped */
+	key = _cache_add (self, route, "example.com", 0, 7 * 24 * 3600);
+	entry = cache_lookup (self, key, route, now);
+	g_assert (entry);
+	g_assert_cmpint (entry->expires_at - entry->added_at, ==, CACHE_MAX_TTL);
+	g_bytes_unref (key);
+
+	/* adding the same name replaces the entry */
+	key = _cache_add (self, route, "example.com", 0, 30);
+	entry = cache_lookup (self, key, route, now);
+	g_assert (entry);
+	g_assert_cmpint (entry->expires_at - entry->added_at, ==, 30);
+	g_assert_cmpint (g_hash_table_size (priv->cache), ==, 1);
+	g_bytes_unref (key);
+
+	/* not cached: truncated and failed answers, and answers without TTL */
+	key = _cache_add (self, route, "tc.example.com", DNS_FLAG_TC, 60);
+	g_assert (!cache_lookup (self, key, route, now));
+	g_bytes_unref (key);
+	key = _cache_add (self, route, "servfail.example.com", DNS_RCODE_SERVFAIL, 60);
+	g_assert (!cache_lookup (self, key, route, now));
+	g_bytes_unref (key);
+	key = _cache_add (self, route, "empty.example.com", 0, 0);
+	g_assert (!cache_lookup (self, key, route, now));
+	g_bytes_unref (key);
+	g_assert_cmpint (g_hash_table_size (priv->cache), ==, 1);
+
+	route_unref (route);
+	route_unref (other);
+	g_object_unref (self);
+}
+
+static void
+test_cache_eviction (void)
+{
+	NMDnsForwarder *self = NM_DNS_FORWARDER (nm_dns_forwarder_new ());
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	GBytes *keys[CACHE_SIZE + 1];
+	Route *route;
+	gint32 now;
+	guint i;
+
+	route = _route_new ("192.0.2.1");
+	now = nm_utils_get_monotonic_timestamp_s ();
+
+	for (i = 0; i < CACHE_SIZE; i++) {
+		gs_free char *name = g_strdup_printf ("host%u.example.com", i);
+
+		keys[i] = _cache_add (self, route, name, 0, 60);
+	}
+	g_assert_cmpint (g_hash_table_size (priv->cache), ==, CACHE_SIZE);
+
+	/* a hit makes the oldest entry the most recently used one */
+	g_assert (cache_lookup (self, keys[0], route, now));
+
+	keys[CACHE_SIZE] = _cache_add (self, route, "new.example.com", 0, 60);
+	g_assert_cmpint (g_hash_table_size (priv->cache), ==, CACHE_SIZE);
+	g_assert_cmpint (priv->cache_lru.length, ==, CACHE_SIZE);
+	g_assert (!cache_lookup (self, keys[1], route, now));
+	g_assert (cache_lookup (self, keys[0], route, now));
+	g_assert (cache_lookup (self, keys[2], route, now));
+	g_assert (cache_lookup (self, keys[CACHE_SIZE], route, now));
+
+	for (i = 0; i <= CACHE_SIZE; i++)
+		g_bytes_unref (keys[i]);
+	route_unref (route);
+	g_object_unref (self);
+}
+
+/*******************************************/
+
+static guint16
+_listen_loopback (GSocketListener *listener)
+{
+	GInetAddress *lo = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+	GSocketAddress *address = g_inet_socket_address_new (lo, 0);
+	GSocketAddress *effective = NULL;
+	guint16 port;
+
+	g_assert (g_socket_listener_add_address (listener, address, G_SOCKET_TYPE_STREAM,
+	                                         G_SOCKET_PROTOCOL_TCP, NULL, &effective, NULL));
+	port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (effective));
+	g_object_unref (effective);
+	g_object_unref (address);
+	g_object_unref (lo);
+	return port;
+}
+
+static void
+_route_add_port (Route *route, guint16 port)
+{
+	Server s;
+
+	g_assert (server_init_from_string (&s, "127.0.0.1"));
+	s.addr.in.sin_port = htons (port);
+	g_array_append_val (route->servers, s);
+	route_update_hash (route);
+}
+
+static GByteArray *
+_tcp_read (GIOStream *stream)
+{
+	GByteArray *msg = g_byte_array_new ();
+	guint8 prefix[2];
+	gsize n;
+
+	if (   !g_input_stream_read_all (g_io_stream_get_input_stream (stream), prefix, 2, &n, NULL, NULL)
+	    || n != 2) {
+		g_byte_array_unref (msg);
+		return NULL;
+	}
+	g_byte_array_set_size (msg, get16 (prefix));
+	g_assert (g_input_stream_read_all (g_io_stream_get_input_stream (stream), msg->data, msg->len, &n, NULL, NULL));
+	g_assert_cmpint (n, ==, msg->len);
+	return msg;
+}
+
+static void
+_tcp_write (GIOStream *stream, GByteArray *msg)
+{
+	guint8 prefix[2];
+
+	put16 (prefix, msg->len);
+	g_assert (g_output_stream_write_all (g_io_stream_get_output_stream (stream), prefix, 2, NULL, NULL, NULL));
+	g_assert (g_output_stream_write_all (g_io_stream_get_output_stream (stream), msg->data, msg->len, NULL, NULL, NULL));
+}
+
+/* Runs in a thread of the threaded socket service and answers every query */
+static gboolean
+_upstream_run_cb (GThreadedSocketService *service,
+                  GSocketConnection *connection,
+                  GObject *source_object,
+                  gpointer user_data)
+{
+	GByteArray *msg;
+
+	while ((msg = _tcp_read (G_IO_STREAM (connection)))) {
+		put16 (&msg->data[2], get16 (&msg->data[2]) | DNS_FLAG_QR);
+		_msg_add_a (msg, 6, 60);
+		_tcp_write (G_IO_STREAM (connection), msg);
+		g_byte_array_unref (msg);
+	}
+	return TRUE;
+}
+
+typedef struct {
+	guint16 port;
+	guint num_queries;
+	GPtrArray *replies;
+	gboolean done;
+} TcpClient;
+
+static gboolean
+_tcp_client_done (gpointer user_data)
+{
+	((TcpClient *) user_data)->done = TRUE;
+	return G_SOURCE_REMOVE;
+}
+
+/* The forwarder runs on the main loop, so the client blocks in a thread */
+static gpointer
+_tcp_client_thread (gpointer user_data)
+{
+	TcpClient *c = user_data;
+	GSocketClient *client = g_socket_client_new ();
+	GSocketConnection *connection;
+	GByteArray *msg;
+	guint i;
+
+	connection = g_socket_client_connect_to_host (client, "127.0.0.1", c->port, NULL, NULL);
+	g_assert (connection);
+	for (i = 0; i < c->num_queries; i++) {
+		msg = _msg_new (DNS_FLAG_RD, "example.com", TYPE_A);
+		_tcp_write (G_IO_STREAM (connection), msg);
+		g_byte_array_unref (msg);
+		msg = _tcp_read (G_IO_STREAM (connection));
+		g_assert (msg);
+		g_ptr_array_add (c->replies, msg);
+	}
+	g_object_unref (connection);
+	g_object_unref (client);
+
+	g_idle_add (_tcp_client_done, c);
+	return NULL;
+}
+
+/* Starts the TCP side of the forwarder on a loopback port */
+static guint16
+_tcp_listen (NMDnsForwarder *self)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	guint16 port;
+
+	priv->routes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) route_unref);
+	priv->tcp_cancellable = g_cancellable_new ();
+	priv->tcp_service = g_socket_service_new ();
+	port = _listen_loopback (G_SOCKET_LISTENER (priv->tcp_service));
+	g_signal_connect (priv->tcp_service, "incoming", G_CALLBACK (tcp_incoming_cb), self);
+	return port;
+}
+
+static GPtrArray *
+_tcp_query (NMDnsForwarder *self, guint16 port, Route *route, guint num_queries)
+{
+	NMDnsForwarderPrivate *priv = NM_DNS_FORWARDER_GET_PRIVATE (self);
+	TcpClient c = { 0 };
+	GThread *thread;
+
+	g_hash_table_insert (priv->routes, g_strdup (""), route_ref (route));
+
+	c.port = port;
+	c.num_queries = num_queries;
+	c.replies = g_ptr_array_new_with_free_func ((GDestroyNotify) g_byte_array_unref);
+	thread = g_thread_new ("client", _tcp_client_thread, &c);
+	while (!c.done)
+		g_main_context_iteration (NULL, TRUE);
+	g_thread_join (thread);
+	return c.replies;
+}
+
+static void
+test_tcp_failover (void)
+{
+	NMDnsForwarder *self = NM_DNS_FORWARDER (nm_dns_forwarder_new ());
+	GSocketListener *silent;
+	GSocketService *upstream;
+	GPtrArray *replies;
+	GByteArray *msg;
+	Route *route;
+	guint16 port;
+
+	port = _tcp_listen (self);
+
+	/* accepts connections in the kernel, but never answers */
+	silent = g_socket_listener_new ();
+	upstream = g_threaded_socket_service_new (1);
+	g_signal_connect (upstream, "run", G_CALLBACK (_upstream_run_cb), NULL);
+
+	route = route_new ();
+	_route_add_port (route, _listen_loopback (silent));
+	_route_add_port (route, _listen_loopback (G_SOCKET_LISTENER (upstream)));
+
+	/* the first query waits for the silent server to time out, the
+	 * second one goes to the server that answered right away. */
+	replies = _tcp_query (self, port, route, 2);
+	g_assert_cmpint (replies->len, ==, 2);
+	msg = replies->pdata[0];
+	g_assert_cmpint (get16 (&msg->data[2]), ==, DNS_FLAG_QR | DNS_FLAG_RD);
+	g_assert_cmpint (get16 (&msg->data[6]), ==, 1);
+	msg = replies->pdata[1];
+	g_assert_cmpint (get16 (&msg->data[6]), ==, 1);
+	g_assert_cmpint (route->preferred, ==, 1);
+	g_ptr_array_unref (replies);
+	route_unref (route);
+
+	/* no server left: SERVFAIL, with the question */
+	g_socket_listener_close (silent);
+	route = route_new ();
+	_route_add_port (route, _listen_loopback (silent));
+	g_socket_listener_close (silent);
+
+	replies = _tcp_query (self, port, route, 1);
+	g_assert_cmpint (replies->len, ==, 1);
+	msg = replies->pdata[0];
+	g_assert_cmpint (get16 (&msg->data[0]), ==, 0x1234);
+	g_assert_cmpint (get16 (&msg->data[2]), ==, DNS_FLAG_QR | DNS_FLAG_RD | DNS_FLAG_RA | DNS_RCODE_SERVFAIL);
+	g_assert_cmpint (get16 (&msg->data[4]), ==, 1);
+	g_assert_cmpint (get16 (&msg->data[6]), ==, 0);
+	g_ptr_array_unref (replies);
+	route_unref (route);
+
+	g_socket_service_stop (upstream);
+	g_socket_listener_close (G_SOCKET_LISTENER (upstream));
+	g_object_unref (upstream);
+	g_object_unref (silent);
+	g_object_unref (self);
+}
+
+/*******************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "INFO", "DEFAULT");
+
+	g_test_add_func ("/dns-forwarder/skip-name", test_skip_name);
+	g_test_add_func ("/dns-forwarder/parse-query", test_parse_query);
+	g_test_add_func ("/dns-forwarder/reply-age-ttls", test_reply_age_ttls);
+	g_test_add_func ("/dns-forwarder/cache", test_cache);
+	g_test_add_func ("/dns-forwarder/cache-eviction", test_cache_eviction);
+	g_test_add_func ("/dns-forwarder/tcp-failover", test_tcp_failover);
+
+	return g_test_run ();
+}
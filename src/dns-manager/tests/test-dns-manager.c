@@ -0,0 +1,171 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <unistd.h>
+
+#include "nm-dns-manager.c"
+
+#include "nm-test-utils.h"
+
+/*****************************************************************************/
+
+static char *config_file;
+
+/* dns=none keeps the manager away from /etc/resolv.conf. The private copy
+ * goes to NMRUNDIR, which the Makefile points to a nonexistent directory. */
+static void
+_config_setup (void)
+{
+	char *args[] = {
+		"test-dns-manager",
+		"--config", NULL,
+		"--config-dir", "/nonexistent",
+		"--system-config-dir", "/nonexistent",
+		"--intern-config", "/dev/null",
+	};
+	char **argv = args;
+	int argc = G_N_ELEMENTS (args);
+	NMConfigCmdLineOptions *cli;
+	GOptionContext *context;
+	GError *error = NULL;
+	gboolean success;
+	int fd;
+
+	fd = g_file_open_tmp ("test-dns-manager-XXXXXX.conf", &config_file, &error);
+	g_assert_no_error (error);
+	close (fd);
+	success = g_file_set_contents (config_file, "[main]\ndns=none\n", -1, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+	args[2] = config_file;
+
+	cli = nm_config_cmd_line_options_new ();
+	context = g_option_context_new (NULL);
+	nm_config_cmd_line_options_add_to_entries (cli, context);
+	success = g_option_context_parse (context, &argc, &argv, NULL);
+	g_assert (success);
+	g_option_context_free (context);
+
+	nm_config_setup (cli, NULL, &error);
+	g_assert_no_error (error);
+	nm_config_cmd_line_options_free (cli);
+}
+
+static NMIP4Config *
+_ip4_config_new (int ifindex, const char *nameserver)
+{
+	NMIP4Config *config;
+
+	config = nm_ip4_config_new (ifindex);
+	nm_ip4_config_add_nameserver (config, nmtst_inet4_from_string (nameserver));
+	return config;
+}
+
+static void
+_assert_hash (NMDnsManager *self, const guint8 *expected)
+{
+	g_assert (memcmp (NM_DNS_MANAGER_GET_PRIVATE (self)->hash, expected, HASH_LEN) == 0);
+}
+
+static void
+_wait_for_update (NMDnsManager *self)
+{
+	while (NM_DNS_MANAGER_GET_PRIVATE (self)->update_id)
+		g_main_context_iteration (NULL, TRUE);
+}
+
+/*****************************************************************************/
+
+static void
+test_coalesce (void)
+{
+	NMDnsManager *self;
+	NMDnsManagerPrivate *priv;
+	gs_unref_object NMIP4Config *config1 = _ip4_config_new (1, "192.0.2.1");
+	gs_unref_object NMIP4Config *config2 = _ip4_config_new (2, "192.0.2.2");
+	gs_unref_object NMIP4Config *config3 = _ip4_config_new (3, "192.0.2.3");
+	guint8 hash_initial[HASH_LEN];
+	guint8 hash[HASH_LEN];
+	gint64 last_update_ms;
+	guint update_id;
+
+	self = g_object_new (NM_TYPE_DNS_MANAGER, NULL);
+	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	g_assert_cmpint (priv->resolv_conf_mode, ==, NM_DNS_MANAGER_RESOLV_CONF_UNMANAGED);
+	memcpy (hash_initial, priv->hash, HASH_LEN);
+
+	/* changes are not committed synchronously, but scheduled once. */
+	nm_dns_manager_add_ip4_config (self, "eth1", config1, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
+	update_id = priv->update_id;
+	g_assert (update_id);
+	nm_dns_manager_add_ip4_config (self, "eth2", config2, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
+	g_assert_cmpint (priv->update_id, ==, update_id);
+	_assert_hash (self, hash_initial);
+	g_assert_cmpint (priv->last_update_ms, ==, 0);
+
+	compute_hash (self, NULL, hash);
+	_wait_for_update (self);
+	_assert_hash (self, hash);
+	last_update_ms = priv->last_update_ms;
+	g_assert_cmpint (last_update_ms, >, 0);
+
+	/* a change that gets reverted before the (rate limited) commit
+	 * doesn't cause a commit. */
+	nm_dns_manager_add_ip4_config (self, "eth3", config3, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
+	g_assert (priv->update_id);
+	nm_dns_manager_remove_ip4_config (self, config3);
+	_wait_for_update (self);
+	_assert_hash (self, hash);
+	g_assert_cmpint (priv->last_update_ms, ==, last_update_ms);
+
+	/* a pending commit is not lost on dispose. */
+	nm_dns_manager_add_ip4_config (self, "eth3", config3, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
+	g_assert (priv->update_id);
+	compute_hash (self, NULL, hash);
+	g_object_run_dispose (G_OBJECT (self));
+	g_assert (!priv->update_id);
+	_assert_hash (self, hash);
+
+	g_object_unref (self);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	int result;
+
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	_config_setup ();
+
+	g_test_add_func ("/dns-manager/coalesce", test_coalesce);
+
+	result = g_test_run ();
+
+	unlink (config_file);
+	g_free (config_file);
+	return result;
+}
@@ -279,6 +279,7 @@ main (int argc, char *argv[])
 	gboolean wrote_pidfile = FALSE;
 	char *bad_domains = NULL;
 	NMConfigCmdLineOptions *config_cli;
+	gint64 rcvbuf_max;
 
 	nm_g_type_init ();
 
@@ -458,6 +459,14 @@ main (int argc, char *argv[])
 	/* Set up platform interaction layer */
 	nm_linux_platform_setup ();
 
+	rcvbuf_max = _nm_utils_ascii_str_to_int64 (nm_config_data_get_value_cached (NM_CONFIG_GET_DATA_ORIG,
+	                                                                           NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                                           NM_CONFIG_KEYFILE_KEY_NETLINK_RCVBUF_MAX,
+	                                                                           NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY),
+	                                           10, 4096, G_MAXINT, 0);
+	if (rcvbuf_max > 0)
+		nm_platform_netlink_set_rcvbuf_max (NM_PLATFORM_GET, rcvbuf_max);
+
 	NM_UTILS_KEEP_ALIVE (config, NM_PLATFORM_GET, "NMConfig-depends-on-NMPlatform");
 
 	nm_dispatcher_init ();
@@ -176,43 +176,49 @@ typedef struct {
 
 static const VTableIP vtable_ip4, vtable_ip6;
 
-static NMPlatformIPRoute *
-_vt_route_index (const VTableIP *vtable, GArray *routes, guint index)
+/* Returns references to the default routes in the platform cache, which
+ * is cheaper than copying them with route_get_all(). */
+static GPtrArray *
+_vt_routes_lookup_default (const VTableIP *vtable)
 {
-	if (vtable->vt->is_ip4)
-		return (NMPlatformIPRoute *) &g_array_index (routes, NMPlatformIP4Route, index);
-	else
-		return (NMPlatformIPRoute *) &g_array_index (routes, NMPlatformIP6Route, index);
+	return vtable->vt->route_lookup_all (NM_PLATFORM_GET, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
 }
 
 static gboolean
-_vt_routes_has_entry (const VTableIP *vtable, GArray *routes, const Entry *entry)
+_vt_routes_has_entry (const VTableIP *vtable, const GPtrArray *routes, const Entry *entry)
 {
 	guint i;
 	NMPlatformIPXRoute route = entry->route;
 
 	route.rx.metric = entry->effective_metric;
 
-	if (vtable->vt->is_ip4) {
-		for (i = 0; i < routes->len; i++) {
-			NMPlatformIP4Route *r = &g_array_index (routes, NMPlatformIP4Route, i);
-
-			route.rx.source = r->source;
-			if (nm_platform_ip4_route_cmp (r, &route.r4) == 0)
-				return TRUE;
-		}
-	} else {
-		for (i = 0; i < routes->len; i++) {
-			NMPlatformIP6Route *r = &g_array_index (routes, NMPlatformIP6Route, i);
+	for (i = 0; i < routes->len; i++) {
+		const NMPlatformIPXRoute *r = routes->pdata[i];
 
-			route.rx.source = r->source;
-			if (nm_platform_ip6_route_cmp (r, &route.r6) == 0)
-				return TRUE;
-		}
+		route.rx.source = r->rx.source;
+		if (vtable->vt->route_cmp (r, &route) == 0)
+			return TRUE;
 	}
 	return FALSE;
 }
 
+/* Returns the set of ifindexes that have a synced entry. */
+static GHashTable *
+_get_synced_ifindexes (GPtrArray *entries)
+{
+	GHashTable *result;
+	guint i;
+
+	result = g_hash_table_new (NULL, NULL);
+	for (i = 0; i < entries->len; i++) {
+		const Entry *e = g_ptr_array_index (entries, i);
+
+		if (e->synced)
+			g_hash_table_add (result, GINT_TO_POINTER (e->route.rx.ifindex));
+	}
+	return result;
+}
+
 static void
 _entry_free (Entry *entry)
 {
@@ -315,33 +321,42 @@ _platform_route_sync_flush (const VTableIP *vtable, NMDefaultRouteManager *self,
 {
 	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
 	GPtrArray *entries = vtable->get_entries (priv);
-	GArray *routes;
-	guint i, j;
+	gs_unref_ptrarray GPtrArray *routes = NULL;
+	gs_unref_hashtable GHashTable *synced_ifindexes = NULL;
+	gs_unref_hashtable GHashTable *synced_routes = NULL;
+	gs_free gint64 *synced_keys = NULL;
+	guint i;
 	gboolean changed = FALSE;
 
 	/* prune all other default routes from this device. */
-	routes = vtable->vt->route_get_all (NM_PLATFORM_GET, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+	routes = _vt_routes_lookup_default (vtable);
+	if (!routes->len)
+		return FALSE;
+
+	/* index the (ifindex, effective-metric) pairs of the synced default routes,
+	 * so that each platform route can be checked without scanning all entries. */
+	synced_ifindexes = _get_synced_ifindexes (entries);
+	synced_routes = g_hash_table_new (g_int64_hash, g_int64_equal);
+	synced_keys = g_new (gint64, entries->len);
+	for (i = 0; i < entries->len; i++) {
+		const Entry *e = g_ptr_array_index (entries, i);
+
+		if (!e->synced || e->never_default)
+			continue;
+		synced_keys[i] = (((gint64) e->route.rx.ifindex) << 32) | e->effective_metric;
+		g_hash_table_add (synced_routes, &synced_keys[i]);
+	}
 
 	for (i = 0; i < routes->len; i++) {
-		const NMPlatformIPRoute *route;
-		gboolean has_ifindex_synced = FALSE;
-		Entry *entry = NULL;
-
-		route = _vt_route_index (vtable, routes, i);
-
-		/* look at all entries and see if the route for this ifindex pair is
-		 * a known entry. */
-		for (j = 0; j < entries->len; j++) {
-			Entry *e = g_ptr_array_index (entries, j);
-
-			if (   e->route.rx.ifindex == route->ifindex
-			    && e->synced) {
-				has_ifindex_synced = TRUE;
-				if (   !e->never_default
-				    && e->effective_metric == route->metric)
-					entry = e;
-			}
-		}
+		const NMPlatformIPRoute *route = routes->pdata[i];
+		gboolean has_ifindex_synced;
+		gboolean has_entry;
+		gint64 key;
+
+		/* see if the route for this ifindex pair is a known entry. */
+		has_ifindex_synced = g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (route->ifindex));
+		key = (((gint64) route->ifindex) << 32) | route->metric;
+		has_entry = g_hash_table_contains (synced_routes, &key);
 
 		/* we only delete the route if we don't have a matching entry,
 		 * and there is at least one entry that references this ifindex
@@ -350,13 +365,12 @@ _platform_route_sync_flush (const VTableIP *vtable, NMDefaultRouteManager *self,
 		 * Otherwise, don't delete the route because it's configured
 		 * externally (and will be assumed -- or already is assumed).
 		 */
-		if (   !entry
+		if (   !has_entry
 		    && (has_ifindex_synced || ifindex_to_flush == route->ifindex)) {
 			vtable->vt->route_delete_default (NM_PLATFORM_GET, route->ifindex, route->metric);
 			changed = TRUE;
 		}
 	}
-	g_array_free (routes, TRUE);
 	return changed;
 }
 
@@ -402,12 +416,54 @@ _sort_entries_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
 	return 0;
 }
 
+/* The entries are kept sorted by _sort_entries_cmp(). When a single entry
+ * changed, move it to its new position instead of re-sorting the whole
+ * list. The result is the same as a stable sort: the entry keeps its
+ * relative order to entries that compare equal. */
+static void
+_entries_reposition (GPtrArray *entries, guint entry_idx)
+{
+	Entry *entry = g_ptr_array_index (entries, entry_idx);
+	guint lo, hi, l, r, m, idx;
+
+	nm_assert (entry_idx < entries->len);
+
+	memmove (&entries->pdata[entry_idx], &entries->pdata[entry_idx + 1],
+	         (entries->len - entry_idx - 1) * sizeof (gpointer));
+
+	/* find the range [lo, hi) of the remaining entries that compare equal. */
+	l = 0;
+	r = entries->len - 1;
+	while (l < r) {
+		m = (l + r) / 2;
+		if (_sort_entries_cmp (&entries->pdata[m], &entry, NULL) < 0)
+			l = m + 1;
+		else
+			r = m;
+	}
+	lo = l;
+	r = entries->len - 1;
+	while (l < r) {
+		m = (l + r) / 2;
+		if (_sort_entries_cmp (&entries->pdata[m], &entry, NULL) <= 0)
+			l = m + 1;
+		else
+			r = m;
+	}
+	hi = l;
+
+	idx = CLAMP (entry_idx, lo, hi);
+	memmove (&entries->pdata[idx + 1], &entries->pdata[idx],
+	         (entries->len - 1 - idx) * sizeof (gpointer));
+	entries->pdata[idx] = entry;
+}
+
 static GHashTable *
-_get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *self, GArray *routes)
+_get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *self, const GPtrArray *routes, GHashTable *synced_ifindexes)
 {
 	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
 	GPtrArray *entries;
-	guint i, j;
+	guint i;
 	GHashTable *result;
 
 	/* create a list of all metrics that are currently assigned on an interface
@@ -420,22 +476,9 @@ _get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *s
 	result = g_hash_table_new (NULL, NULL);
 
 	for (i = 0; i < routes->len; i++) {
-		gboolean ifindex_has_synced_entry = FALSE;
-		const NMPlatformIPRoute *route;
-
-		route = _vt_route_index (vtable, routes, i);
-
-		for (j = 0; j < entries->len; j++) {
-			Entry *e = g_ptr_array_index (entries, j);
+		const NMPlatformIPRoute *route = routes->pdata[i];
 
-			if (   e->synced
-			    && e->route.rx.ifindex == route->ifindex) {
-				ifindex_has_synced_entry = TRUE;
-				break;
-			}
-		}
-
-		if (!ifindex_has_synced_entry)
+		if (!g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (route->ifindex)))
 			g_hash_table_add (result, GUINT_TO_POINTER (vtable->vt->metric_normalize (route->metric)));
 	}
 
@@ -443,23 +486,12 @@ _get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *s
 	 * we track as non-synced but that are no longer part of platform routes. Anyway, for now
 	 * we still want to treat them as assumed. */
 	for (i = 0; i < entries->len; i++) {
-		gboolean ifindex_has_synced_entry = FALSE;
 		Entry *e_i = g_ptr_array_index (entries, i);
 
 		if (e_i->synced)
 			continue;
 
-		for (j = 0; j < entries->len; j++) {
-			Entry *e_j = g_ptr_array_index (entries, j);
-
-			if (   j != i
-			    && (e_j->synced && e_j->route.rx.ifindex == e_i->route.rx.ifindex)) {
-				ifindex_has_synced_entry = TRUE;
-				break;
-			}
-		}
-
-		if (!ifindex_has_synced_entry)
+		if (!g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (e_i->route.rx.ifindex)))
 			g_hash_table_add (result, GUINT_TO_POINTER (vtable->vt->metric_normalize (e_i->route.rx.metric)));
 	}
 
@@ -488,7 +520,8 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 	GPtrArray *entries;
 	GArray *changed_metrics = g_array_new (FALSE, FALSE, sizeof (guint32));
 	GHashTable *assumed_metrics;
-	GArray *routes;
+	GHashTable *synced_ifindexes;
+	GPtrArray *routes;
 	gboolean changed = FALSE;
 	int ifindex_to_flush = 0;
 
@@ -506,9 +539,10 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 
 	entries = vtable->get_entries (priv);
 
-	routes = vtable->vt->route_get_all (NM_PLATFORM_GET, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+	routes = _vt_routes_lookup_default (vtable);
 
-	assumed_metrics = _get_assumed_interface_metrics (vtable, self, routes);
+	synced_ifindexes = _get_synced_ifindexes (entries);
+	assumed_metrics = _get_assumed_interface_metrics (vtable, self, routes, synced_ifindexes);
 
 	if (old_entry && old_entry->synced && !old_entry->never_default) {
 		/* The old version obviously changed. */
@@ -525,22 +559,11 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 			continue;
 
 		if (!entry->synced) {
-			gboolean has_synced_entry = FALSE;
-
 			/* A non synced entry is completely ignored, if we have
 			 * a synced entry for the same if index.
 			 * Otherwise the metric of the entry is still remembered as
 			 * last_metric to avoid reusing it. */
-			for (j = 0; j < entries->len; j++) {
-				const Entry *e = g_ptr_array_index (entries, j);
-
-				if (   e->synced
-					&& e->route.rx.ifindex == entry->route.rx.ifindex) {
-					has_synced_entry = TRUE;
-					break;
-				}
-			}
-			if (!has_synced_entry)
+			if (!g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (entry->route.rx.ifindex)))
 				last_metric = MAX (last_metric, (gint64) entry->effective_metric);
 			continue;
 		}
@@ -558,7 +581,7 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 
 			/* However, if there is a matching route (ifindex+metric) for our current entry, we are done. */
 			for (j = 0; j < routes->len; j++) {
-				const NMPlatformIPRoute *r = _vt_route_index (vtable, routes, i);
+				const NMPlatformIPRoute *r = routes->pdata[j];
 
 				if (   r->metric == expected_metric
 				    && r->ifindex == entry->route.rx.ifindex) {
@@ -605,7 +628,7 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 		last_metric = expected_metric;
 	}
 
-	g_array_free (routes, TRUE);
+	g_ptr_array_unref (routes);
 
 	g_array_sort (changed_metrics, _sort_metrics_ascending_fcn);
 	last_metric = -1;
@@ -634,6 +657,7 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 
 	g_array_free (changed_metrics, TRUE);
 	g_hash_table_unref (assumed_metrics);
+	g_hash_table_unref (synced_ifindexes);
 
 	priv->resync.guard--;
 	return changed;
@@ -662,7 +686,7 @@ _entry_at_idx_update (const VTableIP *vtable, NMDefaultRouteManager *self, guint
 	        vtable->vt->route_to_string (&entry->route, NULL, 0),
 	        entry->effective_metric);
 
-	g_ptr_array_sort_with_data (entries, _sort_entries_cmp, NULL);
+	_entries_reposition (entries, entry_idx);
 
 	_resync_all (vtable, self, entry, old_entry, FALSE);
 }
@@ -1327,59 +1351,57 @@ _resync_idle_reschedule (NMDefaultRouteManager *self)
 }
 
 static void
-_platform_ipx_route_changed_cb (const VTableIP *vtable,
-                                NMDefaultRouteManager *self,
-                                const NMPlatformIPRoute *route)
+_platform_changes_cb (NMPlatform *platform,
+                      GPtrArray *changes,
+                      NMDefaultRouteManager *self)
 {
-	NMDefaultRouteManagerPrivate *priv;
+	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
+	gboolean has_v4_changes = FALSE;
+	gboolean has_v6_changes = FALSE;
+	guint i;
 
-	if (route && !NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
-		/* we only care about address changes or changes of default route. */
+	if (priv->resync.guard) {
+		/* callbacks while executing _resync_all() are ignored. */
 		return;
 	}
 
-	priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
+	/* we only care about address changes or changes of default route.
+	 * Handle all changes of one platform batch at once, so that we
+	 * reschedule the resync only once. */
+	for (i = 0; i < changes->len; i++) {
+		const NMPlatformChange *change = changes->pdata[i];
+
+		switch (change->obj_type) {
+		case NMP_OBJECT_TYPE_IP4_ADDRESS:
+			has_v4_changes = TRUE;
+			break;
+		case NMP_OBJECT_TYPE_IP6_ADDRESS:
+			has_v6_changes = TRUE;
+			break;
+		case NMP_OBJECT_TYPE_IP4_ROUTE:
+			if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (&change->ip_route))
+				has_v4_changes = TRUE;
+			break;
+		case NMP_OBJECT_TYPE_IP6_ROUTE:
+			if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (&change->ip_route))
+				has_v6_changes = TRUE;
+			break;
+		default:
+			break;
+		}
+	}
 
-	if (priv->resync.guard) {
-		/* callbacks while executing _resync_all() are ignored. */
+	if (!has_v4_changes && !has_v6_changes)
 		return;
-	}
 
-	if (vtable->vt->is_ip4)
+	if (has_v4_changes)
 		priv->resync.has_v4_changes = TRUE;
-	else
+	if (has_v6_changes)
 		priv->resync.has_v6_changes = TRUE;
 
 	_resync_idle_reschedule (self);
 }
 
-static void
-_platform_changed_cb (NMPlatform *platform,
-                      NMPObjectType obj_type,
-                      int ifindex,
-                      gpointer platform_object,
-                      NMPlatformSignalChangeType change_type,
-                      NMPlatformReason reason,
-                      NMDefaultRouteManager *self)
-{
-	switch (obj_type) {
-	case NMP_OBJECT_TYPE_IP4_ADDRESS:
-		_platform_ipx_route_changed_cb (&vtable_ip4, self, NULL);
-		break;
-	case NMP_OBJECT_TYPE_IP6_ADDRESS:
-		_platform_ipx_route_changed_cb (&vtable_ip6, self, NULL);
-		break;
-	case NMP_OBJECT_TYPE_IP4_ROUTE:
-		_platform_ipx_route_changed_cb (&vtable_ip4, self, (const NMPlatformIPRoute *) platform_object);
-		break;
-	case NMP_OBJECT_TYPE_IP6_ROUTE:
-		_platform_ipx_route_changed_cb (&vtable_ip6, self, (const NMPlatformIPRoute *) platform_object);
-		break;
-	default:
-		g_return_if_reached ();
-	}
-}
-
 /***********************************************************************************/
 
 static void
@@ -1391,10 +1413,7 @@ nm_default_route_manager_init (NMDefaultRouteManager *self)
 	priv->entries_ip6 = g_ptr_array_new_full (0, (GDestroyNotify) _entry_free);
 
 	priv->platform = g_object_ref (nm_platform_get ());
-	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP4_ADDRESS_CHANGED, G_CALLBACK (_platform_changed_cb), self);
-	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, G_CALLBACK (_platform_changed_cb), self);
-	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, G_CALLBACK (_platform_changed_cb), self);
-	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, G_CALLBACK (_platform_changed_cb), self);
+	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_CHANGES, G_CALLBACK (_platform_changes_cb), self);
 }
 
 static void
@@ -1406,7 +1425,7 @@ dispose (GObject *object)
 	priv->disposed = TRUE;
 
 	if (priv->platform) {
-		g_signal_handlers_disconnect_by_func (priv->platform, G_CALLBACK (_platform_changed_cb), self);
+		g_signal_handlers_disconnect_by_func (priv->platform, G_CALLBACK (_platform_changes_cb), self);
 		g_clear_object (&priv->platform);
 	}
 
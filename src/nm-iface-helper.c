@@ -464,6 +464,7 @@ main (int argc, char *argv[])
 		                                          global_opt.dhcp4_fqdn,
 		                                          global_opt.dhcp4_clientid,
 		                                          45,
+		                                          FALSE,
 		                                          NULL,
 		                                          global_opt.dhcp4_address);
 		g_assert (dhcp4_client);
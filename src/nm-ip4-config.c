@@ -41,12 +41,31 @@ G_DEFINE_TYPE (NMIP4Config, nm_ip4_config, NM_TYPE_EXPORTED_OBJECT)
 
 #define NM_IP4_CONFIG_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_IP4_CONFIG, NMIP4ConfigPrivate))
 
+/* The D-Bus representation of addresses and routes is built on demand and
+ * kept until the corresponding generation counter changes. */
+typedef struct {
+	GVariant *variant;
+	guint64 generation;
+} VariantCache;
+
 typedef struct {
 	gboolean never_default;
 	guint32 gateway;
 	gboolean has_gateway;
 	GArray *addresses;
 	GArray *routes;
+	gboolean addresses_shared;
+	gboolean routes_shared;
+	GHashTable *addresses_idx;
+	GHashTable *routes_idx;
+	guint64 addresses_generation;
+	guint64 routes_generation;
+	VariantCache address_data_variant;
+	VariantCache addresses_variant;
+	VariantCache route_data_variant;
+	VariantCache routes_variant;
+	gboolean dns_digest_valid;
+	guint8 dns_digest[NM_IP4_CONFIG_DNS_DIGEST_LEN];
 	GArray *nameservers;
 	GPtrArray *domains;
 	GPtrArray *searches;
@@ -85,6 +104,22 @@ enum {
 static GParamSpec *obj_properties[LAST_PROP] = { NULL, };
 #define _NOTIFY(config, prop)    G_STMT_START { g_object_notify_by_pspec (G_OBJECT (config), obj_properties[prop]); } G_STMT_END
 
+static void
+_notify_addresses (NMIP4Config *config)
+{
+	NM_IP4_CONFIG_GET_PRIVATE (config)->addresses_generation++;
+	_NOTIFY (config, PROP_ADDRESS_DATA);
+	_NOTIFY (config, PROP_ADDRESSES);
+}
+
+static void
+_notify_routes (NMIP4Config *config)
+{
+	NM_IP4_CONFIG_GET_PRIVATE (config)->routes_generation++;
+	_NOTIFY (config, PROP_ROUTE_DATA);
+	_NOTIFY (config, PROP_ROUTES);
+}
+
 NMIP4Config *
 nm_ip4_config_new (int ifindex)
 {
@@ -190,6 +225,157 @@ routes_are_duplicate (const NMPlatformIP4Route *a, const NMPlatformIP4Route *b,
 	       (!consider_gateway_and_metric || (a->gateway == b->gateway && a->metric == b->metric));
 }
 
+/* Arrays with at least this many entries get a hash index, so that
+ * merging, subtracting and intersecting large configurations doesn't
+ * compare every pair of entries. The index is built lazily and
+ * dropped whenever entries are removed. */
+#define IDX_MIN_LEN 16
+
+typedef struct {
+	in_addr_t address;
+	in_addr_t peer_address_masked;
+	int plen;
+} AddressIdxKey;
+
+typedef struct {
+	in_addr_t network;
+	int plen;
+} RouteIdxKey;
+
+static guint
+_address_idx_key_hash (gconstpointer key)
+{
+	const AddressIdxKey *k = key;
+	guint h;
+
+	h = k->address;
+	h = (h * 33) + k->peer_address_masked;
+	h = (h * 33) + k->plen;
+	return h;
+}
+
+static gboolean
+_address_idx_key_equal (gconstpointer a, gconstpointer b)
+{
+	const AddressIdxKey *k1 = a;
+	const AddressIdxKey *k2 = b;
+
+	return    k1->address == k2->address
+	       && k1->peer_address_masked == k2->peer_address_masked
+	       && k1->plen == k2->plen;
+}
+
+static void
+_address_idx_key_init (AddressIdxKey *key, const NMPlatformIP4Address *addr)
+{
+	/* consistent with addresses_are_duplicate() */
+	key->address = addr->address;
+	key->peer_address_masked = addr->peer_address & nm_utils_ip4_prefix_to_netmask (addr->plen);
+	key->plen = addr->plen;
+}
+
+static guint
+_route_idx_key_hash (gconstpointer key)
+{
+	const RouteIdxKey *k = key;
+
+	return (((guint) k->network) * 33) + k->plen;
+}
+
+static gboolean
+_route_idx_key_equal (gconstpointer a, gconstpointer b)
+{
+	const RouteIdxKey *k1 = a;
+	const RouteIdxKey *k2 = b;
+
+	return    k1->network == k2->network
+	       && k1->plen == k2->plen;
+}
+
+static void
+_addresses_idx_add (NMIP4ConfigPrivate *priv, guint i)
+{
+	AddressIdxKey *key = g_new (AddressIdxKey, 1);
+
+	_address_idx_key_init (key, &g_array_index (priv->addresses, NMPlatformIP4Address, i));
+
+	/* on duplicates, the first one wins -- like the linear search. */
+	if (g_hash_table_contains (priv->addresses_idx, key))
+		g_free (key);
+	else
+		g_hash_table_insert (priv->addresses_idx, key, GUINT_TO_POINTER (i + 1));
+}
+
+static void
+_addresses_idx_clear (NMIP4ConfigPrivate *priv)
+{
+	g_clear_pointer (&priv->addresses_idx, g_hash_table_unref);
+}
+
+static void
+_routes_idx_add (NMIP4ConfigPrivate *priv, guint i)
+{
+	const NMPlatformIP4Route *route = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+	RouteIdxKey *key = g_new (RouteIdxKey, 1);
+
+	key->network = route->network;
+	key->plen = route->plen;
+
+	if (g_hash_table_contains (priv->routes_idx, key))
+		g_free (key);
+	else
+		g_hash_table_insert (priv->routes_idx, key, GUINT_TO_POINTER (i + 1));
+}
+
+static void
+_routes_idx_clear (NMIP4ConfigPrivate *priv)
+{
+	g_clear_pointer (&priv->routes_idx, g_hash_table_unref);
+}
+
+/* The address and route arrays can be shared between configs, after merging
+ * into an empty config or after nm_ip4_config_replace(). A shared array is
+ * immutable, whoever wants to modify it first makes a private copy. */
+static void
+_array_unshare (GArray **array, gboolean *shared, gboolean keep_content)
+{
+	GArray *a;
+
+	if (!*shared)
+		return;
+
+	a = g_array_sized_new (FALSE, FALSE, g_array_get_element_size (*array),
+	                       keep_content ? (*array)->len : 0);
+	if (keep_content)
+		g_array_append_vals (a, (*array)->data, (*array)->len);
+	g_array_unref (*array);
+	*array = a;
+	*shared = FALSE;
+}
+
+#define _addresses_unshare(priv, keep_content) _array_unshare (&(priv)->addresses, &(priv)->addresses_shared, keep_content)
+#define _routes_unshare(priv, keep_content)    _array_unshare (&(priv)->routes, &(priv)->routes_shared, keep_content)
+
+static void
+_addresses_share (NMIP4ConfigPrivate *dst_priv, NMIP4ConfigPrivate *src_priv)
+{
+	_addresses_idx_clear (dst_priv);
+	g_array_unref (dst_priv->addresses);
+	dst_priv->addresses = g_array_ref (src_priv->addresses);
+	dst_priv->addresses_shared = TRUE;
+	src_priv->addresses_shared = TRUE;
+}
+
+static void
+_routes_share (NMIP4ConfigPrivate *dst_priv, NMIP4ConfigPrivate *src_priv)
+{
+	_routes_idx_clear (dst_priv);
+	g_array_unref (dst_priv->routes);
+	dst_priv->routes = g_array_ref (src_priv->routes);
+	dst_priv->routes_shared = TRUE;
+	src_priv->routes_shared = TRUE;
+}
+
 NMIP4Config *
 nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
 {
@@ -199,6 +385,7 @@ nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
 	guint32 lowest_metric = G_MAXUINT32;
 	guint32 old_gateway = 0;
 	gboolean old_has_gateway = FALSE;
+	GPtrArray *routes;
 
 	/* Slaves have no IP configuration */
 	if (nm_platform_link_get_master (NM_PLATFORM_GET, ifindex) > 0)
@@ -209,15 +396,19 @@ nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
 
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
+	priv->addresses_shared = FALSE;
+	priv->routes_shared = FALSE;
+	_addresses_idx_clear (priv);
+	_routes_idx_clear (priv);
 
 	priv->addresses = nm_platform_ip4_address_get_all (NM_PLATFORM_GET, ifindex);
-	priv->routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	routes = nm_platform_ip4_route_lookup_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
 
 	/* Extract gateway from default route */
 	old_gateway = priv->gateway;
 	old_has_gateway = priv->has_gateway;
-	for (i = 0; i < priv->routes->len; ) {
-		const NMPlatformIP4Route *route = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+	for (i = 0; i < routes->len; i++) {
+		const NMPlatformIP4Route *route = routes->pdata[i];
 
 		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
 			if (route->metric < lowest_metric) {
@@ -225,32 +416,31 @@ nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
 				lowest_metric = route->metric;
 			}
 			priv->has_gateway = TRUE;
-			/* Remove the default route from the list */
-			g_array_remove_index_fast (priv->routes, i);
-			continue;
 		}
-		i++;
 	}
 
 	/* we detect the route metric based on the default route. All non-default
 	 * routes have their route metrics explicitly set. */
 	priv->route_metric = priv->has_gateway ? (gint64) lowest_metric : (gint64) -1;
 
-	/* If there is a host route to the gateway, ignore that route.  It is
+	/* Copy the routes from the platform cache, except the default routes.
+	 * If there is a host route to the gateway, ignore that route too. It is
 	 * automatically added by NetworkManager when needed.
 	 */
-	if (priv->has_gateway) {
-		for (i = 0; i < priv->routes->len; i++) {
-			const NMPlatformIP4Route *route = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+	priv->routes = g_array_sized_new (FALSE, FALSE, sizeof (NMPlatformIP4Route), routes->len);
+	for (i = 0; i < routes->len; i++) {
+		const NMPlatformIP4Route *route = routes->pdata[i];
 
-			if (   (route->plen == 32)
-			    && (route->network == priv->gateway)
-			    && (route->gateway == 0)) {
-				g_array_remove_index (priv->routes, i);
-				i--;
-			}
-		}
+		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
+			continue;
+		if (   priv->has_gateway
+		    && (route->plen == 32)
+		    && (route->network == priv->gateway)
+		    && (route->gateway == 0))
+			continue;
+		g_array_append_vals (priv->routes, route, 1);
 	}
+	g_ptr_array_unref (routes);
 
 	/* If the interface has the default route, and has IPv4 addresses, capture
 	 * nameservers from /etc/resolv.conf.
@@ -261,10 +451,8 @@ nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
 	}
 
 	/* actually, nobody should be connected to the signal, just to be sure, notify */
-	_NOTIFY (config, PROP_ADDRESS_DATA);
-	_NOTIFY (config, PROP_ROUTE_DATA);
-	_NOTIFY (config, PROP_ADDRESSES);
-	_NOTIFY (config, PROP_ROUTES);
+	_notify_addresses (config);
+	_notify_routes (config);
 	if (   priv->gateway != old_gateway
 	    || priv->has_gateway != old_has_gateway)
 		_NOTIFY (config, PROP_GATEWAY);
@@ -589,8 +777,15 @@ nm_ip4_config_merge (NMIP4Config *dst, const NMIP4Config *src, NMIPConfigMergeFl
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip4_config_get_num_addresses (src); i++)
-		nm_ip4_config_add_address (dst, nm_ip4_config_get_address (src, i));
+	if (!dst_priv->addresses->len && src_priv->addresses->len) {
+		/* @src has no duplicates, so merging into an empty config yields
+		 * the very same array. */
+		_addresses_share (dst_priv, src_priv);
+		_notify_addresses (dst);
+	} else {
+		for (i = 0; i < nm_ip4_config_get_num_addresses (src); i++)
+			nm_ip4_config_add_address (dst, nm_ip4_config_get_address (src, i));
+	}
 
 	/* nameservers */
 	if (!NM_FLAGS_HAS (merge_flags, NM_IP_CONFIG_MERGE_NO_DNS)) {
@@ -604,8 +799,15 @@ nm_ip4_config_merge (NMIP4Config *dst, const NMIP4Config *src, NMIPConfigMergeFl
 
 	/* routes */
 	if (!NM_FLAGS_HAS (merge_flags, NM_IP_CONFIG_MERGE_NO_ROUTES)) {
-		for (i = 0; i < nm_ip4_config_get_num_routes (src); i++)
-			nm_ip4_config_add_route (dst, nm_ip4_config_get_route (src, i));
+		if (   !dst_priv->routes->len
+		    && src_priv->routes->len
+		    && dst_priv->ifindex == src_priv->ifindex) {
+			_routes_share (dst_priv, src_priv);
+			_notify_routes (dst);
+		} else {
+			for (i = 0; i < nm_ip4_config_get_num_routes (src); i++)
+				nm_ip4_config_add_route (dst, nm_ip4_config_get_route (src, i));
+		}
 	}
 
 	if (dst_priv->route_metric == -1)
@@ -668,15 +870,27 @@ static int
 _addresses_get_index (const NMIP4Config *self, const NMPlatformIP4Address *addr)
 {
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (self);
+	AddressIdxKey key;
 	guint i;
 
-	for (i = 0; i < priv->addresses->len; i++) {
-		const NMPlatformIP4Address *a = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
+	if (priv->addresses->len < IDX_MIN_LEN) {
+		for (i = 0; i < priv->addresses->len; i++) {
+			const NMPlatformIP4Address *a = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
 
-		if (addresses_are_duplicate (addr, a))
-			return (int) i;
+			if (addresses_are_duplicate (addr, a))
+				return (int) i;
+		}
+		return -1;
 	}
-	return -1;
+
+	if (!priv->addresses_idx) {
+		priv->addresses_idx = g_hash_table_new_full (_address_idx_key_hash, _address_idx_key_equal, g_free, NULL);
+		for (i = 0; i < priv->addresses->len; i++)
+			_addresses_idx_add (priv, i);
+	}
+
+	_address_idx_key_init (&key, addr);
+	return ((int) GPOINTER_TO_UINT (g_hash_table_lookup (priv->addresses_idx, &key))) - 1;
 }
 
 static int
@@ -698,16 +912,80 @@ static int
 _routes_get_index (const NMIP4Config *self, const NMPlatformIP4Route *route)
 {
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (self);
+	RouteIdxKey key;
 	guint i;
 
-	for (i = 0; i < priv->routes->len; i++) {
-		const NMPlatformIP4Route *r = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+	if (priv->routes->len < IDX_MIN_LEN) {
+		for (i = 0; i < priv->routes->len; i++) {
+			const NMPlatformIP4Route *r = &g_array_index (priv->routes, NMPlatformIP4Route, i);
 
-		if (   route->network == r->network
-		    && route->plen == r->plen)
-			return (int) i;
+			if (   route->network == r->network
+			    && route->plen == r->plen)
+				return (int) i;
+		}
+		return -1;
+	}
+
+	if (!priv->routes_idx) {
+		priv->routes_idx = g_hash_table_new_full (_route_idx_key_hash, _route_idx_key_equal, g_free, NULL);
+		for (i = 0; i < priv->routes->len; i++)
+			_routes_idx_add (priv, i);
+	}
+
+	key.network = route->network;
+	key.plen = route->plen;
+	return ((int) GPOINTER_TO_UINT (g_hash_table_lookup (priv->routes_idx, &key))) - 1;
+}
+
+/* Removes the entries of @array that are marked in @del, keeping the order
+ * of the others. Returns whether anything was removed. */
+static gboolean
+_array_remove_marked (GArray *array, const guint8 *del)
+{
+	guint elt_size = g_array_get_element_size (array);
+	guint i, j;
+
+	for (i = 0, j = 0; i < array->len; i++) {
+		if (del[i])
+			continue;
+		if (i != j)
+			memcpy (array->data + j * elt_size, array->data + i * elt_size, elt_size);
+		j++;
+	}
+	if (j == array->len)
+		return FALSE;
+	g_array_set_size (array, j);
+	return TRUE;
+}
+
+static void
+_addresses_del_marked (NMIP4Config *config, const guint8 *del)
+{
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+
+	if (!memchr (del, TRUE, priv->addresses->len))
+		return;
+
+	_addresses_unshare (priv, TRUE);
+	if (_array_remove_marked (priv->addresses, del)) {
+		_addresses_idx_clear (priv);
+		_notify_addresses (config);
+	}
+}
+
+static void
+_routes_del_marked (NMIP4Config *config, const guint8 *del)
+{
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+
+	if (!memchr (del, TRUE, priv->routes->len))
+		return;
+
+	_routes_unshare (priv, TRUE);
+	if (_array_remove_marked (priv->routes, del)) {
+		_routes_idx_clear (priv);
+		_notify_routes (config);
 	}
-	return -1;
 }
 
 static int
@@ -806,10 +1084,17 @@ nm_ip4_config_subtract (NMIP4Config *dst, const NMIP4Config *src)
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip4_config_get_num_addresses (src); i++) {
-		idx = _addresses_get_index (dst, nm_ip4_config_get_address (src, i));
-		if (idx >= 0)
-			nm_ip4_config_del_address (dst, idx);
+	if (nm_ip4_config_get_num_addresses (dst)) {
+		gs_free guint8 *del = g_new0 (guint8, nm_ip4_config_get_num_addresses (dst));
+
+		/* mark first and remove afterwards, so that the lookup index of @dst
+		 * stays valid. */
+		for (i = 0; i < nm_ip4_config_get_num_addresses (src); i++) {
+			idx = _addresses_get_index (dst, nm_ip4_config_get_address (src, i));
+			if (idx >= 0)
+				del[idx] = TRUE;
+		}
+		_addresses_del_marked (dst, del);
 	}
 
 	/* nameservers */
@@ -830,10 +1115,15 @@ nm_ip4_config_subtract (NMIP4Config *dst, const NMIP4Config *src)
 	/* ignore route_metric */
 
 	/* routes */
-	for (i = 0; i < nm_ip4_config_get_num_routes (src); i++) {
-		idx = _routes_get_index (dst, nm_ip4_config_get_route (src, i));
-		if (idx >= 0)
-			nm_ip4_config_del_route (dst, idx);
+	if (nm_ip4_config_get_num_routes (dst)) {
+		gs_free guint8 *del = g_new0 (guint8, nm_ip4_config_get_num_routes (dst));
+
+		for (i = 0; i < nm_ip4_config_get_num_routes (src); i++) {
+			idx = _routes_get_index (dst, nm_ip4_config_get_route (src, i));
+			if (idx >= 0)
+				del[idx] = TRUE;
+		}
+		_routes_del_marked (dst, del);
 	}
 
 	/* domains */
@@ -897,12 +1187,15 @@ nm_ip4_config_intersect (NMIP4Config *dst, const NMIP4Config *src)
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip4_config_get_num_addresses (dst); ) {
-		idx = _addresses_get_index (src, nm_ip4_config_get_address (dst, i));
-		if (idx < 0)
-			nm_ip4_config_del_address (dst, i);
-		else
-			i++;
+	if (nm_ip4_config_get_num_addresses (dst)) {
+		gs_free guint8 *del = g_new0 (guint8, nm_ip4_config_get_num_addresses (dst));
+
+		for (i = 0; i < nm_ip4_config_get_num_addresses (dst); i++) {
+			idx = _addresses_get_index (src, nm_ip4_config_get_address (dst, i));
+			if (idx < 0)
+				del[i] = TRUE;
+		}
+		_addresses_del_marked (dst, del);
 	}
 
 	/* ignore route_metric */
@@ -916,12 +1209,15 @@ nm_ip4_config_intersect (NMIP4Config *dst, const NMIP4Config *src)
 	}
 
 	/* routes */
-	for (i = 0; i < nm_ip4_config_get_num_routes (dst); ) {
-		idx = _routes_get_index (src, nm_ip4_config_get_route (dst, i));
-		if (idx < 0)
-			nm_ip4_config_del_route (dst, i);
-		else
-			i++;
+	if (nm_ip4_config_get_num_routes (dst)) {
+		gs_free guint8 *del = g_new0 (guint8, nm_ip4_config_get_num_routes (dst));
+
+		for (i = 0; i < nm_ip4_config_get_num_routes (dst); i++) {
+			idx = _routes_get_index (src, nm_ip4_config_get_route (dst, i));
+			if (idx < 0)
+				del[i] = TRUE;
+		}
+		_routes_del_marked (dst, del);
 	}
 
 	/* ignore domains */
@@ -1000,7 +1296,9 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 	/* addresses */
 	num = nm_ip4_config_get_num_addresses (src);
 	are_equal = num == nm_ip4_config_get_num_addresses (dst);
-	if (are_equal) {
+	if (!are_equal)
+		has_relevant_changes = TRUE;
+	else if (src_priv->addresses != dst_priv->addresses) {
 		for (i = 0; i < num; i++ ) {
 			if (nm_platform_ip4_address_cmp (src_addr = nm_ip4_config_get_address (src, i),
 			                                 dst_addr = nm_ip4_config_get_address (dst, i))) {
@@ -1012,19 +1310,21 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 				}
 			}
 		}
-	} else
-		has_relevant_changes = TRUE;
+	}
 	if (!are_equal) {
-		nm_ip4_config_reset_addresses (dst);
-		for (i = 0; i < num; i++)
-			nm_ip4_config_add_address (dst, nm_ip4_config_get_address (src, i));
+		/* take over the array of @src as a whole and notify once
+		 * instead of once per address. */
+		_addresses_share (dst_priv, src_priv);
+		_notify_addresses (dst);
 		has_minor_changes = TRUE;
 	}
 
 	/* routes */
 	num = nm_ip4_config_get_num_routes (src);
 	are_equal = num == nm_ip4_config_get_num_routes (dst);
-	if (are_equal) {
+	if (!are_equal)
+		has_relevant_changes = TRUE;
+	else if (src_priv->routes != dst_priv->routes) {
 		for (i = 0; i < num; i++ ) {
 			if (nm_platform_ip4_route_cmp (src_route = nm_ip4_config_get_route (src, i),
 			                               dst_route = nm_ip4_config_get_route (dst, i))) {
@@ -1035,12 +1335,12 @@ nm_ip4_config_replace (NMIP4Config *dst, const NMIP4Config *src, gboolean *relev
 				}
 			}
 		}
-	} else
-		has_relevant_changes = TRUE;
+	}
 	if (!are_equal) {
-		nm_ip4_config_reset_routes (dst);
-		for (i = 0; i < num; i++)
-			nm_ip4_config_add_route (dst, nm_ip4_config_get_route (src, i));
+		/* the ifindex was synced above, so the routes of @src are
+		 * valid for @dst as they are. */
+		_routes_share (dst_priv, src_priv);
+		_notify_routes (dst);
 		has_minor_changes = TRUE;
 	}
 
@@ -1313,6 +1613,8 @@ nm_ip4_config_set_gateway (NMIP4Config *config, guint32 gateway)
 	if (priv->gateway != gateway || !priv->has_gateway) {
 		priv->gateway = gateway;
 		priv->has_gateway = TRUE;
+		/* the legacy Addresses property carries the gateway */
+		priv->addresses_generation++;
 		_NOTIFY (config, PROP_GATEWAY);
 	}
 }
@@ -1325,6 +1627,8 @@ nm_ip4_config_unset_gateway (NMIP4Config *config)
 	if (priv->has_gateway) {
 		priv->gateway = 0;
 		priv->has_gateway = FALSE;
+		/* the legacy Addresses property carries the gateway */
+		priv->addresses_generation++;
 		_NOTIFY (config, PROP_GATEWAY);
 	}
 }
@@ -1361,9 +1665,10 @@ nm_ip4_config_reset_addresses (NMIP4Config *config)
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
 
 	if (priv->addresses->len != 0) {
+		_addresses_unshare (priv, FALSE);
 		g_array_set_size (priv->addresses, 0);
-		_NOTIFY (config, PROP_ADDRESS_DATA);
-		_NOTIFY (config, PROP_ADDRESSES);
+		_addresses_idx_clear (priv);
+		_notify_addresses (config);
 	}
 }
 
@@ -1386,42 +1691,46 @@ nm_ip4_config_add_address (NMIP4Config *config, const NMPlatformIP4Address *new)
 
 	g_return_if_fail (new != NULL);
 
-	for (i = 0; i < priv->addresses->len; i++ ) {
+	i = _addresses_get_index (config, new);
+	if (i >= 0) {
 		NMPlatformIP4Address *item = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
 
-		if (addresses_are_duplicate (item, new)) {
-			if (nm_platform_ip4_address_cmp (item, new) == 0)
-				return;
-
-			/* remember the old values. */
-			item_old = *item;
-			/* Copy over old item to get new lifetime, timestamp, preferred */
-			*item = *new;
-
-			/* But restore highest priority source */
-			item->source = MAX (item_old.source, new->source);
-
-			/* for addresses that we read from the kernel, we keep the timestamps as defined
-			 * by the previous source (item_old). The reason is, that the other source configured the lifetimes
-			 * with "what should be" and the kernel values are "what turned out after configuring it".
-			 *
-			 * For other sources, the longer lifetime wins. */
-			if (   (new->source == NM_IP_CONFIG_SOURCE_KERNEL && new->source != item_old.source)
-			    || nm_platform_ip_address_cmp_expiry ((const NMPlatformIPAddress *) &item_old, (const NMPlatformIPAddress *) new) > 0) {
-				item->timestamp = item_old.timestamp;
-				item->lifetime = item_old.lifetime;
-				item->preferred = item_old.preferred;
-			}
-			if (nm_platform_ip4_address_cmp (&item_old, item) == 0)
-				return;
-			goto NOTIFY;
+		if (nm_platform_ip4_address_cmp (item, new) == 0)
+			return;
+
+		_addresses_unshare (priv, TRUE);
+		item = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
+
+		/* remember the old values. */
+		item_old = *item;
+		/* Copy over old item to get new lifetime, timestamp, preferred */
+		*item = *new;
+
+		/* But restore highest priority source */
+		item->source = MAX (item_old.source, new->source);
+
+		/* for addresses that we read from the kernel, we keep the timestamps as defined
+		 * by the previous source (item_old). The reason is, that the other source configured the lifetimes
+		 * with "what should be" and the kernel values are "what turned out after configuring it".
+		 *
+		 * For other sources, the longer lifetime wins. */
+		if (   (new->source == NM_IP_CONFIG_SOURCE_KERNEL && new->source != item_old.source)
+		    || nm_platform_ip_address_cmp_expiry ((const NMPlatformIPAddress *) &item_old, (const NMPlatformIPAddress *) new) > 0) {
+			item->timestamp = item_old.timestamp;
+			item->lifetime = item_old.lifetime;
+			item->preferred = item_old.preferred;
 		}
+		if (nm_platform_ip4_address_cmp (&item_old, item) == 0)
+			return;
+		goto NOTIFY;
 	}
 
+	_addresses_unshare (priv, TRUE);
 	g_array_append_val (priv->addresses, *new);
+	if (priv->addresses_idx)
+		_addresses_idx_add (priv, priv->addresses->len - 1);
 NOTIFY:
-	_NOTIFY (config, PROP_ADDRESS_DATA);
-	_NOTIFY (config, PROP_ADDRESSES);
+	_notify_addresses (config);
 }
 
 void
@@ -1431,9 +1740,10 @@ nm_ip4_config_del_address (NMIP4Config *config, guint i)
 
 	g_return_if_fail (i < priv->addresses->len);
 
+	_addresses_unshare (priv, TRUE);
 	g_array_remove_index (priv->addresses, i);
-	_NOTIFY (config, PROP_ADDRESS_DATA);
-	_NOTIFY (config, PROP_ADDRESSES);
+	_addresses_idx_clear (priv);
+	_notify_addresses (config);
 }
 
 guint
@@ -1467,9 +1777,10 @@ nm_ip4_config_reset_routes (NMIP4Config *config)
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
 
 	if (priv->routes->len != 0) {
+		_routes_unshare (priv, FALSE);
 		g_array_set_size (priv->routes, 0);
-		_NOTIFY (config, PROP_ROUTE_DATA);
-		_NOTIFY (config, PROP_ROUTES);
+		_routes_idx_clear (priv);
+		_notify_routes (config);
 	}
 }
 
@@ -1494,26 +1805,29 @@ nm_ip4_config_add_route (NMIP4Config *config, const NMPlatformIP4Route *new)
 	g_return_if_fail (new->plen > 0);
 	g_assert (priv->ifindex);
 
-	for (i = 0; i < priv->routes->len; i++ ) {
+	i = _routes_get_index (config, new);
+	if (i >= 0) {
 		NMPlatformIP4Route *item = &g_array_index (priv->routes, NMPlatformIP4Route, i);
 
-		if (routes_are_duplicate (item, new, FALSE)) {
-			if (nm_platform_ip4_route_cmp (item, new) == 0)
-				return;
-			old_source = item->source;
-			memcpy (item, new, sizeof (*item));
-			/* Restore highest priority source */
-			item->source = MAX (old_source, new->source);
-			item->ifindex = priv->ifindex;
-			goto NOTIFY;
-		}
+		if (nm_platform_ip4_route_cmp (item, new) == 0)
+			return;
+		_routes_unshare (priv, TRUE);
+		item = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+		old_source = item->source;
+		memcpy (item, new, sizeof (*item));
+		/* Restore highest priority source */
+		item->source = MAX (old_source, new->source);
+		item->ifindex = priv->ifindex;
+		goto NOTIFY;
 	}
 
+	_routes_unshare (priv, TRUE);
 	g_array_append_val (priv->routes, *new);
 	g_array_index (priv->routes, NMPlatformIP4Route, priv->routes->len - 1).ifindex = priv->ifindex;
+	if (priv->routes_idx)
+		_routes_idx_add (priv, priv->routes->len - 1);
 NOTIFY:
-	_NOTIFY (config, PROP_ROUTE_DATA);
-	_NOTIFY (config, PROP_ROUTES);
+	_notify_routes (config);
 }
 
 void
@@ -1523,9 +1837,10 @@ nm_ip4_config_del_route (NMIP4Config *config, guint i)
 
 	g_return_if_fail (i < priv->routes->len);
 
+	_routes_unshare (priv, TRUE);
 	g_array_remove_index (priv->routes, i);
-	_NOTIFY (config, PROP_ROUTE_DATA);
-	_NOTIFY (config, PROP_ROUTES);
+	_routes_idx_clear (priv);
+	_notify_routes (config);
 }
 
 guint
@@ -1583,6 +1898,7 @@ nm_ip4_config_reset_nameservers (NMIP4Config *config)
 
 	if (priv->nameservers->len != 0) {
 		g_array_set_size (priv->nameservers, 0);
+		priv->dns_digest_valid = FALSE;
 		_NOTIFY (config, PROP_NAMESERVERS);
 	}
 }
@@ -1600,6 +1916,7 @@ nm_ip4_config_add_nameserver (NMIP4Config *config, guint32 new)
 			return;
 
 	g_array_append_val (priv->nameservers, new);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_NAMESERVERS);
 }
 
@@ -1611,6 +1928,7 @@ nm_ip4_config_del_nameserver (NMIP4Config *config, guint i)
 	g_return_if_fail (i < priv->nameservers->len);
 
 	g_array_remove_index (priv->nameservers, i);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_NAMESERVERS);
 }
 
@@ -1639,6 +1957,7 @@ nm_ip4_config_reset_domains (NMIP4Config *config)
 
 	if (priv->domains->len != 0) {
 		g_ptr_array_set_size (priv->domains, 0);
+		priv->dns_digest_valid = FALSE;
 		_NOTIFY (config, PROP_DOMAINS);
 	}
 }
@@ -1657,6 +1976,7 @@ nm_ip4_config_add_domain (NMIP4Config *config, const char *domain)
 			return;
 
 	g_ptr_array_add (priv->domains, g_strdup (domain));
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_DOMAINS);
 }
 
@@ -1668,6 +1988,7 @@ nm_ip4_config_del_domain (NMIP4Config *config, guint i)
 	g_return_if_fail (i < priv->domains->len);
 
 	g_ptr_array_remove_index (priv->domains, i);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_DOMAINS);
 }
 
@@ -1696,6 +2017,7 @@ nm_ip4_config_reset_searches (NMIP4Config *config)
 
 	if (priv->searches->len != 0) {
 		g_ptr_array_set_size (priv->searches, 0);
+		priv->dns_digest_valid = FALSE;
 		_NOTIFY (config, PROP_SEARCHES);
 	}
 }
@@ -1714,6 +2036,7 @@ nm_ip4_config_add_search (NMIP4Config *config, const char *new)
 			return;
 
 	g_ptr_array_add (priv->searches, g_strdup (new));
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_SEARCHES);
 }
 
@@ -1725,6 +2048,7 @@ nm_ip4_config_del_search (NMIP4Config *config, guint i)
 	g_return_if_fail (i < priv->searches->len);
 
 	g_ptr_array_remove_index (priv->searches, i);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_SEARCHES);
 }
 
@@ -1753,6 +2077,7 @@ nm_ip4_config_reset_dns_options (NMIP4Config *config)
 
 	if (priv->dns_options->len != 0) {
 		g_ptr_array_set_size (priv->dns_options, 0);
+		priv->dns_digest_valid = FALSE;
 		_NOTIFY (config, PROP_DNS_OPTIONS);
 	}
 }
@@ -1771,6 +2096,7 @@ nm_ip4_config_add_dns_option (NMIP4Config *config, const char *new)
 			return;
 
 	g_ptr_array_add (priv->dns_options, g_strdup (new));
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_DNS_OPTIONS);
 }
 
@@ -1782,6 +2108,7 @@ nm_ip4_config_del_dns_option(NMIP4Config *config, guint i)
 	g_return_if_fail (i < priv->dns_options->len);
 
 	g_ptr_array_remove_index (priv->dns_options, i);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_DNS_OPTIONS);
 }
 
@@ -1894,6 +2221,7 @@ nm_ip4_config_reset_wins (NMIP4Config *config)
 
 	if (priv->wins->len != 0) {
 		g_array_set_size (priv->wins, 0);
+		priv->dns_digest_valid = FALSE;
 		_NOTIFY (config, PROP_WINS_SERVERS);
 	}
 }
@@ -1911,6 +2239,7 @@ nm_ip4_config_add_wins (NMIP4Config *config, guint32 wins)
 			return;
 
 	g_array_append_val (priv->wins, wins);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_WINS_SERVERS);
 }
 
@@ -1922,6 +2251,7 @@ nm_ip4_config_del_wins (NMIP4Config *config, guint i)
 	g_return_if_fail (i < priv->wins->len);
 
 	g_array_remove_index (priv->wins, i);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_WINS_SERVERS);
 }
 
@@ -1997,6 +2327,33 @@ hash_u32 (GChecksum *sum, guint32 n)
 	g_checksum_update (sum, (const guint8 *) &n, sizeof (n));
 }
 
+/**
+ * nm_ip4_config_get_dns_digest:
+ * @config: the #NMIP4Config
+ *
+ * Returns: the SHA1 digest of the DNS related parts of @config, as hashed
+ *   by nm_ip4_config_hash() with @dns_only. The digest is cached until the
+ *   DNS settings of @config change. It is %NM_IP4_CONFIG_DNS_DIGEST_LEN
+ *   bytes long.
+ */
+const guint8 *
+nm_ip4_config_get_dns_digest (const NMIP4Config *config)
+{
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+
+	if (!priv->dns_digest_valid) {
+		GChecksum *sum;
+		gsize len = sizeof (priv->dns_digest);
+
+		sum = g_checksum_new (G_CHECKSUM_SHA1);
+		nm_ip4_config_hash (config, sum, TRUE);
+		g_checksum_get_digest (sum, priv->dns_digest, &len);
+		g_checksum_free (sum);
+		priv->dns_digest_valid = TRUE;
+	}
+	return priv->dns_digest;
+}
+
 void
 nm_ip4_config_hash (const NMIP4Config *config, GChecksum *sum, gboolean dns_only)
 {
@@ -2115,6 +2472,25 @@ nm_ip4_config_init (NMIP4Config *config)
 	priv->route_metric = -1;
 }
 
+static GVariant *
+_variant_cache_get (VariantCache *cache, guint64 generation,
+                    GVariant *(*build) (const NMIP4Config *config), const NMIP4Config *config)
+{
+	if (!cache->variant || cache->generation != generation) {
+		if (cache->variant)
+			g_variant_unref (cache->variant);
+		cache->variant = g_variant_ref_sink (build (config));
+		cache->generation = generation;
+	}
+	return cache->variant;
+}
+
+static void
+_variant_cache_clear (VariantCache *cache)
+{
+	g_clear_pointer (&cache->variant, g_variant_unref);
+}
+
 static void
 finalize (GObject *object)
 {
@@ -2122,6 +2498,12 @@ finalize (GObject *object)
 
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
+	_addresses_idx_clear (priv);
+	_routes_idx_clear (priv);
+	_variant_cache_clear (&priv->address_data_variant);
+	_variant_cache_clear (&priv->addresses_variant);
+	_variant_cache_clear (&priv->route_data_variant);
+	_variant_cache_clear (&priv->routes_variant);
 	g_array_unref (priv->nameservers);
 	g_ptr_array_unref (priv->domains);
 	g_ptr_array_unref (priv->searches);
@@ -2133,6 +2515,130 @@ finalize (GObject *object)
 	G_OBJECT_CLASS (nm_ip4_config_parent_class)->finalize (object);
 }
 
+static GVariant *
+_address_data_to_variant (const NMIP4Config *config)
+{
+	GVariantBuilder array_builder, addr_builder;
+	int naddr = nm_ip4_config_get_num_addresses (config);
+	int i;
+
+	g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aa{sv}"));
+	for (i = 0; i < naddr; i++) {
+		const NMPlatformIP4Address *address = nm_ip4_config_get_address (config, i);
+
+		g_variant_builder_init (&addr_builder, G_VARIANT_TYPE ("a{sv}"));
+		g_variant_builder_add (&addr_builder, "{sv}",
+		                       "address",
+		                       g_variant_new_string (nm_utils_inet4_ntop (address->address, NULL)));
+		g_variant_builder_add (&addr_builder, "{sv}",
+		                       "prefix",
+		                       g_variant_new_uint32 (address->plen));
+		if (address->peer_address != address->address) {
+			g_variant_builder_add (&addr_builder, "{sv}",
+			                       "peer",
+			                       g_variant_new_string (nm_utils_inet4_ntop (address->peer_address, NULL)));
+		}
+
+		if (*address->label) {
+			g_variant_builder_add (&addr_builder, "{sv}",
+			                       "label",
+			                       g_variant_new_string (address->label));
+		}
+
+		g_variant_builder_add (&array_builder, "a{sv}", &addr_builder);
+	}
+
+	return g_variant_builder_end (&array_builder);
+}
+
+static GVariant *
+_addresses_to_variant (const NMIP4Config *config)
+{
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+	GVariantBuilder array_builder;
+	int naddr = nm_ip4_config_get_num_addresses (config);
+	int i;
+
+	g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aau"));
+	for (i = 0; i < naddr; i++) {
+		const NMPlatformIP4Address *address = nm_ip4_config_get_address (config, i);
+		guint32 dbus_addr[3];
+
+		dbus_addr[0] = address->address;
+		dbus_addr[1] = address->plen;
+		dbus_addr[2] = i == 0 ? priv->gateway : 0;
+
+		g_variant_builder_add (&array_builder, "@au",
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+		                                                  dbus_addr, 3, sizeof (guint32)));
+	}
+
+	return g_variant_builder_end (&array_builder);
+}
+
+static GVariant *
+_route_data_to_variant (const NMIP4Config *config)
+{
+	GVariantBuilder array_builder, route_builder;
+	guint nroutes = nm_ip4_config_get_num_routes (config);
+	int i;
+
+	g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aa{sv}"));
+	for (i = 0; i < nroutes; i++) {
+		const NMPlatformIP4Route *route = nm_ip4_config_get_route (config, i);
+
+		g_variant_builder_init (&route_builder, G_VARIANT_TYPE ("a{sv}"));
+		g_variant_builder_add (&route_builder, "{sv}",
+		                       "dest",
+		                       g_variant_new_string (nm_utils_inet4_ntop (route->network, NULL)));
+		g_variant_builder_add (&route_builder, "{sv}",
+		                       "prefix",
+		                       g_variant_new_uint32 (route->plen));
+		if (route->gateway) {
+			g_variant_builder_add (&route_builder, "{sv}",
+			                       "next-hop",
+			                       g_variant_new_string (nm_utils_inet4_ntop (route->gateway, NULL)));
+		}
+		g_variant_builder_add (&route_builder, "{sv}",
+		                       "metric",
+		                       g_variant_new_uint32 (route->metric));
+
+		g_variant_builder_add (&array_builder, "a{sv}", &route_builder);
+	}
+
+	return g_variant_builder_end (&array_builder);
+}
+
+static GVariant *
+_routes_to_variant (const NMIP4Config *config)
+{
+	GVariantBuilder array_builder;
+	guint nroutes = nm_ip4_config_get_num_routes (config);
+	int i;
+
+	g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aau"));
+	for (i = 0; i < nroutes; i++) {
+		const NMPlatformIP4Route *route = nm_ip4_config_get_route (config, i);
+		guint32 dbus_route[4];
+
+		/* legacy versions of nm_ip4_route_set_prefix() in libnm-util assert that the
+		 * plen is positive. Skip the default routes not to break older clients. */
+		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
+			continue;
+
+		dbus_route[0] = route->network;
+		dbus_route[1] = route->plen;
+		dbus_route[2] = route->gateway;
+		dbus_route[3] = route->metric;
+
+		g_variant_builder_add (&array_builder, "@au",
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+		                                                  dbus_route, 4, sizeof (guint32)));
+	}
+
+	return g_variant_builder_end (&array_builder);
+}
+
 static void
 get_property (GObject *object, guint prop_id,
 			  GValue *value, GParamSpec *pspec)
@@ -2145,123 +2651,16 @@ get_property (GObject *object, guint prop_id,
 		g_value_set_int (value, priv->ifindex);
 		break;
 	case PROP_ADDRESS_DATA:
-		{
-			GVariantBuilder array_builder, addr_builder;
-			int naddr = nm_ip4_config_get_num_addresses (config);
-			int i;
-
-			g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aa{sv}"));
-			for (i = 0; i < naddr; i++) {
-				const NMPlatformIP4Address *address = nm_ip4_config_get_address (config, i);
-
-				g_variant_builder_init (&addr_builder, G_VARIANT_TYPE ("a{sv}"));
-				g_variant_builder_add (&addr_builder, "{sv}",
-				                       "address",
-				                       g_variant_new_string (nm_utils_inet4_ntop (address->address, NULL)));
-				g_variant_builder_add (&addr_builder, "{sv}",
-				                       "prefix",
-				                       g_variant_new_uint32 (address->plen));
-				if (address->peer_address != address->address) {
-					g_variant_builder_add (&addr_builder, "{sv}",
-					                       "peer",
-					                       g_variant_new_string (nm_utils_inet4_ntop (address->peer_address, NULL)));
-				}
-
-				if (*address->label) {
-					g_variant_builder_add (&addr_builder, "{sv}",
-					                       "label",
-					                       g_variant_new_string (address->label));
-				}
-
-				g_variant_builder_add (&array_builder, "a{sv}", &addr_builder);
-			}
-
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
-		}
+		g_value_set_variant (value, _variant_cache_get (&priv->address_data_variant, priv->addresses_generation, _address_data_to_variant, config));
 		break;
 	case PROP_ADDRESSES:
-		{
-			GVariantBuilder array_builder;
-			int naddr = nm_ip4_config_get_num_addresses (config);
-			int i;
-
-			g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aau"));
-			for (i = 0; i < naddr; i++) {
-				const NMPlatformIP4Address *address = nm_ip4_config_get_address (config, i);
-				guint32 dbus_addr[3];
-
-				dbus_addr[0] = address->address;
-				dbus_addr[1] = address->plen;
-				dbus_addr[2] = i == 0 ? priv->gateway : 0;
-
-				g_variant_builder_add (&array_builder, "@au",
-				                       g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
-				                                                  dbus_addr, 3, sizeof (guint32)));
-			}
-
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
-		}
+		g_value_set_variant (value, _variant_cache_get (&priv->addresses_variant, priv->addresses_generation, _addresses_to_variant, config));
 		break;
 	case PROP_ROUTE_DATA:
-		{
-			GVariantBuilder array_builder, route_builder;
-			guint nroutes = nm_ip4_config_get_num_routes (config);
-			int i;
-
-			g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aa{sv}"));
-			for (i = 0; i < nroutes; i++) {
-				const NMPlatformIP4Route *route = nm_ip4_config_get_route (config, i);
-
-				g_variant_builder_init (&route_builder, G_VARIANT_TYPE ("a{sv}"));
-				g_variant_builder_add (&route_builder, "{sv}",
-				                       "dest",
-				                       g_variant_new_string (nm_utils_inet4_ntop (route->network, NULL)));
-				g_variant_builder_add (&route_builder, "{sv}",
-				                       "prefix",
-				                       g_variant_new_uint32 (route->plen));
-				if (route->gateway) {
-					g_variant_builder_add (&route_builder, "{sv}",
-					                       "next-hop",
-					                       g_variant_new_string (nm_utils_inet4_ntop (route->gateway, NULL)));
-				}
-				g_variant_builder_add (&route_builder, "{sv}",
-				                       "metric",
-				                       g_variant_new_uint32 (route->metric));
-
-				g_variant_builder_add (&array_builder, "a{sv}", &route_builder);
-			}
-
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
-		}
+		g_value_set_variant (value, _variant_cache_get (&priv->route_data_variant, priv->routes_generation, _route_data_to_variant, config));
 		break;
 	case PROP_ROUTES:
-		{
-			GVariantBuilder array_builder;
-			guint nroutes = nm_ip4_config_get_num_routes (config);
-			int i;
-
-			g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aau"));
-			for (i = 0; i < nroutes; i++) {
-				const NMPlatformIP4Route *route = nm_ip4_config_get_route (config, i);
-				guint32 dbus_route[4];
-
-				/* legacy versions of nm_ip4_route_set_prefix() in libnm-util assert that the
-				 * plen is positive. Skip the default routes not to break older clients. */
-				if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
-					continue;
-
-				dbus_route[0] = route->network;
-				dbus_route[1] = route->plen;
-				dbus_route[2] = route->gateway;
-				dbus_route[3] = route->metric;
-
-				g_variant_builder_add (&array_builder, "@au",
-				                       g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
-				                                                  dbus_route, 4, sizeof (guint32)));
-			}
-
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
-		}
+		g_value_set_variant (value, _variant_cache_get (&priv->routes_variant, priv->routes_generation, _routes_to_variant, config));
 		break;
 	case PROP_GATEWAY:
 		if (priv->has_gateway)
@@ -161,6 +161,8 @@ void nm_ip4_config_set_metered (NMIP4Config *config, gboolean metered);
 gboolean nm_ip4_config_get_metered (const NMIP4Config *config);
 
 void nm_ip4_config_hash (const NMIP4Config *config, GChecksum *sum, gboolean dns_only);
+#define NM_IP4_CONFIG_DNS_DIGEST_LEN 20
+const guint8 *nm_ip4_config_get_dns_digest (const NMIP4Config *config);
 gboolean nm_ip4_config_equal (const NMIP4Config *a, const NMIP4Config *b);
 
 /******************************************************/
@@ -40,11 +40,30 @@ G_DEFINE_TYPE (NMIP6Config, nm_ip6_config, NM_TYPE_EXPORTED_OBJECT)
 
 #define NM_IP6_CONFIG_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_IP6_CONFIG, NMIP6ConfigPrivate))
 
+/* The D-Bus representation of addresses and routes is built on demand and
+ * kept until the corresponding generation counter changes. */
+typedef struct {
+	GVariant *variant;
+	guint64 generation;
+} VariantCache;
+
 typedef struct {
 	gboolean never_default;
 	struct in6_addr gateway;
 	GArray *addresses;
 	GArray *routes;
+	gboolean addresses_shared;
+	gboolean routes_shared;
+	GHashTable *addresses_idx;
+	GHashTable *routes_idx;
+	guint64 addresses_generation;
+	guint64 routes_generation;
+	VariantCache address_data_variant;
+	VariantCache addresses_variant;
+	VariantCache route_data_variant;
+	VariantCache routes_variant;
+	gboolean dns_digest_valid;
+	guint8 dns_digest[NM_IP6_CONFIG_DNS_DIGEST_LEN];
 	GArray *nameservers;
 	GPtrArray *domains;
 	GPtrArray *searches;
@@ -73,6 +92,22 @@ enum {
 static GParamSpec *obj_properties[LAST_PROP] = { NULL, };
 #define _NOTIFY(config, prop)    G_STMT_START { g_object_notify_by_pspec (G_OBJECT (config), obj_properties[prop]); } G_STMT_END
 
+static void
+_notify_addresses (NMIP6Config *config)
+{
+	NM_IP6_CONFIG_GET_PRIVATE (config)->addresses_generation++;
+	_NOTIFY (config, PROP_ADDRESS_DATA);
+	_NOTIFY (config, PROP_ADDRESSES);
+}
+
+static void
+_notify_routes (NMIP6Config *config)
+{
+	NM_IP6_CONFIG_GET_PRIVATE (config)->routes_generation++;
+	_NOTIFY (config, PROP_ROUTE_DATA);
+	_NOTIFY (config, PROP_ROUTES);
+}
+
 
 NMIP6Config *
 nm_ip6_config_new (int ifindex)
@@ -190,6 +225,133 @@ routes_are_duplicate (const NMPlatformIP6Route *a, const NMPlatformIP6Route *b,
 	            && nm_utils_ip6_route_metric_normalize (a->metric) == nm_utils_ip6_route_metric_normalize (b->metric)));
 }
 
+/* Like for NMIP4Config, large arrays get a lazily built hash index,
+ * which is dropped whenever entries are removed or reordered. */
+#define IDX_MIN_LEN 16
+
+typedef struct {
+	struct in6_addr network;
+	int plen;
+} RouteIdxKey;
+
+static guint
+_address_idx_key_hash (gconstpointer key)
+{
+	const guint32 *a = ((const struct in6_addr *) key)->s6_addr32;
+	guint h;
+
+	h = a[0];
+	h = (h * 33) + a[1];
+	h = (h * 33) + a[2];
+	h = (h * 33) + a[3];
+	return h;
+}
+
+static gboolean
+_address_idx_key_equal (gconstpointer a, gconstpointer b)
+{
+	/* consistent with addresses_are_duplicate() */
+	return IN6_ARE_ADDR_EQUAL ((const struct in6_addr *) a, (const struct in6_addr *) b);
+}
+
+static guint
+_route_idx_key_hash (gconstpointer key)
+{
+	const RouteIdxKey *k = key;
+
+	return (_address_idx_key_hash (&k->network) * 33) + k->plen;
+}
+
+static gboolean
+_route_idx_key_equal (gconstpointer a, gconstpointer b)
+{
+	const RouteIdxKey *k1 = a;
+	const RouteIdxKey *k2 = b;
+
+	return    IN6_ARE_ADDR_EQUAL (&k1->network, &k2->network)
+	       && k1->plen == k2->plen;
+}
+
+static void
+_addresses_idx_add (NMIP6ConfigPrivate *priv, guint i)
+{
+	const NMPlatformIP6Address *addr = &g_array_index (priv->addresses, NMPlatformIP6Address, i);
+
+	/* on duplicates, the first one wins -- like the linear search. */
+	if (!g_hash_table_contains (priv->addresses_idx, &addr->address))
+		g_hash_table_insert (priv->addresses_idx, g_memdup (&addr->address, sizeof (addr->address)), GUINT_TO_POINTER (i + 1));
+}
+
+static void
+_addresses_idx_clear (NMIP6ConfigPrivate *priv)
+{
+	g_clear_pointer (&priv->addresses_idx, g_hash_table_unref);
+}
+
+static void
+_routes_idx_add (NMIP6ConfigPrivate *priv, guint i)
+{
+	const NMPlatformIP6Route *route = &g_array_index (priv->routes, NMPlatformIP6Route, i);
+	RouteIdxKey *key = g_new (RouteIdxKey, 1);
+
+	key->network = route->network;
+	key->plen = route->plen;
+
+	if (g_hash_table_contains (priv->routes_idx, key))
+		g_free (key);
+	else
+		g_hash_table_insert (priv->routes_idx, key, GUINT_TO_POINTER (i + 1));
+}
+
+static void
+_routes_idx_clear (NMIP6ConfigPrivate *priv)
+{
+	g_clear_pointer (&priv->routes_idx, g_hash_table_unref);
+}
+
+/* The address and route arrays can be shared between configs, after merging
+ * into an empty config or after nm_ip6_config_replace(). A shared array is
+ * immutable, whoever wants to modify it first makes a private copy. */
+static void
+_array_unshare (GArray **array, gboolean *shared, gboolean keep_content)
+{
+	GArray *a;
+
+	if (!*shared)
+		return;
+
+	a = g_array_sized_new (FALSE, TRUE, g_array_get_element_size (*array),
+	                       keep_content ? (*array)->len : 0);
+	if (keep_content)
+		g_array_append_vals (a, (*array)->data, (*array)->len);
+	g_array_unref (*array);
+	*array = a;
+	*shared = FALSE;
+}
+
+#define _addresses_unshare(priv, keep_content) _array_unshare (&(priv)->addresses, &(priv)->addresses_shared, keep_content)
+#define _routes_unshare(priv, keep_content)    _array_unshare (&(priv)->routes, &(priv)->routes_shared, keep_content)
+
+static void
+_addresses_share (NMIP6ConfigPrivate *dst_priv, NMIP6ConfigPrivate *src_priv)
+{
+	_addresses_idx_clear (dst_priv);
+	g_array_unref (dst_priv->addresses);
+	dst_priv->addresses = g_array_ref (src_priv->addresses);
+	dst_priv->addresses_shared = TRUE;
+	src_priv->addresses_shared = TRUE;
+}
+
+static void
+_routes_share (NMIP6ConfigPrivate *dst_priv, NMIP6ConfigPrivate *src_priv)
+{
+	_routes_idx_clear (dst_priv);
+	g_array_unref (dst_priv->routes);
+	dst_priv->routes = g_array_ref (src_priv->routes);
+	dst_priv->routes_shared = TRUE;
+	src_priv->routes_shared = TRUE;
+}
+
 static gint
 _addresses_sort_cmp_get_prio (const struct in6_addr *addr)
 {
@@ -273,25 +435,30 @@ nm_ip6_config_addresses_sort (NMIP6Config *self, NMSettingIP6ConfigPrivacy use_t
 {
 	NMIP6ConfigPrivate *priv;
 	size_t data_len = 0;
-	char *data_pre = NULL;
+	char *data_sorted = NULL;
 	gboolean changed;
 
 	g_return_val_if_fail (NM_IS_IP6_CONFIG (self), FALSE);
 
 	priv = NM_IP6_CONFIG_GET_PRIVATE (self);
 	if (priv->addresses->len > 1) {
+		/* sort a copy, a shared array is only unshared if the order changes. */
 		data_len = priv->addresses->len * g_array_get_element_size (priv->addresses);
-		data_pre = g_new (char, data_len);
-		memcpy (data_pre, priv->addresses->data, data_len);
-
-		g_array_sort_with_data (priv->addresses, _addresses_sort_cmp, GINT_TO_POINTER (use_temporary));
+		data_sorted = g_memdup (priv->addresses->data, data_len);
+		g_qsort_with_data (data_sorted, priv->addresses->len,
+		                   g_array_get_element_size (priv->addresses),
+		                   _addresses_sort_cmp, GINT_TO_POINTER (use_temporary));
 
-		changed = memcmp (data_pre, priv->addresses->data, data_len) != 0;
-		g_free (data_pre);
+		changed = memcmp (data_sorted, priv->addresses->data, data_len) != 0;
+		if (changed) {
+			_addresses_unshare (priv, TRUE);
+			memcpy (priv->addresses->data, data_sorted, data_len);
+			_addresses_idx_clear (priv);
+		}
+		g_free (data_sorted);
 
 		if (changed) {
-			_NOTIFY (self, PROP_ADDRESS_DATA);
-			_NOTIFY (self, PROP_ADDRESSES);
+			_notify_addresses (self);
 			return TRUE;
 		}
 	}
@@ -308,6 +475,7 @@ nm_ip6_config_capture (int ifindex, gboolean capture_resolv_conf, NMSettingIP6Co
 	struct in6_addr old_gateway = IN6ADDR_ANY_INIT;
 	gboolean has_gateway = FALSE;
 	gboolean notify_nameservers = FALSE;
+	GPtrArray *routes;
 
 	/* Slaves have no IP configuration */
 	if (nm_platform_link_get_master (NM_PLATFORM_GET, ifindex) > 0)
@@ -318,14 +486,18 @@ nm_ip6_config_capture (int ifindex, gboolean capture_resolv_conf, NMSettingIP6Co
 
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
+	priv->addresses_shared = FALSE;
+	priv->routes_shared = FALSE;
+	_addresses_idx_clear (priv);
+	_routes_idx_clear (priv);
 
 	priv->addresses = nm_platform_ip6_address_get_all (NM_PLATFORM_GET, ifindex);
-	priv->routes = nm_platform_ip6_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	routes = nm_platform_ip6_route_lookup_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
 
 	/* Extract gateway from default route */
 	old_gateway = priv->gateway;
-	for (i = 0; i < priv->routes->len; ) {
-		const NMPlatformIP6Route *route = &g_array_index (priv->routes, NMPlatformIP6Route, i);
+	for (i = 0; i < routes->len; i++) {
+		const NMPlatformIP6Route *route = routes->pdata[i];
 
 		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
 			if (route->metric < lowest_metric) {
@@ -333,32 +505,31 @@ nm_ip6_config_capture (int ifindex, gboolean capture_resolv_conf, NMSettingIP6Co
 				lowest_metric = route->metric;
 			}
 			has_gateway = TRUE;
-			/* Remove the default route from the list */
-			g_array_remove_index_fast (priv->routes, i);
-			continue;
 		}
-		i++;
 	}
 
 	/* we detect the route metric based on the default route. All non-default
 	 * routes have their route metrics explicitly set. */
 	priv->route_metric = has_gateway ? (gint64) lowest_metric : (gint64) -1;
 
-	/* If there is a host route to the gateway, ignore that route.  It is
+	/* Copy the routes from the platform cache, except the default routes.
+	 * If there is a host route to the gateway, ignore that route too. It is
 	 * automatically added by NetworkManager when needed.
 	 */
-	if (has_gateway) {
-		for (i = 0; i < priv->routes->len; i++) {
-			const NMPlatformIP6Route *route = &g_array_index (priv->routes, NMPlatformIP6Route, i);
+	priv->routes = g_array_sized_new (FALSE, FALSE, sizeof (NMPlatformIP6Route), routes->len);
+	for (i = 0; i < routes->len; i++) {
+		const NMPlatformIP6Route *route = routes->pdata[i];
 
-			if (   route->plen == 128
-			    && IN6_ARE_ADDR_EQUAL (&route->network, &priv->gateway)
-			    && IN6_IS_ADDR_UNSPECIFIED (&route->gateway)) {
-				g_array_remove_index (priv->routes, i);
-				i--;
-			}
-		}
+		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
+			continue;
+		if (   has_gateway
+		    && route->plen == 128
+		    && IN6_ARE_ADDR_EQUAL (&route->network, &priv->gateway)
+		    && IN6_IS_ADDR_UNSPECIFIED (&route->gateway))
+			continue;
+		g_array_append_vals (priv->routes, route, 1);
 	}
+	g_ptr_array_unref (routes);
 
 	/* If the interface has the default route, and has IPv6 addresses, capture
 	 * nameservers from /etc/resolv.conf.
@@ -369,14 +540,13 @@ nm_ip6_config_capture (int ifindex, gboolean capture_resolv_conf, NMSettingIP6Co
 		                                                        NULL);
 
 	g_array_sort_with_data (priv->addresses, _addresses_sort_cmp, GINT_TO_POINTER (use_temporary));
+	_addresses_idx_clear (priv);
 
 	/* actually, nobody should be connected to the signal, just to be sure, notify */
 	if (notify_nameservers)
 		_NOTIFY (config, PROP_NAMESERVERS);
-	_NOTIFY (config, PROP_ADDRESS_DATA);
-	_NOTIFY (config, PROP_ADDRESSES);
-	_NOTIFY (config, PROP_ROUTE_DATA);
-	_NOTIFY (config, PROP_ROUTES);
+	_notify_addresses (config);
+	_notify_routes (config);
 	if (!IN6_ARE_ADDR_EQUAL (&priv->gateway, &old_gateway))
 		_NOTIFY (config, PROP_GATEWAY);
 
@@ -655,8 +825,15 @@ nm_ip6_config_merge (NMIP6Config *dst, const NMIP6Config *src, NMIPConfigMergeFl
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip6_config_get_num_addresses (src); i++)
-		nm_ip6_config_add_address (dst, nm_ip6_config_get_address (src, i));
+	if (!dst_priv->addresses->len && src_priv->addresses->len) {
+		/* @src has no duplicates, so merging into an empty config yields
+		 * the very same array. */
+		_addresses_share (dst_priv, src_priv);
+		_notify_addresses (dst);
+	} else {
+		for (i = 0; i < nm_ip6_config_get_num_addresses (src); i++)
+			nm_ip6_config_add_address (dst, nm_ip6_config_get_address (src, i));
+	}
 
 	/* nameservers */
 	if (!NM_FLAGS_HAS (merge_flags, NM_IP_CONFIG_MERGE_NO_DNS)) {
@@ -670,8 +847,15 @@ nm_ip6_config_merge (NMIP6Config *dst, const NMIP6Config *src, NMIPConfigMergeFl
 
 	/* routes */
 	if (!NM_FLAGS_HAS (merge_flags, NM_IP_CONFIG_MERGE_NO_ROUTES)) {
-		for (i = 0; i < nm_ip6_config_get_num_routes (src); i++)
-			nm_ip6_config_add_route (dst, nm_ip6_config_get_route (src, i));
+		if (   !dst_priv->routes->len
+		    && src_priv->routes->len
+		    && dst_priv->ifindex == src_priv->ifindex) {
+			_routes_share (dst_priv, src_priv);
+			_notify_routes (dst);
+		} else {
+			for (i = 0; i < nm_ip6_config_get_num_routes (src); i++)
+				nm_ip6_config_add_route (dst, nm_ip6_config_get_route (src, i));
+		}
 	}
 
 	if (dst_priv->route_metric == -1)
@@ -728,13 +912,23 @@ _addresses_get_index (const NMIP6Config *self, const NMPlatformIP6Address *addr)
 	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (self);
 	guint i;
 
-	for (i = 0; i < priv->addresses->len; i++) {
-		const NMPlatformIP6Address *a = &g_array_index (priv->addresses, NMPlatformIP6Address, i);
+	if (priv->addresses->len < IDX_MIN_LEN) {
+		for (i = 0; i < priv->addresses->len; i++) {
+			const NMPlatformIP6Address *a = &g_array_index (priv->addresses, NMPlatformIP6Address, i);
 
-		if (addresses_are_duplicate (a, addr))
-			return (int) i;
+			if (addresses_are_duplicate (a, addr))
+				return (int) i;
+		}
+		return -1;
 	}
-	return -1;
+
+	if (!priv->addresses_idx) {
+		priv->addresses_idx = g_hash_table_new_full (_address_idx_key_hash, _address_idx_key_equal, g_free, NULL);
+		for (i = 0; i < priv->addresses->len; i++)
+			_addresses_idx_add (priv, i);
+	}
+
+	return ((int) GPOINTER_TO_UINT (g_hash_table_lookup (priv->addresses_idx, &addr->address))) - 1;
 }
 
 static int
@@ -756,15 +950,79 @@ static int
 _routes_get_index (const NMIP6Config *self, const NMPlatformIP6Route *route)
 {
 	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (self);
+	RouteIdxKey key;
 	guint i;
 
-	for (i = 0; i < priv->routes->len; i++) {
-		const NMPlatformIP6Route *r = &g_array_index (priv->routes, NMPlatformIP6Route, i);
+	if (priv->routes->len < IDX_MIN_LEN) {
+		for (i = 0; i < priv->routes->len; i++) {
+			const NMPlatformIP6Route *r = &g_array_index (priv->routes, NMPlatformIP6Route, i);
 
-		if (routes_are_duplicate (route, r, FALSE))
-			return (int) i;
+			if (routes_are_duplicate (route, r, FALSE))
+				return (int) i;
+		}
+		return -1;
+	}
+
+	if (!priv->routes_idx) {
+		priv->routes_idx = g_hash_table_new_full (_route_idx_key_hash, _route_idx_key_equal, g_free, NULL);
+		for (i = 0; i < priv->routes->len; i++)
+			_routes_idx_add (priv, i);
+	}
+
+	key.network = route->network;
+	key.plen = route->plen;
+	return ((int) GPOINTER_TO_UINT (g_hash_table_lookup (priv->routes_idx, &key))) - 1;
+}
+
+/* Removes the entries of @array that are marked in @del, keeping the order
+ * of the others. Returns whether anything was removed. */
+static gboolean
+_array_remove_marked (GArray *array, const guint8 *del)
+{
+	guint elt_size = g_array_get_element_size (array);
+	guint i, j;
+
+	for (i = 0, j = 0; i < array->len; i++) {
+		if (del[i])
+			continue;
+		if (i != j)
+			memcpy (array->data + j * elt_size, array->data + i * elt_size, elt_size);
+		j++;
+	}
+	if (j == array->len)
+		return FALSE;
+	g_array_set_size (array, j);
+	return TRUE;
+}
+
+static void
+_addresses_del_marked (NMIP6Config *config, const guint8 *del)
+{
+	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
+
+	if (!memchr (del, TRUE, priv->addresses->len))
+		return;
+
+	_addresses_unshare (priv, TRUE);
+	if (_array_remove_marked (priv->addresses, del)) {
+		_addresses_idx_clear (priv);
+		_notify_addresses (config);
+	}
+}
+
+static void
+_routes_del_marked (NMIP6Config *config, const guint8 *del)
+{
+	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
+
+	if (!memchr (del, TRUE, priv->routes->len))
+		return;
+
+	_routes_unshare (priv, TRUE);
+	if (_array_remove_marked (priv->routes, del)) {
+		_routes_idx_clear (priv);
+		_notify_routes (config);
 	}
-	return -1;
 }
 
 static int
@@ -834,10 +1092,17 @@ nm_ip6_config_subtract (NMIP6Config *dst, const NMIP6Config *src)
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip6_config_get_num_addresses (src); i++) {
-		idx = _addresses_get_index (dst, nm_ip6_config_get_address (src, i));
-		if (idx >= 0)
-			nm_ip6_config_del_address (dst, idx);
+	if (nm_ip6_config_get_num_addresses (dst)) {
+		gs_free guint8 *del = g_new0 (guint8, nm_ip6_config_get_num_addresses (dst));
+
+		/* mark first and remove afterwards, so that the lookup index of @dst
+		 * stays valid. */
+		for (i = 0; i < nm_ip6_config_get_num_addresses (src); i++) {
+			idx = _addresses_get_index (dst, nm_ip6_config_get_address (src, i));
+			if (idx >= 0)
+				del[idx] = TRUE;
+		}
+		_addresses_del_marked (dst, del);
 	}
 
 	/* nameservers */
@@ -859,10 +1124,15 @@ nm_ip6_config_subtract (NMIP6Config *dst, const NMIP6Config *src)
 	/* ignore route_metric */
 
 	/* routes */
-	for (i = 0; i < nm_ip6_config_get_num_routes (src); i++) {
-		idx = _routes_get_index (dst, nm_ip6_config_get_route (src, i));
-		if (idx >= 0)
-			nm_ip6_config_del_route (dst, idx);
+	if (nm_ip6_config_get_num_routes (dst)) {
+		gs_free guint8 *del = g_new0 (guint8, nm_ip6_config_get_num_routes (dst));
+
+		for (i = 0; i < nm_ip6_config_get_num_routes (src); i++) {
+			idx = _routes_get_index (dst, nm_ip6_config_get_route (src, i));
+			if (idx >= 0)
+				del[idx] = TRUE;
+		}
+		_routes_del_marked (dst, del);
 	}
 
 	/* domains */
@@ -905,12 +1175,15 @@ nm_ip6_config_intersect (NMIP6Config *dst, const NMIP6Config *src)
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip6_config_get_num_addresses (dst); ) {
-		idx = _addresses_get_index (src, nm_ip6_config_get_address (dst, i));
-		if (idx < 0)
-			nm_ip6_config_del_address (dst, i);
-		else
-			i++;
+	if (nm_ip6_config_get_num_addresses (dst)) {
+		gs_free guint8 *del = g_new0 (guint8, nm_ip6_config_get_num_addresses (dst));
+
+		for (i = 0; i < nm_ip6_config_get_num_addresses (dst); i++) {
+			idx = _addresses_get_index (src, nm_ip6_config_get_address (dst, i));
+			if (idx < 0)
+				del[i] = TRUE;
+		}
+		_addresses_del_marked (dst, del);
 	}
 
 	/* ignore route_metric */
@@ -927,12 +1200,15 @@ nm_ip6_config_intersect (NMIP6Config *dst, const NMIP6Config *src)
 	}
 
 	/* routes */
-	for (i = 0; i < nm_ip6_config_get_num_routes (dst); ) {
-		idx = _routes_get_index (src, nm_ip6_config_get_route (dst, i));
-		if (idx < 0)
-			nm_ip6_config_del_route (dst, i);
-		else
-			i++;
+	if (nm_ip6_config_get_num_routes (dst)) {
+		gs_free guint8 *del = g_new0 (guint8, nm_ip6_config_get_num_routes (dst));
+
+		for (i = 0; i < nm_ip6_config_get_num_routes (dst); i++) {
+			idx = _routes_get_index (src, nm_ip6_config_get_route (dst, i));
+			if (idx < 0)
+				del[i] = TRUE;
+		}
+		_routes_del_marked (dst, del);
 	}
 
 	/* ignore domains */
@@ -1007,7 +1283,9 @@ nm_ip6_config_replace (NMIP6Config *dst, const NMIP6Config *src, gboolean *relev
 	/* addresses */
 	num = nm_ip6_config_get_num_addresses (src);
 	are_equal = num == nm_ip6_config_get_num_addresses (dst);
-	if (are_equal) {
+	if (!are_equal)
+		has_relevant_changes = TRUE;
+	else if (src_priv->addresses != dst_priv->addresses) {
 		for (i = 0; i < num; i++ ) {
 			if (nm_platform_ip6_address_cmp (src_addr = nm_ip6_config_get_address (src, i),
 			                                 dst_addr = nm_ip6_config_get_address (dst, i))) {
@@ -1021,19 +1299,21 @@ nm_ip6_config_replace (NMIP6Config *dst, const NMIP6Config *src, gboolean *relev
 				}
 			}
 		}
-	} else
-		has_relevant_changes = TRUE;
+	}
 	if (!are_equal) {
-		nm_ip6_config_reset_addresses (dst);
-		for (i = 0; i < num; i++)
-			nm_ip6_config_add_address (dst, nm_ip6_config_get_address (src, i));
+		/* take over the array of @src as a whole and notify once
+		 * instead of once per address. */
+		_addresses_share (dst_priv, src_priv);
+		_notify_addresses (dst);
 		has_minor_changes = TRUE;
 	}
 
 	/* routes */
 	num = nm_ip6_config_get_num_routes (src);
 	are_equal = num == nm_ip6_config_get_num_routes (dst);
-	if (are_equal) {
+	if (!are_equal)
+		has_relevant_changes = TRUE;
+	else if (src_priv->routes != dst_priv->routes) {
 		for (i = 0; i < num; i++ ) {
 			if (nm_platform_ip6_route_cmp (src_route = nm_ip6_config_get_route (src, i),
 			                               dst_route = nm_ip6_config_get_route (dst, i))) {
@@ -1044,12 +1324,12 @@ nm_ip6_config_replace (NMIP6Config *dst, const NMIP6Config *src, gboolean *relev
 				}
 			}
 		}
-	} else
-		has_relevant_changes = TRUE;
+	}
 	if (!are_equal) {
-		nm_ip6_config_reset_routes (dst);
-		for (i = 0; i < num; i++)
-			nm_ip6_config_add_route (dst, nm_ip6_config_get_route (src, i));
+		/* the ifindex was synced above, so the routes of @src are
+		 * valid for @dst as they are. */
+		_routes_share (dst_priv, src_priv);
+		_notify_routes (dst);
 		has_minor_changes = TRUE;
 	}
 
@@ -1231,6 +1511,8 @@ nm_ip6_config_set_gateway (NMIP6Config *config, const struct in6_addr *gateway)
 			return;
 		memset (&priv->gateway, 0, sizeof (priv->gateway));
 	}
+	/* the legacy Addresses property carries the gateway */
+	priv->addresses_generation++;
 	_NOTIFY (config, PROP_GATEWAY);
 }
 
@@ -1258,9 +1540,10 @@ nm_ip6_config_reset_addresses (NMIP6Config *config)
 	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
 
 	if (priv->addresses->len != 0) {
+		_addresses_unshare (priv, FALSE);
 		g_array_set_size (priv->addresses, 0);
-		_NOTIFY (config, PROP_ADDRESS_DATA);
-		_NOTIFY (config, PROP_ADDRESSES);
+		_addresses_idx_clear (priv);
+		_notify_addresses (config);
 	}
 }
 
@@ -1283,42 +1566,46 @@ nm_ip6_config_add_address (NMIP6Config *config, const NMPlatformIP6Address *new)
 
 	g_return_if_fail (new != NULL);
 
-	for (i = 0; i < priv->addresses->len; i++ ) {
+	i = _addresses_get_index (config, new);
+	if (i >= 0) {
 		NMPlatformIP6Address *item = &g_array_index (priv->addresses, NMPlatformIP6Address, i);
 
-		if (addresses_are_duplicate (item, new)) {
-			if (nm_platform_ip6_address_cmp (item, new) == 0)
-				return;
-
-			/* remember the old values. */
-			item_old = *item;
-			/* Copy over old item to get new lifetime, timestamp, preferred */
-			*item = *new;
-
-			/* But restore highest priority source */
-			item->source = MAX (item_old.source, new->source);
-
-			/* for addresses that we read from the kernel, we keep the timestamps as defined
-			 * by the previous source (item_old). The reason is, that the other source configured the lifetimes
-			 * with "what should be" and the kernel values are "what turned out after configuring it".
-			 *
-			 * For other sources, the longer lifetime wins. */
-			if (   (new->source == NM_IP_CONFIG_SOURCE_KERNEL && new->source != item_old.source)
-			    || nm_platform_ip_address_cmp_expiry ((const NMPlatformIPAddress *) &item_old, (const NMPlatformIPAddress *) new) > 0) {
-				item->timestamp = item_old.timestamp;
-				item->lifetime = item_old.lifetime;
-				item->preferred = item_old.preferred;
-			}
-			if (nm_platform_ip6_address_cmp (&item_old, item) == 0)
-				return;
-			goto NOTIFY;
+		if (nm_platform_ip6_address_cmp (item, new) == 0)
+			return;
+
+		_addresses_unshare (priv, TRUE);
+		item = &g_array_index (priv->addresses, NMPlatformIP6Address, i);
+
+		/* remember the old values. */
+		item_old = *item;
+		/* Copy over old item to get new lifetime, timestamp, preferred */
+		*item = *new;
+
+		/* But restore highest priority source */
+		item->source = MAX (item_old.source, new->source);
+
+		/* for addresses that we read from the kernel, we keep the timestamps as defined
+		 * by the previous source (item_old). The reason is, that the other source configured the lifetimes
+		 * with "what should be" and the kernel values are "what turned out after configuring it".
+		 *
+		 * For other sources, the longer lifetime wins. */
+		if (   (new->source == NM_IP_CONFIG_SOURCE_KERNEL && new->source != item_old.source)
+		    || nm_platform_ip_address_cmp_expiry ((const NMPlatformIPAddress *) &item_old, (const NMPlatformIPAddress *) new) > 0) {
+			item->timestamp = item_old.timestamp;
+			item->lifetime = item_old.lifetime;
+			item->preferred = item_old.preferred;
 		}
+		if (nm_platform_ip6_address_cmp (&item_old, item) == 0)
+			return;
+		goto NOTIFY;
 	}
 
+	_addresses_unshare (priv, TRUE);
 	g_array_append_val (priv->addresses, *new);
+	if (priv->addresses_idx)
+		_addresses_idx_add (priv, priv->addresses->len - 1);
 NOTIFY:
-	_NOTIFY (config, PROP_ADDRESS_DATA);
-	_NOTIFY (config, PROP_ADDRESSES);
+	_notify_addresses (config);
 }
 
 void
@@ -1328,9 +1615,10 @@ nm_ip6_config_del_address (NMIP6Config *config, guint i)
 
 	g_return_if_fail (i < priv->addresses->len);
 
+	_addresses_unshare (priv, TRUE);
 	g_array_remove_index (priv->addresses, i);
-	_NOTIFY (config, PROP_ADDRESS_DATA);
-	_NOTIFY (config, PROP_ADDRESSES);
+	_addresses_idx_clear (priv);
+	_notify_addresses (config);
 }
 
 guint
@@ -1364,9 +1652,10 @@ nm_ip6_config_reset_routes (NMIP6Config *config)
 	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
 
 	if (priv->routes->len != 0) {
+		_routes_unshare (priv, FALSE);
 		g_array_set_size (priv->routes, 0);
-		_NOTIFY (config, PROP_ROUTE_DATA);
-		_NOTIFY (config, PROP_ROUTES);
+		_routes_idx_clear (priv);
+		_notify_routes (config);
 	}
 }
 
@@ -1391,26 +1680,29 @@ nm_ip6_config_add_route (NMIP6Config *config, const NMPlatformIP6Route *new)
 	g_return_if_fail (new->plen > 0);
 	g_assert (priv->ifindex);
 
-	for (i = 0; i < priv->routes->len; i++ ) {
+	i = _routes_get_index (config, new);
+	if (i >= 0) {
 		NMPlatformIP6Route *item = &g_array_index (priv->routes, NMPlatformIP6Route, i);
 
-		if (routes_are_duplicate (item, new, FALSE)) {
-			if (nm_platform_ip6_route_cmp (item, new) == 0)
-				return;
-			old_source = item->source;
-			*item = *new;
-			/* Restore highest priority source */
-			item->source = MAX (old_source, new->source);
-			item->ifindex = priv->ifindex;
-			goto NOTIFY;
-		}
+		if (nm_platform_ip6_route_cmp (item, new) == 0)
+			return;
+		_routes_unshare (priv, TRUE);
+		item = &g_array_index (priv->routes, NMPlatformIP6Route, i);
+		old_source = item->source;
+		*item = *new;
+		/* Restore highest priority source */
+		item->source = MAX (old_source, new->source);
+		item->ifindex = priv->ifindex;
+		goto NOTIFY;
 	}
 
+	_routes_unshare (priv, TRUE);
 	g_array_append_val (priv->routes, *new);
 	g_array_index (priv->routes, NMPlatformIP6Route, priv->routes->len - 1).ifindex = priv->ifindex;
+	if (priv->routes_idx)
+		_routes_idx_add (priv, priv->routes->len - 1);
 NOTIFY:
-	_NOTIFY (config, PROP_ROUTE_DATA);
-	_NOTIFY (config, PROP_ROUTES);
+	_notify_routes (config);
 }
 
 void
@@ -1420,9 +1712,10 @@ nm_ip6_config_del_route (NMIP6Config *config, guint i)
 
 	g_return_if_fail (i < priv->routes->len);
 
+	_routes_unshare (priv, TRUE);
 	g_array_remove_index (priv->routes, i);
-	_NOTIFY (config, PROP_ROUTE_DATA);
-	_NOTIFY (config, PROP_ROUTES);
+	_routes_idx_clear (priv);
+	_notify_routes (config);
 }
 
 guint
@@ -1512,6 +1805,7 @@ nm_ip6_config_reset_nameservers (NMIP6Config *config)
 
 	if (priv->nameservers->len != 0) {
 		g_array_set_size (priv->nameservers, 0);
+		priv->dns_digest_valid = FALSE;
 		_NOTIFY (config, PROP_NAMESERVERS);
 	}
 }
@@ -1529,6 +1823,7 @@ nm_ip6_config_add_nameserver (NMIP6Config *config, const struct in6_addr *new)
 			return;
 
 	g_array_append_val (priv->nameservers, *new);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_NAMESERVERS);
 }
 
@@ -1540,6 +1835,7 @@ nm_ip6_config_del_nameserver (NMIP6Config *config, guint i)
 	g_return_if_fail (i < priv->nameservers->len);
 
 	g_array_remove_index (priv->nameservers, i);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_NAMESERVERS);
 }
 
@@ -1568,6 +1864,7 @@ nm_ip6_config_reset_domains (NMIP6Config *config)
 
 	if (priv->domains->len != 0) {
 		g_ptr_array_set_size (priv->domains, 0);
+		priv->dns_digest_valid = FALSE;
 		_NOTIFY (config, PROP_DOMAINS);
 	}
 }
@@ -1586,6 +1883,7 @@ nm_ip6_config_add_domain (NMIP6Config *config, const char *domain)
 			return;
 
 	g_ptr_array_add (priv->domains, g_strdup (domain));
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_DOMAINS);
 }
 
@@ -1597,6 +1895,7 @@ nm_ip6_config_del_domain (NMIP6Config *config, guint i)
 	g_return_if_fail (i < priv->domains->len);
 
 	g_ptr_array_remove_index (priv->domains, i);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_DOMAINS);
 }
 
@@ -1625,6 +1924,7 @@ nm_ip6_config_reset_searches (NMIP6Config *config)
 
 	if (priv->searches->len != 0) {
 		g_ptr_array_set_size (priv->searches, 0);
+		priv->dns_digest_valid = FALSE;
 		_NOTIFY (config, PROP_SEARCHES);
 	}
 }
@@ -1643,6 +1943,7 @@ nm_ip6_config_add_search (NMIP6Config *config, const char *new)
 			return;
 
 	g_ptr_array_add (priv->searches, g_strdup (new));
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_SEARCHES);
 }
 
@@ -1654,6 +1955,7 @@ nm_ip6_config_del_search (NMIP6Config *config, guint i)
 	g_return_if_fail (i < priv->searches->len);
 
 	g_ptr_array_remove_index (priv->searches, i);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_SEARCHES);
 }
 
@@ -1682,6 +1984,7 @@ nm_ip6_config_reset_dns_options (NMIP6Config *config)
 
 	if (priv->dns_options->len != 0) {
 		g_ptr_array_set_size (priv->dns_options, 0);
+		priv->dns_digest_valid = FALSE;
 		_NOTIFY (config, PROP_DNS_OPTIONS);
 	}
 }
@@ -1700,6 +2003,7 @@ nm_ip6_config_add_dns_option (NMIP6Config *config, const char *new)
 			return;
 
 	g_ptr_array_add (priv->dns_options, g_strdup (new));
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_DNS_OPTIONS);
 }
 
@@ -1711,6 +2015,7 @@ nm_ip6_config_del_dns_option (NMIP6Config *config, guint i)
 	g_return_if_fail (i < priv->dns_options->len);
 
 	g_ptr_array_remove_index (priv->dns_options, i);
+	priv->dns_digest_valid = FALSE;
 	_NOTIFY (config, PROP_DNS_OPTIONS);
 }
 
@@ -1765,6 +2070,33 @@ hash_in6addr (GChecksum *sum, const struct in6_addr *a)
 		g_checksum_update (sum, (const guint8 *) &in6addr_any, sizeof (in6addr_any));
 }
 
+/**
+ * nm_ip6_config_get_dns_digest:
+ * @config: the #NMIP6Config
+ *
+ * Returns: the SHA1 digest of the DNS related parts of @config, as hashed
+ *   by nm_ip6_config_hash() with @dns_only. The digest is cached until the
+ *   DNS settings of @config change. It is %NM_IP6_CONFIG_DNS_DIGEST_LEN
+ *   bytes long.
+ */
+const guint8 *
+nm_ip6_config_get_dns_digest (const NMIP6Config *config)
+{
+	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
+
+	if (!priv->dns_digest_valid) {
+		GChecksum *sum;
+		gsize len = sizeof (priv->dns_digest);
+
+		sum = g_checksum_new (G_CHECKSUM_SHA1);
+		nm_ip6_config_hash (config, sum, TRUE);
+		g_checksum_get_digest (sum, priv->dns_digest, &len);
+		g_checksum_free (sum);
+		priv->dns_digest_valid = TRUE;
+	}
+	return priv->dns_digest;
+}
+
 void
 nm_ip6_config_hash (const NMIP6Config *config, GChecksum *sum, gboolean dns_only)
 {
@@ -1870,6 +2202,25 @@ nm_ip6_config_init (NMIP6Config *config)
 	priv->route_metric = -1;
 }
 
+static GVariant *
+_variant_cache_get (VariantCache *cache, guint64 generation,
+                    GVariant *(*build) (const NMIP6Config *config), const NMIP6Config *config)
+{
+	if (!cache->variant || cache->generation != generation) {
+		if (cache->variant)
+			g_variant_unref (cache->variant);
+		cache->variant = g_variant_ref_sink (build (config));
+		cache->generation = generation;
+	}
+	return cache->variant;
+}
+
+static void
+_variant_cache_clear (VariantCache *cache)
+{
+	g_clear_pointer (&cache->variant, g_variant_unref);
+}
+
 static void
 finalize (GObject *object)
 {
@@ -1877,6 +2228,12 @@ finalize (GObject *object)
 
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
+	_addresses_idx_clear (priv);
+	_routes_idx_clear (priv);
+	_variant_cache_clear (&priv->address_data_variant);
+	_variant_cache_clear (&priv->addresses_variant);
+	_variant_cache_clear (&priv->route_data_variant);
+	_variant_cache_clear (&priv->routes_variant);
 	g_array_unref (priv->nameservers);
 	g_ptr_array_unref (priv->domains);
 	g_ptr_array_unref (priv->searches);
@@ -1905,6 +2262,123 @@ nameservers_to_gvalue (GArray *array, GValue *value)
 	g_value_take_variant (value, g_variant_builder_end (&builder));
 }
 
+static GVariant *
+_address_data_to_variant (const NMIP6Config *config)
+{
+	GVariantBuilder array_builder, addr_builder;
+	int naddr = nm_ip6_config_get_num_addresses (config);
+	int i;
+
+	g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aa{sv}"));
+	for (i = 0; i < naddr; i++) {
+		const NMPlatformIP6Address *address = nm_ip6_config_get_address (config, i);
+
+		g_variant_builder_init (&addr_builder, G_VARIANT_TYPE ("a{sv}"));
+		g_variant_builder_add (&addr_builder, "{sv}",
+		                       "address",
+		                       g_variant_new_string (nm_utils_inet6_ntop (&address->address, NULL)));
+		g_variant_builder_add (&addr_builder, "{sv}",
+		                       "prefix",
+		                       g_variant_new_uint32 (address->plen));
+		if (   !IN6_IS_ADDR_UNSPECIFIED (&address->peer_address)
+		    && !IN6_ARE_ADDR_EQUAL (&address->peer_address, &address->address)) {
+			g_variant_builder_add (&addr_builder, "{sv}",
+			                       "peer",
+			                       g_variant_new_string (nm_utils_inet6_ntop (&address->peer_address, NULL)));
+		}
+
+		g_variant_builder_add (&array_builder, "a{sv}", &addr_builder);
+	}
+
+	return g_variant_builder_end (&array_builder);
+}
+
+static GVariant *
+_addresses_to_variant (const NMIP6Config *config)
+{
+	GVariantBuilder array_builder;
+	const struct in6_addr *gateway = nm_ip6_config_get_gateway (config);
+	int naddr = nm_ip6_config_get_num_addresses (config);
+	int i;
+
+	g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("a(ayuay)"));
+	for (i = 0; i < naddr; i++) {
+		const NMPlatformIP6Address *address = nm_ip6_config_get_address (config, i);
+
+		g_variant_builder_add (&array_builder, "(@ayu@ay)",
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  &address->address, 16, 1),
+		                       address->plen,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  (i == 0 && gateway ? gateway : &in6addr_any),
+		                                                  16, 1));
+	}
+
+	return g_variant_builder_end (&array_builder);
+}
+
+static GVariant *
+_route_data_to_variant (const NMIP6Config *config)
+{
+	GVariantBuilder array_builder, route_builder;
+	guint nroutes = nm_ip6_config_get_num_routes (config);
+	int i;
+
+	g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aa{sv}"));
+	for (i = 0; i < nroutes; i++) {
+		const NMPlatformIP6Route *route = nm_ip6_config_get_route (config, i);
+
+		g_variant_builder_init (&route_builder, G_VARIANT_TYPE ("a{sv}"));
+		g_variant_builder_add (&route_builder, "{sv}",
+		                       "dest",
+		                       g_variant_new_string (nm_utils_inet6_ntop (&route->network, NULL)));
+		g_variant_builder_add (&route_builder, "{sv}",
+		                       "prefix",
+		                       g_variant_new_uint32 (route->plen));
+		if (!IN6_IS_ADDR_UNSPECIFIED (&route->gateway)) {
+			g_variant_builder_add (&route_builder, "{sv}",
+			                       "next-hop",
+			                       g_variant_new_string (nm_utils_inet6_ntop (&route->gateway, NULL)));
+		}
+
+		g_variant_builder_add (&route_builder, "{sv}",
+		                       "metric",
+		                       g_variant_new_uint32 (route->metric));
+
+		g_variant_builder_add (&array_builder, "a{sv}", &route_builder);
+	}
+
+	return g_variant_builder_end (&array_builder);
+}
+
+static GVariant *
+_routes_to_variant (const NMIP6Config *config)
+{
+	GVariantBuilder array_builder;
+	int nroutes = nm_ip6_config_get_num_routes (config);
+	int i;
+
+	g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("a(ayuayu)"));
+	for (i = 0; i < nroutes; i++) {
+		const NMPlatformIP6Route *route = nm_ip6_config_get_route (config, i);
+
+		/* legacy versions of nm_ip6_route_set_prefix() in libnm-util assert that the
+		 * plen is positive. Skip the default routes not to break older clients. */
+		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
+			continue;
+
+		g_variant_builder_add (&array_builder, "(@ayu@ayu)",
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  &route->network, 16, 1),
+		                       (guint32) route->plen,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  &route->gateway, 16, 1),
+		                       (guint32) route->metric);
+	}
+
+	return g_variant_builder_end (&array_builder);
+}
+
 static void
 get_property (GObject *object, guint prop_id,
 			  GValue *value, GParamSpec *pspec)
@@ -1917,117 +2391,16 @@ get_property (GObject *object, guint prop_id,
 		g_value_set_int (value, priv->ifindex);
 		break;
 	case PROP_ADDRESS_DATA:
-		{
-			GVariantBuilder array_builder, addr_builder;
-			int naddr = nm_ip6_config_get_num_addresses (config);
-			int i;
-
-			g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aa{sv}"));
-			for (i = 0; i < naddr; i++) {
-				const NMPlatformIP6Address *address = nm_ip6_config_get_address (config, i);
-
-				g_variant_builder_init (&addr_builder, G_VARIANT_TYPE ("a{sv}"));
-				g_variant_builder_add (&addr_builder, "{sv}",
-				                       "address",
-				                       g_variant_new_string (nm_utils_inet6_ntop (&address->address, NULL)));
-				g_variant_builder_add (&addr_builder, "{sv}",
-				                       "prefix",
-				                       g_variant_new_uint32 (address->plen));
-				if (   !IN6_IS_ADDR_UNSPECIFIED (&address->peer_address)
-				    && !IN6_ARE_ADDR_EQUAL (&address->peer_address, &address->address)) {
-					g_variant_builder_add (&addr_builder, "{sv}",
-					                       "peer",
-					                       g_variant_new_string (nm_utils_inet6_ntop (&address->peer_address, NULL)));
-				}
-
-				g_variant_builder_add (&array_builder, "a{sv}", &addr_builder);
-			}
-
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
-		}
+		g_value_set_variant (value, _variant_cache_get (&priv->address_data_variant, priv->addresses_generation, _address_data_to_variant, config));
 		break;
 	case PROP_ADDRESSES:
-		{
-			GVariantBuilder array_builder;
-			const struct in6_addr *gateway = nm_ip6_config_get_gateway (config);
-			int naddr = nm_ip6_config_get_num_addresses (config);
-			int i;
-
-			g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("a(ayuay)"));
-			for (i = 0; i < naddr; i++) {
-				const NMPlatformIP6Address *address = nm_ip6_config_get_address (config, i);
-
-				g_variant_builder_add (&array_builder, "(@ayu@ay)",
-				                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
-				                                                  &address->address, 16, 1),
-				                       address->plen,
-				                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
-				                                                  (i == 0 && gateway ? gateway : &in6addr_any),
-				                                                  16, 1));
-			}
-
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
-		}
+		g_value_set_variant (value, _variant_cache_get (&priv->addresses_variant, priv->addresses_generation, _addresses_to_variant, config));
 		break;
 	case PROP_ROUTE_DATA:
-		{
-			GVariantBuilder array_builder, route_builder;
-			guint nroutes = nm_ip6_config_get_num_routes (config);
-			int i;
-
-			g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("aa{sv}"));
-			for (i = 0; i < nroutes; i++) {
-				const NMPlatformIP6Route *route = nm_ip6_config_get_route (config, i);
-
-				g_variant_builder_init (&route_builder, G_VARIANT_TYPE ("a{sv}"));
-				g_variant_builder_add (&route_builder, "{sv}",
-				                       "dest",
-				                       g_variant_new_string (nm_utils_inet6_ntop (&route->network, NULL)));
-				g_variant_builder_add (&route_builder, "{sv}",
-				                       "prefix",
-				                       g_variant_new_uint32 (route->plen));
-				if (!IN6_IS_ADDR_UNSPECIFIED (&route->gateway)) {
-					g_variant_builder_add (&route_builder, "{sv}",
-					                       "next-hop",
-					                       g_variant_new_string (nm_utils_inet6_ntop (&route->gateway, NULL)));
-				}
-
-				g_variant_builder_add (&route_builder, "{sv}",
-				                       "metric",
-				                       g_variant_new_uint32 (route->metric));
-
-				g_variant_builder_add (&array_builder, "a{sv}", &route_builder);
-			}
-
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
-		}
+		g_value_set_variant (value, _variant_cache_get (&priv->route_data_variant, priv->routes_generation, _route_data_to_variant, config));
 		break;
 	case PROP_ROUTES:
-		{
-			GVariantBuilder array_builder;
-			int nroutes = nm_ip6_config_get_num_routes (config);
-			int i;
-
-			g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("a(ayuayu)"));
-			for (i = 0; i < nroutes; i++) {
-				const NMPlatformIP6Route *route = nm_ip6_config_get_route (config, i);
-
-				/* legacy versions of nm_ip6_route_set_prefix() in libnm-util assert that the
-				 * plen is positive. Skip the default routes not to break older clients. */
-				if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
-					continue;
-
-				g_variant_builder_add (&array_builder, "(@ayu@ayu)",
-				                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
-				                                                  &route->network, 16, 1),
-				                       (guint32) route->plen,
-				                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
-				                                                  &route->gateway, 16, 1),
-				                       (guint32) route->metric);
-			}
-
-			g_value_take_variant (value, g_variant_builder_end (&array_builder));
-		}
+		g_value_set_variant (value, _variant_cache_get (&priv->routes_variant, priv->routes_generation, _routes_to_variant, config));
 		break;
 	case PROP_GATEWAY:
 		if (!IN6_IS_ADDR_UNSPECIFIED (&priv->gateway))
@@ -138,6 +138,8 @@ void nm_ip6_config_set_mss (NMIP6Config *config, guint32 mss);
 guint32 nm_ip6_config_get_mss (const NMIP6Config *config);
 
 void nm_ip6_config_hash (const NMIP6Config *config, GChecksum *sum, gboolean dns_only);
+#define NM_IP6_CONFIG_DNS_DIGEST_LEN 20
+const guint8 *nm_ip6_config_get_dns_digest (const NMIP6Config *config);
 gboolean nm_ip6_config_equal (const NMIP6Config *a, const NMIP6Config *b);
 
 /******************************************************/
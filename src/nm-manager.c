@@ -2217,13 +2217,18 @@ find_master (NMManager *self,
 			/* Might be a virtual interface that hasn't been created yet, so
 			 * look through the interface names of connections that require
 			 * virtual interfaces and see if one of their virtual interface
-			 * names matches the master.
+			 * names matches the master. Master connections always have an
+			 * interface name, so only those with a matching one are
+			 * candidates.
 			 */
-			connections = nm_manager_get_activatable_connections (self);
+			connections = nm_settings_get_connections_by_iface (priv->settings, master);
 			for (iter = connections; iter && !master_connection; iter = g_slist_next (iter)) {
 				NMSettingsConnection *candidate = iter->data;
 				char *vname;
 
+				if (find_ac_for_connection (self, NM_CONNECTION (candidate)))
+					continue;
+
 				vname = get_virtual_iface_name (self, NM_CONNECTION (candidate), NULL, NULL);
 				if (g_strcmp0 (master, vname) == 0 && is_compatible_with_slave (NM_CONNECTION (candidate), connection))
 					master_connection = candidate;
@@ -4111,6 +4116,28 @@ impl_manager_get_logging (NMManager *manager,
 	                                                      nm_logging_domains_to_string ()));
 }
 
+static void
+impl_manager_get_netlink_statistics (NMManager *manager,
+                                     GDBusMethodInvocation *context)
+{
+	NMPlatformNetlinkStats stats;
+	GVariantBuilder builder;
+
+	nm_platform_netlink_get_stats (NM_PLATFORM_GET, &stats);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+	g_variant_builder_add (&builder, "{sv}", "overruns", g_variant_new_uint32 (stats.overruns));
+	g_variant_builder_add (&builder, "{sv}", "resyncs", g_variant_new_uint32 (stats.resyncs));
+	g_variant_builder_add (&builder, "{sv}", "resync-last-usec", g_variant_new_int64 (stats.resync_last_usec));
+	g_variant_builder_add (&builder, "{sv}", "resync-total-usec", g_variant_new_int64 (stats.resync_total_usec));
+	g_variant_builder_add (&builder, "{sv}", "rcvbuf-size", g_variant_new_int32 (stats.rcvbuf_size));
+	g_variant_builder_add (&builder, "{sv}", "rcvbuf-size-route", g_variant_new_int32 (stats.rcvbuf_size_route));
+	g_variant_builder_add (&builder, "{sv}", "rcvbuf-max", g_variant_new_int32 (stats.rcvbuf_max));
+
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(a{sv})", &builder));
+}
+
 static void
 connectivity_check_done (GObject *object,
                          GAsyncResult *result,
@@ -5538,6 +5565,7 @@ nm_manager_class_init (NMManagerClass *manager_class)
 	                                        "GetPermissions", impl_manager_get_permissions,
 	                                        "SetLogging", impl_manager_set_logging,
 	                                        "GetLogging", impl_manager_get_logging,
+	                                        "GetNetlinkStatistics", impl_manager_get_netlink_statistics,
 	                                        "CheckConnectivity", impl_manager_check_connectivity,
 	                                        "state", impl_manager_get_state,
 	                                        NULL);
@@ -27,63 +27,256 @@
 
 #include "nm-macros-internal.h"
 
+/* The index is a hash table with open addressing and linear probing. Its
+ * size is a power of two, and at most half of the slots are in use. Each
+ * group keeps its values in a contiguous, %NULL terminated array, so that
+ * nm_multi_index_lookup() can return it as is. */
 struct NMMultiIndex {
+	NMMultiIndexFuncHash hash_fcn;
 	NMMultiIndexFuncEqual equal_fcn;
 	NMMultiIndexFuncClone clone_fcn;
-	GHashTable *hash;
+	NMMultiIndexFuncDestroy destroy_fcn;
+	struct _ValuesData **slots;
+	guint n_slots;
+	guint n_groups;
 };
 
-typedef struct {
-	GHashTable *index;
+/* Groups with up to this many values are searched linearly. Larger ones
+ * get an additional table to find the position of a value. */
+#define VALUES_LINEAR_MAX 8
+
+typedef struct _ValuesData {
+	NMMultiIndexId *id;
+	guint id_hash;
+
 	gpointer *values;
+	guint len;
+	guint alloc;
+
+	/* open addressing table of the positions in @values plus one. Zero
+	 * marks a free slot. Between one eighth and one half of the slots
+	 * are in use. */
+	guint *pos;
+	guint n_pos;
 } ValuesData;
 
+#define NOT_FOUND G_MAXUINT
+
 /******************************************************************************************/
 
-static ValuesData *
-_values_data_create (void)
+static inline guint
+_hash_mix (guint64 x)
 {
-	ValuesData *values_data;
+	/* the finalizer of MurmurHash3. Linear probing needs well distributed
+	 * lower bits, which neither pointers nor the id hashes guarantee. */
+	x ^= x >> 33;
+	x *= G_GUINT64_CONSTANT (0xff51afd7ed558ccd);
+	x ^= x >> 33;
+	return (guint) x;
+}
+
+#define _ptr_hash(ptr) _hash_mix ((guint64) (guintptr) (ptr))
 
-	values_data = g_slice_new (ValuesData);
-	values_data->index = g_hash_table_new (NULL, NULL);
-	values_data->values = NULL;
-	return values_data;
+static guint
+_values_pos_find_slot (const ValuesData *values_data, gconstpointer value)
+{
+	guint mask = values_data->n_pos - 1;
+	guint i;
+
+	nm_assert (values_data->pos);
+
+	i = _ptr_hash (value) & mask;
+	while (   values_data->pos[i]
+	       && values_data->values[values_data->pos[i] - 1] != value)
+		i = (i + 1) & mask;
+	return i;
 }
 
-static void
-_values_data_destroy (ValuesData *values_data)
+static guint
+_values_find (const ValuesData *values_data, gconstpointer value)
 {
-	if (values_data) {
-		g_free (values_data->values);
-		g_hash_table_unref (values_data->index);
-		g_slice_free (ValuesData, values_data);
+	guint i;
+
+	if (values_data->pos) {
+		i = _values_pos_find_slot (values_data, value);
+		return values_data->pos[i] ? values_data->pos[i] - 1 : NOT_FOUND;
 	}
+
+	for (i = 0; i < values_data->len; i++) {
+		if (values_data->values[i] == value)
+			return i;
+	}
+	return NOT_FOUND;
 }
 
 static void
-_values_data_populate_array (ValuesData *values_data)
+_values_pos_rebuild (ValuesData *values_data)
 {
-	guint i, len;
-	gpointer *values;
-	GHashTableIter iter;
+	guint i, n;
 
-	nm_assert (values_data);
-	nm_assert (values_data->index && g_hash_table_size (values_data->index) > 0);
+	g_clear_pointer (&values_data->pos, g_free);
+	values_data->n_pos = 0;
 
-	if (values_data->values)
+	if (values_data->len <= VALUES_LINEAR_MAX)
 		return;
 
-	len = g_hash_table_size (values_data->index);
-	values = g_new (gpointer, len + 1);
+	for (n = 16; n < values_data->len * 4; n <<= 1)
+		;
+	values_data->pos = g_new0 (guint, n);
+	values_data->n_pos = n;
+	for (i = 0; i < values_data->len; i++)
+		values_data->pos[_values_pos_find_slot (values_data, values_data->values[i])] = i + 1;
+}
+
+static gboolean
+_values_add (ValuesData *values_data, gconstpointer value)
+{
+	guint slot = 0;
+
+	if (values_data->pos) {
+		slot = _values_pos_find_slot (values_data, value);
+		if (values_data->pos[slot])
+			return FALSE;
+	} else if (_values_find (values_data, value) != NOT_FOUND)
+		return FALSE;
+
+	if (values_data->len == values_data->alloc) {
+		values_data->alloc = MAX (4, values_data->alloc * 2);
+		values_data->values = g_renew (gpointer, values_data->values, values_data->alloc + 1);
+	}
+	values_data->values[values_data->len++] = (gpointer) value;
+	values_data->values[values_data->len] = NULL;
+
+	if (values_data->pos && values_data->len * 2 <= values_data->n_pos)
+		values_data->pos[slot] = values_data->len;
+	else if (values_data->pos || values_data->len > VALUES_LINEAR_MAX)
+		_values_pos_rebuild (values_data);
+	return TRUE;
+}
+
+static gboolean
+_values_remove (ValuesData *values_data, gconstpointer value)
+{
+	guint idx, last;
+
+	if (values_data->pos) {
+		guint mask = values_data->n_pos - 1;
+		guint i, j, k;
+
+		i = _values_pos_find_slot (values_data, value);
+		if (!values_data->pos[i])
+			return FALSE;
+		idx = values_data->pos[i] - 1;
+
+		/* backward shift deletion: move up following entries of the probe
+		 * sequence, unless their home slot lies cyclically in (i, j]. */
+		values_data->pos[i] = 0;
+		for (j = (i + 1) & mask; values_data->pos[j]; j = (j + 1) & mask) {
+			k = _ptr_hash (values_data->values[values_data->pos[j] - 1]) & mask;
+			if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+				continue;
+			values_data->pos[i] = values_data->pos[j];
+			values_data->pos[j] = 0;
+			i = j;
+		}
+	} else {
+		idx = _values_find (values_data, value);
+		if (idx == NOT_FOUND)
+			return FALSE;
+	}
+
+	/* fill the gap with the last value. */
+	last = values_data->len - 1;
+	if (idx != last) {
+		values_data->values[idx] = values_data->values[last];
+		if (values_data->pos)
+			values_data->pos[_values_pos_find_slot (values_data, values_data->values[idx])] = idx + 1;
+	}
+	values_data->values[last] = NULL;
+	values_data->len = last;
+
+	if (   values_data->pos
+	    && (   values_data->len <= VALUES_LINEAR_MAX
+	        || values_data->len * 8 < values_data->n_pos))
+		_values_pos_rebuild (values_data);
+
+	if (values_data->alloc > 4 && values_data->len * 4 < values_data->alloc) {
+		values_data->alloc /= 2;
+		values_data->values = g_renew (gpointer, values_data->values, values_data->alloc + 1);
+	}
+	return TRUE;
+}
+
+static void
+_values_data_destroy (const NMMultiIndex *index, ValuesData *values_data)
+{
+	index->destroy_fcn (values_data->id);
+	g_free (values_data->values);
+	g_free (values_data->pos);
+	g_slice_free (ValuesData, values_data);
+}
+
+/******************************************************************************************/
+
+static guint
+_index_find_slot (const NMMultiIndex *index, const NMMultiIndexId *id, guint id_hash)
+{
+	guint mask = index->n_slots - 1;
+	guint i;
 
-	g_hash_table_iter_init (&iter, values_data->index);
-	for (i = 0; g_hash_table_iter_next (&iter, &values[i], NULL); i++)
-		nm_assert (i < len);
-	nm_assert (i == len);
-	values[i] = NULL;
+	nm_assert (index->n_slots);
 
-	values_data->values = values;
+	i = id_hash & mask;
+	while (   index->slots[i]
+	       && (   index->slots[i]->id_hash != id_hash
+	           || !index->equal_fcn (index->slots[i]->id, id)))
+		i = (i + 1) & mask;
+	return i;
+}
+
+static ValuesData *
+_index_lookup (const NMMultiIndex *index, const NMMultiIndexId *id)
+{
+	if (!index->n_groups)
+		return NULL;
+	return index->slots[_index_find_slot (index, id, _hash_mix (index->hash_fcn (id)))];
+}
+
+static void
+_index_resize (NMMultiIndex *index, guint n_slots)
+{
+	ValuesData **slots_old = index->slots;
+	guint n_slots_old = index->n_slots;
+	guint i, j;
+
+	index->slots = g_new0 (ValuesData *, n_slots);
+	index->n_slots = n_slots;
+	for (i = 0; i < n_slots_old; i++) {
+		if (!slots_old[i])
+			continue;
+		for (j = slots_old[i]->id_hash & (n_slots - 1); index->slots[j]; j = (j + 1) & (n_slots - 1))
+			;
+		index->slots[j] = slots_old[i];
+	}
+	g_free (slots_old);
+}
+
+static void
+_index_clear_slot (NMMultiIndex *index, guint i)
+{
+	guint mask = index->n_slots - 1;
+	guint j, k;
+
+	/* backward shift deletion, see _values_remove(). */
+	index->slots[i] = NULL;
+	for (j = (i + 1) & mask; index->slots[j]; j = (j + 1) & mask) {
+		k = index->slots[j]->id_hash & mask;
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+		index->slots[i] = index->slots[j];
+		index->slots[j] = NULL;
+		i = j;
+	}
 }
 
 /******************************************************************************************/
@@ -108,15 +301,14 @@ nm_multi_index_lookup (const NMMultiIndex *index,
 	g_return_val_if_fail (index, NULL);
 	g_return_val_if_fail (id, NULL);
 
-	values_data = g_hash_table_lookup (index->hash, id);
+	values_data = _index_lookup (index, id);
 	if (!values_data) {
 		if (out_len)
 			*out_len = 0;
 		return NULL;
 	}
-	_values_data_populate_array (values_data);
 	if (out_len)
-		*out_len = g_hash_table_size (values_data->index);
+		*out_len = values_data->len;
 	return values_data->values;
 }
 
@@ -131,34 +323,32 @@ nm_multi_index_contains (const NMMultiIndex *index,
 	g_return_val_if_fail (id, FALSE);
 	g_return_val_if_fail (value, FALSE);
 
-	values_data = g_hash_table_lookup (index->hash, id);
+	values_data = _index_lookup (index, id);
 	return    values_data
-	       && g_hash_table_contains (values_data->index, value);
+	       && _values_find (values_data, value) != NOT_FOUND;
 }
 
 const NMMultiIndexId *
 nm_multi_index_lookup_first_by_value (const NMMultiIndex *index,
                                       gconstpointer value)
 {
-	GHashTableIter iter;
-	const NMMultiIndexId *id;
-	ValuesData *values_data;
+	guint i;
 
 	g_return_val_if_fail (index, NULL);
 	g_return_val_if_fail (value, NULL);
 
-	/* reverse-lookup needs to iterate over all hash tables. It should
-	 * still be fairly quick, if the number of hash tables is small.
+	/* reverse-lookup needs to iterate over all groups. It should
+	 * still be fairly quick, if the number of groups is small.
 	 * There is no O(1) reverse lookup implemented, because this access
 	 * pattern is not what NMMultiIndex is here for.
 	 * You are supposed to use NMMultiIndex by always knowing which @id
 	 * a @value has.
 	 */
 
-	g_hash_table_iter_init (&iter, index->hash);
-	while (g_hash_table_iter_next (&iter, (gpointer *) &id, (gpointer *) &values_data)) {
-		if (g_hash_table_contains (values_data->index, value))
-			return id;
+	for (i = 0; i < index->n_slots; i++) {
+		if (   index->slots[i]
+		    && _values_find (index->slots[i], value) != NOT_FOUND)
+			return index->slots[i]->id;
 	}
 	return NULL;
 }
@@ -169,21 +359,17 @@ nm_multi_index_foreach (const NMMultiIndex *index,
                         NMMultiIndexFuncForeach foreach_func,
                         gpointer user_data)
 {
-	GHashTableIter iter;
+	NMMultiIndexIter iter;
 	const NMMultiIndexId *id;
-	ValuesData *values_data;
+	void *const*values;
+	guint len;
 
 	g_return_if_fail (index);
 	g_return_if_fail (foreach_func);
 
-	g_hash_table_iter_init (&iter, index->hash);
-	while (g_hash_table_iter_next (&iter, (gpointer *) &id, (gpointer *) &values_data)) {
-		if (   value
-		    && !g_hash_table_contains (values_data->index, value))
-			continue;
-
-		_values_data_populate_array (values_data);
-		if (!foreach_func (id, values_data->values, g_hash_table_size (values_data->index), user_data))
+	nm_multi_index_iter_init (&iter, index, value);
+	while (nm_multi_index_iter_next (&iter, &id, &values, &len)) {
+		if (!foreach_func (id, values, len, user_data))
 			return;
 	}
 }
@@ -196,9 +382,9 @@ nm_multi_index_iter_init (NMMultiIndexIter *iter,
 	g_return_if_fail (index);
 	g_return_if_fail (iter);
 
-	g_hash_table_iter_init (&iter->_iter, index->hash);
 	iter->_index = index;
 	iter->_value = value;
+	iter->_pos = 0;
 }
 
 gboolean
@@ -207,21 +393,22 @@ nm_multi_index_iter_next (NMMultiIndexIter *iter,
                           void *const**out_values,
                           guint *out_len)
 {
-	const NMMultiIndexId *id;
 	ValuesData *values_data;
 
 	g_return_val_if_fail (iter, FALSE);
 
-	while (g_hash_table_iter_next (&iter->_iter, (gpointer *) &id, (gpointer *) &values_data)) {
+	while (iter->_pos < iter->_index->n_slots) {
+		values_data = iter->_index->slots[iter->_pos++];
+		if (!values_data)
+			continue;
 		if (   !iter->_value
-		    || g_hash_table_contains (values_data->index, iter->_value)) {
-			_values_data_populate_array (values_data);
+		    || _values_find (values_data, iter->_value) != NOT_FOUND) {
 			if (out_id)
-				*out_id = id;
+				*out_id = values_data->id;
 			if (out_values)
 				*out_values = values_data->values;
 			if (out_len)
-				*out_len = g_hash_table_size (values_data->index);
+				*out_len = values_data->len;
 			return TRUE;
 		}
 	}
@@ -241,13 +428,10 @@ nm_multi_index_id_iter_init (NMMultiIndexIdIter *iter,
 	g_return_if_fail (iter);
 	g_return_if_fail (id);
 
-	values_data = g_hash_table_lookup (index->hash, id);
-	if (!values_data)
-		iter->_state = 1;
-	else {
-		iter->_state = 0;
-		g_hash_table_iter_init (&iter->_iter, values_data->index);
-	}
+	values_data = _index_lookup (index, id);
+	iter->_values = values_data ? values_data->values : NULL;
+	iter->_len = values_data ? values_data->len : 0;
+	iter->_pos = 0;
 }
 
 gboolean
@@ -255,14 +439,13 @@ nm_multi_index_id_iter_next (NMMultiIndexIdIter *iter,
                              void **out_value)
 {
 	g_return_val_if_fail (iter, FALSE);
-	g_return_val_if_fail (iter->_state <= 1, FALSE);
 
-	if (iter->_state == 0)
-		return g_hash_table_iter_next (&iter->_iter, out_value, NULL);
-	else {
-		iter->_state = 2;
+	if (iter->_pos >= iter->_len)
 		return FALSE;
-	}
+	if (out_value)
+		*out_value = iter->_values[iter->_pos];
+	iter->_pos++;
+	return TRUE;
 }
 
 /******************************************************************************************/
@@ -273,33 +456,41 @@ _do_add (NMMultiIndex *index,
          gconstpointer value)
 {
 	ValuesData *values_data;
-
-	values_data = g_hash_table_lookup (index->hash, id);
-	if (!values_data) {
-		NMMultiIndexId *id_new;
-
-		/* Contrary to GHashTable, we don't take ownership of the @id that was
-		 * provided to nm_multi_index_add(). Instead we clone it via @clone_fcn
-		 * when needed.
-		 *
-		 * The reason is, that we expect in most cases that there exists
-		 * already a @id so that we don't need ownership of it (or clone it).
-		 * By doing this, the caller can pass a stack allocated @id or
-		 * reuse the @id for other insertions.
-		 */
-		id_new = index->clone_fcn (id);
-		if (!id_new)
-			g_return_val_if_reached (FALSE);
-
-		values_data = _values_data_create ();
-		g_hash_table_replace (values_data->index, (gpointer) value, (gpointer) value);
-
-		g_hash_table_insert (index->hash, id_new, values_data);
-	} else {
-		if (!nm_g_hash_table_replace (values_data->index, (gpointer) value, (gpointer) value))
-			return FALSE;
-		g_clear_pointer (&values_data->values, g_free);
+	NMMultiIndexId *id_new;
+	guint id_hash, slot;
+
+	id_hash = _hash_mix (index->hash_fcn (id));
+	if (index->n_groups) {
+		values_data = index->slots[_index_find_slot (index, id, id_hash)];
+		if (values_data)
+			return _values_add (values_data, value);
 	}
+
+	/* Contrary to GHashTable, we don't take ownership of the @id that was
+	 * provided to nm_multi_index_add(). Instead we clone it via @clone_fcn
+	 * when needed.
+	 *
+	 * The reason is, that we expect in most cases that there exists
+	 * already a @id so that we don't need ownership of it (or clone it).
+	 * By doing this, the caller can pass a stack allocated @id or
+	 * reuse the @id for other insertions.
+	 */
+	id_new = index->clone_fcn (id);
+	if (!id_new)
+		g_return_val_if_reached (FALSE);
+
+	if ((index->n_groups + 1) * 2 > index->n_slots)
+		_index_resize (index, MAX (8, index->n_slots * 2));
+
+	values_data = g_slice_new0 (ValuesData);
+	values_data->id = id_new;
+	values_data->id_hash = id_hash;
+	_values_add (values_data, value);
+
+	slot = _index_find_slot (index, id, id_hash);
+	nm_assert (!index->slots[slot]);
+	index->slots[slot] = values_data;
+	index->n_groups++;
 	return TRUE;
 }
 
@@ -309,18 +500,26 @@ _do_remove (NMMultiIndex *index,
             gconstpointer value)
 {
 	ValuesData *values_data;
+	guint slot;
+
+	if (!index->n_groups)
+		return FALSE;
 
-	values_data = g_hash_table_lookup (index->hash, id);
+	slot = _index_find_slot (index, id, _hash_mix (index->hash_fcn (id)));
+	values_data = index->slots[slot];
 	if (!values_data)
 		return FALSE;
 
-	if (!g_hash_table_remove (values_data->index, value))
+	if (!_values_remove (values_data, value))
 		return FALSE;
 
-	if (g_hash_table_size (values_data->index) == 0)
-		g_hash_table_remove (index->hash, id);
-	else
-		g_clear_pointer (&values_data->values, g_free);
+	if (values_data->len == 0) {
+		_index_clear_slot (index, slot);
+		_values_data_destroy (index, values_data);
+		index->n_groups--;
+		if (index->n_slots > 8 && index->n_groups * 8 < index->n_slots)
+			_index_resize (index, index->n_slots / 2);
+	}
 	return TRUE;
 }
 
@@ -403,7 +602,7 @@ guint
 nm_multi_index_get_num_groups (const NMMultiIndex *index)
 {
 	g_return_val_if_fail (index, 0);
-	return g_hash_table_size (index->hash);
+	return index->n_groups;
 }
 
 NMMultiIndex *
@@ -419,22 +618,25 @@ nm_multi_index_new (NMMultiIndexFuncHash hash_fcn,
 	g_return_val_if_fail (clone_fcn, NULL);
 	g_return_val_if_fail (destroy_fcn, NULL);
 
-	index = g_new (NMMultiIndex, 1);
+	index = g_new0 (NMMultiIndex, 1);
+	index->hash_fcn = hash_fcn;
 	index->equal_fcn = equal_fcn;
 	index->clone_fcn = clone_fcn;
-
-	index->hash = g_hash_table_new_full ((GHashFunc) hash_fcn,
-	                                     (GEqualFunc) equal_fcn,
-	                                     (GDestroyNotify) destroy_fcn,
-	                                     (GDestroyNotify) _values_data_destroy);
+	index->destroy_fcn = destroy_fcn;
 	return index;
 }
 
 void
 nm_multi_index_free (NMMultiIndex *index)
 {
+	guint i;
+
 	g_return_if_fail (index);
-	g_hash_table_unref (index->hash);
+
+	for (i = 0; i < index->n_slots; i++) {
+		if (index->slots[i])
+			_values_data_destroy (index, index->slots[i]);
+	}
+	g_free (index->slots);
 	g_free (index);
 }
-
@@ -33,14 +33,15 @@ typedef struct {
 typedef struct NMMultiIndex NMMultiIndex;
 
 typedef struct {
-	GHashTableIter _iter;
 	const NMMultiIndex *_index;
 	gconstpointer _value;
+	guint _pos;
 } NMMultiIndexIter;
 
 typedef struct {
-	GHashTableIter _iter;
-	guint _state;
+	void *const*_values;
+	guint _len;
+	guint _pos;
 } NMMultiIndexIdIter;
 
 typedef gboolean (*NMMultiIndexFuncEqual) (const NMMultiIndexId *id_a, const NMMultiIndexId *id_b);
@@ -639,7 +639,8 @@ auto_activate_device (gpointer user_data)
 	NMSettingsConnection *best_connection;
 	char *specific_object = NULL;
 	GPtrArray *connections;
-	GSList *connection_list;
+	GHashTable *active;
+	const GSList *iter;
 	guint i;
 
 	g_assert (data);
@@ -655,30 +656,35 @@ auto_activate_device (gpointer user_data)
 	if (nm_device_get_act_request (data->device))
 		goto out;
 
-	connection_list = nm_manager_get_activatable_connections (priv->manager);
-	if (!connection_list)
-		goto out;
+	/* Connections that are already active can't be activated again */
+	active = g_hash_table_new (NULL, NULL);
+	for (iter = nm_manager_get_active_connections (priv->manager); iter; iter = iter->next) {
+		NMActiveConnection *ac = iter->data;
 
-	connections = _nm_utils_copy_slist_to_array (connection_list, NULL, NULL);
-	g_slist_free (connection_list);
+		if (nm_active_connection_get_state (ac) < NM_ACTIVE_CONNECTION_STATE_DEACTIVATED)
+			g_hash_table_add (active, nm_active_connection_get_settings_connection (ac));
+	}
 
-	/* sort is stable (which is important at this point) so that connections
-	 * with same priority are still sorted by last-connected-timestamp. */
-	g_ptr_array_sort (connections, (GCompareFunc) nm_utils_cmp_connection_by_autoconnect_priority);
+	/* Only the connections that may be compatible with the device, sorted
+	 * by autoconnect, then autoconnect-priority and last-connected-timestamp. */
+	connections = nm_settings_get_autoconnect_candidates (priv->settings, data->device);
 
 	/* Find the first connection that should be auto-activated */
 	best_connection = NULL;
 	for (i = 0; i < connections->len; i++) {
-		NMSettingsConnection *candidate = NM_SETTINGS_CONNECTION (connections->pdata[i]);
+		NMSettingsConnection *candidate = connections->pdata[i];
 
 		if (!nm_settings_connection_can_autoconnect (candidate))
 			continue;
+		if (g_hash_table_contains (active, candidate))
+			continue;
 		if (nm_device_can_auto_connect (data->device, (NMConnection *) candidate, &specific_object)) {
 			best_connection = candidate;
 			break;
 		}
 	}
-	g_ptr_array_free (connections, TRUE);
+	g_ptr_array_unref (connections);
+	g_hash_table_unref (active);
 
 	if (best_connection) {
 		GError *error = NULL;
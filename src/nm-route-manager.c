@@ -40,10 +40,45 @@ typedef struct {
 	NMPlatformIPXRoute *entries[1];
 } RouteIndex;
 
+typedef struct {
+	int ifindex;
+
+	/* copies of the non-default routes in platform on @ifindex, sorted by route_id_cmp().
+	 * The list is kept up to date from the platform signals, so that a sync doesn't
+	 * have to fetch and sort the platform routes every time. */
+	GPtrArray *plat_routes;
+
+	/* whether the routes in platform or the effective metrics of our routes
+	 * on @ifindex changed since the last successful sync. */
+	gboolean dirty;
+
+	/* the link got removed while syncing it. Drop the entry afterwards. */
+	gboolean link_removed;
+
+	/* the arguments of the last successful sync. @known_routes is %NULL
+	 * if there was no successful sync yet. */
+	GArray *known_routes;
+	gboolean ignore_kernel_routes;
+	gboolean full_sync;
+} IfindexRoutes;
+
+typedef struct {
+	NMPlatformSignalChangeType change_type;
+	NMPlatformIPXRoute route;
+} PendingRouteChange;
+
 typedef struct {
 	GArray *entries;
 	RouteIndex *index;
 
+	/* IfindexRoutes by ifindex. */
+	GHashTable *ifindexes;
+
+	/* while syncing @syncing, platform changes are not applied to @ifindexes
+	 * but queued to @pending_changes. */
+	IfindexRoutes *syncing;
+	GArray *pending_changes;
+
 	/* list of effective metrics. The indexes of the array correspond to @index, not @entries. */
 	GArray *effective_metrics;
 
@@ -149,36 +184,20 @@ static gboolean _ip4_device_routes_cancel (NMRouteManager *self);
 
 #if NM_MORE_ASSERTS && !defined (G_DISABLE_ASSERT)
 inline static void
-ASSERT_route_index_valid (const VTableIP *vtable, const GArray *entries, const RouteIndex *index, gboolean unique_ifindexes)
+ASSERT_route_index_valid_sorted (const VTableIP *vtable, const RouteIndex *index, gboolean unique_ifindexes)
 {
 	guint i, j;
 	int c;
 	const NMPlatformIPXRoute *r1, *r2;
 	gs_unref_hashtable GHashTable *ptrs = g_hash_table_new (NULL, NULL);
-	const NMPlatformIPXRoute *r_first = NULL, *r_last = NULL;
 
 	g_assert (index);
 
-	if (entries)
-		g_assert_cmpint (entries->len, ==, index->len);
-	else
-		g_assert (index->len == 0);
-
-	if (index->len > 0) {
-		r_first = VTABLE_ROUTE_INDEX (vtable, entries, 0);
-		r_last = VTABLE_ROUTE_INDEX (vtable, entries, index->len - 1);
-	}
-
-	/* assert that the @index is valid for the @entries. */
-
 	g_assert (!index->entries[index->len]);
 	for (i = 0; i < index->len; i++) {
 		r1 = index->entries[i];
 
 		g_assert (r1);
-		g_assert (r1 >= r_first);
-		g_assert (r1 <= r_last);
-		g_assert_cmpint ((((char *) r1) - ((char *) entries->data)) % vtable->vt->sizeof_route, ==, 0);
 
 		g_assert (!g_hash_table_contains (ptrs, (gpointer) r1));
 		g_hash_table_add (ptrs, (gpointer) r1);
@@ -195,7 +214,39 @@ ASSERT_route_index_valid (const VTableIP *vtable, const GArray *entries, const R
 		}
 	}
 }
+
+inline static void
+ASSERT_route_index_valid (const VTableIP *vtable, const GArray *entries, const RouteIndex *index, gboolean unique_ifindexes)
+{
+	guint i;
+	const NMPlatformIPXRoute *r1;
+	const NMPlatformIPXRoute *r_first = NULL, *r_last = NULL;
+
+	g_assert (index);
+
+	if (entries)
+		g_assert_cmpint (entries->len, ==, index->len);
+	else
+		g_assert (index->len == 0);
+
+	if (index->len > 0) {
+		r_first = VTABLE_ROUTE_INDEX (vtable, entries, 0);
+		r_last = VTABLE_ROUTE_INDEX (vtable, entries, index->len - 1);
+	}
+
+	/* assert that the @index is valid for the @entries. */
+	for (i = 0; i < index->len; i++) {
+		r1 = index->entries[i];
+
+		g_assert (r1 >= r_first);
+		g_assert (r1 <= r_last);
+		g_assert_cmpint ((((char *) r1) - ((char *) entries->data)) % vtable->vt->sizeof_route, ==, 0);
+	}
+
+	ASSERT_route_index_valid_sorted (vtable, index, unique_ifindexes);
+}
 #else
+#define ASSERT_route_index_valid_sorted(vtable, index, unique_ifindexes) G_STMT_START { (void) 0; } G_STMT_END
 #define ASSERT_route_index_valid(vtable, entries, index, unique_ifindexes) G_STMT_START { (void) 0; } G_STMT_END
 #endif
 
@@ -282,6 +333,30 @@ _route_index_create (const VTableIP *vtable, const GArray *routes)
 	return index;
 }
 
+/* create an index for the platform routes of @ifr. The routes are already sorted,
+ * just skip over the kernel routes, if requested. The index borrows the routes
+ * from @ifr. */
+static RouteIndex *
+_route_index_create_from_ifindex_routes (const IfindexRoutes *ifr, gboolean ignore_kernel_routes)
+{
+	RouteIndex *index;
+	guint i, len = ifr->plat_routes->len;
+
+	index = g_malloc (sizeof (RouteIndex) + len * sizeof (NMPlatformIPXRoute *));
+
+	index->len = 0;
+	for (i = 0; i < len; i++) {
+		NMPlatformIPXRoute *r = ifr->plat_routes->pdata[i];
+
+		if (   ignore_kernel_routes
+		    && r->rx.source == NM_IP_CONFIG_SOURCE_RTPROT_KERNEL)
+			continue;
+		index->entries[index->len++] = r;
+	}
+	index->entries[index->len] = NULL;
+	return index;
+}
+
 static int
 _vx_route_id_cmp_full (const NMPlatformIPXRoute *r1, const NMPlatformIPXRoute *r2, const VTableIP *vtable)
 {
@@ -339,6 +414,177 @@ _route_index_reverse_idx (const VTableIP *vtable, const RouteIndex *index, guint
 
 /*********************************************************************************************/
 
+static int
+_vx_route_dest_cmp_full (const NMPlatformIPXRoute *r1, const NMPlatformIPXRoute *r2, const VTableIP *vtable)
+{
+	return vtable->route_dest_cmp (r1, r2);
+}
+
+static void
+_ifindex_routes_free (IfindexRoutes *ifr)
+{
+	g_ptr_array_unref (ifr->plat_routes);
+	if (ifr->known_routes)
+		g_array_unref (ifr->known_routes);
+	g_slice_free (IfindexRoutes, ifr);
+}
+
+static IfindexRoutes *
+_ifindex_routes_get (const VTableIP *vtable, NMRouteManager *self, int ifindex)
+{
+	NMRouteManagerPrivate *priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
+	RouteEntries *ipx_routes = vtable->vt->is_ip4 ? &priv->ip4_routes : &priv->ip6_routes;
+	IfindexRoutes *ifr;
+	GPtrArray *routes;
+	guint i;
+
+	ifr = g_hash_table_lookup (ipx_routes->ifindexes, GINT_TO_POINTER (ifindex));
+	if (ifr)
+		return ifr;
+
+	/* the first sync of @ifindex. Fetch the routes once, afterwards the
+	 * list gets updated by _platform_ipx_route_changed_cb(). */
+	routes = vtable->vt->route_lookup_all (priv->platform, ifindex,
+	                                       NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_RTPROT_KERNEL);
+
+	ifr = g_slice_new0 (IfindexRoutes);
+	ifr->ifindex = ifindex;
+	ifr->dirty = TRUE;
+	ifr->plat_routes = g_ptr_array_new_full (routes->len, g_free);
+	for (i = 0; i < routes->len; i++)
+		g_ptr_array_add (ifr->plat_routes, g_memdup (routes->pdata[i], vtable->vt->sizeof_route));
+	g_ptr_array_sort_with_data (ifr->plat_routes, (GCompareDataFunc) _route_index_create_sort, (gpointer) vtable);
+	g_ptr_array_unref (routes);
+
+	g_hash_table_insert (ipx_routes->ifindexes, GINT_TO_POINTER (ifindex), ifr);
+	return ifr;
+}
+
+static void
+_ifindex_routes_set_dirty (RouteEntries *ipx_routes, int ifindex)
+{
+	IfindexRoutes *ifr;
+
+	ifr = g_hash_table_lookup (ipx_routes->ifindexes, GINT_TO_POINTER (ifindex));
+	if (ifr)
+		ifr->dirty = TRUE;
+}
+
+static void
+_ifindex_routes_update (const VTableIP *vtable, IfindexRoutes *ifr, const NMPlatformIPXRoute *route, NMPlatformSignalChangeType change_type)
+{
+	gssize idx;
+
+	idx = _nm_utils_ptrarray_find_binary_search (ifr->plat_routes->pdata, ifr->plat_routes->len, (gpointer) route, (GCompareDataFunc) _vx_route_id_cmp_full, (gpointer) vtable);
+	if (change_type == NM_PLATFORM_SIGNAL_REMOVED) {
+		if (idx >= 0)
+			g_ptr_array_remove_index (ifr->plat_routes, idx);
+	} else if (idx >= 0)
+		memcpy (ifr->plat_routes->pdata[idx], route, vtable->vt->sizeof_route);
+	else
+		g_ptr_array_insert (ifr->plat_routes, ~idx, g_memdup (route, vtable->vt->sizeof_route));
+}
+
+/* Check whether @ipx_routes wants @route configured in platform, i.e. whether there
+ * is a route with the same destination on the same ifindex and with an effective
+ * metric that equals the metric of @route. */
+static gboolean
+_ipx_routes_wants_plat_route (const VTableIP *vtable, const RouteEntries *ipx_routes, const NMPlatformIPXRoute *route)
+{
+	const RouteIndex *index = ipx_routes->index;
+	gint64 metric = vtable->vt->metric_normalize (route->rx.metric);
+	gssize idx;
+	guint i;
+
+	nm_assert (ipx_routes->effective_metrics->len == index->len);
+
+	idx = _nm_utils_ptrarray_find_binary_search ((gpointer *) index->entries, index->len, (gpointer) route, (GCompareDataFunc) _vx_route_dest_cmp_full, (gpointer) vtable);
+	if (idx < 0)
+		return FALSE;
+
+	while (idx > 0 && vtable->route_dest_cmp (index->entries[idx - 1], route) == 0)
+		idx--;
+	for (i = idx; i < index->len && vtable->route_dest_cmp (index->entries[i], route) == 0; i++) {
+		if (   index->entries[i]->rx.ifindex == route->rx.ifindex
+		    && g_array_index (ipx_routes->effective_metrics, gint64, i) == metric)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* Whether @route, which failed to be added, is one of the entries of
+ * @ipx_routes->index that are marked in @queued. */
+static gboolean
+_ipx_routes_find_queued (const VTableIP *vtable, const RouteEntries *ipx_routes, const gboolean *queued, const NMPlatformIPXRoute *route)
+{
+	const RouteIndex *index = ipx_routes->index;
+	gint64 metric = vtable->vt->metric_normalize (route->rx.metric);
+	gssize idx;
+	guint i;
+
+	idx = _nm_utils_ptrarray_find_binary_search ((gpointer *) index->entries, index->len, (gpointer) route, (GCompareDataFunc) _vx_route_dest_cmp_full, (gpointer) vtable);
+	if (idx < 0)
+		return FALSE;
+
+	while (idx > 0 && vtable->route_dest_cmp (index->entries[idx - 1], route) == 0)
+		idx--;
+	for (i = idx; i < index->len && vtable->route_dest_cmp (index->entries[i], route) == 0; i++) {
+		if (   queued[i]
+		    && vtable->vt->metric_normalize (g_array_index (ipx_routes->effective_metrics, gint64, i)) == metric)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+_ifindex_routes_apply_change (const VTableIP *vtable, RouteEntries *ipx_routes, const NMPlatformIPXRoute *route, NMPlatformSignalChangeType change_type)
+{
+	IfindexRoutes *ifr;
+	gboolean expected;
+
+	ifr = g_hash_table_lookup (ipx_routes->ifindexes, GINT_TO_POINTER (route->rx.ifindex));
+	if (!ifr)
+		return;
+
+	_ifindex_routes_update (vtable, ifr, route, change_type);
+
+	/* Changes that only bring platform in line with what we configured,
+	 * don't require a new sync. Anything else does. */
+	switch (change_type) {
+	case NM_PLATFORM_SIGNAL_ADDED:
+		expected = _ipx_routes_wants_plat_route (vtable, ipx_routes, route);
+		break;
+	case NM_PLATFORM_SIGNAL_REMOVED:
+		expected = !_ipx_routes_wants_plat_route (vtable, ipx_routes, route);
+		break;
+	default:
+		expected = FALSE;
+		break;
+	}
+	if (!expected)
+		ifr->dirty = TRUE;
+}
+
+static gboolean
+_ifindex_routes_is_synced (const VTableIP *vtable, const IfindexRoutes *ifr, const GArray *known_routes, gboolean ignore_kernel_routes, gboolean full_sync)
+{
+	guint i, len = known_routes ? known_routes->len : 0;
+
+	if (   ifr->dirty
+	    || !ifr->known_routes
+	    || ifr->ignore_kernel_routes != ignore_kernel_routes
+	    || (full_sync && !ifr->full_sync)
+	    || ifr->known_routes->len != len)
+		return FALSE;
+
+	for (i = 0; i < len; i++) {
+		if (vtable->vt->route_cmp (VTABLE_ROUTE_INDEX (vtable, ifr->known_routes, i),
+		                           VTABLE_ROUTE_INDEX (vtable, known_routes, i)) != 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 _route_equals_ignoring_ifindex (const VTableIP *vtable, const NMPlatformIPXRoute *r1, const NMPlatformIPXRoute *r2, gint64 r2_metric)
 {
@@ -434,7 +680,6 @@ static gboolean
 _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const GArray *known_routes, gboolean ignore_kernel_routes, gboolean full_sync)
 {
 	NMRouteManagerPrivate *priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
-	GArray *plat_routes;
 	RouteEntries *ipx_routes;
 	RouteIndex *plat_routes_idx, *known_routes_idx;
 	gboolean success = TRUE;
@@ -447,20 +692,34 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 	gint64 *p_effective_metric = NULL;
 	gboolean ipx_routes_changed = FALSE;
 	gint64 *effective_metrics = NULL;
+	GArray *queued_indexes = NULL;
+	GPtrArray *failed_objs = NULL;
+	IfindexRoutes *ifr, *ifr_syncing;
 
 	nm_platform_process_events (priv->platform);
 
 	ipx_routes = vtable->vt->is_ip4 ? &priv->ip4_routes : &priv->ip6_routes;
-	plat_routes = vtable->vt->route_get_all (priv->platform, ifindex,
-	                                         ignore_kernel_routes
-	                                             ? NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT
-	                                             : NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_RTPROT_KERNEL);
-	plat_routes_idx = _route_index_create (vtable, plat_routes);
+
+	ifr = _ifindex_routes_get (vtable, self, ifindex);
+	if (_ifindex_routes_is_synced (vtable, ifr, known_routes, ignore_kernel_routes, full_sync)) {
+		/* neither @known_routes nor the platform changed since the last sync. Nothing to do.
+		 * Any change below results in comparing all routes of @ifindex again. */
+		_LOGD (vtable->vt->addr_family, "%3d: sync %u IPv%c routes (unchanged)", ifindex,
+		       known_routes ? known_routes->len : 0, vtable->vt->is_ip4 ? '4' : '6');
+		return TRUE;
+	}
+
+	/* while syncing, don't modify @ifr->plat_routes, because @plat_routes_idx
+	 * points into it. */
+	ifr_syncing = ipx_routes->syncing;
+	ipx_routes->syncing = ifr;
+
+	plat_routes_idx = _route_index_create_from_ifindex_routes (ifr, ignore_kernel_routes);
 	known_routes_idx = _route_index_create (vtable, known_routes);
 
 	effective_metrics = &g_array_index (ipx_routes->effective_metrics, gint64, 0);
 
-	ASSERT_route_index_valid (vtable, plat_routes, plat_routes_idx, TRUE);
+	ASSERT_route_index_valid_sorted (vtable, plat_routes_idx, TRUE);
 	ASSERT_route_index_valid (vtable, known_routes, known_routes_idx, FALSE);
 
 	_LOGD (vtable->vt->addr_family, "%3d: sync %u IPv%c routes", ifindex, known_routes_idx->len, vtable->vt->is_ip4 ? '4' : '6');
@@ -530,6 +789,10 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 			cur_known_route = _get_next_known_route (vtable, known_routes_idx, FALSE, &i_known_routes);
 	}
 
+	/* Queue all changes to platform and send them at once at the end. That way, syncing
+	 * a large number of routes doesn't cost one netlink round trip per route. */
+	nm_platform_batch_begin (priv->platform);
+
 	if (!full_sync && to_delete_indexes) {
 		/***************************************************************************
 		 * Delete routes in platform, that we are about to remove from @ipx_routes
@@ -778,12 +1041,17 @@ next:
 			}
 			*p_effective_metric_reversed = *p_effective_metric;
 
+			cur_ipx_route = ipx_routes->index->entries[i_ipx_routes];
+			if (cur_ipx_route->rx.ifindex != ifindex) {
+				/* the other ifindex needs a sync to remove routes with a stale metric. */
+				_ifindex_routes_set_dirty (ipx_routes, cur_ipx_route->rx.ifindex);
+			}
+
 			if (*p_effective_metric == -1) {
 				/* the entry is shadowed. Nothing to do. */
 				continue;
 			}
 
-			cur_ipx_route = ipx_routes->index->entries[i_ipx_routes];
 			if (cur_ipx_route->rx.ifindex == ifindex) {
 				/* @cur_ipx_route is on the current @ifindex. No need to special handling them
 				 * because we are about to do a full sync of the ifindex. */
@@ -880,14 +1148,74 @@ next:
 						 * to sync the remaining routes. */
 						success = FALSE;
 					}
+				} else if (cur_ipx_route->rx.source >= NM_IP_CONFIG_SOURCE_USER) {
+					/* The request might only be queued. Remember the route to
+					 * check for errors after committing the batch. */
+					if (!queued_indexes)
+						queued_indexes = g_array_new (FALSE, FALSE, sizeof (guint));
+					g_array_append_val (queued_indexes, i_ipx_routes);
+				}
+			}
+		}
+	}
+
+	if (!nm_platform_batch_commit (priv->platform, &failed_objs) && failed_objs) {
+		NMPObjectType obj_type = vtable->vt->is_ip4 ? NMP_OBJECT_TYPE_IP4_ROUTE : NMP_OBJECT_TYPE_IP6_ROUTE;
+
+		/* Failures of deleting routes and of adding routes with a source
+		 * below NM_IP_CONFIG_SOURCE_USER are ignored, like above. */
+		if (queued_indexes) {
+			gs_free gboolean *queued = g_new0 (gboolean, ipx_routes->index->len);
+
+			for (i = 0; i < queued_indexes->len; i++)
+				queued[g_array_index (queued_indexes, guint, i)] = TRUE;
+
+			for (i = 0; i < failed_objs->len; i++) {
+				const NMPObject *obj = failed_objs->pdata[i];
+
+				if (   NMP_OBJECT_GET_TYPE (obj) == obj_type
+				    && obj->ip_route.ifindex == ifindex
+				    && _ipx_routes_find_queued (vtable, ipx_routes, queued, &obj->ipx_route)) {
+					success = FALSE;
+					break;
 				}
 			}
 		}
 	}
+	if (failed_objs)
+		g_ptr_array_unref (failed_objs);
+	if (queued_indexes)
+		g_array_unref (queued_indexes);
 
 	g_free (known_routes_idx);
 	g_free (plat_routes_idx);
-	g_array_unref (plat_routes);
+
+	ipx_routes->syncing = ifr_syncing;
+
+	/* remember the last successful sync. Platform changes that arrived meanwhile
+	 * mark @ifr dirty again, unless they are the result of this sync. */
+	ifr->dirty = !success;
+	if (success) {
+		if (ifr->known_routes)
+			g_array_unref (ifr->known_routes);
+		ifr->known_routes = g_array_sized_new (FALSE, FALSE, vtable->vt->sizeof_route, known_routes ? known_routes->len : 0);
+		if (known_routes)
+			g_array_append_vals (ifr->known_routes, known_routes->data, known_routes->len);
+		ifr->ignore_kernel_routes = ignore_kernel_routes;
+		ifr->full_sync = full_sync;
+	}
+
+	if (!ipx_routes->syncing) {
+		for (i = 0; i < ipx_routes->pending_changes->len; i++) {
+			const PendingRouteChange *change = &g_array_index (ipx_routes->pending_changes, PendingRouteChange, i);
+
+			_ifindex_routes_apply_change (vtable, ipx_routes, &change->route, change->change_type);
+		}
+		g_array_set_size (ipx_routes->pending_changes, 0);
+	}
+
+	if (ifr->link_removed && ipx_routes->syncing != ifr)
+		g_hash_table_remove (ipx_routes->ifindexes, GINT_TO_POINTER (ifindex));
 
 	return success;
 }
@@ -907,6 +1235,10 @@ next:
  * Default routes are ignored (both in @known_routes and those already
  * configured on the device).
  *
+ * A sync is skipped if neither @known_routes nor the routes of @ifindex in
+ * platform changed since the last successful sync. Otherwise, all routes of
+ * the interface are compared, the sync is not incremental.
+ *
  * Returns: %TRUE on success.
  */
 gboolean
@@ -1123,6 +1455,83 @@ nm_route_manager_ip4_route_register_device_route_purge_list (NMRouteManager *sel
 
 /*********************************************************************************************/
 
+static void
+_platform_ipx_route_changed_cb (NMPlatform *platform,
+                                NMPObjectType obj_type,
+                                int ifindex,
+                                const NMPlatformIPXRoute *route,
+                                NMPlatformSignalChangeType change_type,
+                                NMPlatformReason reason,
+                                NMRouteManager *self)
+{
+	NMRouteManagerPrivate *priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
+	const VTableIP *vtable;
+	RouteEntries *ipx_routes;
+	PendingRouteChange *change;
+
+	if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
+		/* IfindexRoutes only tracks non-default routes. */
+		return;
+	}
+
+	if (obj_type == NMP_OBJECT_TYPE_IP4_ROUTE) {
+		vtable = &vtable_v4;
+		ipx_routes = &priv->ip4_routes;
+	} else {
+		vtable = &vtable_v6;
+		ipx_routes = &priv->ip6_routes;
+	}
+
+	if (!g_hash_table_contains (ipx_routes->ifindexes, GINT_TO_POINTER (route->rx.ifindex)))
+		return;
+
+	if (ipx_routes->syncing) {
+		g_array_set_size (ipx_routes->pending_changes, ipx_routes->pending_changes->len + 1);
+		change = &g_array_index (ipx_routes->pending_changes, PendingRouteChange, ipx_routes->pending_changes->len - 1);
+		change->change_type = change_type;
+		memcpy (&change->route, route, vtable->vt->sizeof_route);
+		return;
+	}
+
+	_ifindex_routes_apply_change (vtable, ipx_routes, route, change_type);
+}
+
+static void
+_ifindex_routes_link_removed (RouteEntries *ipx_routes, int ifindex)
+{
+	IfindexRoutes *ifr;
+
+	ifr = g_hash_table_lookup (ipx_routes->ifindexes, GINT_TO_POINTER (ifindex));
+	if (!ifr)
+		return;
+
+	if (ifr == ipx_routes->syncing) {
+		ifr->link_removed = TRUE;
+		ifr->dirty = TRUE;
+	} else
+		g_hash_table_remove (ipx_routes->ifindexes, GINT_TO_POINTER (ifindex));
+}
+
+static void
+_platform_link_changed_cb (NMPlatform *platform,
+                           NMPObjectType obj_type,
+                           int ifindex,
+                           const NMPlatformLink *link,
+                           NMPlatformSignalChangeType change_type,
+                           NMPlatformReason reason,
+                           NMRouteManager *self)
+{
+	NMRouteManagerPrivate *priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
+
+	if (change_type != NM_PLATFORM_SIGNAL_REMOVED)
+		return;
+
+	_ifindex_routes_link_removed (&priv->ip4_routes, ifindex);
+	_ifindex_routes_link_removed (&priv->ip6_routes, ifindex);
+}
+
+/*********************************************************************************************/
+
 static const VTableIP vtable_v4 = {
 	.vt                             = &nm_platform_vtable_route_v4,
 	.route_dest_cmp                 = (int (*) (const NMPlatformIPXRoute *, const NMPlatformIPXRoute *)) _v4_route_dest_cmp,
@@ -1152,10 +1561,18 @@ nm_route_manager_init (NMRouteManager *self)
 	priv->ip6_routes.effective_metrics_reverse = g_array_new (FALSE, FALSE, sizeof (gint64));
 	priv->ip4_routes.index = _route_index_create (&vtable_v4, priv->ip4_routes.entries);
 	priv->ip6_routes.index = _route_index_create (&vtable_v6, priv->ip6_routes.entries);
+	priv->ip4_routes.ifindexes = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) _ifindex_routes_free);
+	priv->ip6_routes.ifindexes = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) _ifindex_routes_free);
+	priv->ip4_routes.pending_changes = g_array_new (FALSE, FALSE, sizeof (PendingRouteChange));
+	priv->ip6_routes.pending_changes = g_array_new (FALSE, FALSE, sizeof (PendingRouteChange));
 	priv->ip4_device_routes.entries = g_hash_table_new_full ((GHashFunc) nmp_object_id_hash,
 	                                                         (GEqualFunc) nmp_object_id_equal,
 	                                                         (GDestroyNotify) nmp_object_unref,
 	                                                         (GDestroyNotify) _ip4_device_routes_purge_entry_free);
+
+	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_LINK_CHANGED, G_CALLBACK (_platform_link_changed_cb), self);
+	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, G_CALLBACK (_platform_ipx_route_changed_cb), self);
+	g_signal_connect (priv->platform, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, G_CALLBACK (_platform_ipx_route_changed_cb), self);
 }
 
 static void
@@ -1167,6 +1584,10 @@ dispose (GObject *object)
 	g_hash_table_remove_all (priv->ip4_device_routes.entries);
 	_ip4_device_routes_cancel (self);
 
+	if (priv->platform) {
+		g_signal_handlers_disconnect_by_func (priv->platform, G_CALLBACK (_platform_link_changed_cb), self);
+		g_signal_handlers_disconnect_by_func (priv->platform, G_CALLBACK (_platform_ipx_route_changed_cb), self);
+	}
 	g_clear_object (&priv->platform);
 
 	G_OBJECT_CLASS (nm_route_manager_parent_class)->dispose (object);
@@ -1185,6 +1606,10 @@ finalize (GObject *object)
 	g_array_free (priv->ip6_routes.effective_metrics_reverse, TRUE);
 	g_free (priv->ip4_routes.index);
 	g_free (priv->ip6_routes.index);
+	g_hash_table_unref (priv->ip4_routes.ifindexes);
+	g_hash_table_unref (priv->ip6_routes.ifindexes);
+	g_array_free (priv->ip4_routes.pending_changes, TRUE);
+	g_array_free (priv->ip6_routes.pending_changes, TRUE);
 
 	g_hash_table_unref (priv->ip4_device_routes.entries);
 
@@ -131,6 +131,7 @@ typedef enum {
 	DELAYED_ACTION_TYPE_REFRESH_LINK                = (1LL << 5),
 	DELAYED_ACTION_TYPE_MASTER_CONNECTED            = (1LL << 6),
 	DELAYED_ACTION_TYPE_READ_NETLINK                = (1LL << 7),
+	DELAYED_ACTION_TYPE_PRUNE_IFINDEX               = (1LL << 8),
 	__DELAYED_ACTION_TYPE_MAX,
 
 	DELAYED_ACTION_TYPE_REFRESH_ALL                 = DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS |
@@ -148,6 +149,7 @@ static void do_request_link (NMPlatform *platform, int ifindex, const char *name
 static void do_request_all (NMPlatform *platform, DelayedActionType action_type, gboolean handle_delayed_action);
 static void cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMPCacheOpsType ops_type, gpointer user_data);
 static gboolean event_handler_read_netlink_all (NMPlatform *platform, gboolean wait_for_acks);
+static void sysctl_cache_remove_ifname (NMPlatform *platform, const char *ifname);
 static NMPCacheOpsType cache_remove_netlink (NMPlatform *platform, const NMPObject *obj_id, NMPObject **out_obj_cache, gboolean *out_was_visible, NMPlatformReason reason);
 
 /******************************************************************
@@ -1716,6 +1718,14 @@ nmp_object_new_from_nl (NMPlatform *platform, const NMPCache *cache, struct nl_m
 	}
 }
 
+/* Parse a netlink message without platform instance and cache, which
+ * suffices for addresses and routes. For tests only. */
+NMPObject *
+_nm_linux_platform_object_new_from_nl (struct nl_msg *msg, gboolean id_only)
+{
+	return nmp_object_new_from_nl (NULL, NULL, msg, id_only);
+}
+
 /******************************************************************/
 
 static gboolean
@@ -2113,6 +2123,20 @@ _nl_sock_flush_data (struct nl_sock *sk)
 	return nle;
 }
 
+static int
+_nl_sock_set_rcvbuf (struct nl_sock *sk, int size)
+{
+	int fd = nl_socket_get_fd (sk);
+
+	/* SO_RCVBUFFORCE may exceed net.core.rmem_max, but requires CAP_NET_ADMIN.
+	 * Fall back to SO_RCVBUF, which the kernel silently caps. */
+	if (setsockopt (fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof (size)) == 0)
+		return 0;
+	if (setsockopt (fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof (size)) == 0)
+		return 0;
+	return -errno;
+}
+
 static void
 _nl_msg_set_seq (struct nl_sock *sk, struct nl_msg *msg, guint32 *out_seq)
 {
@@ -2174,19 +2198,51 @@ _support_kernel_extended_ifa_flags_get (void)
  * NMPlatform types and functions
  ******************************************************************/
 
+typedef struct {
+	NMPObject *obj_id;
+	struct nl_msg *nlmsg;
+	guint32 seq;
+	int nle;
+	gboolean is_delete;
+	gboolean acked;
+	gboolean success;
+} BatchEntry;
+
 typedef struct _NMLinuxPlatformPrivate NMLinuxPlatformPrivate;
 
 struct _NMLinuxPlatformPrivate {
 	struct nl_sock *nlh;
 	struct nl_sock *nlh_event;
+	struct nl_sock *nlh_event_route;
 	guint32 nlh_seq_expect;
 	guint32 nlh_seq_last;
 	NMPCache *cache;
 	GIOChannel *event_channel;
 	guint event_id;
+	GIOChannel *event_channel_route;
+	guint event_id_route;
+
+	struct {
+		int rcvbuf_size;
+		int rcvbuf_size_route;
+		int rcvbuf_max;
+
+		/* object types for which a dump is currently requested on nlh_event. */
+		DelayedActionType dump_in_progress;
+
+		/* object types that must be dumped to recover from an overrun. */
+		DelayedActionType resync_pending;
+		gint64 resync_start_us;
+
+		guint overruns;
+		guint resyncs;
+		gint64 resync_last_usec;
+		gint64 resync_total_usec;
+	} netlink;
 
 	gboolean sysctl_get_warned;
 	GHashTable *sysctl_get_prev_values;
+	GHashTable *sysctl_cache;
 
 	GUdevClient *udev_client;
 
@@ -2194,6 +2250,7 @@ struct _NMLinuxPlatformPrivate {
 		DelayedActionType flags;
 		GPtrArray *list_master_connected;
 		GPtrArray *list_refresh_link;
+		GPtrArray *list_prune_ifindex;
 		gint is_handling;
 		guint idle_id;
 	} delayed_action;
@@ -2201,6 +2258,11 @@ struct _NMLinuxPlatformPrivate {
 	GHashTable *prune_candidates;
 	GHashTable *delayed_deletion;
 
+	struct {
+		int depth;
+		GArray *entries;
+	} batch;
+
 	GHashTable *wifi_data;
 };
 
@@ -2355,6 +2417,7 @@ delayed_action_to_string (DelayedActionType action_type)
 	case DELAYED_ACTION_TYPE_REFRESH_LINK                   : return "refresh-link";
 	case DELAYED_ACTION_TYPE_MASTER_CONNECTED               : return "master-connected";
 	case DELAYED_ACTION_TYPE_READ_NETLINK                   : return "read-netlink";
+	case DELAYED_ACTION_TYPE_PRUNE_IFINDEX                  : return "prune-ifindex";
 	default:
 		return "unknown";
 	}
@@ -2393,6 +2456,65 @@ delayed_action_handle_READ_NETLINK (NMPlatform *platform)
 	event_handler_read_netlink_all (platform, TRUE);
 }
 
+static void
+delayed_action_handle_PRUNE_IFINDEX (NMPlatform *platform, int ifindex)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	static const NMPObjectType obj_types[] = {
+		NMP_OBJECT_TYPE_IP4_ADDRESS,
+		NMP_OBJECT_TYPE_IP6_ADDRESS,
+		NMP_OBJECT_TYPE_IP4_ROUTE,
+		NMP_OBJECT_TYPE_IP6_ROUTE,
+	};
+	const NMPObject *obj_link;
+	guint i, j;
+
+	obj_link = nmp_cache_lookup_link (priv->cache, ifindex);
+	if (obj_link && obj_link->_link.netlink.is_in_netlink) {
+		/* The link is still there (or came back). We don't know which
+		 * addresses and routes kernel removed, fall back to a full refresh
+		 * like for a removed link. */
+		delayed_action_schedule (platform,
+		                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES |
+		                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES |
+		                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
+		                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
+		                         NULL);
+		return;
+	}
+
+	/* Kernel drops all addresses and routes together with the link, but it
+	 * doesn't notify us about all of them. Instead of dumping everything,
+	 * remove what we have cached for the ifindex. */
+	for (i = 0; i < G_N_ELEMENTS (obj_types); i++) {
+		const NMPlatformObject *const *objects;
+		gs_unref_ptrarray GPtrArray *prune_list = NULL;
+		NMPCacheId cache_id;
+		guint len;
+
+		objects = nmp_cache_lookup_multi (priv->cache,
+		                                  nmp_cache_id_init_addrroute_visible_by_ifindex (&cache_id, obj_types[i], ifindex),
+		                                  &len);
+		if (!len)
+			continue;
+
+		/* the index changes while removing objects, copy it first. */
+		prune_list = g_ptr_array_new_full (len, (GDestroyNotify) nmp_object_unref);
+		for (j = 0; j < len; j++)
+			g_ptr_array_add (prune_list, nmp_object_ref (NMP_OBJECT_UP_CAST (objects[j])));
+
+		for (j = 0; j < len; j++) {
+			nm_auto_nmpobj NMPObject *obj_cache = NULL;
+			gboolean was_visible;
+			NMPCacheOpsType cache_op;
+
+			_LOGt ("prune-ifindex: remove %s", nmp_object_to_string (prune_list->pdata[j], NMP_OBJECT_TO_STRING_ID, NULL, 0));
+			cache_op = nmp_cache_remove (priv->cache, prune_list->pdata[j], TRUE, &obj_cache, &was_visible, cache_pre_hook, platform);
+			do_emit_signal (platform, obj_cache, cache_op, was_visible, NM_PLATFORM_REASON_INTERNAL);
+		}
+	}
+}
+
 static gboolean
 delayed_action_handle_one (NMPlatform *platform)
 {
@@ -2431,6 +2553,23 @@ delayed_action_handle_one (NMPlatform *platform)
 		return TRUE;
 	}
 
+	/* Pruning a removed link must happen before refreshing, because it
+	 * may still escalate to a refresh. */
+	if (NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_PRUNE_IFINDEX)) {
+		nm_assert (priv->delayed_action.list_prune_ifindex->len > 0);
+
+		user_data = priv->delayed_action.list_prune_ifindex->pdata[0];
+		g_ptr_array_remove_index_fast (priv->delayed_action.list_prune_ifindex, 0);
+		if (priv->delayed_action.list_prune_ifindex->len == 0)
+			priv->delayed_action.flags &= ~DELAYED_ACTION_TYPE_PRUNE_IFINDEX;
+		nm_assert (_nm_utils_ptrarray_find_first (priv->delayed_action.list_prune_ifindex->pdata, priv->delayed_action.list_prune_ifindex->len, user_data) < 0);
+
+		_LOGt_delayed_action (DELAYED_ACTION_TYPE_PRUNE_IFINDEX, user_data, "handle");
+		delayed_action_handle_PRUNE_IFINDEX (platform, GPOINTER_TO_INT (user_data));
+		return TRUE;
+	}
+	nm_assert (priv->delayed_action.list_prune_ifindex->len == 0);
+
 	if (NM_FLAGS_ANY (priv->delayed_action.flags, DELAYED_ACTION_TYPE_REFRESH_ALL)) {
 		DelayedActionType flags, iflags;
 
@@ -2472,12 +2611,14 @@ delayed_action_handle_all (NMPlatform *platform, gboolean read_netlink)
 	gboolean any = FALSE;
 
 	nm_clear_g_source (&priv->delayed_action.idle_id);
+	nm_platform_changes_freeze (platform);
 	priv->delayed_action.is_handling++;
 	if (read_netlink)
 		delayed_action_schedule (platform, DELAYED_ACTION_TYPE_READ_NETLINK, NULL);
 	while (delayed_action_handle_one (platform))
 		any = TRUE;
 	priv->delayed_action.is_handling--;
+	nm_platform_changes_thaw (platform);
 	return any;
 }
 
@@ -2532,6 +2673,10 @@ delayed_action_schedule (NMPlatform *platform, DelayedActionType action_type, gp
 		nm_assert (nm_utils_is_power_of_two (action_type));
 		if (_nm_utils_ptrarray_find_first (priv->delayed_action.list_master_connected->pdata, priv->delayed_action.list_master_connected->len, user_data) < 0)
 			g_ptr_array_add (priv->delayed_action.list_master_connected, user_data);
+	} else if (NM_FLAGS_HAS (action_type, DELAYED_ACTION_TYPE_PRUNE_IFINDEX)) {
+		nm_assert (nm_utils_is_power_of_two (action_type));
+		if (_nm_utils_ptrarray_find_first (priv->delayed_action.list_prune_ifindex->pdata, priv->delayed_action.list_prune_ifindex->len, user_data) < 0)
+			g_ptr_array_add (priv->delayed_action.list_prune_ifindex, user_data);
 	} else
 		nm_assert (!user_data);
 
@@ -2713,7 +2858,7 @@ cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMP
 		{
 			int ifindex = 0;
 
-			/* if we remove a link (from netlink), we must refresh the addresses and routes */
+			/* if we remove a link (from netlink), we must drop its addresses and routes */
 			if (   ops_type == NMP_CACHE_OPS_REMOVED
 			    && old /* <-- nonsensical, make coverity happy */)
 				ifindex = old->link.ifindex;
@@ -2723,14 +2868,8 @@ cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMP
 			         && new->_link.netlink.is_in_netlink != old->_link.netlink.is_in_netlink)
 				ifindex = new->link.ifindex;
 
-			if (ifindex > 0) {
-				delayed_action_schedule (platform,
-				                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES |
-				                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES |
-				                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
-				                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
-				                         NULL);
-			}
+			if (ifindex > 0)
+				delayed_action_schedule (platform, DELAYED_ACTION_TYPE_PRUNE_IFINDEX, GINT_TO_POINTER (ifindex));
 		}
 		{
 			int ifindex = -1;
@@ -2764,19 +2903,37 @@ cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMP
 			}
 		}
 		{
-			/* if a link goes down, we must refresh routes */
+			/* if a link goes down, we must refresh routes. If it is also
+			 * administratively down, it is likely about to be removed, in which
+			 * case pruning the ifindex avoids the refresh. */
 			if (   ops_type == NMP_CACHE_OPS_UPDATED
 			    && old && new /* <-- nonsensical, make coverity happy */
 			    && old->_link.netlink.is_in_netlink
 			    && NM_FLAGS_HAS (old->link.flags, IFF_LOWER_UP)
 			    && new->_link.netlink.is_in_netlink
 			    && !NM_FLAGS_HAS (new->link.flags, IFF_LOWER_UP)) {
-				delayed_action_schedule (platform,
-				                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
-				                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
-				                         NULL);
+				if (!NM_FLAGS_HAS (new->link.flags, IFF_UP))
+					delayed_action_schedule (platform, DELAYED_ACTION_TYPE_PRUNE_IFINDEX, GINT_TO_POINTER (new->link.ifindex));
+				else {
+					delayed_action_schedule (platform,
+					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
+					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
+					                         NULL);
+				}
 			}
 		}
+		{
+			/* sysctl values of a link are gone with it or must be looked up under
+			 * the new name. */
+			if (   old
+			    && (   !new
+			        || strcmp (old->link.name, new->link.name) != 0))
+				sysctl_cache_remove_ifname (platform, old->link.name);
+			if (   new
+			    && (   !old
+			        || strcmp (old->link.name, new->link.name) != 0))
+				sysctl_cache_remove_ifname (platform, new->link.name);
+		}
 		{
 			/* on enslave/release, we also refresh the master. */
 			int ifindex1 = 0, ifindex2 = 0;
@@ -2803,13 +2960,22 @@ cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMP
 	case NMP_OBJECT_TYPE_IP6_ADDRESS:
 		{
 			/* Address deletion is sometimes accompanied by route deletion. We need to
-			 * check all routes belonging to the same interface. */
+			 * check all routes belonging to the same interface. If the interface is
+			 * down or gone, defer that decision to the pruning of the ifindex. */
 			if (ops_type == NMP_CACHE_OPS_REMOVED) {
-				delayed_action_schedule (platform,
-				                         (klass->obj_type == NMP_OBJECT_TYPE_IP4_ADDRESS)
-				                             ? DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES
-				                             : DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
-				                         NULL);
+				const NMPObject *obj_link = nmp_cache_lookup_link (cache, old->object.ifindex);
+
+				if (   !obj_link
+				    || !obj_link->_link.netlink.is_in_netlink
+				    || !NM_FLAGS_HAS (obj_link->link.flags, IFF_UP))
+					delayed_action_schedule (platform, DELAYED_ACTION_TYPE_PRUNE_IFINDEX, GINT_TO_POINTER (old->object.ifindex));
+				else {
+					delayed_action_schedule (platform,
+					                         (klass->obj_type == NMP_OBJECT_TYPE_IP4_ADDRESS)
+					                             ? DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES
+					                             : DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
+					                         NULL);
+				}
 			}
 		}
 	default:
@@ -2936,10 +3102,15 @@ do_request_all (NMPlatform *platform, DelayedActionType action_type, gboolean ha
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	guint32 seq;
 	DelayedActionType iflags;
+	DelayedActionType resyncing;
 
 	nm_assert (!NM_FLAGS_ANY (action_type, ~DELAYED_ACTION_TYPE_REFRESH_ALL));
 	action_type &= DELAYED_ACTION_TYPE_REFRESH_ALL;
 
+	/* an overrun while dumping sets the flags again and postpones completion. */
+	resyncing = priv->netlink.resync_pending & action_type;
+	priv->netlink.resync_pending &= ~action_type;
+
 	for (iflags = (DelayedActionType) 0x1LL; iflags <= DELAYED_ACTION_TYPE_MAX; iflags <<= 1) {
 		if (NM_FLAGS_HAS (action_type, iflags))
 			cache_prune_candidates_record_all (platform, delayed_action_refresh_to_object_type (iflags));
@@ -2981,16 +3152,28 @@ do_request_all (NMPlatform *platform, DelayedActionType action_type, gboolean ha
 			_nl_msg_set_seq (priv->nlh_event, nlmsg, &seq);
 
 			nle = nl_send_auto (priv->nlh_event, nlmsg);
-			if (nle >= 0)
+			if (nle >= 0) {
 				_new_sequence_number (platform, seq);
+				priv->netlink.dump_in_progress |= iflags;
+			}
 		}
 next:
 		;
 	}
 	event_handler_read_netlink_all (platform, TRUE);
+	priv->netlink.dump_in_progress &= ~action_type;
 
 	cache_prune_candidates_prune (platform);
 
+	if (resyncing && !priv->netlink.resync_pending) {
+		gint64 duration = nm_utils_get_monotonic_timestamp_us () - priv->netlink.resync_start_us;
+
+		priv->netlink.resyncs++;
+		priv->netlink.resync_last_usec = duration;
+		priv->netlink.resync_total_usec += duration;
+		_LOGD ("netlink: platform cache resynchronized after overrun in %"G_GINT64_FORMAT" usec", duration);
+	}
+
 	if (handle_delayed_action)
 		delayed_action_handle_all (platform, FALSE);
 }
@@ -3074,6 +3257,32 @@ event_notification (struct nl_msg *msg, gpointer user_data)
 
 	switch (msghdr->nlmsg_type) {
 
+	case RTM_NEWROUTE:
+		if (obj->object.ifindex > 0) {
+			const NMPObject *obj_link = nmp_cache_lookup_link (priv->cache, obj->object.ifindex);
+
+			/* Route notifications come on their own socket. The link might already
+			 * be removed (and with it, its routes) or its notification might not be
+			 * read yet, or got lost in an overrun of the other socket. Don't put
+			 * the route into the cache now, but dump the routes again: the dump
+			 * replies come on the socket for links, after the link notifications.
+			 * A dump reply itself can only refer to a link that is gone. */
+			if (!obj_link || !obj_link->_link.netlink.is_in_netlink) {
+				_LOGT ("event-notification: ignore route for unknown ifindex %d%s", obj->object.ifindex,
+				       NM_FLAGS_HAS (msghdr->nlmsg_flags, NLM_F_MULTI) ? "" : ", refresh routes");
+				if (!NM_FLAGS_HAS (msghdr->nlmsg_flags, NLM_F_MULTI)) {
+					delayed_action_schedule (platform,
+					                         NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_IP4_ROUTE
+					                             ? DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES
+					                             : DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
+					                         NULL);
+				}
+				break;
+			}
+		}
+		cache_update_netlink (platform, obj, &obj_cache, NULL, NM_PLATFORM_REASON_EXTERNAL);
+		break;
+
 	case RTM_NEWLINK:
 		if (NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_LINK) {
 			if (g_hash_table_lookup (priv->delayed_deletion, obj) != NULL) {
@@ -3086,7 +3295,6 @@ event_notification (struct nl_msg *msg, gpointer user_data)
 		}
 		/* fall-through */
 	case RTM_NEWADDR:
-	case RTM_NEWROUTE:
 		cache_update_netlink (platform, obj, &obj_cache, NULL, NM_PLATFORM_REASON_EXTERNAL);
 		break;
 
@@ -3146,22 +3354,160 @@ _log_dbg_sysctl_set_impl (NMPlatform *platform, const char *path, const char *va
 		} \
 	} G_STMT_END
 
+/* Values below these directories are cached by sysctl_get(). The cache
+ * is indexed by the interface name (or "all"/"default"), so that the
+ * entries of a renamed or removed link can be dropped at once. */
+#define SYSCTL_CACHE_DIR_IP4 "/proc/sys/net/ipv4/conf/"
+#define SYSCTL_CACHE_DIR_IP6 "/proc/sys/net/ipv6/conf/"
+
+/* Other programs may write the options too, without us noticing. Only
+ * reuse values that were read very recently, which still covers the
+ * bursts of reads during activation. */
+#define SYSCTL_CACHE_TIMEOUT_MS 1000
+
+typedef struct {
+	char *value;
+	gint64 timestamp_ms;
+} SysctlCacheEntry;
+
+static void
+_sysctl_cache_entry_free (gpointer data)
+{
+	SysctlCacheEntry *entry = data;
+
+	g_free (entry->value);
+	g_slice_free (SysctlCacheEntry, entry);
+}
+
+/* Options that the kernel changes by itself, for example when a router
+ * advertisement announces a MTU or hop limit, or when DAD fails. These
+ * are never cached. */
 static gboolean
-sysctl_set (NMPlatform *platform, const char *path, const char *value)
+_sysctl_cache_is_volatile (const char *path)
+{
+	static const char *const names[] = { "mtu", "hop_limit", "disable_ipv6" };
+	const char *name = strrchr (path, '/');
+	guint i;
+
+	if (!name)
+		return FALSE;
+	for (i = 0; i < G_N_ELEMENTS (names); i++) {
+		if (!strcmp (name + 1, names[i]))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static char *
+_sysctl_cache_get_ifname (const char *path)
+{
+	const char *ifname, *slash;
+
+	if (g_str_has_prefix (path, SYSCTL_CACHE_DIR_IP4))
+		ifname = &path[STRLEN (SYSCTL_CACHE_DIR_IP4)];
+	else if (g_str_has_prefix (path, SYSCTL_CACHE_DIR_IP6))
+		ifname = &path[STRLEN (SYSCTL_CACHE_DIR_IP6)];
+	else
+		return NULL;
+
+	slash = strchr (ifname, '/');
+	if (!slash || slash == ifname)
+		return NULL;
+	return g_strndup (ifname, slash - ifname);
+}
+
+static const char *
+sysctl_cache_lookup (NMPlatform *platform, const char *path)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gs_free char *ifname = NULL;
+	GHashTable *values;
+	SysctlCacheEntry *entry;
+
+	ifname = _sysctl_cache_get_ifname (path);
+	if (!ifname)
+		return NULL;
+
+	values = g_hash_table_lookup (priv->sysctl_cache, ifname);
+	entry = values ? g_hash_table_lookup (values, path) : NULL;
+	if (!entry)
+		return NULL;
+
+	if (nm_utils_get_monotonic_timestamp_ms () - entry->timestamp_ms >= SYSCTL_CACHE_TIMEOUT_MS) {
+		g_hash_table_remove (values, path);
+		return NULL;
+	}
+	return entry->value;
+}
+
+static void
+sysctl_cache_add (NMPlatform *platform, const char *path, const char *value)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	char *ifname;
+	GHashTable *values;
+	SysctlCacheEntry *entry;
+
+	if (_sysctl_cache_is_volatile (path))
+		return;
+
+	ifname = _sysctl_cache_get_ifname (path);
+	if (!ifname)
+		return;
+
+	values = g_hash_table_lookup (priv->sysctl_cache, ifname);
+	if (!values) {
+		values = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _sysctl_cache_entry_free);
+		g_hash_table_insert (priv->sysctl_cache, ifname, values);
+	} else
+		g_free (ifname);
+
+	entry = g_slice_new (SysctlCacheEntry);
+	entry->value = g_strdup (value);
+	entry->timestamp_ms = nm_utils_get_monotonic_timestamp_ms ();
+	g_hash_table_insert (values, g_strdup (path), entry);
+}
+
+static void
+sysctl_cache_remove (NMPlatform *platform, const char *path)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gs_free char *ifname = NULL;
+	GHashTable *values;
+
+	ifname = _sysctl_cache_get_ifname (path);
+	if (!ifname || strcmp (ifname, "all") == 0) {
+		/* Writing to "all" or to global options like ip_forward also
+		 * changes the values of the interfaces. */
+		if (g_str_has_prefix (path, "/proc/sys/net/"))
+			g_hash_table_remove_all (priv->sysctl_cache);
+		return;
+	}
+
+	values = g_hash_table_lookup (priv->sysctl_cache, ifname);
+	if (values)
+		g_hash_table_remove (values, path);
+}
+
+static void
+sysctl_cache_remove_ifname (NMPlatform *platform, const char *ifname)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	if (ifname && ifname[0])
+		g_hash_table_remove (priv->sysctl_cache, ifname);
+}
+
+static gboolean
+_sysctl_set_at (NMPlatform *platform, int dirfd, const char *path, const char *name, const char *value)
 {
 	int fd, len, nwrote, tries;
 	char *actual;
 
-	g_return_val_if_fail (path != NULL, FALSE);
-	g_return_val_if_fail (value != NULL, FALSE);
+	/* Whatever happens, the cached value might no longer be valid. */
+	sysctl_cache_remove (platform, path);
 
-	/* Don't write outside known locations */
-	g_assert (g_str_has_prefix (path, "/proc/sys/")
-	          || g_str_has_prefix (path, "/sys/"));
-	/* Don't write to suspicious locations */
-	g_assert (!strstr (path, "/../"));
-
-	fd = open (path, O_WRONLY | O_TRUNC);
+	fd = openat (dirfd, name, O_WRONLY | O_TRUNC);
 	if (fd == -1) {
 		if (errno == ENOENT) {
 			_LOGD ("sysctl: failed to open '%s': (%d) %s",
@@ -3207,6 +3553,60 @@ sysctl_set (NMPlatform *platform, const char *path, const char *value)
 	return (nwrote == len);
 }
 
+static gboolean
+sysctl_set (NMPlatform *platform, const char *path, const char *value)
+{
+	g_return_val_if_fail (path != NULL, FALSE);
+	g_return_val_if_fail (value != NULL, FALSE);
+
+	/* Don't write outside known locations */
+	g_assert (g_str_has_prefix (path, "/proc/sys/")
+	          || g_str_has_prefix (path, "/sys/"));
+	/* Don't write to suspicious locations */
+	g_assert (!strstr (path, "/../"));
+
+	return _sysctl_set_at (platform, AT_FDCWD, path, path, value);
+}
+
+static gboolean
+sysctl_set_multiple (NMPlatform *platform, const char *dirname, const char *const *keys_values)
+{
+	gboolean success = TRUE;
+	int dirfd;
+
+	/* Don't write outside known locations */
+	g_assert (g_str_has_prefix (dirname, "/proc/sys/")
+	          || g_str_has_prefix (dirname, "/sys/"));
+	/* Don't write to suspicious locations */
+	g_assert (!strstr (dirname, "/../"));
+
+	dirfd = open (dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dirfd == -1) {
+		if (errno == ENOENT) {
+			_LOGD ("sysctl: failed to open directory '%s': (%d) %s",
+			       dirname, errno, strerror (errno));
+		} else {
+			_LOGE ("sysctl: failed to open directory '%s': (%d) %s",
+			       dirname, errno, strerror (errno));
+		}
+		return FALSE;
+	}
+
+	for (; keys_values[0]; keys_values += 2) {
+		gs_free char *path = NULL;
+
+		g_assert (nm_utils_is_valid_path_component (keys_values[0]));
+		g_assert (keys_values[1]);
+
+		path = g_strdup_printf ("%s/%s", dirname, keys_values[0]);
+		if (!_sysctl_set_at (platform, dirfd, path, keys_values[0], keys_values[1]))
+			success = FALSE;
+	}
+
+	close (dirfd);
+	return success;
+}
+
 static GSList *sysctl_clear_cache_list;
 
 void
@@ -3271,6 +3671,7 @@ sysctl_get (NMPlatform *platform, const char *path)
 {
 	GError *error = NULL;
 	char *contents;
+	const char *cached;
 
 	/* Don't write outside known locations */
 	g_assert (g_str_has_prefix (path, "/proc/sys/")
@@ -3278,6 +3679,10 @@ sysctl_get (NMPlatform *platform, const char *path)
 	/* Don't write to suspicious locations */
 	g_assert (!strstr (path, "/../"));
 
+	cached = sysctl_cache_lookup (platform, path);
+	if (cached)
+		return g_strdup (cached);
+
 	if (!g_file_get_contents (path, &contents, NULL, &error)) {
 		/* We assume FAILED means EOPNOTSUP */
 		if (   g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)
@@ -3293,6 +3698,7 @@ sysctl_get (NMPlatform *platform, const char *path)
 
 	_log_dbg_sysctl_get (platform, path, contents);
 
+	sysctl_cache_add (platform, path, contents);
 	return contents;
 }
 
@@ -3394,82 +3800,500 @@ link_get_lnk (NMPlatform *platform, int ifindex, NMLinkType link_type, const NMP
 	        || link_type != NMP_OBJECT_GET_CLASS (obj->_link.netlink.lnk)->lnk_link_type))
 		return NULL;
 
-	return obj->_link.netlink.lnk;
+	return obj->_link.netlink.lnk;
+}
+
+/*****************************************************************************/
+
+static gboolean
+do_add_link (NMPlatform *platform,
+             NMLinkType link_type,
+             const char *name,
+             struct nl_msg *nlmsg)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	int nle;
+
+	event_handler_read_netlink_all (platform, FALSE);
+
+	nle = nl_send_auto (priv->nlh, nlmsg);
+	if (nle < 0) {
+		_LOGE ("do-add-link[%s/%s]: failure sending netlink request \"%s\" (%d)",
+		       name,
+		       nm_link_type_to_string (link_type),
+		       nl_geterror (nle), -nle);
+		return FALSE;
+	}
+
+	nle = nl_wait_for_ack (priv->nlh);
+	switch (nle) {
+	case -NLE_SUCCESS:
+		_LOGD ("do-add-link[%s/%s]: success adding",
+		       name,
+		       nm_link_type_to_string (link_type));
+		break;
+	default:
+		_LOGE ("do-add-link[%s/%s]: failed with \"%s\" (%d)",
+		       name,
+		       nm_link_type_to_string (link_type),
+		       nl_geterror (nle), -nle);
+		return FALSE;
+	}
+
+	delayed_action_handle_all (platform, TRUE);
+
+	/* FIXME: we add the link object via the second netlink socket. Sometimes,
+	 * the notification is not yet ready via nlh_event, so we have to re-request the
+	 * link so that it is in the cache. A better solution would be to do everything
+	 * via one netlink socket. */
+	if (!nmp_cache_lookup_link_full (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache, 0, name, FALSE, NM_LINK_TYPE_NONE, NULL, NULL)) {
+		_LOGt ("do-add-link[%s/%s]: the added link is not yet ready. Request anew",
+		       name,
+		       nm_link_type_to_string (link_type));
+		do_request_link (platform, 0, name, TRUE);
+	}
+
+	/* Return true, because the netlink request succeeded. This doesn't indicate that the
+	 * object is now actually in the cache, because there could be a race. */
+	return TRUE;
+}
+
+static gboolean
+do_add_link_with_lookup (NMPlatform *platform,
+                         NMLinkType link_type,
+                         const char *name,
+                         struct nl_msg *nlmsg,
+                         NMPlatformLink *out_link)
+{
+	const NMPObject *obj;
+
+	do_add_link (platform, link_type, name, nlmsg);
+
+	obj = nmp_cache_lookup_link_full (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache,
+	                                  0, name, FALSE, link_type, NULL, NULL);
+	if (out_link && obj)
+		*out_link = obj->link;
+	return !!obj;
+}
+
+static gboolean
+_do_add_addrroute_check_result (NMPlatform *platform, const NMPObject *obj_id, int nle)
+{
+	switch (nle) {
+	case -NLE_SUCCESS:
+		_LOGD ("do-add-%s[%s]: success adding", NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name, nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0));
+		return TRUE;
+	case -NLE_EXIST:
+		/* NLE_EXIST is considered equivalent to success to avoid race conditions. You
+		 * never know when something sends an identical object just before
+		 * NetworkManager. */
+		_LOGD ("do-add-%s[%s]: adding link failed with \"%s\" (%d), meaning such a link already exists",
+		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
+		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+		       nl_geterror (nle), -nle);
+		return TRUE;
+	default:
+		_LOGE ("do-add-%s[%s]: failed with \"%s\" (%d)",
+		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
+		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+		       nl_geterror (nle), -nle);
+		return FALSE;
+	}
+}
+
+static gboolean
+_do_delete_object_check_result (NMPlatform *platform, const NMPObject *obj_id, int nle)
+{
+	switch (nle) {
+	case -NLE_SUCCESS:
+		_LOGD ("do-delete-%s[%s]: success deleting", NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name, nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0));
+		return TRUE;
+	case -NLE_OBJ_NOTFOUND:
+		_LOGD ("do-delete-%s[%s]: failed with \"%s\" (%d), meaning the object was already removed",
+		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
+		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+		       nl_geterror (nle), -nle);
+		return TRUE;
+	case -NLE_FAILURE:
+		if (NMP_OBJECT_GET_TYPE (obj_id) != NMP_OBJECT_TYPE_IP6_ADDRESS)
+			goto nle_failure;
+
+		/* On RHEL7 kernel, deleting a non existing address fails with ENXIO (which libnl maps to NLE_FAILURE) */
+		_LOGD ("do-delete-%s[%s]: deleting address failed with \"%s\" (%d), meaning the address was already removed",
+		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
+		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+		       nl_geterror (nle), -nle);
+		return TRUE;
+	case -NLE_NOADDR:
+		if (   NMP_OBJECT_GET_TYPE (obj_id) != NMP_OBJECT_TYPE_IP4_ADDRESS
+		    && NMP_OBJECT_GET_TYPE (obj_id) != NMP_OBJECT_TYPE_IP6_ADDRESS)
+			goto nle_failure;
+
+		_LOGD ("do-delete-%s[%s]: deleting address failed with \"%s\" (%d), meaning the address was already removed",
+		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
+		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+		       nl_geterror (nle), -nle);
+		return TRUE;
+	default:
+nle_failure:
+		_LOGE ("do-delete-%s[%s]: failed with \"%s\" (%d)",
+		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
+		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+		       nl_geterror (nle), -nle);
+		return FALSE;
+	}
+}
+
+/******************************************************************/
+
+/* Maximum number of requests and bytes that are sent to kernel in one write
+ * during a batch commit. We must receive the ACKs for a chunk before sending
+ * the next one, otherwise they might overflow the receive buffer of the
+ * request socket. */
+#define BATCH_CHUNK_MAX_MSGS     128
+#define BATCH_CHUNK_MAX_BYTES    (32 * 1024)
+
+/* How long to wait for the next ACK of a chunk. A request whose ACK doesn't
+ * arrive in time (e.g. because the receive buffer overflowed) fails. */
+#define BATCH_ACK_TIMEOUT_MS     250
+
+static void
+_batch_entry_clear (BatchEntry *entry)
+{
+	g_clear_pointer (&entry->obj_id, nmp_object_unref);
+	g_clear_pointer (&entry->nlmsg, nlmsg_free);
+}
+
+static gboolean
+batch_queue (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *nlmsg, gboolean is_delete)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	BatchEntry *entry;
+
+	nm_assert (priv->batch.depth > 0);
+	nm_assert (NM_IN_SET (NMP_OBJECT_GET_TYPE (obj_id),
+	                      NMP_OBJECT_TYPE_IP4_ADDRESS, NMP_OBJECT_TYPE_IP6_ADDRESS,
+	                      NMP_OBJECT_TYPE_IP4_ROUTE, NMP_OBJECT_TYPE_IP6_ROUTE));
+
+	g_array_set_size (priv->batch.entries, priv->batch.entries->len + 1);
+	entry = &g_array_index (priv->batch.entries, BatchEntry, priv->batch.entries->len - 1);
+
+	/* the caller frees @nlmsg on return, take our own reference. */
+	nlmsg_get (nlmsg);
+
+	entry->obj_id = nmp_object_clone (obj_id, TRUE);
+	entry->nlmsg = nlmsg;
+	entry->seq = 0;
+	entry->nle = -NLE_FAILURE;
+	entry->is_delete = is_delete;
+	entry->acked = FALSE;
+	entry->success = FALSE;
+
+	_LOGt ("batch: queue %s-%s[%s] (#%u)",
+	       is_delete ? "delete" : "add",
+	       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
+	       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+	       priv->batch.entries->len - 1);
+	return TRUE;
+}
+
+typedef struct {
+	BatchEntry *entries;
+	guint len;
+	guint n_pending;
+} BatchAckData;
+
+static BatchEntry *
+_batch_ack_data_find (BatchAckData *data, guint32 seq)
+{
+	guint32 i;
+
+	/* the requests of a chunk get consecutive sequence numbers. The unsigned
+	 * difference also works when they wrap around, except that _nl_msg_set_seq()
+	 * skips zero. Then the entry is one position before. */
+	i = seq - data->entries[0].seq;
+	if (i < data->len && data->entries[i].seq == seq)
+		return &data->entries[i];
+	if (i > 0 && i - 1 < data->len && data->entries[i - 1].seq == seq)
+		return &data->entries[i - 1];
+	return NULL;
+}
+
+static int
+_batch_ack_seq_check (struct nl_msg *msg, gpointer user_data)
+{
+	/* we match the ACKs by sequence number ourselves. */
+	return NL_OK;
+}
+
+static int
+_batch_ack_valid (struct nl_msg *msg, gpointer user_data)
+{
+	/* the request socket doesn't subscribe to any multicast groups. Ignore
+	 * anything that is not an ACK. */
+	return NL_OK;
+}
+
+static int
+_batch_ack_handler (struct nl_msg *msg, gpointer user_data)
+{
+	BatchAckData *data = user_data;
+	BatchEntry *entry;
+
+	entry = _batch_ack_data_find (data, nlmsg_hdr (msg)->nlmsg_seq);
+	if (entry && !entry->acked) {
+		entry->acked = TRUE;
+		entry->nle = -NLE_SUCCESS;
+		data->n_pending--;
+	}
+	return NL_OK;
+}
+
+static int
+_batch_ack_err_handler (struct sockaddr_nl *nla, struct nlmsgerr *nlerr, gpointer user_data)
+{
+	BatchAckData *data = user_data;
+	BatchEntry *entry;
+
+	entry = _batch_ack_data_find (data, nlerr->msg.nlmsg_seq);
+	if (entry && !entry->acked) {
+		entry->acked = TRUE;
+		entry->nle = -nl_syserr2nlerr (nlerr->error);
+		data->n_pending--;
+	}
+	return NL_SKIP;
+}
+
+static void
+_batch_send_chunk (NMPlatform *platform, BatchEntry *entries, guint len)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	BatchAckData data = {
+		.entries = entries,
+		.len = len,
+		.n_pending = 0,
+	};
+	gs_free guint8 *buf = NULL;
+	gsize buf_len = 0, buf_alloc = 0;
+	struct nl_cb *cb;
+	gint64 timestamp, now;
+	guint i;
+	int nle;
+
+	for (i = 0; i < len; i++) {
+		struct nlmsghdr *hdr = nlmsg_hdr (entries[i].nlmsg);
+
+		buf_alloc += NLMSG_ALIGN (hdr->nlmsg_len);
+	}
+	buf = g_malloc (buf_alloc);
+
+	/* Concatenate all messages of the chunk, so that we can pass them to
+	 * kernel with one single write. Kernel processes the messages in order and
+	 * sends one ACK for each of them, which we match by sequence number. */
+	for (i = 0; i < len; i++) {
+		struct nlmsghdr *hdr = nlmsg_hdr (entries[i].nlmsg);
+
+		hdr->nlmsg_flags |= NLM_F_REQUEST | NLM_F_ACK;
+		hdr->nlmsg_pid = nl_socket_get_local_port (priv->nlh);
+		_nl_msg_set_seq (priv->nlh, entries[i].nlmsg, &entries[i].seq);
+
+		memcpy (&buf[buf_len], hdr, hdr->nlmsg_len);
+		memset (&buf[buf_len + hdr->nlmsg_len], 0, NLMSG_ALIGN (hdr->nlmsg_len) - hdr->nlmsg_len);
+		buf_len += NLMSG_ALIGN (hdr->nlmsg_len);
+	}
+
+	_LOGt ("batch: send %u requests (%" G_GSIZE_FORMAT " bytes)", len, buf_len);
+
+	nle = nl_sendto (priv->nlh, buf, buf_len);
+	if (nle < 0) {
+		_LOGE ("batch: failure sending %u netlink requests \"%s\" (%d)",
+		       len, nl_geterror (nle), -nle);
+		for (i = 0; i < len; i++)
+			entries[i].nle = nle;
+		return;
+	}
+
+	cb = nl_cb_clone (nl_socket_get_cb (priv->nlh));
+	if (!cb) {
+		for (i = 0; i < len; i++)
+			entries[i].nle = -NLE_NOMEM;
+		return;
+	}
+
+	nl_cb_set (cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM, _batch_ack_seq_check, &data);
+	nl_cb_set (cb, NL_CB_VALID, NL_CB_CUSTOM, _batch_ack_valid, &data);
+	nl_cb_set (cb, NL_CB_ACK, NL_CB_CUSTOM, _batch_ack_handler, &data);
+	nl_cb_err (cb, NL_CB_CUSTOM, _batch_ack_err_handler, &data);
+
+	/* The request socket is blocking. Only read when there is something to
+	 * read, so that a lost ACK can't block us forever. */
+	data.n_pending = len;
+	timestamp = nm_utils_get_monotonic_timestamp_ms ();
+	while (data.n_pending > 0) {
+		struct pollfd pfd = {
+			.fd = nl_socket_get_fd (priv->nlh),
+			.events = POLLIN,
+		};
+		guint n_pending = data.n_pending;
+		int r;
+
+		now = nm_utils_get_monotonic_timestamp_ms ();
+		if (now - timestamp >= BATCH_ACK_TIMEOUT_MS)
+			break;
+
+		r = poll (&pfd, 1, BATCH_ACK_TIMEOUT_MS - (now - timestamp));
+		if (r == 0)
+			break;
+		if (r < 0) {
+			int errsv = errno;
+
+			if (errsv == EINTR)
+				continue;
+			_LOGE ("batch: poll failed with %s", strerror (errsv));
+			break;
+		}
+
+		nle = nl_recvmsgs (priv->nlh, cb);
+		if (nle < 0) {
+			_LOGE ("batch: failure receiving ACKs for %u pending requests \"%s\" (%d)",
+			       data.n_pending, nl_geterror (nle), -nle);
+			for (i = 0; i < len; i++) {
+				if (!entries[i].acked)
+					entries[i].nle = nle;
+			}
+			goto out;
+		}
+
+		/* restart counting the wait time whenever an ACK arrives. */
+		if (data.n_pending < n_pending)
+			timestamp = nm_utils_get_monotonic_timestamp_ms ();
+	}
+
+	if (data.n_pending > 0) {
+		_LOGW ("batch: timeout waiting for ACKs to %u of %u requests", data.n_pending, len);
+		for (i = 0; i < len; i++) {
+			if (!entries[i].acked)
+				entries[i].nle = -NLE_AGAIN;
+		}
+	}
+
+out:
+	nl_cb_put (cb);
 }
 
-/*****************************************************************************/
+static void
+batch_begin (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	if (priv->batch.depth++ == 0)
+		_LOGt ("batch: begin");
+}
 
 static gboolean
-do_add_link (NMPlatform *platform,
-             NMLinkType link_type,
-             const char *name,
-             struct nl_msg *nlmsg)
+batch_commit (NMPlatform *platform, GPtrArray **out_failed)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	int nle;
+	GArray *entries;
+	GPtrArray *failed = NULL;
+	DelayedActionType refresh = DELAYED_ACTION_TYPE_NONE;
+	gboolean any_success = FALSE;
+	guint i, chunk_start, chunk_bytes;
 
-	event_handler_read_netlink_all (platform, FALSE);
+	g_return_val_if_fail (priv->batch.depth > 0, FALSE);
 
-	nle = nl_send_auto (priv->nlh, nlmsg);
-	if (nle < 0) {
-		_LOGE ("do-add-link[%s/%s]: failure sending netlink request \"%s\" (%d)",
-		       name,
-		       nm_link_type_to_string (link_type),
-		       nl_geterror (nle), -nle);
-		return FALSE;
+	NM_SET_OUT (out_failed, NULL);
+
+	if (--priv->batch.depth > 0) {
+		/* a nested transaction. The outermost commit will send the requests. */
+		return TRUE;
 	}
 
-	nle = nl_wait_for_ack (priv->nlh);
-	switch (nle) {
-	case -NLE_SUCCESS:
-		_LOGD ("do-add-link[%s/%s]: success adding",
-		       name,
-		       nm_link_type_to_string (link_type));
-		break;
-	default:
-		_LOGE ("do-add-link[%s/%s]: failed with \"%s\" (%d)",
-		       name,
-		       nm_link_type_to_string (link_type),
-		       nl_geterror (nle), -nle);
-		return FALSE;
+	/* detach the queued entries. Signal handlers invoked below might start
+	 * a new transaction. */
+	entries = priv->batch.entries;
+	priv->batch.entries = g_array_new (FALSE, FALSE, sizeof (BatchEntry));
+	g_array_set_clear_func (priv->batch.entries, (GDestroyNotify) _batch_entry_clear);
+
+	_LOGt ("batch: commit %u requests", entries->len);
+
+	if (entries->len == 0) {
+		g_array_unref (entries);
+		return TRUE;
 	}
 
-	delayed_action_handle_all (platform, TRUE);
+	event_handler_read_netlink_all (platform, FALSE);
 
-	/* FIXME: we add the link object via the second netlink socket. Sometimes,
-	 * the notification is not yet ready via nlh_event, so we have to re-request the
-	 * link so that it is in the cache. A better solution would be to do everything
-	 * via one netlink socket. */
-	if (!nmp_cache_lookup_link_full (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache, 0, name, FALSE, NM_LINK_TYPE_NONE, NULL, NULL)) {
-		_LOGt ("do-add-link[%s/%s]: the added link is not yet ready. Request anew",
-		       name,
-		       nm_link_type_to_string (link_type));
-		do_request_link (platform, 0, name, TRUE);
+	chunk_start = 0;
+	chunk_bytes = 0;
+	for (i = 0; i < entries->len; i++) {
+		chunk_bytes += NLMSG_ALIGN (nlmsg_hdr (g_array_index (entries, BatchEntry, i).nlmsg)->nlmsg_len);
+		if (   i + 1 == entries->len
+		    || i + 1 - chunk_start >= BATCH_CHUNK_MAX_MSGS
+		    || chunk_bytes >= BATCH_CHUNK_MAX_BYTES) {
+			_batch_send_chunk (platform, &g_array_index (entries, BatchEntry, chunk_start), i + 1 - chunk_start);
+			chunk_start = i + 1;
+			chunk_bytes = 0;
+		}
 	}
 
-	/* Return true, because the netlink request succeeded. This doesn't indicate that the
-	 * object is now actually in the cache, because there could be a race. */
-	return TRUE;
-}
+	for (i = 0; i < entries->len; i++) {
+		BatchEntry *entry = &g_array_index (entries, BatchEntry, i);
 
-static gboolean
-do_add_link_with_lookup (NMPlatform *platform,
-                         NMLinkType link_type,
-                         const char *name,
-                         struct nl_msg *nlmsg,
-                         NMPlatformLink *out_link)
-{
-	const NMPObject *obj;
+		if (entry->is_delete)
+			entry->success = _do_delete_object_check_result (platform, entry->obj_id, entry->nle);
+		else
+			entry->success = _do_add_addrroute_check_result (platform, entry->obj_id, entry->nle);
+
+		if (entry->success)
+			any_success = TRUE;
+		else {
+			if (!failed)
+				failed = g_ptr_array_new_with_free_func ((GDestroyNotify) nmp_object_unref);
+			g_ptr_array_add (failed, nmp_object_ref (entry->obj_id));
+		}
+	}
 
-	do_add_link (platform, link_type, name, nlmsg);
+	if (any_success) {
+		delayed_action_handle_all (platform, TRUE);
 
-	obj = nmp_cache_lookup_link_full (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache,
-	                                  0, name, FALSE, link_type, NULL, NULL);
-	if (out_link && obj)
-		*out_link = obj->link;
-	return !!obj;
+		/* like do_add_addrroute() and do_delete_object(), re-request the objects
+		 * that are not yet in sync. Dump each object type only once, instead of
+		 * requesting every object on its own. */
+		for (i = 0; i < entries->len; i++) {
+			BatchEntry *entry = &g_array_index (entries, BatchEntry, i);
+			gboolean in_cache;
+
+			if (!entry->success)
+				continue;
+
+			in_cache = !!nmp_cache_lookup_obj (priv->cache, entry->obj_id);
+			if (entry->is_delete ? in_cache : !in_cache) {
+				_LOGt ("batch: %s-%s[%s]: the object is not yet in sync. Request anew",
+				       entry->is_delete ? "delete" : "add",
+				       NMP_OBJECT_GET_CLASS (entry->obj_id)->obj_type_name,
+				       nmp_object_to_string (entry->obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0));
+				refresh |= delayed_action_refresh_from_object_type (NMP_OBJECT_GET_TYPE (entry->obj_id));
+			}
+		}
+		if (refresh != DELAYED_ACTION_TYPE_NONE)
+			do_request_all (platform, refresh, TRUE);
+	}
+
+	g_array_unref (entries);
+
+	if (failed) {
+		if (out_failed)
+			*out_failed = failed;
+		else
+			g_ptr_array_unref (failed);
+		return FALSE;
+	}
+	return TRUE;
 }
 
+/******************************************************************/
+
 static gboolean
 do_add_addrroute (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *nlmsg)
 {
@@ -3480,6 +4304,9 @@ do_add_addrroute (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *
 	                      NMP_OBJECT_TYPE_IP4_ADDRESS, NMP_OBJECT_TYPE_IP6_ADDRESS,
 	                      NMP_OBJECT_TYPE_IP4_ROUTE, NMP_OBJECT_TYPE_IP6_ROUTE));
 
+	if (priv->batch.depth > 0)
+		return batch_queue (platform, obj_id, nlmsg, FALSE);
+
 	event_handler_read_netlink_all (platform, FALSE);
 
 	nle = nl_send_auto (priv->nlh, nlmsg);
@@ -3492,26 +4319,8 @@ do_add_addrroute (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *
 	}
 
 	nle = nl_wait_for_ack (priv->nlh);
-	switch (nle) {
-	case -NLE_SUCCESS:
-		_LOGD ("do-add-%s[%s]: success adding", NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name, nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0));
-		break;
-	case -NLE_EXIST:
-		/* NLE_EXIST is considered equivalent to success to avoid race conditions. You
-		 * never know when something sends an identical object just before
-		 * NetworkManager. */
-		_LOGD ("do-add-%s[%s]: adding link failed with \"%s\" (%d), meaning such a link already exists",
-		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
-		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
-		       nl_geterror (nle), -nle);
-		break;
-	default:
-		_LOGE ("do-add-%s[%s]: failed with \"%s\" (%d)",
-		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
-		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
-		       nl_geterror (nle), -nle);
+	if (!_do_add_addrroute_check_result (platform, obj_id, nle))
 		return FALSE;
-	}
 
 	delayed_action_handle_all (platform, TRUE);
 
@@ -3535,6 +4344,10 @@ do_delete_object (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	int nle;
 
+	if (   priv->batch.depth > 0
+	    && NMP_OBJECT_GET_TYPE (obj_id) != NMP_OBJECT_TYPE_LINK)
+		return batch_queue (platform, obj_id, nlmsg, TRUE);
+
 	event_handler_read_netlink_all (platform, FALSE);
 
 	nle = nl_send_auto (priv->nlh, nlmsg);
@@ -3547,44 +4360,8 @@ do_delete_object (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *
 	}
 
 	nle = nl_wait_for_ack (priv->nlh);
-	switch (nle) {
-	case -NLE_SUCCESS:
-		_LOGD ("do-delete-%s[%s]: success deleting", NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name, nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0));
-		break;
-	case -NLE_OBJ_NOTFOUND:
-		_LOGD ("do-delete-%s[%s]: failed with \"%s\" (%d), meaning the object was already removed",
-		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
-		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
-		       nl_geterror (nle), -nle);
-		break;
-	case -NLE_FAILURE:
-		if (NMP_OBJECT_GET_TYPE (obj_id) != NMP_OBJECT_TYPE_IP6_ADDRESS)
-			goto nle_failure;
-
-		/* On RHEL7 kernel, deleting a non existing address fails with ENXIO (which libnl maps to NLE_FAILURE) */
-		_LOGD ("do-delete-%s[%s]: deleting address failed with \"%s\" (%d), meaning the address was already removed",
-		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
-		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
-		       nl_geterror (nle), -nle);
-		break;
-	case -NLE_NOADDR:
-		if (   NMP_OBJECT_GET_TYPE (obj_id) != NMP_OBJECT_TYPE_IP4_ADDRESS
-		    && NMP_OBJECT_GET_TYPE (obj_id) != NMP_OBJECT_TYPE_IP6_ADDRESS)
-			goto nle_failure;
-
-		_LOGD ("do-delete-%s[%s]: deleting address failed with \"%s\" (%d), meaning the address was already removed",
-		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
-		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
-		       nl_geterror (nle), -nle);
-		break;
-	default:
-nle_failure:
-		_LOGE ("do-delete-%s[%s]: failed with \"%s\" (%d)",
-		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
-		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
-		       nl_geterror (nle), -nle);
+	if (!_do_delete_object_check_result (platform, obj_id, nle))
 		return FALSE;
-	}
 
 	delayed_action_handle_all (platform, TRUE);
 
@@ -4612,6 +5389,63 @@ ip6_address_get_all (NMPlatform *platform, int ifindex)
 	return ipx_address_get_all (platform, ifindex, NMP_OBJECT_TYPE_IP6_ADDRESS);
 }
 
+static void
+_lookup_all_unref (gpointer plobj)
+{
+	nmp_object_unref (NMP_OBJECT_UP_CAST (plobj));
+}
+
+/* Returns a #GPtrArray with references to the cached objects of the
+ * multi-index @cache_id. Contrary to nmp_cache_lookup_multi_to_array(),
+ * the objects are not copied. If @skip_rtprot_kernel is set, routes with
+ * source NM_IP_CONFIG_SOURCE_RTPROT_KERNEL are omitted. */
+static GPtrArray *
+_lookup_all_ref (NMPlatform *platform, const NMPCacheId *cache_id, gboolean skip_rtprot_kernel)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	const NMPlatformObject *const *objects;
+	GPtrArray *array;
+	guint i, len;
+
+	objects = nmp_cache_lookup_multi (priv->cache, cache_id, &len);
+
+	array = g_ptr_array_new_full (len, _lookup_all_unref);
+	for (i = 0; i < len; i++) {
+		if (   skip_rtprot_kernel
+		    && ((const NMPlatformIPRoute *) objects[i])->source == NM_IP_CONFIG_SOURCE_RTPROT_KERNEL)
+			continue;
+
+		/* the array holds the public part, not the NMPObject itself. */
+		nmp_object_ref (NMP_OBJECT_UP_CAST (objects[i]));
+		g_ptr_array_add (array, (gpointer) objects[i]);
+	}
+	return array;
+}
+
+static GPtrArray *
+ipx_address_lookup_all (NMPlatform *platform, int ifindex, NMPObjectType obj_type)
+{
+	nm_assert (NM_IN_SET (obj_type, NMP_OBJECT_TYPE_IP4_ADDRESS, NMP_OBJECT_TYPE_IP6_ADDRESS));
+
+	return _lookup_all_ref (platform,
+	                        nmp_cache_id_init_addrroute_visible_by_ifindex (NMP_CACHE_ID_STATIC,
+	                                                                        obj_type,
+	                                                                        ifindex),
+	                        FALSE);
+}
+
+static GPtrArray *
+ip4_address_lookup_all (NMPlatform *platform, int ifindex)
+{
+	return ipx_address_lookup_all (platform, ifindex, NMP_OBJECT_TYPE_IP4_ADDRESS);
+}
+
+static GPtrArray *
+ip6_address_lookup_all (NMPlatform *platform, int ifindex)
+{
+	return ipx_address_lookup_all (platform, ifindex, NMP_OBJECT_TYPE_IP6_ADDRESS);
+}
+
 static gboolean
 ip4_address_add (NMPlatform *platform,
                  int ifindex,
@@ -4797,6 +5631,37 @@ ip6_route_get_all (NMPlatform *platform, int ifindex, NMPlatformGetRouteFlags fl
 	return ipx_route_get_all (platform, ifindex, NMP_OBJECT_TYPE_IP6_ROUTE, flags);
 }
 
+static GPtrArray *
+ipx_route_lookup_all (NMPlatform *platform, int ifindex, NMPObjectType obj_type, NMPlatformGetRouteFlags flags)
+{
+	NMPCacheId cache_id;
+
+	nm_assert (NM_IN_SET (obj_type, NMP_OBJECT_TYPE_IP4_ROUTE, NMP_OBJECT_TYPE_IP6_ROUTE));
+
+	if (!NM_FLAGS_ANY (flags, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT))
+		flags |= NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT;
+
+	nmp_cache_id_init_routes_visible (&cache_id,
+	                                  obj_type,
+	                                  NM_FLAGS_HAS (flags, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT),
+	                                  NM_FLAGS_HAS (flags, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT),
+	                                  ifindex);
+
+	return _lookup_all_ref (platform, &cache_id, !NM_FLAGS_HAS (flags, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_RTPROT_KERNEL));
+}
+
+static GPtrArray *
+ip4_route_lookup_all (NMPlatform *platform, int ifindex, NMPlatformGetRouteFlags flags)
+{
+	return ipx_route_lookup_all (platform, ifindex, NMP_OBJECT_TYPE_IP4_ROUTE, flags);
+}
+
+static GPtrArray *
+ip6_route_lookup_all (NMPlatform *platform, int ifindex, NMPlatformGetRouteFlags flags)
+{
+	return ipx_route_lookup_all (platform, ifindex, NMP_OBJECT_TYPE_IP6_ROUTE, flags);
+}
+
 static gboolean
 ip4_route_add (NMPlatform *platform, int ifindex, NMIPConfigSource source,
                in_addr_t network, int plen, in_addr_t gateway,
@@ -4961,6 +5826,9 @@ ip6_route_get (NMPlatform *platform, int ifindex, struct in6_addr network, int p
 
 /******************************************************************/
 
+#define EVENT_RCVBUF_SIZE_INITIAL   (128 * 1024)
+#define EVENT_RCVBUF_SIZE_MAX       (8 * 1024 * 1024)
+
 #define EVENT_CONDITIONS      ((GIOCondition) (G_IO_IN | G_IO_PRI))
 #define ERROR_CONDITIONS      ((GIOCondition) (G_IO_ERR | G_IO_NVAL))
 #define DISCONNECT_CONDITIONS ((GIOCondition) (G_IO_HUP))
@@ -4990,13 +5858,73 @@ event_handler (GIOChannel *channel,
 	return TRUE;
 }
 
-static gboolean
-event_handler_read_netlink_one (NMPlatform *platform)
+static void
+event_socket_set_rcvbuf (NMPlatform *platform, struct nl_sock *sk, int *p_rcvbuf_size, int size)
+{
+	int errsv;
+
+	errsv = _nl_sock_set_rcvbuf (sk, size);
+	if (errsv < 0) {
+		_LOGW ("netlink: failed to set receive buffer of event socket (fd=%d) to %d bytes: %s",
+		       nl_socket_get_fd (sk), size, strerror (-errsv));
+		return;
+	}
+	_LOGD ("netlink: receive buffer of event socket (fd=%d) set to %d bytes", nl_socket_get_fd (sk), size);
+	*p_rcvbuf_size = size;
+}
+
+static void
+event_handler_overrun (NMPlatform *platform, struct nl_sock *sk)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	DelayedActionType resync;
+	int *p_rcvbuf_size;
+
+	if (sk == priv->nlh_event_route) {
+		/* the route socket only receives route notifications. */
+		resync = DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
+		         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES;
+		p_rcvbuf_size = &priv->netlink.rcvbuf_size_route;
+	} else {
+		/* besides link and address notifications, nlh_event also receives the
+		 * replies to our dump requests. Any of them might be incomplete now. */
+		resync = DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS |
+		         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES |
+		         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES |
+		         priv->netlink.dump_in_progress;
+		p_rcvbuf_size = &priv->netlink.rcvbuf_size;
+	}
+
+	priv->netlink.overruns++;
+	_LOGI ("Too many netlink events. Need to resynchronize platform cache (%s)",
+	       sk == priv->nlh_event_route ? "routes" : "links and addresses");
+
+	/* Drain the event queue, we've lost events and are out of sync anyway and we'd
+	 * like to free up some space. We'll read in the status synchronously. */
+	_nl_sock_flush_data (sk);
+	if (sk == priv->nlh_event)
+		priv->nlh_seq_expect = 0;
+
+	/* Grow the buffer so that the next burst of events fits. */
+	if (*p_rcvbuf_size < priv->netlink.rcvbuf_max) {
+		event_socket_set_rcvbuf (platform, sk, p_rcvbuf_size,
+		                         *p_rcvbuf_size <= priv->netlink.rcvbuf_max / 2
+		                             ? *p_rcvbuf_size * 2
+		                             : priv->netlink.rcvbuf_max);
+	}
+
+	if (!priv->netlink.resync_pending)
+		priv->netlink.resync_start_us = nm_utils_get_monotonic_timestamp_us ();
+	priv->netlink.resync_pending |= resync;
+	delayed_action_schedule (platform, resync, NULL);
+}
+
+static gboolean
+event_handler_read_netlink_one (NMPlatform *platform, struct nl_sock *sk)
+{
 	int nle;
 
-	nle = nl_recvmsgs_default (priv->nlh_event);
+	nle = nl_recvmsgs_default (sk);
 
 	/* Work around a libnl bug fixed in 3.2.22 (375a6294) */
 	if (nle == 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
@@ -5010,18 +5938,7 @@ event_handler_read_netlink_one (NMPlatform *platform)
 			_LOGD ("Uncritical failure to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
 			break;
 		case -NLE_NOMEM:
-			_LOGI ("Too many netlink events. Need to resynchronize platform cache");
-			/* Drain the event queue, we've lost events and are out of sync anyway and we'd
-			 * like to free up some space. We'll read in the status synchronously. */
-			_nl_sock_flush_data (priv->nlh_event);
-			priv->nlh_seq_expect = 0;
-			delayed_action_schedule (platform,
-			                         DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS |
-			                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES |
-			                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES |
-			                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
-			                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
-			                         NULL);
+			event_handler_overrun (platform, sk);
 			break;
 		default:
 			_LOGE ("Failed to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
@@ -5043,7 +5960,10 @@ event_handler_read_netlink_all (NMPlatform *platform, gboolean wait_for_acks)
 	guint32 wait_for_seq = 0;
 
 	while (TRUE) {
-		while (event_handler_read_netlink_one (platform))
+		/* Links and addresses first, so that route notifications find
+		 * their interface already in the cache. */
+		while (   event_handler_read_netlink_one (platform, priv->nlh_event)
+		       || event_handler_read_netlink_one (platform, priv->nlh_event_route))
 			any = TRUE;
 
 		if (!wait_for_acks || priv->nlh_seq_expect == 0) {
@@ -5095,6 +6015,34 @@ event_handler_read_netlink_all (NMPlatform *platform, gboolean wait_for_acks)
 	return any;
 }
 
+static gboolean
+netlink_get_stats (NMPlatform *platform, NMPlatformNetlinkStats *out_stats)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	out_stats->overruns = priv->netlink.overruns;
+	out_stats->resyncs = priv->netlink.resyncs;
+	out_stats->resync_last_usec = priv->netlink.resync_last_usec;
+	out_stats->resync_total_usec = priv->netlink.resync_total_usec;
+	out_stats->rcvbuf_size = priv->netlink.rcvbuf_size;
+	out_stats->rcvbuf_size_route = priv->netlink.rcvbuf_size_route;
+	out_stats->rcvbuf_max = priv->netlink.rcvbuf_max;
+	return TRUE;
+}
+
+static void
+netlink_set_rcvbuf_max (NMPlatform *platform, int rcvbuf_max)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	priv->netlink.rcvbuf_max = rcvbuf_max;
+
+	if (priv->netlink.rcvbuf_size > rcvbuf_max)
+		event_socket_set_rcvbuf (platform, priv->nlh_event, &priv->netlink.rcvbuf_size, rcvbuf_max);
+	if (priv->netlink.rcvbuf_size_route > rcvbuf_max)
+		event_socket_set_rcvbuf (platform, priv->nlh_event_route, &priv->netlink.rcvbuf_size_route, rcvbuf_max);
+}
+
 static struct nl_sock *
 setup_socket (NMPlatform *platform, gboolean event)
 {
@@ -5250,7 +6198,33 @@ nm_linux_platform_init (NMLinuxPlatform *self)
 	priv->cache = nmp_cache_new ();
 	priv->delayed_action.list_master_connected = g_ptr_array_new ();
 	priv->delayed_action.list_refresh_link = g_ptr_array_new ();
+	priv->delayed_action.list_prune_ifindex = g_ptr_array_new ();
+	priv->batch.entries = g_array_new (FALSE, FALSE, sizeof (BatchEntry));
+	g_array_set_clear_func (priv->batch.entries, (GDestroyNotify) _batch_entry_clear);
 	priv->wifi_data = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) wifi_utils_deinit);
+	priv->netlink.rcvbuf_max = EVENT_RCVBUF_SIZE_MAX;
+	priv->sysctl_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+}
+
+static GIOChannel *
+event_channel_new (NMPlatform *platform, struct nl_sock *sk, guint *out_event_id)
+{
+	GIOChannel *channel;
+	int channel_flags;
+	gboolean status;
+
+	channel = g_io_channel_unix_new (nl_socket_get_fd (sk));
+	g_io_channel_set_encoding (channel, NULL, NULL);
+	g_io_channel_set_close_on_unref (channel, TRUE);
+
+	channel_flags = g_io_channel_get_flags (channel);
+	status = g_io_channel_set_flags (channel,
+		channel_flags | G_IO_FLAG_NONBLOCK, NULL);
+	g_assert (status);
+	*out_event_id = g_io_add_watch (channel,
+	                                (EVENT_CONDITIONS | ERROR_CONDITIONS | DISCONNECT_CONDITIONS),
+	                                event_handler, platform);
+	return channel;
 }
 
 static void
@@ -5259,8 +6233,6 @@ constructed (GObject *_object)
 	NMPlatform *platform = NM_PLATFORM (_object);
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	const char *udev_subsys[] = { "net", NULL };
-	int channel_flags;
-	gboolean status;
 	int nle;
 	GUdevEnumerator *enumerator;
 	GList *devices, *iter;
@@ -5275,31 +6247,34 @@ constructed (GObject *_object)
 	/* Initialize netlink socket for events */
 	priv->nlh_event = setup_socket (platform, TRUE);
 	g_assert (priv->nlh_event);
-	/* The default buffer size wasn't enough for the testsuites. It might just
-	 * as well happen with NetworkManager itself. For now let's hope 128KB is
-	 * good enough.
+	/* The default buffer size wasn't enough for the testsuites. Start with
+	 * 128KB and grow the buffer whenever the kernel drops events.
 	 */
-	nle = nl_socket_set_buffer_size (priv->nlh_event, 131072, 0);
-	g_assert (!nle);
+	event_socket_set_rcvbuf (platform, priv->nlh_event, &priv->netlink.rcvbuf_size,
+	                         MIN (EVENT_RCVBUF_SIZE_INITIAL, priv->netlink.rcvbuf_max));
 	nle = nl_socket_add_memberships (priv->nlh_event,
 	                                 RTNLGRP_LINK,
 	                                 RTNLGRP_IPV4_IFADDR, RTNLGRP_IPV6_IFADDR,
-	                                 RTNLGRP_IPV4_ROUTE,  RTNLGRP_IPV6_ROUTE,
 	                                 0);
 	g_assert (!nle);
 	_LOGD ("Netlink socket for events established: port=%u, fd=%d", nl_socket_get_local_port (priv->nlh_event), nl_socket_get_fd (priv->nlh_event));
 
-	priv->event_channel = g_io_channel_unix_new (nl_socket_get_fd (priv->nlh_event));
-	g_io_channel_set_encoding (priv->event_channel, NULL, NULL);
-	g_io_channel_set_close_on_unref (priv->event_channel, TRUE);
+	/* Route notifications come on a separate socket. Route storms are by far the
+	 * most common reason for overruns, and this way they only require to dump
+	 * the routes again.
+	 */
+	priv->nlh_event_route = setup_socket (platform, TRUE);
+	g_assert (priv->nlh_event_route);
+	event_socket_set_rcvbuf (platform, priv->nlh_event_route, &priv->netlink.rcvbuf_size_route,
+	                         MIN (EVENT_RCVBUF_SIZE_INITIAL, priv->netlink.rcvbuf_max));
+	nle = nl_socket_add_memberships (priv->nlh_event_route,
+	                                 RTNLGRP_IPV4_ROUTE, RTNLGRP_IPV6_ROUTE,
+	                                 0);
+	g_assert (!nle);
+	_LOGD ("Netlink socket for route events established: port=%u, fd=%d", nl_socket_get_local_port (priv->nlh_event_route), nl_socket_get_fd (priv->nlh_event_route));
 
-	channel_flags = g_io_channel_get_flags (priv->event_channel);
-	status = g_io_channel_set_flags (priv->event_channel,
-		channel_flags | G_IO_FLAG_NONBLOCK, NULL);
-	g_assert (status);
-	priv->event_id = g_io_add_watch (priv->event_channel,
-	                                (EVENT_CONDITIONS | ERROR_CONDITIONS | DISCONNECT_CONDITIONS),
-	                                 event_handler, platform);
+	priv->event_channel = event_channel_new (platform, priv->nlh_event, &priv->event_id);
+	priv->event_channel_route = event_channel_new (platform, priv->nlh_event_route, &priv->event_id_route);
 
 	/* Set up udev monitoring */
 	priv->udev_client = g_udev_client_new (udev_subsys);
@@ -5345,6 +6320,7 @@ dispose (GObject *object)
 	priv->delayed_action.flags = DELAYED_ACTION_TYPE_NONE;
 	g_ptr_array_set_size (priv->delayed_action.list_master_connected, 0);
 	g_ptr_array_set_size (priv->delayed_action.list_refresh_link, 0);
+	g_ptr_array_set_size (priv->delayed_action.list_prune_ifindex, 0);
 
 	nm_clear_g_source (&priv->delayed_action.idle_id);
 
@@ -5363,16 +6339,24 @@ nm_linux_platform_finalize (GObject *object)
 
 	g_ptr_array_unref (priv->delayed_action.list_master_connected);
 	g_ptr_array_unref (priv->delayed_action.list_refresh_link);
+	g_ptr_array_unref (priv->delayed_action.list_prune_ifindex);
+
+	g_array_unref (priv->batch.entries);
 
 	/* Free netlink resources */
 	g_source_remove (priv->event_id);
 	g_io_channel_unref (priv->event_channel);
+	g_source_remove (priv->event_id_route);
+	g_io_channel_unref (priv->event_channel_route);
 	nl_socket_free (priv->nlh);
 	nl_socket_free (priv->nlh_event);
+	nl_socket_free (priv->nlh_event_route);
 
 	g_object_unref (priv->udev_client);
 	g_hash_table_unref (priv->wifi_data);
 
+	g_hash_table_unref (priv->sysctl_cache);
+
 	if (priv->sysctl_get_prev_values) {
 		sysctl_clear_cache_list = g_slist_remove (sysctl_clear_cache_list, object);
 		g_hash_table_destroy (priv->sysctl_get_prev_values);
@@ -5398,6 +6382,7 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 
 	platform_class->sysctl_set = sysctl_set;
 	platform_class->sysctl_get = sysctl_get;
+	platform_class->sysctl_set_multiple = sysctl_set_multiple;
 
 	platform_class->link_get = _nm_platform_link_get;
 	platform_class->link_get_by_ifname = _nm_platform_link_get_by_ifname;
@@ -5465,6 +6450,8 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->ip6_address_get = ip6_address_get;
 	platform_class->ip4_address_get_all = ip4_address_get_all;
 	platform_class->ip6_address_get_all = ip6_address_get_all;
+	platform_class->ip4_address_lookup_all = ip4_address_lookup_all;
+	platform_class->ip6_address_lookup_all = ip6_address_lookup_all;
 	platform_class->ip4_address_add = ip4_address_add;
 	platform_class->ip6_address_add = ip6_address_add;
 	platform_class->ip4_address_delete = ip4_address_delete;
@@ -5474,11 +6461,19 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->ip6_route_get = ip6_route_get;
 	platform_class->ip4_route_get_all = ip4_route_get_all;
 	platform_class->ip6_route_get_all = ip6_route_get_all;
+	platform_class->ip4_route_lookup_all = ip4_route_lookup_all;
+	platform_class->ip6_route_lookup_all = ip6_route_lookup_all;
 	platform_class->ip4_route_add = ip4_route_add;
 	platform_class->ip6_route_add = ip6_route_add;
 	platform_class->ip4_route_delete = ip4_route_delete;
 	platform_class->ip6_route_delete = ip6_route_delete;
 
+	platform_class->batch_begin = batch_begin;
+	platform_class->batch_commit = batch_commit;
+
+	platform_class->netlink_get_stats = netlink_get_stats;
+	platform_class->netlink_set_rcvbuf_max = netlink_set_rcvbuf_max;
+
 	platform_class->check_support_kernel_extended_ifa_flags = check_support_kernel_extended_ifa_flags;
 	platform_class->check_support_user_ipv6ll = check_support_user_ipv6ll;
 
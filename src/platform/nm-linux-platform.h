@@ -52,4 +52,9 @@ void nm_linux_platform_setup (void);
 
 void _nm_linux_platform_sysctl_clear_cache (void);
 
+struct nl_msg;
+struct _NMPObject;
+
+struct _NMPObject *_nm_linux_platform_object_new_from_nl (struct nl_msg *msg, gboolean id_only);
+
 #endif /* __NETWORKMANAGER_LINUX_PLATFORM_H__ */
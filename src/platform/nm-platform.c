@@ -84,6 +84,7 @@ enum {
 	SIGNAL_IP6_ADDRESS_CHANGED,
 	SIGNAL_IP4_ROUTE_CHANGED,
 	SIGNAL_IP6_ROUTE_CHANGED,
+	SIGNAL_CHANGES,
 	LAST_SIGNAL
 };
 
@@ -97,6 +98,11 @@ enum {
 
 typedef struct {
 	gboolean register_singleton;
+
+	struct {
+		guint freeze_count;
+		GPtrArray *pending;
+	} changes;
 } NMPlatformPrivate;
 
 /******************************************************************/
@@ -256,6 +262,191 @@ nm_platform_process_events (NMPlatform *self)
 		klass->process_events (self);
 }
 
+/**
+ * nm_platform_batch_begin:
+ * @self: platform instance
+ *
+ * Start a transaction for adding and deleting IP addresses and routes.
+ * Until the matching nm_platform_batch_commit(), the platform implementation
+ * may queue the requests instead of sending them one by one and waiting for
+ * each result. In this case, the add/delete functions return %TRUE when the
+ * request was queued and errors are only reported by nm_platform_batch_commit().
+ *
+ * Platform implementations that don't support batching perform the requests
+ * right away. Transactions can be nested, only the outermost commit sends
+ * the queued requests.
+ */
+void
+nm_platform_batch_begin (NMPlatform *self)
+{
+	_CHECK_SELF_VOID (self, klass);
+
+	if (klass->batch_begin)
+		klass->batch_begin (self);
+}
+
+/**
+ * nm_platform_batch_commit:
+ * @self: platform instance
+ * @out_failed: (allow-none): on return, an array of #NMPObject instances
+ *   with the ID of every queued request that failed, or %NULL.
+ *
+ * Send all requests queued since nm_platform_batch_begin() and wait for
+ * their results. Afterwards the platform cache is up to date with the
+ * changes.
+ *
+ * Returns: %TRUE if all queued requests succeeded.
+ */
+gboolean
+nm_platform_batch_commit (NMPlatform *self, GPtrArray **out_failed)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	if (!klass->batch_commit) {
+		NM_SET_OUT (out_failed, NULL);
+		return TRUE;
+	}
+	return klass->batch_commit (self, out_failed);
+}
+
+/******************************************************************/
+
+static void
+_changes_emit (NMPlatform *self)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	gs_unref_ptrarray GPtrArray *changes = NULL;
+
+	if (!priv->changes.pending)
+		return;
+
+	/* handlers might cause new changes. Those start a new array. */
+	changes = priv->changes.pending;
+	priv->changes.pending = NULL;
+
+	_LOGt ("signal: changes: emit %u changes", changes->len);
+	g_signal_emit (self, signals[SIGNAL_CHANGES], 0, changes);
+}
+
+static void
+_changes_free (NMPlatformChange *change)
+{
+	g_slice_free (NMPlatformChange, change);
+}
+
+static void
+_changes_record (NMPlatform *self,
+                 NMPObjectType obj_type,
+                 int ifindex,
+                 gconstpointer object,
+                 gsize object_size,
+                 NMPlatformSignalChangeType change_type,
+                 NMPlatformReason reason)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	NMPlatformChange *change;
+
+	nm_assert (object_size <= sizeof (NMPlatformChange) - G_STRUCT_OFFSET (NMPlatformChange, object));
+
+	/* Don't bother copying the objects, if nobody listens. */
+	if (!g_signal_has_handler_pending (self, signals[SIGNAL_CHANGES], 0, TRUE))
+		return;
+
+	change = g_slice_new0 (NMPlatformChange);
+	change->obj_type = obj_type;
+	change->ifindex = ifindex;
+	change->change_type = change_type;
+	change->reason = reason;
+	memcpy (&change->object, object, object_size);
+
+	if (!priv->changes.pending)
+		priv->changes.pending = g_ptr_array_new_with_free_func ((GDestroyNotify) _changes_free);
+	g_ptr_array_add (priv->changes.pending, change);
+
+	if (priv->changes.freeze_count == 0)
+		_changes_emit (self);
+}
+
+/**
+ * nm_platform_changes_freeze:
+ * @self: platform instance
+ *
+ * Start collecting the changes for the %NM_PLATFORM_SIGNAL_CHANGES signal,
+ * instead of emitting it for every change. The platform implementation
+ * freezes while processing netlink events. Calls can be nested.
+ */
+void
+nm_platform_changes_freeze (NMPlatform *self)
+{
+	_CHECK_SELF_VOID (self, klass);
+
+	NM_PLATFORM_GET_PRIVATE (self)->changes.freeze_count++;
+}
+
+/**
+ * nm_platform_changes_thaw:
+ * @self: platform instance
+ *
+ * Undo nm_platform_changes_freeze(). The last thaw emits the collected
+ * changes as one %NM_PLATFORM_SIGNAL_CHANGES signal.
+ */
+void
+nm_platform_changes_thaw (NMPlatform *self)
+{
+	NMPlatformPrivate *priv;
+
+	_CHECK_SELF_VOID (self, klass);
+
+	priv = NM_PLATFORM_GET_PRIVATE (self);
+	g_return_if_fail (priv->changes.freeze_count > 0);
+
+	if (--priv->changes.freeze_count == 0)
+		_changes_emit (self);
+}
+
+/******************************************************************/
+
+/**
+ * nm_platform_netlink_get_stats:
+ * @self: platform instance
+ * @out_stats: (out): the statistics of the event sockets
+ *
+ * Returns: %FALSE if the platform implementation does not track
+ *   netlink statistics. In this case, @out_stats is zeroed.
+ */
+gboolean
+nm_platform_netlink_get_stats (NMPlatform *self, NMPlatformNetlinkStats *out_stats)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (out_stats, FALSE);
+
+	memset (out_stats, 0, sizeof (*out_stats));
+	if (!klass->netlink_get_stats)
+		return FALSE;
+	return klass->netlink_get_stats (self, out_stats);
+}
+
+/**
+ * nm_platform_netlink_set_rcvbuf_max:
+ * @self: platform instance
+ * @rcvbuf_max: the maximum size in bytes
+ *
+ * Sets the size up to which the receive buffer of the event sockets
+ * grows when the kernel reports an overrun. A value smaller than the
+ * current size shrinks the buffer right away.
+ */
+void
+nm_platform_netlink_set_rcvbuf_max (NMPlatform *self, int rcvbuf_max)
+{
+	_CHECK_SELF_VOID (self, klass);
+
+	g_return_if_fail (rcvbuf_max > 0);
+
+	if (klass->netlink_set_rcvbuf_max)
+		klass->netlink_set_rcvbuf_max (self, rcvbuf_max);
+}
+
 /******************************************************************/
 
 /**
@@ -282,6 +473,46 @@ nm_platform_sysctl_set (NMPlatform *self, const char *path, const char *value)
 	return klass->sysctl_set (self, path, value);
 }
 
+/**
+ * nm_platform_sysctl_set_multiple:
+ * @self: platform instance
+ * @dirname: Absolute path of the directory containing the options
+ * @keys_values: %NULL terminated array of option names, each followed
+ *   by the value to write
+ *
+ * Writes several options in the same directory, like a series of
+ * nm_platform_sysctl_set() calls. Implementations may open @dirname
+ * only once for all of them. All options are written, even if
+ * setting one of them fails.
+ *
+ * Returns: %TRUE if all options were set successfully.
+ */
+gboolean
+nm_platform_sysctl_set_multiple (NMPlatform *self, const char *dirname, const char *const *keys_values)
+{
+	gboolean success = TRUE;
+
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (dirname, FALSE);
+	g_return_val_if_fail (keys_values, FALSE);
+
+	if (klass->sysctl_set_multiple)
+		return klass->sysctl_set_multiple (self, dirname, keys_values);
+
+	g_return_val_if_fail (klass->sysctl_set, FALSE);
+
+	for (; keys_values[0]; keys_values += 2) {
+		gs_free char *path = g_strdup_printf ("%s/%s", dirname, keys_values[0]);
+
+		g_return_val_if_fail (keys_values[1], FALSE);
+
+		if (!klass->sysctl_set (self, path, keys_values[1]))
+			success = FALSE;
+	}
+	return success;
+}
+
 gboolean
 nm_platform_sysctl_set_ip6_hop_limit_safe (NMPlatform *self, const char *iface, int value)
 {
@@ -2074,6 +2305,75 @@ nm_platform_ip6_address_get_all (NMPlatform *self, int ifindex)
 	return klass->ip6_address_get_all (self, ifindex);
 }
 
+static GPtrArray *
+_lookup_all_from_array (GArray *array, gsize sizeof_obj)
+{
+	GPtrArray *result;
+	guint i;
+
+	if (!array)
+		return NULL;
+
+	result = g_ptr_array_new_full (array->len, g_free);
+	for (i = 0; i < array->len; i++)
+		g_ptr_array_add (result, g_memdup (&array->data[i * sizeof_obj], sizeof_obj));
+	g_array_unref (array);
+	return result;
+}
+
+/**
+ * nm_platform_ip4_address_lookup_all:
+ * @self: platform instance
+ * @ifindex: interface index
+ *
+ * Like nm_platform_ip4_address_get_all(), but instead of copying the addresses
+ * into a new #GArray, the returned #GPtrArray references the platform's cached
+ * #NMPlatformIP4Address instances. The elements are kept alive until the
+ * array is released, even after they got removed from the cache, but they
+ * must not be modified.
+ *
+ * The elements are no snapshots. When processing platform events updates
+ * an object, the cache changes it in place, so everything but the fields
+ * identifying the object (like lifetimes, flags or the label) can change
+ * while the caller holds the array. Once removed from the cache, an element
+ * keeps its last state. Copy the elements that must not change. Platforms
+ * without a cache may return copies instead.
+ *
+ * Returns: (transfer full): a #GPtrArray of `const NMPlatformIP4Address *`.
+ */
+GPtrArray *
+nm_platform_ip4_address_lookup_all (NMPlatform *self, int ifindex)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+
+	if (!klass->ip4_address_lookup_all)
+		return _lookup_all_from_array (nm_platform_ip4_address_get_all (self, ifindex), sizeof (NMPlatformIP4Address));
+	return klass->ip4_address_lookup_all (self, ifindex);
+}
+
+/**
+ * nm_platform_ip6_address_lookup_all:
+ * @self: platform instance
+ * @ifindex: interface index
+ *
+ * The IPv6 variant of nm_platform_ip4_address_lookup_all().
+ *
+ * Returns: (transfer full): a #GPtrArray of `const NMPlatformIP6Address *`.
+ */
+GPtrArray *
+nm_platform_ip6_address_lookup_all (NMPlatform *self, int ifindex)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+
+	if (!klass->ip6_address_lookup_all)
+		return _lookup_all_from_array (nm_platform_ip6_address_get_all (self, ifindex), sizeof (NMPlatformIP6Address));
+	return klass->ip6_address_lookup_all (self, ifindex);
+}
+
 gboolean
 nm_platform_ip4_address_add (NMPlatform *self,
                              int ifindex,
@@ -2268,22 +2568,22 @@ array_contains_ip6_address (const GArray *addresses, const NMPlatformIP6Address
 gboolean
 nm_platform_ip4_address_sync (NMPlatform *self, int ifindex, const GArray *known_addresses, GPtrArray **out_added_addresses)
 {
-	GArray *addresses;
-	NMPlatformIP4Address *address;
+	GPtrArray *addresses;
+	const NMPlatformIP4Address *address;
 	guint32 now = nm_utils_get_monotonic_timestamp_s ();
 	int i;
 
 	_CHECK_SELF (self, klass, FALSE);
 
 	/* Delete unknown addresses */
-	addresses = nm_platform_ip4_address_get_all (self, ifindex);
+	addresses = nm_platform_ip4_address_lookup_all (self, ifindex);
 	for (i = 0; i < addresses->len; i++) {
-		address = &g_array_index (addresses, NMPlatformIP4Address, i);
+		address = addresses->pdata[i];
 
 		if (!array_contains_ip4_address (known_addresses, address, now, ADDRESS_LIFETIME_PADDING))
 			nm_platform_ip4_address_delete (self, ifindex, address->address, address->plen, address->peer_address);
 	}
-	g_array_free (addresses, TRUE);
+	g_ptr_array_unref (addresses);
 
 	if (out_added_addresses)
 		*out_added_addresses = NULL;
@@ -2329,15 +2629,15 @@ nm_platform_ip4_address_sync (NMPlatform *self, int ifindex, const GArray *known
 gboolean
 nm_platform_ip6_address_sync (NMPlatform *self, int ifindex, const GArray *known_addresses, gboolean keep_link_local)
 {
-	GArray *addresses;
-	NMPlatformIP6Address *address;
+	GPtrArray *addresses;
+	const NMPlatformIP6Address *address;
 	guint32 now = nm_utils_get_monotonic_timestamp_s ();
 	int i;
 
 	/* Delete unknown addresses */
-	addresses = nm_platform_ip6_address_get_all (self, ifindex);
+	addresses = nm_platform_ip6_address_lookup_all (self, ifindex);
 	for (i = 0; i < addresses->len; i++) {
-		address = &g_array_index (addresses, NMPlatformIP6Address, i);
+		address = addresses->pdata[i];
 
 		/* Leave link local address management to the kernel */
 		if (keep_link_local && IN6_IS_ADDR_LINKLOCAL (&address->address))
@@ -2346,7 +2646,7 @@ nm_platform_ip6_address_sync (NMPlatform *self, int ifindex, const GArray *known
 		if (!array_contains_ip6_address (known_addresses, address, now, ADDRESS_LIFETIME_PADDING))
 			nm_platform_ip6_address_delete (self, ifindex, address->address, address->plen);
 	}
-	g_array_free (addresses, TRUE);
+	g_ptr_array_unref (addresses);
 
 	if (!known_addresses)
 		return TRUE;
@@ -2400,6 +2700,52 @@ nm_platform_ip6_route_get_all (NMPlatform *self, int ifindex, NMPlatformGetRoute
 	return klass->ip6_route_get_all (self, ifindex, flags);
 }
 
+/**
+ * nm_platform_ip4_route_lookup_all:
+ * @self: platform instance
+ * @ifindex: interface index or 0 for all interfaces
+ * @flags: select which routes to return
+ *
+ * Like nm_platform_ip4_route_get_all(), but returns references to the cached
+ * routes instead of copying them. See nm_platform_ip4_address_lookup_all()
+ * for the lifetime of the elements.
+ *
+ * Returns: (transfer full): a #GPtrArray of `const NMPlatformIP4Route *`.
+ */
+GPtrArray *
+nm_platform_ip4_route_lookup_all (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (ifindex >= 0, NULL);
+
+	if (!klass->ip4_route_lookup_all)
+		return _lookup_all_from_array (nm_platform_ip4_route_get_all (self, ifindex, flags), sizeof (NMPlatformIP4Route));
+	return klass->ip4_route_lookup_all (self, ifindex, flags);
+}
+
+/**
+ * nm_platform_ip6_route_lookup_all:
+ * @self: platform instance
+ * @ifindex: interface index or 0 for all interfaces
+ * @flags: select which routes to return
+ *
+ * The IPv6 variant of nm_platform_ip4_route_lookup_all().
+ *
+ * Returns: (transfer full): a #GPtrArray of `const NMPlatformIP6Route *`.
+ */
+GPtrArray *
+nm_platform_ip6_route_lookup_all (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (ifindex >= 0, NULL);
+
+	if (!klass->ip6_route_lookup_all)
+		return _lookup_all_from_array (nm_platform_ip6_route_get_all (self, ifindex, flags), sizeof (NMPlatformIP6Route));
+	return klass->ip6_route_lookup_all (self, ifindex, flags);
+}
+
 gboolean
 nm_platform_ip4_route_add (NMPlatform *self,
                            int ifindex, NMIPConfigSource source,
@@ -3501,34 +3847,39 @@ nm_platform_signal_change_type_to_string (NMPlatformSignalChangeType change_type
 }
 
 static void
-log_link (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformLink *device, NMPlatformSignalChangeType change_type, gpointer user_data)
+log_link (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformLink *device, NMPlatformSignalChangeType change_type, NMPlatformReason reason, gpointer user_data)
 {
 
 	_LOGD ("signal: link %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_link_to_string (device, NULL, 0));
+	_changes_record (self, obj_type, ifindex, device, sizeof (*device), change_type, reason);
 }
 
 static void
-log_ip4_address (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP4Address *address, NMPlatformSignalChangeType change_type, gpointer user_data)
+log_ip4_address (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP4Address *address, NMPlatformSignalChangeType change_type, NMPlatformReason reason, gpointer user_data)
 {
 	_LOGD ("signal: address 4 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip4_address_to_string (address, NULL, 0));
+	_changes_record (self, obj_type, ifindex, address, sizeof (*address), change_type, reason);
 }
 
 static void
-log_ip6_address (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP6Address *address, NMPlatformSignalChangeType change_type, gpointer user_data)
+log_ip6_address (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP6Address *address, NMPlatformSignalChangeType change_type, NMPlatformReason reason, gpointer user_data)
 {
 	_LOGD ("signal: address 6 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip6_address_to_string (address, NULL, 0));
+	_changes_record (self, obj_type, ifindex, address, sizeof (*address), change_type, reason);
 }
 
 static void
-log_ip4_route (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP4Route *route, NMPlatformSignalChangeType change_type, gpointer user_data)
+log_ip4_route (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP4Route *route, NMPlatformSignalChangeType change_type, NMPlatformReason reason, gpointer user_data)
 {
 	_LOGD ("signal: route   4 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip4_route_to_string (route, NULL, 0));
+	_changes_record (self, obj_type, ifindex, route, sizeof (*route), change_type, reason);
 }
 
 static void
-log_ip6_route (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP6Route *route, NMPlatformSignalChangeType change_type, gpointer user_data)
+log_ip6_route (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP6Route *route, NMPlatformSignalChangeType change_type, NMPlatformReason reason, gpointer user_data)
 {
 	_LOGD ("signal: route   6 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip6_route_to_string (route, NULL, 0));
+	_changes_record (self, obj_type, ifindex, route, sizeof (*route), change_type, reason);
 }
 
 /******************************************************************/
@@ -3607,6 +3958,7 @@ const NMPlatformVTableRoute nm_platform_vtable_route_v4 = {
 	.route_cmp                      = (int (*) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b)) nm_platform_ip4_route_cmp,
 	.route_to_string                = (const char *(*) (const NMPlatformIPXRoute *route, char *buf, gsize len)) nm_platform_ip4_route_to_string,
 	.route_get_all                  = nm_platform_ip4_route_get_all,
+	.route_lookup_all               = nm_platform_ip4_route_lookup_all,
 	.route_add                      = _vtr_v4_route_add,
 	.route_delete                   = _vtr_v4_route_delete,
 	.route_delete_default           = _vtr_v4_route_delete_default,
@@ -3620,6 +3972,7 @@ const NMPlatformVTableRoute nm_platform_vtable_route_v6 = {
 	.route_cmp                      = (int (*) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b)) nm_platform_ip6_route_cmp,
 	.route_to_string                = (const char *(*) (const NMPlatformIPXRoute *route, char *buf, gsize len)) nm_platform_ip6_route_to_string,
 	.route_get_all                  = nm_platform_ip6_route_get_all,
+	.route_lookup_all               = nm_platform_ip6_route_lookup_all,
 	.route_add                      = _vtr_v6_route_add,
 	.route_delete                   = _vtr_v6_route_delete,
 	.route_delete_default           = _vtr_v6_route_delete_default,
@@ -3662,6 +4015,16 @@ nm_platform_init (NMPlatform *object)
 {
 }
 
+static void
+finalize (GObject *object)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (object);
+
+	g_clear_pointer (&priv->changes.pending, g_ptr_array_unref);
+
+	G_OBJECT_CLASS (nm_platform_parent_class)->finalize (object);
+}
+
 #define SIGNAL(signal_id, method) signals[signal_id] = \
 	g_signal_new_class_handler (NM_PLATFORM_ ## signal_id, \
 		G_OBJECT_CLASS_TYPE (object_class), \
@@ -3679,6 +4042,7 @@ nm_platform_class_init (NMPlatformClass *platform_class)
 
 	object_class->set_property = set_property;
 	object_class->constructed = constructed;
+	object_class->finalize = finalize;
 
 	platform_class->wifi_set_powersave = wifi_set_powersave;
 
@@ -3696,4 +4060,11 @@ nm_platform_class_init (NMPlatformClass *platform_class)
 	SIGNAL (SIGNAL_IP6_ADDRESS_CHANGED, log_ip6_address)
 	SIGNAL (SIGNAL_IP4_ROUTE_CHANGED, log_ip4_route)
 	SIGNAL (SIGNAL_IP6_ROUTE_CHANGED, log_ip6_route)
+
+	signals[SIGNAL_CHANGES] =
+	    g_signal_new (NM_PLATFORM_SIGNAL_CHANGES,
+	                  G_OBJECT_CLASS_TYPE (object_class),
+	                  G_SIGNAL_RUN_FIRST,
+	                  0, NULL, NULL, NULL,
+	                  G_TYPE_NONE, 1, G_TYPE_PTR_ARRAY);
 }
@@ -289,12 +289,16 @@ typedef union {
  * configures addresses. */
 #define NM_PLATFORM_ROUTE_METRIC_IP4_DEVICE_ROUTE 0
 
+/* The fields are ordered to avoid padding: a route is cached for every
+ * entry in the kernel routing tables, so its size matters. @plen comes last,
+ * so that the IPv4 scope can make use of the bytes up to the next 4-byte
+ * aligned field. */
 #define __NMPlatformIPRoute_COMMON \
 	__NMPlatformObject_COMMON; \
 	NMIPConfigSource source; \
-	int plen; \
 	guint32 metric; \
 	guint32 mss; \
+	guint8 plen; \
 	;
 
 typedef struct {
@@ -310,13 +314,14 @@ typedef struct {
 
 struct _NMPlatformIP4Route {
 	__NMPlatformIPRoute_COMMON;
-	in_addr_t network;
-	in_addr_t gateway;
 
 	/* The bitwise inverse of the route scope. It is inverted so that the
 	 * default value (RT_SCOPE_NOWHERE) is nul. */
 	guint8 scope_inv;
 
+	in_addr_t network;
+	in_addr_t gateway;
+
 	/* RTA_PREFSRC/rtnl_route_get_pref_src(). A value of zero means that
 	 * no pref-src is set.  */
 	in_addr_t pref_src;
@@ -339,6 +344,25 @@ typedef union {
 
 #undef __NMPlatformObject_COMMON
 
+/* One entry of the NM_PLATFORM_SIGNAL_CHANGES signal. Contrary to the
+ * object passed to the per-object signals, it stays valid as long as
+ * the subscriber keeps a reference to the array. */
+typedef struct {
+	NMPObjectType obj_type;
+	int ifindex;
+	NMPlatformSignalChangeType change_type;
+	NMPlatformReason reason;
+	union {
+		NMPlatformObject     object;
+		NMPlatformLink       link;
+		NMPlatformIP4Address ip4_address;
+		NMPlatformIP6Address ip6_address;
+		NMPlatformIPRoute    ip_route;
+		NMPlatformIP4Route   ip4_route;
+		NMPlatformIP6Route   ip6_route;
+	};
+} NMPlatformChange;
+
 
 typedef struct {
 	gboolean is_ip4;
@@ -347,6 +371,7 @@ typedef struct {
 	int (*route_cmp) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b);
 	const char *(*route_to_string) (const NMPlatformIPXRoute *route, char *buf, gsize len);
 	GArray *(*route_get_all) (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
+	GPtrArray *(*route_lookup_all) (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
 	gboolean (*route_add) (NMPlatform *self, int ifindex, const NMPlatformIPXRoute *route, gint64 metric);
 	gboolean (*route_delete) (NMPlatform *self, int ifindex, const NMPlatformIPXRoute *route);
 	gboolean (*route_delete_default) (NMPlatform *self, int ifindex, guint32 metric);
@@ -415,6 +440,25 @@ typedef struct {
 	gboolean multi_queue;
 } NMPlatformTunProperties;
 
+typedef struct {
+	/* number of times the kernel dropped netlink events (ENOBUFS). */
+	guint overruns;
+
+	/* number of completed resynchronizations after an overrun. */
+	guint resyncs;
+
+	/* duration of the last and of all resynchronizations, in microseconds. */
+	gint64 resync_last_usec;
+	gint64 resync_total_usec;
+
+	/* receive buffer size of the event socket for links and addresses,
+	 * of the event socket for routes and the size up to which both
+	 * grow on overruns, in bytes. */
+	int rcvbuf_size;
+	int rcvbuf_size_route;
+	int rcvbuf_max;
+} NMPlatformNetlinkStats;
+
 /******************************************************************/
 
 /* NMPlatform abstract class and its implementations provide a layer between
@@ -454,6 +498,7 @@ typedef struct {
 
 	gboolean (*sysctl_set) (NMPlatform *, const char *path, const char *value);
 	char * (*sysctl_get) (NMPlatform *, const char *path);
+	gboolean (*sysctl_set_multiple) (NMPlatform *, const char *dirname, const char *const *keys_values);
 
 	const NMPlatformLink *(*link_get) (NMPlatform *platform, int ifindex);
 	const NMPlatformLink *(*link_get_by_ifname) (NMPlatform *platform, const char *ifname);
@@ -543,6 +588,8 @@ typedef struct {
 
 	GArray * (*ip4_address_get_all) (NMPlatform *, int ifindex);
 	GArray * (*ip6_address_get_all) (NMPlatform *, int ifindex);
+	GPtrArray * (*ip4_address_lookup_all) (NMPlatform *, int ifindex);
+	GPtrArray * (*ip6_address_lookup_all) (NMPlatform *, int ifindex);
 	gboolean (*ip4_address_add) (NMPlatform *,
 	                             int ifindex,
 	                             in_addr_t address,
@@ -566,6 +613,8 @@ typedef struct {
 
 	GArray * (*ip4_route_get_all) (NMPlatform *, int ifindex, NMPlatformGetRouteFlags flags);
 	GArray * (*ip6_route_get_all) (NMPlatform *, int ifindex, NMPlatformGetRouteFlags flags);
+	GPtrArray * (*ip4_route_lookup_all) (NMPlatform *, int ifindex, NMPlatformGetRouteFlags flags);
+	GPtrArray * (*ip6_route_lookup_all) (NMPlatform *, int ifindex, NMPlatformGetRouteFlags flags);
 	gboolean (*ip4_route_add) (NMPlatform *, int ifindex, NMIPConfigSource source,
 	                           in_addr_t network, int plen, in_addr_t gateway,
 	                           in_addr_t pref_src, guint32 metric, guint32 mss);
@@ -577,6 +626,12 @@ typedef struct {
 	const NMPlatformIP4Route *(*ip4_route_get) (NMPlatform *, int ifindex, in_addr_t network, int plen, guint32 metric);
 	const NMPlatformIP6Route *(*ip6_route_get) (NMPlatform *, int ifindex, struct in6_addr network, int plen, guint32 metric);
 
+	void (*batch_begin) (NMPlatform *self);
+	gboolean (*batch_commit) (NMPlatform *self, GPtrArray **out_failed);
+
+	gboolean (*netlink_get_stats) (NMPlatform *self, NMPlatformNetlinkStats *out_stats);
+	void (*netlink_set_rcvbuf_max) (NMPlatform *self, int rcvbuf_max);
+
 	gboolean (*check_support_kernel_extended_ifa_flags) (NMPlatform *);
 	gboolean (*check_support_user_ipv6ll) (NMPlatform *);
 } NMPlatformClass;
@@ -598,6 +653,14 @@ typedef struct {
 #define NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED "ip4-route-changed"
 #define NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED "ip6-route-changed"
 
+/* Emitted after the per-object signals above, with a GPtrArray of
+ * NMPlatformChange for everything that changed since the last emission.
+ * While frozen via nm_platform_changes_freeze(), the changes are
+ * collected and delivered as one array on the last thaw. That allows
+ * subscribers to react once per batch of netlink events instead of once
+ * per object. */
+#define NM_PLATFORM_SIGNAL_CHANGES "changes"
+
 const char *nm_platform_signal_change_type_to_string (NMPlatformSignalChangeType change_type);
 
 /******************************************************************/
@@ -635,6 +698,7 @@ const char *nm_platform_error_to_string (NMPlatformError error);
 
 gboolean nm_platform_sysctl_set (NMPlatform *self, const char *path, const char *value);
 char *nm_platform_sysctl_get (NMPlatform *self, const char *path);
+gboolean nm_platform_sysctl_set_multiple (NMPlatform *self, const char *dirname, const char *const *keys_values);
 gint32 nm_platform_sysctl_get_int32 (NMPlatform *self, const char *path, gint32 fallback);
 gint64 nm_platform_sysctl_get_int_checked (NMPlatform *self, const char *path, guint base, gint64 min, gint64 max, gint64 fallback);
 
@@ -672,6 +736,15 @@ const char *nm_platform_link_get_type_name (NMPlatform *self, int ifindex);
 gboolean nm_platform_link_refresh (NMPlatform *self, int ifindex);
 void nm_platform_process_events (NMPlatform *self);
 
+void nm_platform_batch_begin (NMPlatform *self);
+gboolean nm_platform_batch_commit (NMPlatform *self, GPtrArray **out_failed);
+
+void nm_platform_changes_freeze (NMPlatform *self);
+void nm_platform_changes_thaw (NMPlatform *self);
+
+gboolean nm_platform_netlink_get_stats (NMPlatform *self, NMPlatformNetlinkStats *out_stats);
+void nm_platform_netlink_set_rcvbuf_max (NMPlatform *self, int rcvbuf_max);
+
 gboolean nm_platform_link_set_up (NMPlatform *self, int ifindex, gboolean *out_no_firmware);
 gboolean nm_platform_link_set_down (NMPlatform *self, int ifindex);
 gboolean nm_platform_link_set_arp (NMPlatform *self, int ifindex);
@@ -758,6 +831,8 @@ const NMPlatformIP4Address *nm_platform_ip4_address_get (NMPlatform *self, int i
 const NMPlatformIP6Address *nm_platform_ip6_address_get (NMPlatform *self, int ifindex, struct in6_addr address, int plen);
 GArray *nm_platform_ip4_address_get_all (NMPlatform *self, int ifindex);
 GArray *nm_platform_ip6_address_get_all (NMPlatform *self, int ifindex);
+GPtrArray *nm_platform_ip4_address_lookup_all (NMPlatform *self, int ifindex);
+GPtrArray *nm_platform_ip6_address_lookup_all (NMPlatform *self, int ifindex);
 gboolean nm_platform_ip4_address_add (NMPlatform *self,
                                       int ifindex,
                                       in_addr_t address,
@@ -784,6 +859,8 @@ const NMPlatformIP4Route *nm_platform_ip4_route_get (NMPlatform *self, int ifind
 const NMPlatformIP6Route *nm_platform_ip6_route_get (NMPlatform *self, int ifindex, struct in6_addr network, int plen, guint32 metric);
 GArray *nm_platform_ip4_route_get_all (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
 GArray *nm_platform_ip6_route_get_all (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
+GPtrArray *nm_platform_ip4_route_lookup_all (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
+GPtrArray *nm_platform_ip6_route_lookup_all (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
 gboolean nm_platform_ip4_route_add (NMPlatform *self, int ifindex, NMIPConfigSource source,
                                     in_addr_t network, int plen, in_addr_t gateway,
                                     in_addr_t pref_src, guint32 metric, guint32 mss);
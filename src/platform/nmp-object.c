@@ -149,7 +149,7 @@ _link_get_driver (GUdevDevice *udev_device, const char *kind, const char *ifname
 }
 
 void
-_nmp_object_fixup_link_udev_fields (NMPObject *obj, gboolean use_udev)
+_nmp_object_fixup_link_udev_fields (NMPObject *obj, const NMPObject *old, gboolean use_udev)
 {
 	const char *driver = NULL;
 	gboolean initialized = FALSE;
@@ -161,9 +161,20 @@ _nmp_object_fixup_link_udev_fields (NMPObject *obj, gboolean use_udev)
 
 	/* When a link is not in netlink, it's udev fields don't matter. */
 	if (obj->_link.netlink.is_in_netlink) {
-		driver = _link_get_driver (obj->_link.udev.device,
-		                           obj->link.kind,
-		                           obj->link.name);
+		if (   old
+		    && old->link.driver
+		    && old->_link.udev.device == obj->_link.udev.device
+		    && old->link.kind == obj->link.kind
+		    && strcmp (old->link.name, obj->link.name) == 0) {
+			/* The driver only depends on the fields above. Reuse the interned
+			 * string of @old instead of walking up the udev parents or asking
+			 * ethtool on every netlink update. */
+			driver = old->link.driver;
+		} else {
+			driver = _link_get_driver (obj->_link.udev.device,
+			                           obj->link.kind,
+			                           obj->link.name);
+		}
 		if (obj->_link.udev.device)
 			initialized = TRUE;
 		else if (!use_udev) {
@@ -1564,7 +1575,7 @@ nmp_cache_remove_netlink (NMPCache *cache, const NMPObject *obj_needle, NMPObjec
 		obj->_link.netlink.is_in_netlink = FALSE;
 
 		_nmp_object_fixup_link_master_connected (obj, cache);
-		_nmp_object_fixup_link_udev_fields (obj, cache->use_udev);
+		_nmp_object_fixup_link_udev_fields (obj, NULL, cache->use_udev);
 
 		if (pre_hook)
 			pre_hook (cache, old, obj, NMP_CACHE_OPS_UPDATED, user_data);
@@ -1627,7 +1638,7 @@ nmp_cache_update_netlink (NMPCache *cache, NMPObject *obj, NMPObject **out_obj,
 
 		if (NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_LINK) {
 			_nmp_object_fixup_link_master_connected (obj, cache);
-			_nmp_object_fixup_link_udev_fields (obj, cache->use_udev);
+			_nmp_object_fixup_link_udev_fields (obj, NULL, cache->use_udev);
 		}
 
 		if (out_obj)
@@ -1694,7 +1705,7 @@ nmp_cache_update_netlink (NMPCache *cache, NMPObject *obj, NMPObject **out_obj,
 				/* Merge the netlink parts with what we have from udev. */
 				g_clear_object (&obj->_link.udev.device);
 				obj->_link.udev.device = old->_link.udev.device ? g_object_ref (old->_link.udev.device) : NULL;
-				_nmp_object_fixup_link_udev_fields (obj, cache->use_udev);
+				_nmp_object_fixup_link_udev_fields (obj, old, cache->use_udev);
 			}
 		} else
 			is_alive = nmp_object_is_alive (obj);
@@ -1738,7 +1749,7 @@ nmp_cache_update_link_udev (NMPCache *cache, int ifindex, GUdevDevice *udev_devi
 		obj->link.ifindex = ifindex;
 		obj->_link.udev.device = g_object_ref (udev_device);
 
-		_nmp_object_fixup_link_udev_fields (obj, cache->use_udev);
+		_nmp_object_fixup_link_udev_fields (obj, NULL, cache->use_udev);
 
 		nm_assert (nmp_object_is_alive (obj));
 
@@ -1773,7 +1784,7 @@ nmp_cache_update_link_udev (NMPCache *cache, int ifindex, GUdevDevice *udev_devi
 		g_clear_object (&obj->_link.udev.device);
 		obj->_link.udev.device = udev_device ? g_object_ref (udev_device) : NULL;
 
-		_nmp_object_fixup_link_udev_fields (obj, cache->use_udev);
+		_nmp_object_fixup_link_udev_fields (obj, NULL, cache->use_udev);
 
 		nm_assert (nmp_object_is_alive (obj));
 
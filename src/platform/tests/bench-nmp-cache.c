@@ -0,0 +1,328 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* bench-nmp-cache.c - Measure the platform cache hot paths
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+/* Usage: bench-nmp-cache [NUM_OBJECTS...]
+ *
+ * For each number of objects (default 1000, 10000 and 100000) prints
+ * the time per operation and the heap memory retained per object.
+ * Netlink messages are synthesized, so no privileges are needed.
+ */
+
+#include "config.h"
+
+#include <malloc.h>
+#include <linux/rtnetlink.h>
+#include <netlink/msg.h>
+#include <netlink/attr.h>
+
+#include "nmp-object.h"
+#include "nm-linux-platform.h"
+#include "nm-fake-platform.h"
+#include "NetworkManagerUtils.h"
+
+#include "nm-default.h"
+
+#include "nm-test-utils.h"
+
+/* spread the objects over that many interfaces. */
+#define NUM_IFINDEXES 100
+
+/******************************************************************/
+
+typedef struct {
+	NMTstBench t;
+	int start_heap;
+} Bench;
+
+static int
+_heap_in_use (void)
+{
+	return mallinfo ().uordblks;
+}
+
+static void
+bench_start (Bench *b, const char *name, guint n)
+{
+	b->start_heap = _heap_in_use ();
+	nmtst_bench_start (&b->t, name, n, "op");
+}
+
+/* @n_objects: number of objects that are still alive and make up the retained
+ *   heap memory, or 0 not to report memory. */
+static void
+bench_stop (Bench *b, guint n_objects)
+{
+	int heap = _heap_in_use () - b->start_heap;
+
+	nmtst_bench_stop (&b->t);
+	if (n_objects)
+		nmtst_bench_print ("  retained heap", (double) heap / n_objects, "bytes/obj");
+}
+
+/******************************************************************/
+
+static struct nl_msg *
+_msg_new_route (int family, guint i)
+{
+	struct nl_msg *msg;
+	struct rtmsg rtm = {
+		.rtm_family = family,
+		.rtm_dst_len = family == AF_INET ? 32 : 128,
+		.rtm_table = RT_TABLE_MAIN,
+		.rtm_protocol = RTPROT_STATIC,
+		.rtm_scope = RT_SCOPE_LINK,
+		.rtm_type = RTN_UNICAST,
+	};
+	NMIPAddr dst = NMIPAddrInit;
+
+	if (family == AF_INET)
+		dst.addr4 = htonl (0x0A000000u + i);
+	else {
+		guint32 i_be = htonl (i);
+
+		dst.addr6.s6_addr[0] = 0x20;
+		dst.addr6.s6_addr[1] = 0x01;
+		memcpy (&dst.addr6.s6_addr[12], &i_be, sizeof (i_be));
+	}
+
+	msg = nlmsg_alloc_simple (RTM_NEWROUTE, 0);
+	g_assert (msg);
+	nlmsg_set_proto (msg, NETLINK_ROUTE);
+	if (nlmsg_append (msg, &rtm, sizeof (rtm), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+
+	NLA_PUT (msg, RTA_DST, family == AF_INET ? sizeof (in_addr_t) : sizeof (struct in6_addr), &dst);
+	NLA_PUT_U32 (msg, RTA_OIF, 1 + (i % NUM_IFINDEXES));
+	NLA_PUT_U32 (msg, RTA_PRIORITY, 100);
+	return msg;
+
+nla_put_failure:
+	g_assert_not_reached ();
+}
+
+static struct nl_msg *
+_msg_new_ip4_address (guint i)
+{
+	struct nl_msg *msg;
+	struct ifaddrmsg ifa = {
+		.ifa_family = AF_INET,
+		.ifa_prefixlen = 24,
+		.ifa_index = 1 + (i % NUM_IFINDEXES),
+	};
+	in_addr_t addr = htonl (0x0A000000u + i);
+
+	msg = nlmsg_alloc_simple (RTM_NEWADDR, 0);
+	g_assert (msg);
+	nlmsg_set_proto (msg, NETLINK_ROUTE);
+	if (nlmsg_append (msg, &ifa, sizeof (ifa), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+
+	NLA_PUT (msg, IFA_LOCAL, sizeof (addr), &addr);
+	NLA_PUT (msg, IFA_ADDRESS, sizeof (addr), &addr);
+	return msg;
+
+nla_put_failure:
+	g_assert_not_reached ();
+}
+
+static GPtrArray *
+_msgs_new (const char *what, guint n)
+{
+	GPtrArray *msgs;
+	guint i;
+
+	msgs = g_ptr_array_new_full (n, (GDestroyNotify) nlmsg_free);
+	for (i = 0; i < n; i++) {
+		if (!strcmp (what, "ip4-route"))
+			g_ptr_array_add (msgs, _msg_new_route (AF_INET, i));
+		else if (!strcmp (what, "ip6-route"))
+			g_ptr_array_add (msgs, _msg_new_route (AF_INET6, i));
+		else
+			g_ptr_array_add (msgs, _msg_new_ip4_address (i));
+	}
+	return msgs;
+}
+
+static GPtrArray *
+_objs_new (GPtrArray *msgs)
+{
+	GPtrArray *objs;
+	guint i;
+
+	objs = g_ptr_array_new_full (msgs->len, (GDestroyNotify) nmp_object_unref);
+	for (i = 0; i < msgs->len; i++) {
+		NMPObject *obj = _nm_linux_platform_object_new_from_nl (msgs->pdata[i], FALSE);
+
+		g_assert (obj);
+		g_ptr_array_add (objs, obj);
+	}
+	return objs;
+}
+
+/******************************************************************/
+
+static void
+bench_cache (const char *what, NMPObjectType obj_type, guint n)
+{
+	gs_unref_ptrarray GPtrArray *msgs = NULL;
+	GPtrArray *objs;
+	NMPCache *cache;
+	NMPCacheId cache_id;
+	Bench b;
+	char name[64];
+	guint i, len, n_lookups;
+
+	msgs = _msgs_new (what, n);
+
+	g_snprintf (name, sizeof (name), "nmp_object_new_from_nl(%s)", what);
+	bench_start (&b, name, n);
+	objs = _objs_new (msgs);
+	bench_stop (&b, n);
+
+	cache = nmp_cache_new ();
+
+	g_snprintf (name, sizeof (name), "nmp_cache_update_netlink(add)");
+	bench_start (&b, name, n);
+	for (i = 0; i < n; i++)
+		g_assert_cmpint (nmp_cache_update_netlink (cache, objs->pdata[i], NULL, NULL, NULL, NULL), ==, NMP_CACHE_OPS_ADDED);
+	bench_stop (&b, n);
+	g_ptr_array_unref (objs);
+
+	/* updates with fresh, but identical objects as they come from a dump. */
+	objs = _objs_new (msgs);
+	g_snprintf (name, sizeof (name), "nmp_cache_update_netlink(unchanged)");
+	bench_start (&b, name, n);
+	for (i = 0; i < n; i++)
+		nmp_cache_update_netlink (cache, objs->pdata[i], NULL, NULL, NULL, NULL);
+	bench_stop (&b, 0);
+	g_ptr_array_unref (objs);
+
+	n_lookups = MAX (n, 10000u);
+	g_snprintf (name, sizeof (name), "nmp_cache_lookup_multi(ifindex)");
+	bench_start (&b, name, n_lookups);
+	for (i = 0; i < n_lookups; i++) {
+		nmp_cache_id_init_addrroute_visible_by_ifindex (&cache_id, obj_type, 1 + (i % NUM_IFINDEXES));
+		nmp_cache_lookup_multi (cache, &cache_id, &len);
+		g_assert_cmpint (len, >=, n / NUM_IFINDEXES);
+	}
+	bench_stop (&b, 0);
+
+	if (obj_type != NMP_OBJECT_TYPE_IP4_ADDRESS) {
+		/* this is what ipx_route_get_all() does for the linux platform. */
+		n_lookups = MAX (10000u / n, 1u);
+		g_snprintf (name, sizeof (name), "ipx_route_get_all(all ifindexes)");
+		bench_start (&b, name, n_lookups);
+		for (i = 0; i < n_lookups; i++) {
+			GArray *routes;
+
+			nmp_cache_id_init_routes_visible (&cache_id, obj_type, TRUE, TRUE, 0);
+			routes = nmp_cache_lookup_multi_to_array (cache, obj_type, &cache_id);
+			g_assert_cmpint (routes->len, ==, n);
+			g_array_unref (routes);
+		}
+		bench_stop (&b, 0);
+	}
+
+	objs = _objs_new (msgs);
+	g_snprintf (name, sizeof (name), "nmp_cache_remove_netlink()");
+	bench_start (&b, name, n);
+	for (i = 0; i < n; i++)
+		g_assert_cmpint (nmp_cache_remove_netlink (cache, objs->pdata[i], NULL, NULL, NULL, NULL), ==, NMP_CACHE_OPS_REMOVED);
+	bench_stop (&b, 0);
+	g_ptr_array_unref (objs);
+
+	nmp_cache_free (cache);
+}
+
+static void
+bench_fake_platform (guint n)
+{
+	NMPlatform *platform = NM_PLATFORM_GET;
+	Bench b;
+	guint i, n_lookups;
+
+	bench_start (&b, "nm_platform_ip4_route_add(fake)", n);
+	for (i = 0; i < n; i++) {
+		g_assert (nm_platform_ip4_route_add (platform, 1 + (i % NUM_IFINDEXES), NM_IP_CONFIG_SOURCE_USER,
+		                                     htonl (0x0A000000u + i), 32, 0, 0, 100, 0));
+	}
+	bench_stop (&b, n);
+
+	n_lookups = MAX (10000u / n, 1u);
+	bench_start (&b, "nm_platform_ip4_route_get_all(fake)", n_lookups);
+	for (i = 0; i < n_lookups; i++) {
+		GArray *routes;
+
+		routes = nm_platform_ip4_route_get_all (platform, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+		g_assert_cmpint (routes->len, ==, n);
+		g_array_unref (routes);
+	}
+	bench_stop (&b, 0);
+
+	for (i = 0; i < n; i++) {
+		g_assert (nm_platform_ip4_route_delete (platform, 1 + (i % NUM_IFINDEXES),
+		                                        htonl (0x0A000000u + i), 32, 100));
+	}
+}
+
+/******************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	static const guint default_sizes[] = { 1000, 10000, 100000 };
+	gs_free guint *sizes = NULL;
+	guint n_sizes, i;
+
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	if (argc > 1) {
+		n_sizes = argc - 1;
+		sizes = g_new (guint, n_sizes);
+		for (i = 0; i < n_sizes; i++) {
+			sizes[i] = _nm_utils_ascii_str_to_int64 (argv[i + 1], 10, 1, G_MAXINT32, 0);
+			if (!sizes[i]) {
+				g_printerr ("invalid number of objects '%s'\n", argv[i + 1]);
+				return 1;
+			}
+		}
+	} else {
+		n_sizes = G_N_ELEMENTS (default_sizes);
+		sizes = g_memdup (default_sizes, sizeof (default_sizes));
+	}
+
+	nm_fake_platform_setup ();
+
+	for (i = 0; i < n_sizes; i++) {
+		g_print ("%u ip4 routes:\n", sizes[i]);
+		bench_cache ("ip4-route", NMP_OBJECT_TYPE_IP4_ROUTE, sizes[i]);
+		bench_fake_platform (sizes[i]);
+
+		g_print ("%u ip6 routes:\n", sizes[i]);
+		bench_cache ("ip6-route", NMP_OBJECT_TYPE_IP6_ROUTE, sizes[i]);
+
+		g_print ("%u ip4 addresses:\n", sizes[i]);
+		bench_cache ("ip4-address", NMP_OBJECT_TYPE_IP4_ADDRESS, sizes[i]);
+	}
+
+	return 0;
+}
@@ -86,6 +86,68 @@ test_cleanup_internal (void)
 	g_array_unref (routes6);
 }
 
+static void
+test_cleanup_external (void)
+{
+	int ifindex;
+	GArray *addresses4;
+	GArray *addresses6;
+	GArray *routes4;
+	GArray *routes6;
+	GArray *routes4_all;
+	guint routes4_others;
+
+	if (!nmtstp_is_root_test ()) {
+		g_test_skip ("Skipping test for external cleanup: requires the kernel");
+		return;
+	}
+
+	nmtstp_run_command_check ("ip link add %s type dummy && ip link set %s up", DEVICE_NAME, DEVICE_NAME);
+	ifindex = nmtstp_assert_wait_for_link (DEVICE_NAME, NM_LINK_TYPE_DUMMY, 100)->ifindex;
+
+	nmtstp_run_command_check ("ip addr add 192.0.2.1/24 dev %s && ip addr add 2001:db8:a:b::1/64 dev %s nodad",
+	                          DEVICE_NAME, DEVICE_NAME);
+	nmtstp_run_command_check ("ip route add 192.0.3.0/24 via 192.0.2.2 dev %s metric 20 && ip route add 2001:db8:c:d::/64 dev %s metric 20",
+	                          DEVICE_NAME, DEVICE_NAME);
+	nm_platform_process_events (NM_PLATFORM_GET);
+
+	addresses4 = nm_platform_ip4_address_get_all (NM_PLATFORM_GET, ifindex);
+	routes4 = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	routes4_all = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	g_assert_cmpint (addresses4->len, ==, 1);
+	g_assert_cmpint (routes4->len, >=, 1);
+	routes4_others = routes4_all->len - routes4->len;
+	g_array_unref (addresses4);
+	g_array_unref (routes4);
+	g_array_unref (routes4_all);
+
+	/* Kernel doesn't send notifications for all addresses and routes of a removed
+	 * link. They are pruned from the cache per ifindex. */
+	nmtstp_run_command_check ("ip link delete %s", DEVICE_NAME);
+	nm_platform_process_events (NM_PLATFORM_GET);
+	g_assert (!nm_platform_link_get (NM_PLATFORM_GET, ifindex));
+
+	addresses4 = nm_platform_ip4_address_get_all (NM_PLATFORM_GET, ifindex);
+	addresses6 = nm_platform_ip6_address_get_all (NM_PLATFORM_GET, ifindex);
+	routes4 = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	routes6 = nm_platform_ip6_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+
+	g_assert_cmpint (addresses4->len, ==, 0);
+	g_assert_cmpint (addresses6->len, ==, 0);
+	g_assert_cmpint (routes4->len, ==, 0);
+	g_assert_cmpint (routes6->len, ==, 0);
+
+	g_array_unref (addresses4);
+	g_array_unref (addresses6);
+	g_array_unref (routes4);
+	g_array_unref (routes6);
+
+	/* ...without touching the other links */
+	routes4_all = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	g_assert_cmpint (routes4_all->len, ==, routes4_others);
+	g_array_unref (routes4_all);
+}
+
 void
 init_tests (int *argc, char ***argv)
 {
@@ -99,5 +161,5 @@ setup_tests (void)
 	g_assert (!nm_platform_link_get_by_ifname (NM_PLATFORM_GET, DEVICE_NAME));
 
 	g_test_add_func ("/internal", test_cleanup_internal);
-	/* FIXME: add external cleanup check */
+	g_test_add_func ("/external", test_cleanup_external);
 }
@@ -642,6 +642,47 @@ test_external (void)
 
 /*****************************************************************************/
 
+static void
+test_sysctl_external (void)
+{
+	gs_free char *path_mtu = g_strdup_printf ("/proc/sys/net/ipv6/conf/%s/mtu", DEVICE_NAME);
+	gs_free char *path_ra = g_strdup_printf ("/proc/sys/net/ipv6/conf/%s/accept_ra", DEVICE_NAME);
+	char *value;
+
+	nmtstp_run_command_check ("ip link add %s type %s", DEVICE_NAME, "dummy");
+	nmtstp_assert_wait_for_link (DEVICE_NAME, NM_LINK_TYPE_DUMMY, 100);
+
+	value = nm_platform_sysctl_get (NM_PLATFORM_GET, path_mtu);
+	g_assert_cmpstr (value, ==, "1500");
+	g_free (value);
+
+	/* The kernel changes the IPv6 MTU for router advertisements, without
+	 * any notification. It is read anew each time. */
+	nmtstp_run_command_check ("echo 1400 > %s", path_mtu);
+	value = nm_platform_sysctl_get (NM_PLATFORM_GET, path_mtu);
+	g_assert_cmpstr (value, ==, "1400");
+	g_free (value);
+
+	/* Writing through the platform is seen right away */
+	g_assert (nm_platform_sysctl_set (NM_PLATFORM_GET, path_ra, "0"));
+	value = nm_platform_sysctl_get (NM_PLATFORM_GET, path_ra);
+	g_assert_cmpstr (value, ==, "0");
+	g_free (value);
+
+	/* ...and a change by somebody else once the cached value expired */
+	nmtstp_run_command_check ("echo 2 > %s", path_ra);
+	g_usleep (1100 * 1000);
+	value = nm_platform_sysctl_get (NM_PLATFORM_GET, path_ra);
+	g_assert_cmpstr (value, ==, "2");
+	g_free (value);
+
+	nmtstp_run_command_check ("ip link del %s", DEVICE_NAME);
+	nm_platform_process_events (NM_PLATFORM_GET);
+	g_assert (!nm_platform_link_get_by_ifname (NM_PLATFORM_GET, DEVICE_NAME));
+}
+
+/*****************************************************************************/
+
 typedef struct {
 	NMLinkType link_type;
 	int test_mode;
@@ -1398,6 +1439,7 @@ setup_tests (void)
 
 	if (nmtstp_is_root_test ()) {
 		g_test_add_func ("/link/external", test_external);
+		g_test_add_func ("/link/sysctl/external", test_sysctl_external);
 
 		test_software_detect_add ("/link/software/detect/gre", NM_LINK_TYPE_GRE, 0);
 		test_software_detect_add ("/link/software/detect/macvlan", NM_LINK_TYPE_MACVLAN, 0);
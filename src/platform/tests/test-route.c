@@ -282,6 +282,273 @@ test_ip6_route (void)
 	free_signal (route_removed);
 }
 
+static void
+test_ip4_route_batch (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	SignalData *route_added = add_signal (NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NM_PLATFORM_SIGNAL_ADDED, ip4_route_callback);
+	SignalData *route_removed = add_signal (NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NM_PLATFORM_SIGNAL_REMOVED, ip4_route_callback);
+	GPtrArray *failed = NULL;
+	in_addr_t network;
+	int plen = 32;
+	int metric = 22988;
+	int mss = 1000;
+	const guint N = 300;
+	guint i;
+
+	inet_pton (AF_INET, "192.0.2.0", &network);
+
+	/* add more routes than fit into one chunk. */
+	nm_platform_batch_begin (NM_PLATFORM_GET);
+	for (i = 0; i < N; i++)
+		g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, network, plen, INADDR_ANY, 0, metric + i, mss));
+	g_assert (nm_platform_batch_commit (NM_PLATFORM_GET, &failed));
+	g_assert (!failed);
+	accept_signals (route_added, N, N);
+
+	for (i = 0; i < N; i++)
+		assert_ip4_route_exists (TRUE, DEVICE_NAME, network, plen, metric + i);
+
+	/* nested transactions are committed by the outermost commit. */
+	nm_platform_batch_begin (NM_PLATFORM_GET);
+	nm_platform_batch_begin (NM_PLATFORM_GET);
+	for (i = 0; i < N; i++)
+		g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, network, plen, metric + i));
+	g_assert (nm_platform_batch_commit (NM_PLATFORM_GET, NULL));
+	g_assert (nm_platform_batch_commit (NM_PLATFORM_GET, &failed));
+	g_assert (!failed);
+	accept_signals (route_removed, N, N);
+
+	for (i = 0; i < N; i++)
+		assert_ip4_route_exists (FALSE, DEVICE_NAME, network, plen, metric + i);
+
+	free_signal (route_added);
+	free_signal (route_removed);
+}
+
+static void
+test_ip4_route_lookup_all (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	SignalData *route_added = add_signal (NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NM_PLATFORM_SIGNAL_ADDED, ip4_route_callback);
+	SignalData *route_changed = add_signal (NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NM_PLATFORM_SIGNAL_CHANGED, ip4_route_callback);
+	SignalData *route_removed = add_signal (NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NM_PLATFORM_SIGNAL_REMOVED, ip4_route_callback);
+	GArray *routes;
+	GPtrArray *routes_ref;
+	const NMPlatformIP4Route *r;
+	NMPlatformIP4Route route_copy;
+	in_addr_t network;
+	int plen = 24;
+	int metric = 22987;
+	int mss = 1000;
+	guint i;
+
+	inet_pton (AF_INET, "192.0.2.0", &network);
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, network, plen, INADDR_ANY, 0, metric, mss));
+	accept_signal (route_added);
+
+	/* the references must match the copied routes. */
+	routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	routes_ref = nm_platform_ip4_route_lookup_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	g_assert (routes_ref);
+	g_assert_cmpint (routes->len, ==, routes_ref->len);
+	for (i = 0; i < routes->len; i++) {
+		g_assert_cmpint (nm_platform_ip4_route_cmp (&g_array_index (routes, NMPlatformIP4Route, i),
+		                                            routes_ref->pdata[i]), ==, 0);
+	}
+	g_array_unref (routes);
+
+	for (i = 0; i < routes_ref->len; i++) {
+		r = routes_ref->pdata[i];
+		if (r->network == network && r->plen == plen && r->metric == metric)
+			break;
+	}
+	g_assert_cmpint (i, <, routes_ref->len);
+
+	/* The references of the linux platform are no snapshots: updates of the
+	 * cached route are visible through them, only the fields of the ID don't
+	 * change. The fake platform returns copies. */
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, network, plen, INADDR_ANY, 0, metric, mss + 1));
+	accept_signal (route_changed);
+	if (nmtstp_is_root_test ()) {
+		g_assert (r == nm_platform_ip4_route_get (NM_PLATFORM_GET, ifindex, network, plen, metric));
+		g_assert_cmpint (r->mss, ==, mss + 1);
+	} else
+		g_assert_cmpint (r->mss, ==, mss);
+	g_assert_cmpint (r->network, ==, network);
+	g_assert_cmpint (r->plen, ==, plen);
+	g_assert_cmpint (r->metric, ==, metric);
+
+	/* the referenced routes stay valid after they are removed from the platform,
+	 * and keep their last state. */
+	route_copy = *r;
+
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, network, plen, metric));
+	accept_signal (route_removed);
+	assert_ip4_route_exists (FALSE, DEVICE_NAME, network, plen, metric);
+
+	g_assert_cmpint (nm_platform_ip4_route_cmp (&route_copy, r), ==, 0);
+	g_ptr_array_unref (routes_ref);
+
+	free_signal (route_added);
+	free_signal (route_changed);
+	free_signal (route_removed);
+}
+
+typedef struct {
+	guint emitted;
+	GPtrArray *changes;
+} ChangesData;
+
+static void
+changes_cb (NMPlatform *platform, GPtrArray *changes, ChangesData *data)
+{
+	data->emitted++;
+	if (data->changes)
+		g_ptr_array_unref (data->changes);
+	data->changes = g_ptr_array_ref (changes);
+}
+
+static void
+assert_ip4_route_change (ChangesData *data, guint idx, int ifindex, in_addr_t network, NMPlatformSignalChangeType change_type)
+{
+	const NMPlatformChange *change;
+
+	g_assert (data->changes);
+	g_assert_cmpint (idx, <, data->changes->len);
+	change = data->changes->pdata[idx];
+
+	g_assert_cmpint (change->obj_type, ==, NMP_OBJECT_TYPE_IP4_ROUTE);
+	g_assert_cmpint (change->ifindex, ==, ifindex);
+	g_assert_cmpint (change->change_type, ==, change_type);
+	g_assert_cmpint (change->ip4_route.ifindex, ==, ifindex);
+	g_assert_cmpint (change->ip4_route.network, ==, network);
+}
+
+static void
+test_ip4_route_changes (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	ChangesData data = { 0 };
+	in_addr_t network1, network2;
+	int plen = 24;
+	int metric = 22988;
+	gulong id;
+
+	if (nmtstp_is_root_test ()) {
+		g_test_skip ("Skipping test for batched changes: the kernel might report other changes meanwhile");
+		return;
+	}
+
+	inet_pton (AF_INET, "192.0.4.0", &network1);
+	inet_pton (AF_INET, "192.0.5.0", &network2);
+
+	id = g_signal_connect (NM_PLATFORM_GET, NM_PLATFORM_SIGNAL_CHANGES, G_CALLBACK (changes_cb), &data);
+
+	/* while frozen, the changes are collected and emitted once on thaw. */
+	nm_platform_changes_freeze (NM_PLATFORM_GET);
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, network1, plen, INADDR_ANY, 0, metric, 0));
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, network2, plen, INADDR_ANY, 0, metric, 0));
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, network1, plen, metric));
+	g_assert_cmpint (data.emitted, ==, 0);
+	nm_platform_changes_thaw (NM_PLATFORM_GET);
+
+	g_assert_cmpint (data.emitted, ==, 1);
+	g_assert_cmpint (data.changes->len, ==, 3);
+	assert_ip4_route_change (&data, 0, ifindex, network1, NM_PLATFORM_SIGNAL_ADDED);
+	assert_ip4_route_change (&data, 1, ifindex, network2, NM_PLATFORM_SIGNAL_ADDED);
+	assert_ip4_route_change (&data, 2, ifindex, network1, NM_PLATFORM_SIGNAL_REMOVED);
+
+	/* nested freezes emit on the last thaw. */
+	nm_platform_changes_freeze (NM_PLATFORM_GET);
+	nm_platform_changes_freeze (NM_PLATFORM_GET);
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, network1, plen, INADDR_ANY, 0, metric, 0));
+	nm_platform_changes_thaw (NM_PLATFORM_GET);
+	g_assert_cmpint (data.emitted, ==, 1);
+	nm_platform_changes_thaw (NM_PLATFORM_GET);
+	g_assert_cmpint (data.emitted, ==, 2);
+	g_assert_cmpint (data.changes->len, ==, 1);
+	assert_ip4_route_change (&data, 0, ifindex, network1, NM_PLATFORM_SIGNAL_ADDED);
+
+	/* when not frozen, every change is emitted on its own. */
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, network1, plen, metric));
+	g_assert_cmpint (data.emitted, ==, 3);
+	g_assert_cmpint (data.changes->len, ==, 1);
+	assert_ip4_route_change (&data, 0, ifindex, network1, NM_PLATFORM_SIGNAL_REMOVED);
+
+	/* without a handler, nothing is recorded: a handler connected
+	 * before the thaw doesn't get the changes. */
+	g_signal_handler_disconnect (NM_PLATFORM_GET, id);
+	nm_platform_changes_freeze (NM_PLATFORM_GET);
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, network2, plen, metric));
+	id = g_signal_connect (NM_PLATFORM_GET, NM_PLATFORM_SIGNAL_CHANGES, G_CALLBACK (changes_cb), &data);
+	nm_platform_changes_thaw (NM_PLATFORM_GET);
+	g_assert_cmpint (data.emitted, ==, 3);
+
+	g_signal_handler_disconnect (NM_PLATFORM_GET, id);
+	g_ptr_array_unref (data.changes);
+}
+
+static void
+test_ip4_route_of_removed_link (void)
+{
+	const char *ifname = "nm-test-rtlink";
+	const NMPlatformLink *plink;
+	GArray *routes;
+	int ifindex;
+
+	if (!nmtstp_is_root_test ()) {
+		g_test_skip ("Skipping test for route events: requires the kernel");
+		return;
+	}
+
+	nmtstp_run_command_check ("ip link add %s type dummy && ip link set %s up", ifname, ifname);
+	plink = nmtstp_assert_wait_for_link (ifname, NM_LINK_TYPE_DUMMY, 100);
+	ifindex = plink->ifindex;
+
+	/* Without reading events in between, queue a route notification on the route
+	 * socket and the removal of its link on the socket for links. The link goes
+	 * first, so the route notification refers to an ifindex that is gone. */
+	nmtstp_run_command_check ("ip route add 192.0.2.0/24 dev %s metric 22986 && ip link delete %s", ifname, ifname);
+	nm_platform_process_events (NM_PLATFORM_GET);
+
+	g_assert (!nm_platform_link_get (NM_PLATFORM_GET, ifindex));
+	routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	g_assert_cmpint (routes->len, ==, 0);
+	g_array_unref (routes);
+}
+
+static void
+test_ip4_route_of_new_link (void)
+{
+	const char *ifname = "nm-test-rtlink";
+	const NMPlatformLink *plink;
+	GArray *routes;
+	int ifindex;
+
+	if (!nmtstp_is_root_test ()) {
+		g_test_skip ("Skipping test for route events: requires the kernel");
+		return;
+	}
+
+	/* Queue the notifications of a new link and of its route, without reading
+	 * events in between. Even if the route is seen before its link, it must
+	 * end up in the cache. */
+	nmtstp_run_command_check ("ip link add %s type dummy && ip link set %s up && ip route add 192.0.2.0/24 dev %s metric 22987",
+	                          ifname, ifname, ifname);
+	plink = nmtstp_assert_wait_for_link (ifname, NM_LINK_TYPE_DUMMY, 100);
+	ifindex = plink->ifindex;
+	nm_platform_process_events (NM_PLATFORM_GET);
+
+	routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	g_assert_cmpint (routes->len, ==, 1);
+	g_assert_cmpint (g_array_index (routes, NMPlatformIP4Route, 0).metric, ==, 22987);
+	g_array_unref (routes);
+
+	nmtstp_run_command_check ("ip link delete %s", ifname);
+	nm_platform_process_events (NM_PLATFORM_GET);
+}
+
 void
 init_tests (int *argc, char ***argv)
 {
@@ -304,4 +571,9 @@ setup_tests (void)
 	g_test_add_func ("/route/ip4", test_ip4_route);
 	g_test_add_func ("/route/ip6", test_ip6_route);
 	g_test_add_func ("/route/ip4_metric0", test_ip4_route_metric0);
+	g_test_add_func ("/route/ip4_batch", test_ip4_route_batch);
+	g_test_add_func ("/route/ip4_lookup_all", test_ip4_route_lookup_all);
+	g_test_add_func ("/route/ip4_changes", test_ip4_route_changes);
+	g_test_add_func ("/route/ip4_of_removed_link", test_ip4_route_of_removed_link);
+	g_test_add_func ("/route/ip4_of_new_link", test_ip4_route_of_new_link);
 }
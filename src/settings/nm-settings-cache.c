@@ -0,0 +1,525 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include <nm-simple-connection.h>
+#include <nm-setting-8021x.h>
+
+#include "nm-default.h"
+#include "nm-settings-cache.h"
+#include "NetworkManagerUtils.h"
+
+/* The cache is a single GVariant of type CACHE_TYPE:
+ *
+ *   (format, NetworkManager version, { path: (stamp, connection) })
+ *
+ * where the connection is what nm_connection_to_dbus() returns and the
+ * stamp lists device, inode, size, modification and change time of each
+ * file the connection was parsed from, followed by the certificates it
+ * refers to. An entry is only used if the stamp
+ * still matches, and the whole cache is dropped on a version change, as
+ * the plugins may parse the same files differently then.
+ */
+
+/* Bump when the layout below changes */
+#define CACHE_FORMAT 1
+
+#define STAMP_TYPE "a(sttttt)"
+#define ENTRY_TYPE "(" STAMP_TYPE "a{sa{sv}})"
+#define CACHE_TYPE "(usa{s" ENTRY_TYPE "})"
+
+struct _NMSettingsCache {
+	char *filename;
+	GHashTable *entries;
+	gboolean dirty;
+	guint write_id;
+};
+
+typedef struct {
+	GVariant *stamp;
+	GVariant *connection;
+	gboolean used;
+} CacheEntry;
+
+/* Takes ownership of @stamp and @connection */
+static CacheEntry *
+cache_entry_new (GVariant *stamp, GVariant *connection)
+{
+	CacheEntry *entry;
+
+	entry = g_slice_new0 (CacheEntry);
+	entry->stamp = stamp;
+	entry->connection = connection;
+	return entry;
+}
+
+static void
+cache_entry_free (gpointer data)
+{
+	CacheEntry *entry = data;
+
+	g_variant_unref (entry->stamp);
+	g_variant_unref (entry->connection);
+	g_slice_free (CacheEntry, entry);
+}
+
+static void
+cache_load (NMSettingsCache *cache)
+{
+	gs_unref_variant GVariant *variant = NULL;
+	gs_unref_variant GVariant *entries = NULL;
+	GVariantIter iter;
+	GError *error = NULL;
+	char *contents;
+	gsize len;
+	guint32 format;
+	const char *version, *path;
+	GVariant *stamp, *connection;
+
+	if (!g_file_get_contents (cache->filename, &contents, &len, &error)) {
+		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+			nm_log_dbg (LOGD_SETTINGS, "settings: cannot read connection cache '%s': %s",
+			            cache->filename, error->message);
+		}
+		g_error_free (error);
+		return;
+	}
+
+	/* The file is not trusted to be in normal form; GVariant copes with
+	 * that, and nm_simple_connection_new_from_dbus() verifies each entry. */
+	variant = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE (CACHE_TYPE),
+	                                                       contents, len, FALSE,
+	                                                       g_free, contents));
+
+	g_variant_get (variant, "(u&s@a{s" ENTRY_TYPE "})", &format, &version, &entries);
+	if (format != CACHE_FORMAT || strcmp (version, VERSION)) {
+		nm_log_dbg (LOGD_SETTINGS, "settings: ignoring connection cache '%s' from version %s",
+		            cache->filename, version);
+		cache->dirty = TRUE;
+		return;
+	}
+
+	g_variant_iter_init (&iter, entries);
+	while (g_variant_iter_next (&iter, "{&s(@" STAMP_TYPE "@a{sa{sv}})}", &path, &stamp, &connection))
+		g_hash_table_insert (cache->entries, g_strdup (path), cache_entry_new (stamp, connection));
+}
+
+/**
+ * nm_settings_cache_new:
+ * @filename: the file the cache is kept in
+ *
+ * Loads the cache from @filename. A missing, unreadable or outdated file
+ * results in an empty cache.
+ *
+ * Returns: the cache, to be released with nm_settings_cache_free()
+ */
+NMSettingsCache *
+nm_settings_cache_new (const char *filename)
+{
+	NMSettingsCache *cache;
+
+	g_return_val_if_fail (filename, NULL);
+
+	cache = g_slice_new0 (NMSettingsCache);
+	cache->filename = g_strdup (filename);
+	cache->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, cache_entry_free);
+	cache_load (cache);
+	return cache;
+}
+
+static gboolean cache_write_file (NMSettingsCache *cache, GError **error);
+
+/**
+ * nm_settings_cache_free:
+ * @cache: the cache
+ *
+ * Writes the removals that are still pending and releases @cache.
+ */
+void
+nm_settings_cache_free (NMSettingsCache *cache)
+{
+	GError *error = NULL;
+
+	if (!cache)
+		return;
+
+	if (cache->write_id && !cache_write_file (cache, &error)) {
+		nm_log_dbg (LOGD_SETTINGS, "settings: cannot write connection cache: %s", error->message);
+		g_error_free (error);
+	}
+	nm_clear_g_source (&cache->write_id);
+	g_hash_table_destroy (cache->entries);
+	g_free (cache->filename);
+	g_slice_free (NMSettingsCache, cache);
+}
+
+static guint64
+_timespec_to_ns (const struct timespec *ts)
+{
+	return (guint64) ts->tv_sec * NM_UTILS_NS_PER_SECOND + ts->tv_nsec;
+}
+
+static void
+_stamp_add_file (GVariantBuilder *builder, const char *file)
+{
+	struct stat st;
+
+	if (stat (file, &st) != 0)
+		memset (&st, 0, sizeof (st));
+	g_variant_builder_add (builder, "(sttttt)",
+	                       file,
+	                       (guint64) st.st_dev,
+	                       (guint64) st.st_ino,
+	                       (guint64) st.st_size,
+	                       _timespec_to_ns (&st.st_mtim),
+	                       _timespec_to_ns (&st.st_ctim));
+}
+
+/**
+ * nm_settings_cache_stamp:
+ * @files: %NULL-terminated list of files a connection is parsed from
+ *
+ * Records the identity of @files, including whether they exist. Take the
+ * stamp before parsing, so that a file changing meanwhile invalidates the
+ * entry.
+ *
+ * Returns: (transfer full): the stamp
+ */
+GVariant *
+nm_settings_cache_stamp (const char *const *files)
+{
+	GVariantBuilder builder;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE (STAMP_TYPE));
+	for (; *files; files++)
+		_stamp_add_file (&builder, *files);
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+/* Certificates and keys that 802.1x settings refer to by path are read
+ * while parsing, so entries are stamped with them too. */
+static GVariant *
+_stamp_extend (GVariant *stamp, NMConnection *connection)
+{
+	NMSetting8021x *s_8021x;
+	GVariantBuilder builder;
+	GVariantIter iter;
+	GVariant *child;
+
+	s_8021x = nm_connection_get_setting_802_1x (connection);
+	if (!s_8021x)
+		return g_variant_ref (stamp);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE (STAMP_TYPE));
+	g_variant_iter_init (&iter, stamp);
+	while ((child = g_variant_iter_next_value (&iter))) {
+		g_variant_builder_add_value (&builder, child);
+		g_variant_unref (child);
+	}
+
+	if (nm_setting_802_1x_get_ca_cert_scheme (s_8021x) == NM_SETTING_802_1X_CK_SCHEME_PATH)
+		_stamp_add_file (&builder, nm_setting_802_1x_get_ca_cert_path (s_8021x));
+	if (nm_setting_802_1x_get_client_cert_scheme (s_8021x) == NM_SETTING_802_1X_CK_SCHEME_PATH)
+		_stamp_add_file (&builder, nm_setting_802_1x_get_client_cert_path (s_8021x));
+	if (nm_setting_802_1x_get_private_key_scheme (s_8021x) == NM_SETTING_802_1X_CK_SCHEME_PATH)
+		_stamp_add_file (&builder, nm_setting_802_1x_get_private_key_path (s_8021x));
+	if (nm_setting_802_1x_get_phase2_ca_cert_scheme (s_8021x) == NM_SETTING_802_1X_CK_SCHEME_PATH)
+		_stamp_add_file (&builder, nm_setting_802_1x_get_phase2_ca_cert_path (s_8021x));
+	if (nm_setting_802_1x_get_phase2_client_cert_scheme (s_8021x) == NM_SETTING_802_1X_CK_SCHEME_PATH)
+		_stamp_add_file (&builder, nm_setting_802_1x_get_phase2_client_cert_path (s_8021x));
+	if (nm_setting_802_1x_get_phase2_private_key_scheme (s_8021x) == NM_SETTING_802_1X_CK_SCHEME_PATH)
+		_stamp_add_file (&builder, nm_setting_802_1x_get_phase2_private_key_path (s_8021x));
+
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+/* Whether @cached, as extended by _stamp_extend(), still matches the
+ * current @stamp and the files it was extended with. */
+static gboolean
+_stamp_matches (GVariant *cached, GVariant *stamp)
+{
+	gs_unref_variant GVariant *current = NULL;
+	GVariantBuilder builder;
+	GVariantIter iter;
+	GVariant *child;
+	const char *file;
+	gsize i, n;
+
+	n = g_variant_n_children (stamp);
+	if (g_variant_n_children (cached) < n)
+		return FALSE;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE (STAMP_TYPE));
+	g_variant_iter_init (&iter, stamp);
+	while ((child = g_variant_iter_next_value (&iter))) {
+		g_variant_builder_add_value (&builder, child);
+		g_variant_unref (child);
+	}
+	for (i = n; i < g_variant_n_children (cached); i++) {
+		g_variant_get_child (cached, i, "(&sttttt)", &file, NULL, NULL, NULL, NULL, NULL);
+		_stamp_add_file (&builder, file);
+	}
+	current = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+	return g_variant_equal (current, cached);
+}
+
+/**
+ * nm_settings_cache_lookup:
+ * @cache: the cache
+ * @path: the file the connection was read from
+ * @stamp: the current stamp of the files the connection depends on
+ *
+ * Returns: (transfer full): the cached connection if @stamp and the
+ *   certificates the connection refers to are unchanged since it was
+ *   added, or %NULL
+ */
+NMConnection *
+nm_settings_cache_lookup (NMSettingsCache *cache, const char *path, GVariant *stamp)
+{
+	CacheEntry *entry;
+	NMConnection *connection;
+	GError *error = NULL;
+
+	g_return_val_if_fail (cache, NULL);
+	g_return_val_if_fail (path, NULL);
+	g_return_val_if_fail (stamp, NULL);
+
+	entry = g_hash_table_lookup (cache->entries, path);
+	if (!entry)
+		return NULL;
+
+	if (!_stamp_matches (entry->stamp, stamp)) {
+		g_hash_table_remove (cache->entries, path);
+		cache->dirty = TRUE;
+		return NULL;
+	}
+
+	connection = nm_simple_connection_new_from_dbus (entry->connection, &error);
+	if (!connection) {
+		nm_log_dbg (LOGD_SETTINGS, "settings: invalid cached connection for '%s': %s",
+		            path, error->message);
+		g_error_free (error);
+		g_hash_table_remove (cache->entries, path);
+		cache->dirty = TRUE;
+		return NULL;
+	}
+
+	entry->used = TRUE;
+	return connection;
+}
+
+/**
+ * nm_settings_cache_add:
+ * @cache: the cache
+ * @path: the file @connection was read from
+ * @stamp: the stamp taken before reading @connection
+ * @connection: the parsed connection
+ *
+ * Replaces the entry for @path.
+ */
+void
+nm_settings_cache_add (NMSettingsCache *cache,
+                       const char *path,
+                       GVariant *stamp,
+                       NMConnection *connection)
+{
+	CacheEntry *entry;
+
+	g_return_if_fail (cache);
+	g_return_if_fail (path);
+	g_return_if_fail (stamp);
+	g_return_if_fail (NM_IS_CONNECTION (connection));
+
+	entry = cache_entry_new (_stamp_extend (stamp, connection),
+	                         g_variant_ref_sink (nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_ALL)));
+	entry->used = TRUE;
+	g_hash_table_insert (cache->entries, g_strdup (path), entry);
+	cache->dirty = TRUE;
+}
+
+static gboolean
+write_all (int fd, const char *data, gsize len)
+{
+	ssize_t n;
+
+	while (len > 0) {
+		n = write (fd, data, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return FALSE;
+		}
+		data += n;
+		len -= n;
+	}
+	return TRUE;
+}
+
+/* Writes all entries to the file */
+static gboolean
+cache_write_file (NMSettingsCache *cache, GError **error)
+{
+	gs_unref_variant GVariant *variant = NULL;
+	gs_free char *tmp_filename = NULL;
+	GVariantBuilder builder;
+	GHashTableIter iter;
+	const char *path;
+	CacheEntry *entry;
+	int fd, errsv;
+
+	nm_clear_g_source (&cache->write_id);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s" ENTRY_TYPE "}"));
+	g_hash_table_iter_init (&iter, cache->entries);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &path, (gpointer *) &entry)) {
+		g_variant_builder_add (&builder, "{s(@" STAMP_TYPE "@a{sa{sv}})}",
+		                       path, entry->stamp, entry->connection);
+	}
+	variant = g_variant_ref_sink (g_variant_new ("(us@a{s" ENTRY_TYPE "})",
+	                                             (guint32) CACHE_FORMAT,
+	                                             VERSION,
+	                                             g_variant_builder_end (&builder)));
+
+	/* Unlike g_file_set_contents(), create the file with restricted
+	 * permissions right away. */
+	tmp_filename = g_strdup_printf ("%s.XXXXXX", cache->filename);
+	fd = g_mkstemp_full (tmp_filename, O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		errsv = errno;
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "cannot create '%s': %s", tmp_filename, g_strerror (errsv));
+		return FALSE;
+	}
+
+	if (   !write_all (fd, g_variant_get_data (variant), g_variant_get_size (variant))
+	    || fsync (fd) != 0) {
+		errsv = errno;
+		close (fd);
+		unlink (tmp_filename);
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "cannot write '%s': %s", tmp_filename, g_strerror (errsv));
+		return FALSE;
+	}
+	close (fd);
+
+	if (rename (tmp_filename, cache->filename) != 0) {
+		errsv = errno;
+		unlink (tmp_filename);
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "cannot rename '%s' to '%s': %s",
+		             tmp_filename, cache->filename, g_strerror (errsv));
+		return FALSE;
+	}
+
+	nm_log_dbg (LOGD_SETTINGS, "settings: wrote %u connections to cache '%s'",
+	            g_hash_table_size (cache->entries), cache->filename);
+	cache->dirty = FALSE;
+	return TRUE;
+}
+
+/**
+ * nm_settings_cache_write:
+ * @cache: the cache
+ * @error: location to store the error on failure
+ *
+ * Writes the entries that were looked up or added since loading or the
+ * previous call back to the file, dropping the others, which belong to
+ * files that are gone. The file is only accessible by root, as connections
+ * include their secrets.
+ *
+ * Returns: %TRUE on success or if nothing changed
+ */
+gboolean
+nm_settings_cache_write (NMSettingsCache *cache, GError **error)
+{
+	GHashTableIter iter;
+	CacheEntry *entry;
+	gboolean success = TRUE;
+
+	g_return_val_if_fail (cache, FALSE);
+
+	g_hash_table_iter_init (&iter, cache->entries);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+		if (!entry->used) {
+			g_hash_table_iter_remove (&iter);
+			cache->dirty = TRUE;
+		}
+	}
+
+	if (cache->dirty)
+		success = cache_write_file (cache, error);
+
+	/* the next read of the connections has to use them again */
+	g_hash_table_iter_init (&iter, cache->entries);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+		entry->used = FALSE;
+
+	return success;
+}
+
+static gboolean
+cache_write_idle_cb (gpointer user_data)
+{
+	NMSettingsCache *cache = user_data;
+	GError *error = NULL;
+
+	cache->write_id = 0;
+	if (!cache_write_file (cache, &error)) {
+		nm_log_dbg (LOGD_SETTINGS, "settings: cannot write connection cache: %s", error->message);
+		g_error_free (error);
+	}
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * nm_settings_cache_remove:
+ * @cache: the cache
+ * @path: the file the connection was read from
+ *
+ * Removes the entry for @path. Plugins call this when a connection goes
+ * away, so that its secrets don't stay on disk until the next start. The
+ * file is written back from an idle handler, once for all connections
+ * removed in a row, or by nm_settings_cache_free().
+ *
+ * Returns: %TRUE if there was an entry for @path
+ */
+gboolean
+nm_settings_cache_remove (NMSettingsCache *cache, const char *path)
+{
+	g_return_val_if_fail (cache, FALSE);
+	g_return_val_if_fail (path, FALSE);
+
+	if (!g_hash_table_remove (cache->entries, path))
+		return FALSE;
+
+	cache->dirty = TRUE;
+	if (!cache->write_id)
+		cache->write_id = g_idle_add (cache_write_idle_cb, cache);
+	return TRUE;
+}
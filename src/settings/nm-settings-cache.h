@@ -0,0 +1,52 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NM_SETTINGS_CACHE_H__
+#define __NM_SETTINGS_CACHE_H__
+
+#include <nm-connection.h>
+
+#include "nm-default.h"
+
+/* Connections that settings plugins parsed on a previous start, keyed by
+ * the file they were read from and stamped with the identity of the files
+ * the result depends on. */
+typedef struct _NMSettingsCache NMSettingsCache;
+
+NMSettingsCache *nm_settings_cache_new (const char *filename);
+
+void nm_settings_cache_free (NMSettingsCache *cache);
+
+GVariant *nm_settings_cache_stamp (const char *const *files);
+
+NMConnection *nm_settings_cache_lookup (NMSettingsCache *cache,
+                                        const char *path,
+                                        GVariant *stamp);
+
+void nm_settings_cache_add (NMSettingsCache *cache,
+                            const char *path,
+                            GVariant *stamp,
+                            NMConnection *connection);
+
+gboolean nm_settings_cache_write (NMSettingsCache *cache, GError **error);
+
+gboolean nm_settings_cache_remove (NMSettingsCache *cache, const char *path);
+
+#endif  /* __NM_SETTINGS_CACHE_H__ */
@@ -84,6 +84,7 @@ enum {
 	UPDATED,
 	REMOVED,
 	UPDATED_BY_USER,
+	TIMESTAMP_CHANGED,
 	LAST_SIGNAL
 };
 static guint signals[LAST_SIGNAL] = { 0 };
@@ -2155,8 +2156,11 @@ nm_settings_connection_update_timestamp (NMSettingsConnection *self,
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
 
 	/* Update timestamp in private storage */
-	priv->timestamp = timestamp;
-	priv->timestamp_set = TRUE;
+	if (!priv->timestamp_set || priv->timestamp != timestamp) {
+		priv->timestamp = timestamp;
+		priv->timestamp_set = TRUE;
+		g_signal_emit (self, signals[TIMESTAMP_CHANGED], 0);
+	}
 
 	if (flush_to_disk == FALSE)
 		return;
@@ -2783,6 +2787,14 @@ nm_settings_connection_class_init (NMSettingsConnectionClass *class)
 		              g_cclosure_marshal_VOID__VOID,
 		              G_TYPE_NONE, 0);
 
+	signals[TIMESTAMP_CHANGED] =
+		g_signal_new (NM_SETTINGS_CONNECTION_TIMESTAMP_CHANGED,
+		              G_TYPE_FROM_CLASS (class),
+		              G_SIGNAL_RUN_FIRST,
+		              0, NULL, NULL,
+		              g_cclosure_marshal_VOID__VOID,
+		              G_TYPE_NONE, 0);
+
 	signals[REMOVED] = 
 		g_signal_new (NM_SETTINGS_CONNECTION_REMOVED,
 		              G_TYPE_FROM_CLASS (class),
@@ -46,6 +46,9 @@ G_BEGIN_DECLS
 /* Emitted when connection is changed by a user action */
 #define NM_SETTINGS_CONNECTION_UPDATED_BY_USER "updated-by-user"
 
+/* Emitted when the last-connected timestamp changes */
+#define NM_SETTINGS_CONNECTION_TIMESTAMP_CHANGED "timestamp-changed"
+
 /* Properties */
 #define NM_SETTINGS_CONNECTION_VISIBLE  "visible"
 #define NM_SETTINGS_CONNECTION_UNSAVED  "unsaved"
@@ -140,6 +140,18 @@ typedef struct {
 	GSList *plugins;
 	gboolean connections_loaded;
 	GHashTable *connections;
+
+	/* Secondary indexes over @connections, kept up to date by
+	 * index_add() and index_remove(). The by-interface, by-type and
+	 * by-candidate-key indexes map to sets of connections.
+	 * @connections_sorted is ordered by index_keys_cmp(). */
+	GHashTable *index_keys;
+	GHashTable *connections_by_uuid;
+	GHashTable *connections_by_iface;
+	GHashTable *connections_by_type;
+	GHashTable *connections_by_candidate_key;
+	GPtrArray *connections_sorted;
+
 	GSList *unmanaged_specs;
 	GSList *unrecognized_specs;
 	GSList *get_connections_cache;
@@ -184,6 +196,263 @@ enum {
 	LAST_PROP
 };
 
+typedef struct {
+	char *uuid;
+	char *iface;
+	char *type;
+	char *hw_address;
+
+	/* "type/interface-name", see candidate_key() */
+	char *candidate_key;
+
+	/* the autoconnect order at the time of indexing */
+	gboolean autoconnect;
+	gint priority;
+	guint64 timestamp;
+} IndexKeys;
+
+static void
+index_keys_free (IndexKeys *keys)
+{
+	g_free (keys->uuid);
+	g_free (keys->iface);
+	g_free (keys->type);
+	g_free (keys->hw_address);
+	g_free (keys->candidate_key);
+	g_slice_free (IndexKeys, keys);
+}
+
+/* The MAC address a device must have for @connection to be compatible */
+static const char *
+connection_get_hw_address (NMConnection *connection)
+{
+	NMSettingWired *s_wired;
+	NMSettingWireless *s_wireless;
+	const char *const *subchans;
+
+	s_wired = nm_connection_get_setting_wired (connection);
+	if (s_wired) {
+		/* s390 devices are matched by their subchannels instead */
+		subchans = nm_setting_wired_get_s390_subchannels (s_wired);
+		if (subchans && subchans[0])
+			return NULL;
+		return nm_setting_wired_get_mac_address (s_wired);
+	}
+
+	s_wireless = nm_connection_get_setting_wireless (connection);
+	if (s_wireless)
+		return nm_setting_wireless_get_mac_address (s_wireless);
+
+	return NULL;
+}
+
+/* Connections are indexed by their type together with their interface
+ * name, so that the candidates for a device are the ones with one of the
+ * types it accepts and either its interface name or none. */
+static char *
+candidate_key (const char *type, const char *iface)
+{
+	return g_strdup_printf ("%s/%s", type, iface ? iface : "");
+}
+
+static void
+index_keys_fill_order (IndexKeys *keys, NMSettingsConnection *connection)
+{
+	NMSettingConnection *s_con;
+
+	s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
+	keys->autoconnect = s_con && nm_setting_connection_get_autoconnect (s_con);
+	keys->priority = s_con ? nm_setting_connection_get_autoconnect_priority (s_con) : 0;
+	keys->timestamp = 0;
+	nm_settings_connection_get_timestamp (connection, &keys->timestamp);
+}
+
+/* Autoconnect order: connections that can autoconnect first, then by
+ * autoconnect-priority and finally the most recently used first. This is
+ * the order nm_utils_cmp_connection_by_autoconnect_priority() gives when
+ * applied (stably) to a list sorted by timestamp. */
+static int
+index_keys_cmp (const IndexKeys *a, const IndexKeys *b)
+{
+	if (a->autoconnect != b->autoconnect)
+		return a->autoconnect ? -1 : 1;
+	if (a->autoconnect && a->priority != b->priority)
+		return a->priority > b->priority ? -1 : 1;
+	if (a->timestamp != b->timestamp)
+		return a->timestamp > b->timestamp ? -1 : 1;
+	return 0;
+}
+
+/* Returns the first index in @connections_sorted whose entry sorts after
+ * @keys, or, with @lower, the first one that does not sort before it. */
+static guint
+sorted_bsearch (NMSettingsPrivate *priv, const IndexKeys *keys, gboolean lower)
+{
+	guint lo = 0, hi = priv->connections_sorted->len;
+
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		const IndexKeys *k = g_hash_table_lookup (priv->index_keys, priv->connections_sorted->pdata[mid]);
+		int c = index_keys_cmp (k, keys);
+
+		if (c < 0 || (c == 0 && !lower))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static void
+index_set_add (GHashTable *index, const char *key, NMSettingsConnection *connection)
+{
+	GHashTable *set;
+
+	if (!key)
+		return;
+
+	set = g_hash_table_lookup (index, key);
+	if (!set) {
+		set = g_hash_table_new (NULL, NULL);
+		g_hash_table_insert (index, g_strdup (key), set);
+	}
+	g_hash_table_add (set, connection);
+}
+
+static void
+index_set_remove (GHashTable *index, const char *key, NMSettingsConnection *connection)
+{
+	GHashTable *set;
+
+	if (!key)
+		return;
+
+	set = g_hash_table_lookup (index, key);
+	if (set) {
+		g_hash_table_remove (set, connection);
+		if (!g_hash_table_size (set))
+			g_hash_table_remove (index, key);
+	}
+}
+
+static void
+index_remove (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	IndexKeys *keys;
+	guint i;
+
+	keys = g_hash_table_lookup (priv->index_keys, connection);
+	if (!keys)
+		return;
+
+	if (keys->uuid && g_hash_table_lookup (priv->connections_by_uuid, keys->uuid) == connection)
+		g_hash_table_remove (priv->connections_by_uuid, keys->uuid);
+	index_set_remove (priv->connections_by_iface, keys->iface, connection);
+	index_set_remove (priv->connections_by_type, keys->type, connection);
+	index_set_remove (priv->connections_by_candidate_key, keys->candidate_key, connection);
+
+	/* the connection is within the run of entries that compare equal */
+	for (i = sorted_bsearch (priv, keys, TRUE); i < priv->connections_sorted->len; i++) {
+		if (priv->connections_sorted->pdata[i] == connection) {
+			g_ptr_array_remove_index (priv->connections_sorted, i);
+			break;
+		}
+	}
+
+	g_hash_table_remove (priv->index_keys, connection);
+}
+
+static void
+index_add (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	NMConnection *c = NM_CONNECTION (connection);
+	IndexKeys *keys;
+
+	keys = g_slice_new0 (IndexKeys);
+	keys->uuid = g_strdup (nm_connection_get_uuid (c));
+	keys->iface = g_strdup (nm_connection_get_interface_name (c));
+	keys->type = g_strdup (nm_connection_get_connection_type (c));
+	keys->hw_address = g_strdup (connection_get_hw_address (c));
+	if (keys->type)
+		keys->candidate_key = candidate_key (keys->type, keys->iface);
+	index_keys_fill_order (keys, connection);
+
+	/* Duplicate UUIDs are rejected when claiming connections */
+	if (keys->uuid && !g_hash_table_contains (priv->connections_by_uuid, keys->uuid))
+		g_hash_table_insert (priv->connections_by_uuid, g_strdup (keys->uuid), connection);
+	index_set_add (priv->connections_by_iface, keys->iface, connection);
+	index_set_add (priv->connections_by_type, keys->type, connection);
+	index_set_add (priv->connections_by_candidate_key, keys->candidate_key, connection);
+
+	g_ptr_array_insert (priv->connections_sorted, sorted_bsearch (priv, keys, FALSE), connection);
+
+	g_hash_table_insert (priv->index_keys, connection, keys);
+}
+
+static void
+connection_changed_reindex (NMSettingsConnection *connection, gpointer user_data)
+{
+	NMSettings *self = NM_SETTINGS (user_data);
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	NMConnection *c = NM_CONNECTION (connection);
+	IndexKeys *keys, order;
+
+	/* "changed" is also emitted for secrets; only reindex when a key changed */
+	keys = g_hash_table_lookup (priv->index_keys, connection);
+	if (keys) {
+		index_keys_fill_order (&order, connection);
+		if (   !g_strcmp0 (keys->uuid, nm_connection_get_uuid (c))
+		    && !g_strcmp0 (keys->iface, nm_connection_get_interface_name (c))
+		    && !g_strcmp0 (keys->type, nm_connection_get_connection_type (c))
+		    && !g_strcmp0 (keys->hw_address, connection_get_hw_address (c))
+		    && keys->autoconnect == order.autoconnect
+		    && keys->priority == order.priority
+		    && keys->timestamp == order.timestamp)
+			return;
+	}
+
+	index_remove (self, connection);
+	index_add (self, connection);
+}
+
+static gint
+sort_by_index_keys (gconstpointer pa, gconstpointer pb, gpointer index_keys)
+{
+	return index_keys_cmp (g_hash_table_lookup (index_keys, *((gpointer *) pa)),
+	                       g_hash_table_lookup (index_keys, *((gpointer *) pb)));
+}
+
+/* Returns the connections of @set in autoconnect order, see
+ * nm_settings_get_connections(). */
+static GSList *
+index_set_to_sorted_list (NMSettings *self, GHashTable *set)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	GPtrArray *array;
+	GHashTableIter iter;
+	gpointer data;
+	GSList *list = NULL;
+	guint i;
+
+	if (!set)
+		return NULL;
+
+	array = g_ptr_array_sized_new (g_hash_table_size (set));
+	g_hash_table_iter_init (&iter, set);
+	while (g_hash_table_iter_next (&iter, NULL, &data))
+		g_ptr_array_add (array, data);
+	g_ptr_array_sort_with_data (array, sort_by_index_keys, priv->index_keys);
+
+	for (i = array->len; i > 0; i--)
+		list = g_slist_prepend (list, array->pdata[i - 1]);
+	g_ptr_array_free (array, TRUE);
+	return list;
+}
+
+/*****************************************************************************/
+
 static void
 check_startup_complete (NMSettings *self)
 {
@@ -301,22 +570,46 @@ impl_settings_list_connections (NMSettings *self,
 NMSettingsConnection *
 nm_settings_get_connection_by_uuid (NMSettings *self, const char *uuid)
 {
-	NMSettingsPrivate *priv;
-	NMSettingsConnection *candidate;
-	GHashTableIter iter;
-
 	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
 	g_return_val_if_fail (uuid != NULL, NULL);
 
-	priv = NM_SETTINGS_GET_PRIVATE (self);
+	return g_hash_table_lookup (NM_SETTINGS_GET_PRIVATE (self)->connections_by_uuid, uuid);
+}
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &candidate)) {
-		if (g_strcmp0 (uuid, nm_settings_connection_get_uuid (candidate)) == 0)
-			return candidate;
-	}
+/**
+ * nm_settings_get_connections_by_iface:
+ * @self: the #NMSettings
+ * @iface: an interface name
+ *
+ * Returns: the connections whose interface-name is @iface, sorted like
+ * nm_settings_get_connections(). Caller must free the list with
+ * g_slist_free().
+ */
+GSList *
+nm_settings_get_connections_by_iface (NMSettings *self, const char *iface)
+{
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+	g_return_val_if_fail (iface != NULL, NULL);
 
-	return NULL;
+	return index_set_to_sorted_list (self, g_hash_table_lookup (NM_SETTINGS_GET_PRIVATE (self)->connections_by_iface, iface));
+}
+
+/**
+ * nm_settings_get_connections_by_type:
+ * @self: the #NMSettings
+ * @type: a connection type, like %NM_SETTING_WIRED_SETTING_NAME
+ *
+ * Returns: the connections of type @type, sorted like
+ * nm_settings_get_connections(). Caller must free the list with
+ * g_slist_free().
+ */
+GSList *
+nm_settings_get_connections_by_type (NMSettings *self, const char *type)
+{
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+	g_return_val_if_fail (type != NULL, NULL);
+
+	return index_set_to_sorted_list (self, g_hash_table_lookup (NM_SETTINGS_GET_PRIVATE (self)->connections_by_type, type));
 }
 
 static void
@@ -367,55 +660,145 @@ error:
 	g_clear_object (&subject);
 }
 
-static int
-connection_sort (gconstpointer pa, gconstpointer pb)
-{
-	NMConnection *a = NM_CONNECTION (pa);
-	NMSettingConnection *con_a;
-	NMConnection *b = NM_CONNECTION (pb);
-	NMSettingConnection *con_b;
-	guint64 ts_a = 0, ts_b = 0;
-	gboolean can_ac_a, can_ac_b;
-
-	con_a = nm_connection_get_setting_connection (a);
-	g_assert (con_a);
-	con_b = nm_connection_get_setting_connection (b);
-	g_assert (con_b);
-
-	can_ac_a = !!nm_setting_connection_get_autoconnect (con_a);
-	can_ac_b = !!nm_setting_connection_get_autoconnect (con_b);
-	if (can_ac_a != can_ac_b)
-		return can_ac_a ? -1 : 1;
-
-	nm_settings_connection_get_timestamp (NM_SETTINGS_CONNECTION (pa), &ts_a);
-	nm_settings_connection_get_timestamp (NM_SETTINGS_CONNECTION (pb), &ts_b);
-	if (ts_a > ts_b)
-		return -1;
-	else if (ts_a == ts_b)
-		return 0;
-	return 1;
-}
-
 /* Returns a list of NMSettingsConnections.
  * The list is sorted in the order suitable for auto-connecting, i.e.
- * first go connections with autoconnect=yes and most recent timestamp.
+ * first go connections with autoconnect=yes, then those with higher
+ * autoconnect-priority and most recent timestamp.
  * Caller must free the list with g_slist_free().
  */
 GSList *
 nm_settings_get_connections (NMSettings *self)
 {
-	GHashTableIter iter;
-	gpointer data = NULL;
+	NMSettingsPrivate *priv;
 	GSList *list = NULL;
+	guint i;
 
 	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
 
-	g_hash_table_iter_init (&iter, NM_SETTINGS_GET_PRIVATE (self)->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data))
-		list = g_slist_insert_sorted (list, data, connection_sort);
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	for (i = priv->connections_sorted->len; i > 0; i--)
+		list = g_slist_prepend (list, priv->connections_sorted->pdata[i - 1]);
 	return list;
 }
 
+/**
+ * nm_settings_get_connections_sorted:
+ * @self: the #NMSettings
+ * @out_len: (out) (allow-none): the number of connections
+ *
+ * Returns: the connections in the order of nm_settings_get_connections(),
+ * without copying. The array is owned by @self and only valid until
+ * connections are added, removed or changed; callers must not keep it
+ * across calls that may modify settings.
+ */
+NMSettingsConnection *const*
+nm_settings_get_connections_sorted (NMSettings *self, guint *out_len)
+{
+	NMSettingsPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	if (out_len)
+		*out_len = priv->connections_sorted->len;
+	return (NMSettingsConnection *const*) priv->connections_sorted->pdata;
+}
+
+static gboolean
+candidate_matches (const IndexKeys *keys, const char *iface, const char *hw_address)
+{
+	if (keys->iface && g_strcmp0 (keys->iface, iface))
+		return FALSE;
+	if (   hw_address
+	    && keys->hw_address
+	    && !nm_utils_hwaddr_matches (keys->hw_address, -1, hw_address, -1))
+		return FALSE;
+	return TRUE;
+}
+
+static void
+candidates_add_set (NMSettingsPrivate *priv,
+                    GPtrArray *candidates,
+                    const char *key,
+                    const char *hw_address)
+{
+	GHashTable *set;
+	GHashTableIter iter;
+	gpointer connection;
+
+	set = g_hash_table_lookup (priv->connections_by_candidate_key, key);
+	if (!set)
+		return;
+
+	g_hash_table_iter_init (&iter, set);
+	while (g_hash_table_iter_next (&iter, &connection, NULL)) {
+		if (candidate_matches (g_hash_table_lookup (priv->index_keys, connection), NULL, hw_address))
+			g_ptr_array_add (candidates, connection);
+	}
+}
+
+/**
+ * nm_settings_get_autoconnect_candidates:
+ * @self: the #NMSettings
+ * @device: the device to autoconnect
+ *
+ * Prefilters the connections by the keys nm_device_check_connection_compatible()
+ * checks first: the connection types @device accepts, the interface-name
+ * and the MAC address of wireless connections and of wired connections
+ * without s390 subchannels. Connections that
+ * are not returned can't be compatible with @device; the returned ones
+ * still have to be checked.
+ *
+ * Returns: (transfer container): a #GPtrArray of #NMSettingsConnection in
+ * the order of nm_settings_get_connections(). Free it with g_ptr_array_unref().
+ */
+GPtrArray *
+nm_settings_get_autoconnect_candidates (NMSettings *self, NMDevice *device)
+{
+	NMSettingsPrivate *priv;
+	const char *const *types;
+	const char *iface, *hw_address;
+	GPtrArray *candidates;
+	guint i;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+	g_return_val_if_fail (NM_IS_DEVICE (device), NULL);
+
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+	types = nm_device_get_compatible_connection_types (device);
+	iface = nm_device_get_iface (device);
+	hw_address = nm_device_get_compatible_hw_address (device);
+
+	if (!types) {
+		/* Already sorted; only filter */
+		candidates = g_ptr_array_new ();
+		for (i = 0; i < priv->connections_sorted->len; i++) {
+			gpointer connection = priv->connections_sorted->pdata[i];
+
+			if (candidate_matches (g_hash_table_lookup (priv->index_keys, connection), iface, hw_address))
+				g_ptr_array_add (candidates, connection);
+		}
+		return candidates;
+	}
+
+	candidates = g_ptr_array_new ();
+	for (i = 0; types[i]; i++) {
+		gs_free char *key = NULL;
+
+		key = candidate_key (types[i], NULL);
+		candidates_add_set (priv, candidates, key, hw_address);
+		if (iface) {
+			g_free (key);
+			key = candidate_key (types[i], iface);
+			candidates_add_set (priv, candidates, key, hw_address);
+		}
+	}
+	g_ptr_array_sort_with_data (candidates, sort_by_index_keys, priv->index_keys);
+	return candidates;
+}
+
 NMSettingsConnection *
 nm_settings_get_connection_by_path (NMSettings *self, const char *path)
 {
@@ -433,15 +816,8 @@ gboolean
 nm_settings_has_connection (NMSettings *self, NMSettingsConnection *connection)
 {
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
-	GHashTableIter iter;
-	gpointer data;
-
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data))
-		if (data == connection)
-			return TRUE;
 
-	return FALSE;
+	return g_hash_table_contains (priv->index_keys, connection);
 }
 
 const GSList *
@@ -894,9 +1270,11 @@ connection_removed (NMSettingsConnection *connection, gpointer user_data)
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_updated_by_user), self);
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_visibility_changed), self);
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_ready_changed), self);
+	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_changed_reindex), self);
 	g_object_unref (self);
 
 	/* Forget about the connection internally */
+	index_remove (self, connection);
 	g_hash_table_remove (priv->connections, (gpointer) cpath);
 
 	/* Notify D-Bus */
@@ -970,20 +1348,15 @@ claim_connection (NMSettings *self, NMSettingsConnection *connection)
 {
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 	GError *error = NULL;
-	GHashTableIter iter;
-	gpointer data;
 	const char *path;
 	NMSettingsConnection *existing;
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (connection));
 	g_return_if_fail (nm_connection_get_path (NM_CONNECTION (connection)) == NULL);
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data)) {
-		/* prevent duplicates */
-		if (data == connection)
-			return;
-	}
+	/* prevent duplicates */
+	if (g_hash_table_contains (priv->index_keys, connection))
+		return;
 
 	if (!nm_connection_normalize (NM_CONNECTION (connection), NULL, NULL, &error)) {
 		nm_log_warn (LOGD_SETTINGS, "plugin provided invalid connection: %s",
@@ -1028,6 +1401,10 @@ claim_connection (NMSettings *self, NMSettingsConnection *connection)
 	                  G_CALLBACK (connection_updated), self);
 	g_signal_connect (connection, NM_SETTINGS_CONNECTION_UPDATED_BY_USER,
 	                  G_CALLBACK (connection_updated_by_user), self);
+	g_signal_connect (connection, NM_CONNECTION_CHANGED,
+	                  G_CALLBACK (connection_changed_reindex), self);
+	g_signal_connect (connection, NM_SETTINGS_CONNECTION_TIMESTAMP_CHANGED,
+	                  G_CALLBACK (connection_changed_reindex), self);
 	g_signal_connect (connection, "notify::" NM_SETTINGS_CONNECTION_VISIBLE,
 	                  G_CALLBACK (connection_visibility_changed),
 	                  self);
@@ -1045,6 +1422,7 @@ claim_connection (NMSettings *self, NMSettingsConnection *connection)
 	g_hash_table_insert (priv->connections,
 	                     (gpointer) nm_connection_get_path (NM_CONNECTION (connection)),
 	                     g_object_ref (connection));
+	index_add (self, connection);
 
 	nm_utils_log_connection_diff (NM_CONNECTION (connection), NULL, LOGL_DEBUG, LOGD_CORE, "new connection", "++ ");
 
@@ -1085,20 +1463,16 @@ nm_settings_add_connection (NMSettings *self,
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 	GSList *iter;
 	NMSettingsConnection *added = NULL;
-	GHashTableIter citer;
-	NMConnection *candidate = NULL;
+	const char *uuid;
 
 	/* Make sure a connection with this UUID doesn't already exist */
-	g_hash_table_iter_init (&citer, priv->connections);
-	while (g_hash_table_iter_next (&citer, NULL, (gpointer *) &candidate)) {
-		if (g_strcmp0 (nm_connection_get_uuid (connection),
-		               nm_connection_get_uuid (candidate)) == 0) {
-			g_set_error_literal (error,
-			                     NM_SETTINGS_ERROR,
-			                     NM_SETTINGS_ERROR_UUID_EXISTS,
-			                     "A connection with this UUID already exists.");
-			return NULL;
-		}
+	uuid = nm_connection_get_uuid (connection);
+	if (uuid && g_hash_table_contains (priv->connections_by_uuid, uuid)) {
+		g_set_error_literal (error,
+		                     NM_SETTINGS_ERROR,
+		                     NM_SETTINGS_ERROR_UUID_EXISTS,
+		                     "A connection with this UUID already exists.");
+		return NULL;
 	}
 
 	/* 1) plugin writes the NMConnection to disk
@@ -1733,58 +2107,70 @@ hostname_file_changed_cb (GFileMonitor *monitor,
 }
 
 static gboolean
-have_connection_for_device (NMSettings *self, NMDevice *device)
+wired_connection_matches_device (NMConnection *connection,
+                                 NMDevice *device,
+                                 const char *device_hwaddr)
 {
-	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
-	GHashTableIter iter;
-	gpointer data;
 	NMSettingConnection *s_con;
 	NMSettingWired *s_wired;
 	const char *setting_hwaddr;
-	const char *device_hwaddr;
+	const char *ctype, *iface;
 
-	g_return_val_if_fail (NM_IS_SETTINGS (self), FALSE);
+	if (!nm_device_check_connection_compatible (device, connection))
+		return FALSE;
 
-	device_hwaddr = nm_device_get_hw_address (device);
+	s_con = nm_connection_get_setting_connection (connection);
 
-	/* Find a wired connection locked to the given MAC address, if any */
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data)) {
-		NMConnection *connection = NM_CONNECTION (data);
-		const char *ctype, *iface;
+	iface = nm_setting_connection_get_interface_name (s_con);
+	if (iface && strcmp (iface, nm_device_get_iface (device)) != 0)
+		return FALSE;
 
-		if (!nm_device_check_connection_compatible (device, connection))
-			continue;
+	ctype = nm_setting_connection_get_connection_type (s_con);
+	s_wired = nm_connection_get_setting_wired (connection);
 
-		s_con = nm_connection_get_setting_connection (connection);
+	if (!s_wired && !strcmp (ctype, NM_SETTING_PPPOE_SETTING_NAME)) {
+		/* No wired setting; therefore the PPPoE connection applies to any device */
+		return TRUE;
+	}
 
-		iface = nm_setting_connection_get_interface_name (s_con);
-		if (iface && strcmp (iface, nm_device_get_iface (device)) != 0)
-			continue;
+	g_assert (s_wired != NULL);
 
-		ctype = nm_setting_connection_get_connection_type (s_con);
-		if (   strcmp (ctype, NM_SETTING_WIRED_SETTING_NAME)
-		    && strcmp (ctype, NM_SETTING_PPPOE_SETTING_NAME))
-			continue;
+	setting_hwaddr = nm_setting_wired_get_mac_address (s_wired);
+	if (setting_hwaddr) {
+		/* A connection mac-locked to this device */
+		return    device_hwaddr
+		       && nm_utils_hwaddr_matches (setting_hwaddr, -1, device_hwaddr, -1);
+	}
 
-		s_wired = nm_connection_get_setting_wired (connection);
+	/* A connection that applies to any wired device */
+	return TRUE;
+}
 
-		if (!s_wired && !strcmp (ctype, NM_SETTING_PPPOE_SETTING_NAME)) {
-			/* No wired setting; therefore the PPPoE connection applies to any device */
-			return TRUE;
-		}
+static gboolean
+have_connection_for_device (NMSettings *self, NMDevice *device)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	static const char *const ctypes[] = { NM_SETTING_WIRED_SETTING_NAME, NM_SETTING_PPPOE_SETTING_NAME };
+	const char *device_hwaddr;
+	GHashTableIter iter;
+	GHashTable *set;
+	gpointer data;
+	guint i;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), FALSE);
 
-		g_assert (s_wired != NULL);
+	device_hwaddr = nm_device_get_hw_address (device);
+
+	/* Find a wired connection locked to the given MAC address, if any */
+	for (i = 0; i < G_N_ELEMENTS (ctypes); i++) {
+		set = g_hash_table_lookup (priv->connections_by_type, ctypes[i]);
+		if (!set)
+			continue;
 
-		setting_hwaddr = nm_setting_wired_get_mac_address (s_wired);
-		if (setting_hwaddr) {
-			/* A connection mac-locked to this device */
-			if (   device_hwaddr
-			    && nm_utils_hwaddr_matches (setting_hwaddr, -1, device_hwaddr, -1))
+		g_hash_table_iter_init (&iter, set);
+		while (g_hash_table_iter_next (&iter, NULL, &data)) {
+			if (wired_connection_matches_device (NM_CONNECTION (data), device, device_hwaddr))
 				return TRUE;
-		} else {
-			/* A connection that applies to any wired device */
-			return TRUE;
 		}
 	}
 
@@ -1947,6 +2333,12 @@ nm_settings_sort_connections (gconstpointer a, gconstpointer b)
 	return 0;
 }
 
+static gint
+sort_connections_by_timestamp_desc (gconstpointer pa, gconstpointer pb)
+{
+	return nm_settings_sort_connections (*((gpointer *) pb), *((gpointer *) pa));
+}
+
 static GSList *
 get_best_connections (NMConnectionProvider *provider,
                       guint max_requested,
@@ -1960,41 +2352,36 @@ get_best_connections (NMConnectionProvider *provider,
 	GSList *sorted = NULL;
 	GHashTableIter iter;
 	NMSettingsConnection *connection;
-	guint added = 0;
-	guint64 oldest = 0;
+	GHashTable *candidates = priv->connections;
+	GPtrArray *array;
+	guint i, len;
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &connection)) {
-		guint64 cur_ts = 0;
+	if (ctype1) {
+		candidates = g_hash_table_lookup (priv->connections_by_type, ctype1);
+		if (!candidates)
+			return NULL;
+	}
 
-		if (ctype1 && !nm_connection_is_type (NM_CONNECTION (connection), ctype1))
-			continue;
+	array = g_ptr_array_new ();
+	g_hash_table_iter_init (&iter, candidates);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &connection)) {
 		if (ctype2 && !nm_connection_is_type (NM_CONNECTION (connection), ctype2))
 			continue;
 		if (func && !func (provider, NM_CONNECTION (connection), func_data))
 			continue;
-
-		/* Don't bother with a connection that's older than the oldest one in the list */
-		if (max_requested && added >= max_requested) {
-		    nm_settings_connection_get_timestamp (connection, &cur_ts);
-		    if (cur_ts <= oldest)
-				continue;
-		}
-
-		/* List is sorted with oldest first */
-		sorted = g_slist_insert_sorted (sorted, connection, nm_settings_sort_connections);
-		added++;
-
-		if (max_requested && added > max_requested) {
-			/* Over the limit, remove the oldest one */
-			sorted = g_slist_delete_link (sorted, sorted);
-			added--;
-		}
-
-		nm_settings_connection_get_timestamp (NM_SETTINGS_CONNECTION (sorted->data), &oldest);
+		g_ptr_array_add (array, connection);
 	}
 
-	return g_slist_reverse (sorted);
+	/* Most recently used first, and only the first @max_requested ones */
+	g_ptr_array_sort (array, sort_connections_by_timestamp_desc);
+	len = array->len;
+	if (max_requested && len > max_requested)
+		len = max_requested;
+
+	for (i = len; i > 0; i--)
+		sorted = g_slist_prepend (sorted, array->pdata[i - 1]);
+	g_ptr_array_free (array, TRUE);
+	return sorted;
 }
 
 static const GSList *
@@ -2177,6 +2564,12 @@ nm_settings_init (NMSettings *self)
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	priv->connections = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	priv->index_keys = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) index_keys_free);
+	priv->connections_by_uuid = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->connections_by_iface = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	priv->connections_by_type = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	priv->connections_by_candidate_key = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	priv->connections_sorted = g_ptr_array_new ();
 
 	/* Hold a reference to the agent manager so it stays alive; the only
 	 * other holders are NMSettingsConnection objects which are often
@@ -2234,6 +2627,12 @@ finalize (GObject *object)
 	NMSettings *self = NM_SETTINGS (object);
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
+	g_hash_table_destroy (priv->connections_by_uuid);
+	g_hash_table_destroy (priv->connections_by_iface);
+	g_hash_table_destroy (priv->connections_by_type);
+	g_hash_table_destroy (priv->connections_by_candidate_key);
+	g_ptr_array_free (priv->connections_sorted, TRUE);
+	g_hash_table_destroy (priv->index_keys);
 	g_hash_table_destroy (priv->connections);
 	g_slist_free (priv->get_connections_cache);
 
@@ -103,6 +103,12 @@ void nm_settings_add_connection_dbus (NMSettings *self,
  */
 GSList *nm_settings_get_connections (NMSettings *settings);
 
+NMSettingsConnection *const*nm_settings_get_connections_sorted (NMSettings *settings,
+                                                               guint *out_len);
+
+GPtrArray *nm_settings_get_autoconnect_candidates (NMSettings *settings,
+                                                   NMDevice *device);
+
 NMSettingsConnection *nm_settings_add_connection (NMSettings *settings,
                                                   NMConnection *connection,
                                                   gboolean save_to_disk,
@@ -113,6 +119,12 @@ NMSettingsConnection *nm_settings_get_connection_by_path (NMSettings *settings,
 NMSettingsConnection *nm_settings_get_connection_by_uuid (NMSettings *settings,
                                                           const char *uuid);
 
+GSList *nm_settings_get_connections_by_iface (NMSettings *settings,
+                                              const char *iface);
+
+GSList *nm_settings_get_connections_by_type (NMSettings *settings,
+                                             const char *type);
+
 gboolean nm_settings_has_connection (NMSettings *self, NMSettingsConnection *connection);
 
 const GSList *nm_settings_get_unmanaged_specs (NMSettings *self);
@@ -212,9 +212,22 @@ files_changed_cb (NMInotifyHelper *ih,
 	g_signal_emit (self, signals[IFCFG_CHANGED], 0);
 }
 
+/* nm_ifcfg_connection_new:
+ * @source: if given, the connection to add from memory
+ * @parsed: if given, the connection the caller already read from @full_path.
+ *   It must not be unmanaged or unrecognized.
+ * @full_path: the ifcfg file, read if neither @source nor @parsed is given
+ * @out_parsed: (allow-none): if @full_path was read, on success set to the
+ *   connection read from it if that only depends on the contents of the
+ *   files, so the caller can cache it
+ * @error: error in case of failure
+ * @out_ignore_error: set to %TRUE if the error should not be logged
+ */
 NMIfcfgConnection *
 nm_ifcfg_connection_new (NMConnection *source,
+                         NMConnection *parsed,
                          const char *full_path,
+                         NMConnection **out_parsed,
                          GError **error,
                          gboolean *out_ignore_error)
 {
@@ -223,8 +236,10 @@ nm_ifcfg_connection_new (NMConnection *source,
 	char *unhandled_spec = NULL;
 	const char *unmanaged_spec = NULL, *unrecognized_spec = NULL;
 	gboolean update_unsaved = TRUE;
+	gboolean cacheable = FALSE;
 
 	g_assert (source || full_path);
+	g_assert (!source || !parsed);
 
 	if (out_ignore_error)
 		*out_ignore_error = FALSE;
@@ -233,12 +248,17 @@ nm_ifcfg_connection_new (NMConnection *source,
 	if (source)
 		tmp = g_object_ref (source);
 	else {
-		tmp = connection_from_file (full_path,
-		                            &unhandled_spec,
-		                            error,
-		                            out_ignore_error);
-		if (!tmp)
-			return NULL;
+		if (parsed)
+			tmp = g_object_ref (parsed);
+		else {
+			tmp = connection_from_file (full_path,
+			                            &unhandled_spec,
+			                            error,
+			                            out_ignore_error,
+			                            &cacheable);
+			if (!tmp)
+				return NULL;
+		}
 
 		/* If we just read the connection from disk, it's clearly not Unsaved */
 		update_unsaved = FALSE;
@@ -264,6 +284,9 @@ nm_ifcfg_connection_new (NMConnection *source,
 	else
 		g_clear_object (&object);
 
+	if (object && cacheable && out_parsed)
+		*out_parsed = g_object_ref (tmp);
+
 	g_object_unref (tmp);
 	g_free (unhandled_spec);
 	return (NMIfcfgConnection *) object;
@@ -398,7 +421,7 @@ commit_changes (NMSettingsConnection *connection,
 	 */
 	filename = nm_settings_connection_get_filename (connection);
 	if (filename) {
-		reread = connection_from_file (filename, NULL, NULL, NULL);
+		reread = connection_from_file (filename, NULL, NULL, NULL, NULL);
 		if (reread) {
 			same = nm_connection_compare (NM_CONNECTION (connection),
 			                              reread,
@@ -47,7 +47,9 @@ typedef struct {
 GType nm_ifcfg_connection_get_type (void);
 
 NMIfcfgConnection *nm_ifcfg_connection_new (NMConnection *source,
+                                            NMConnection *parsed,
                                             const char *full_path,
+                                            NMConnection **out_parsed,
                                             GError **error,
                                             gboolean *out_ignore_error);
 
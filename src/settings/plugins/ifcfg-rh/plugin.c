@@ -37,6 +37,7 @@
 #include "common.h"
 #include "plugin.h"
 #include "nm-settings-plugin.h"
+#include "nm-settings-cache.h"
 #include "nm-config.h"
 #include "NetworkManagerUtils.h"
 
@@ -64,13 +65,17 @@
 
 #define ERR_GET_MSG(err) (((err) && (err)->message) ? (err)->message : "(unknown)")
 
+#define IFCFG_CACHE_FILE NMSTATEDIR "/ifcfg-rh-connections.cache"
+
 
 static NMIfcfgConnection *update_connection (SettingsPluginIfcfg *plugin,
                                              NMConnection *source,
+                                             NMConnection *parsed,
                                              const char *full_path,
                                              NMIfcfgConnection *connection,
                                              gboolean protect_existing_connection,
                                              GHashTable *protected_connections,
+                                             NMConnection **out_parsed,
                                              GError **error);
 
 static void settings_plugin_interface_init (NMSettingsPluginInterface *plugin_iface);
@@ -97,6 +102,9 @@ typedef struct {
 
 	GFileMonitor *ifcfg_monitor;
 	guint ifcfg_monitor_id;
+
+	/* loaded on the first read of the connections */
+	NMSettingsCache *cache;
 } SettingsPluginIfcfgPrivate;
 
 static SettingsPluginIfcfg *settings_plugin_ifcfg_get (void);
@@ -120,12 +128,24 @@ connection_ifcfg_changed (NMIfcfgConnection *connection, gpointer user_data)
 
 	_LOGD ("connection_ifcfg_changed("NM_IFCFG_CONNECTION_LOG_FMTD"): %s", NM_IFCFG_CONNECTION_LOG_ARGD (connection), "reload");
 
-	update_connection (self, NULL, path, connection, TRUE, NULL, NULL);
+	update_connection (self, NULL, NULL, path, connection, TRUE, NULL, NULL, NULL);
+}
+
+/* The cache includes secrets, don't keep them for removed connections */
+static void
+cache_remove_connection (SettingsPluginIfcfg *self, NMSettingsConnection *connection)
+{
+	SettingsPluginIfcfgPrivate *priv = SETTINGS_PLUGIN_IFCFG_GET_PRIVATE (self);
+	const char *path = nm_settings_connection_get_filename (connection);
+
+	if (priv->cache && path)
+		nm_settings_cache_remove (priv->cache, path);
 }
 
 static void
 connection_removed_cb (NMSettingsConnection *obj, gpointer user_data)
 {
+	cache_remove_connection (user_data, obj);
 	g_hash_table_remove (SETTINGS_PLUGIN_IFCFG_GET_PRIVATE (user_data)->connections,
 	                     nm_connection_get_uuid (NM_CONNECTION (obj)));
 }
@@ -148,6 +168,7 @@ remove_connection (SettingsPluginIfcfg *self, NMIfcfgConnection *connection)
 	g_hash_table_remove (priv->connections, nm_connection_get_uuid (NM_CONNECTION (connection)));
 	if (!unmanaged && !unrecognized)
 		nm_settings_connection_signal_remove (NM_SETTINGS_CONNECTION (connection));
+	cache_remove_connection (self, NM_SETTINGS_CONNECTION (connection));
 	g_object_unref (connection);
 
 	/* Emit changes _after_ removing the connection */
@@ -174,13 +195,21 @@ find_by_path (SettingsPluginIfcfg *self, const char *path)
 	return NULL;
 }
 
+/* update_connection:
+ * @parsed: (allow-none): the connection already read from @full_path,
+ *   see nm_ifcfg_connection_new(). Only valid without @source.
+ * @out_parsed: (allow-none): returns the connection read from @full_path
+ *   if it can be cached, see nm_ifcfg_connection_new().
+ */
 static NMIfcfgConnection *
 update_connection (SettingsPluginIfcfg *self,
                    NMConnection *source,
+                   NMConnection *parsed,
                    const char *full_path,
                    NMIfcfgConnection *connection,
                    gboolean protect_existing_connection,
                    GHashTable *protected_connections,
+                   NMConnection **out_parsed,
                    GError **error)
 {
 	SettingsPluginIfcfgPrivate *priv = SETTINGS_PLUGIN_IFCFG_GET_PRIVATE (self);
@@ -201,7 +230,7 @@ update_connection (SettingsPluginIfcfg *self,
 
 	/* Create a NMIfcfgConnection instance, either by reading from @full_path or
 	 * based on @source. */
-	connection_new = nm_ifcfg_connection_new (source, full_path, &local, &ignore_error);
+	connection_new = nm_ifcfg_connection_new (source, parsed, full_path, out_parsed, &local, &ignore_error);
 	if (!connection_new) {
 		/* Unexpected failure. Probably the file is invalid? */
 		if (   connection
@@ -420,7 +449,7 @@ ifcfg_dir_changed (GFileMonitor *monitor,
 		case G_FILE_MONITOR_EVENT_CREATED:
 		case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
 			/* Update or new */
-			update_connection (plugin, NULL, ifcfg_path, connection, TRUE, NULL, NULL);
+			update_connection (plugin, NULL, NULL, ifcfg_path, connection, TRUE, NULL, NULL, NULL);
 			break;
 		default:
 			break;
@@ -485,6 +514,59 @@ _sort_paths (const char **f1, const char **f2, GHashTable *paths)
 	return strcmp (*f1, *f2);
 }
 
+/* Adds @item, an entry of IFCFG_DIR, to the alias files of each ifcfg
+ * file it may belong to, see utils_is_ifcfg_alias_file(). */
+static void
+_aliases_add (GHashTable *aliases, const char *item)
+{
+	const char *p;
+	GPtrArray *files;
+
+	if (!utils_is_ifcfg_alias_file (item, NULL))
+		return;
+
+	for (p = strchr (item, ':'); p; p = strchr (p + 1, ':')) {
+		char *ifcfg = g_strndup (item, p - item);
+
+		files = g_hash_table_lookup (aliases, ifcfg);
+		if (!files) {
+			files = g_ptr_array_new_with_free_func (g_free);
+			g_hash_table_insert (aliases, ifcfg, files);
+		} else
+			g_free (ifcfg);
+		g_ptr_array_add (files, g_build_filename (IFCFG_DIR, item, NULL));
+	}
+}
+
+/* Stamps the files that connection_from_file() reads for @path */
+static GVariant *
+_stamp_ifcfg (const char *path, GHashTable *aliases)
+{
+	GPtrArray *files, *alias_files;
+	gs_free char *base = NULL;
+	GVariant *stamp;
+	guint i;
+
+	files = g_ptr_array_new_with_free_func (g_free);
+	g_ptr_array_add (files, g_strdup (path));
+	g_ptr_array_add (files, utils_get_keys_path (path));
+	g_ptr_array_add (files, utils_get_route_path (path));
+	g_ptr_array_add (files, utils_get_route6_path (path));
+	g_ptr_array_add (files, g_strdup (SYSCONFDIR "/sysconfig/network"));
+
+	base = g_path_get_basename (path);
+	alias_files = g_hash_table_lookup (aliases, base);
+	if (alias_files) {
+		for (i = 0; i < alias_files->len; i++)
+			g_ptr_array_add (files, g_strdup (alias_files->pdata[i]));
+	}
+	g_ptr_array_add (files, NULL);
+
+	stamp = nm_settings_cache_stamp ((const char *const *) files->pdata);
+	g_ptr_array_free (files, TRUE);
+	return stamp;
+}
+
 static void
 read_connections (SettingsPluginIfcfg *plugin)
 {
@@ -499,6 +581,7 @@ read_connections (SettingsPluginIfcfg *plugin)
 	guint i;
 	GPtrArray *filenames;
 	GHashTable *paths;
+	GHashTable *aliases;
 
 	dir = g_dir_open (IFCFG_DIR, 0, &err);
 	if (!dir) {
@@ -510,6 +593,7 @@ read_connections (SettingsPluginIfcfg *plugin)
 	alive_connections = g_hash_table_new (NULL, NULL);
 
 	filenames = g_ptr_array_new_with_free_func (g_free);
+	aliases = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
 	while ((item = g_dir_read_name (dir))) {
 		char *full_path, *real_path;
 
@@ -519,6 +603,8 @@ read_connections (SettingsPluginIfcfg *plugin)
 		if (real_path)
 			g_ptr_array_add (filenames, real_path);
 		g_free (full_path);
+
+		_aliases_add (aliases, item);
 	}
 	g_dir_close (dir);
 
@@ -532,12 +618,33 @@ read_connections (SettingsPluginIfcfg *plugin)
 	g_ptr_array_sort_with_data (filenames, (GCompareDataFunc) _sort_paths, paths);
 	g_hash_table_destroy (paths);
 
+	/* Take the connections whose files did not change since the last
+	 * time from the cache instead of parsing them again. */
+	if (!priv->cache)
+		priv->cache = nm_settings_cache_new (IFCFG_CACHE_FILE);
 	for (i = 0; i < filenames->len; i++) {
-		connection = update_connection (plugin, NULL, filenames->pdata[i], NULL, FALSE, alive_connections, NULL);
+		const char *path = filenames->pdata[i];
+		gs_unref_variant GVariant *stamp = NULL;
+		gs_unref_object NMConnection *cached = NULL;
+		gs_unref_object NMConnection *parsed = NULL;
+
+		stamp = _stamp_ifcfg (path, aliases);
+		cached = nm_settings_cache_lookup (priv->cache, path, stamp);
+
+		connection = update_connection (plugin, NULL, cached, path, NULL, FALSE, alive_connections,
+		                                cached ? NULL : &parsed, NULL);
 		if (connection)
 			g_hash_table_add (alive_connections, connection);
+		if (parsed)
+			nm_settings_cache_add (priv->cache, path, stamp, parsed);
 	}
 	g_ptr_array_free (filenames, TRUE);
+	g_hash_table_destroy (aliases);
+
+	if (!nm_settings_cache_write (priv->cache, &err)) {
+		_LOGD ("cannot write connection cache: %s", err->message);
+		g_clear_error (&err);
+	}
 
 	g_hash_table_iter_init (&iter, priv->connections);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &connection)) {
@@ -604,7 +711,7 @@ load_connection (NMSettingsPlugin *config,
 		return FALSE;
 
 	connection = find_by_path (plugin, ifcfg_path);
-	update_connection (plugin, NULL, ifcfg_path, connection, TRUE, NULL, NULL);
+	update_connection (plugin, NULL, NULL, ifcfg_path, connection, TRUE, NULL, NULL, NULL);
 	if (!connection)
 		connection = find_by_path (plugin, ifcfg_path);
 
@@ -682,7 +789,7 @@ add_connection (NMSettingsPlugin *config,
 		if (!writer_new_connection (connection, IFCFG_DIR, &path, error))
 			return NULL;
 	}
-	return NM_SETTINGS_CONNECTION (update_connection (self, connection, path, NULL, FALSE, NULL, error));
+	return NM_SETTINGS_CONNECTION (update_connection (self, connection, NULL, path, NULL, FALSE, NULL, NULL, error));
 }
 
 static void
@@ -999,6 +1106,8 @@ dispose (GObject *object)
 		g_object_unref (priv->ifcfg_monitor);
 	}
 
+	g_clear_pointer (&priv->cache, nm_settings_cache_free);
+
 	G_OBJECT_CLASS (settings_plugin_ifcfg_parent_class)->dispose (object);
 }
 
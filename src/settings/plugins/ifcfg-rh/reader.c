@@ -4889,13 +4889,17 @@ check_dns_search_domains (shvarFile *ifcfg, NMSetting *s_ip4, NMSetting *s_ip6)
 	}
 }
 
+/* @out_cacheable: set to %FALSE if the result depends on more than the
+ * contents of the files, namely if the type was detected from the device
+ * or the device is unmanaged or of an unrecognized type. */
 static NMConnection *
 connection_from_file_full (const char *filename,
                            const char *network_file,  /* for unit tests only */
                            const char *test_type,     /* for unit tests only */
                            char **out_unhandled,
                            GError **error,
-                           gboolean *out_ignore_error)
+                           gboolean *out_ignore_error,
+                           gboolean *out_cacheable)
 {
 	NMConnection *connection = NULL;
 	shvarFile *parsed;
@@ -4908,6 +4912,9 @@ connection_from_file_full (const char *filename,
 	if (out_unhandled)
 		g_return_val_if_fail (*out_unhandled == NULL, NULL);
 
+	if (out_cacheable)
+		*out_cacheable = TRUE;
+
 	/* Non-NULL only for unit tests; normally use /etc/sysconfig/network */
 	if (!network_file)
 		network_file = SYSCONFDIR "/sysconfig/network";
@@ -4981,10 +4988,14 @@ connection_from_file_full (const char *filename,
 				type = g_strdup (TYPE_BOND);
 			else if (is_vlan_device (device, parsed))
 				type = g_strdup (TYPE_VLAN);
-			else if (is_wifi_device (device, parsed))
-				type = g_strdup (TYPE_WIRELESS);
-			else
-				type = g_strdup (TYPE_ETHERNET);
+			else {
+				if (out_cacheable)
+					*out_cacheable = FALSE;
+				if (is_wifi_device (device, parsed))
+					type = g_strdup (TYPE_WIRELESS);
+				else
+					type = g_strdup (TYPE_ETHERNET);
+			}
 		} else {
 			/* For the unit tests, there won't necessarily be any
 			 * adapters of the connection's type in the system so the
@@ -5085,6 +5096,8 @@ connection_from_file_full (const char *filename,
 
 done:
 	svCloseFile (parsed);
+	if (out_cacheable && out_unhandled && *out_unhandled)
+		*out_cacheable = FALSE;
 	return connection;
 }
 
@@ -5092,12 +5105,14 @@ NMConnection *
 connection_from_file (const char *filename,
                       char **out_unhandled,
                       GError **error,
-                      gboolean *out_ignore_error)
+                      gboolean *out_ignore_error,
+                      gboolean *out_cacheable)
 {
 	return connection_from_file_full (filename, NULL, NULL,
 	                                  out_unhandled,
 	                                  error,
-	                                  out_ignore_error);
+	                                  out_ignore_error,
+	                                  out_cacheable);
 }
 
 NMConnection *
@@ -5112,6 +5127,7 @@ connection_from_file_test (const char *filename,
 	                                  test_type,
 	                                  out_unhandled,
 	                                  error,
+	                                  NULL,
 	                                  NULL);
 }
 
@@ -29,7 +29,8 @@
 NMConnection *connection_from_file (const char *filename,
                                     char **out_unhandled,
                                     GError **error,
-                                    gboolean *out_ignore_error);
+                                    gboolean *out_ignore_error,
+                                    gboolean *out_cacheable);
 
 char *uuid_from_file (const char *filename);
 
@@ -54,6 +54,7 @@
 #include "reader.h"
 #include "writer.h"
 #include "utils.h"
+#include "nm-settings-cache.h"
 #include "nm-default.h"
 
 #include "nm-test-utils.h"
@@ -13089,6 +13090,80 @@ test_read_vlan_trailing_spaces (void)
 
 #define DEFAULT_HEX_PSK "7d308b11df1b4243b0f78e5f3fc68cdbb9a264ed0edf4c188edf329ff5b467f0"
 
+#define TEST_CACHE_FILE TEST_SCRATCH_DIR "ifcfg-rh-connections.cache"
+
+static GVariant *
+_cache_stamp (const char *path)
+{
+	gs_free char *keys = utils_get_keys_path (path);
+	gs_free char *route = utils_get_route_path (path);
+	gs_free char *route6 = utils_get_route6_path (path);
+	const char *files[] = { path, keys, route, route6, NULL };
+
+	return nm_settings_cache_stamp (files);
+}
+
+static void
+test_read_connection_cache (void)
+{
+	static const struct {
+		const char *path;
+		const char *type;
+	} files[] = {
+		{ TEST_IFCFG_WIRED_STATIC, TYPE_ETHERNET },
+		{ TEST_IFCFG_WIFI_WPA_PSK, TYPE_WIRELESS },
+		{ TEST_IFCFG_WIRED_8021X_TLS_AGENT, TYPE_ETHERNET },
+		{ TEST_IFCFG_ALIASES_GOOD, TYPE_ETHERNET },
+		{ TEST_IFCFG_DIR"/network-scripts/ifcfg-test-vlan-physdev", TYPE_ETHERNET },
+		{ TEST_IFCFG_DIR"/network-scripts/ifcfg-test-team-master", TYPE_ETHERNET },
+	};
+	NMSettingsCache *cache;
+	GError *error = NULL;
+	guint i;
+
+	unlink (TEST_CACHE_FILE);
+
+	cache = nm_settings_cache_new (TEST_CACHE_FILE);
+	for (i = 0; i < G_N_ELEMENTS (files); i++) {
+		gs_unref_variant GVariant *stamp = _cache_stamp (files[i].path);
+		gs_unref_object NMConnection *connection = NULL;
+
+		g_assert (!nm_settings_cache_lookup (cache, files[i].path, stamp));
+		connection = connection_from_file_test (files[i].path, NULL, files[i].type, NULL, &error);
+		g_assert_no_error (error);
+		nm_settings_cache_add (cache, files[i].path, stamp, connection);
+	}
+	g_assert (nm_settings_cache_write (cache, &error));
+	g_assert_no_error (error);
+	nm_settings_cache_free (cache);
+
+	/* Loading the cache again yields what the reader returns */
+	cache = nm_settings_cache_new (TEST_CACHE_FILE);
+	for (i = 0; i < G_N_ELEMENTS (files); i++) {
+		gs_unref_variant GVariant *stamp = _cache_stamp (files[i].path);
+		gs_unref_object NMConnection *cached = NULL;
+		gs_unref_object NMConnection *connection = NULL;
+
+		cached = nm_settings_cache_lookup (cache, files[i].path, stamp);
+		g_assert (cached);
+		connection = connection_from_file_test (files[i].path, NULL, files[i].type, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (nm_connection_compare (cached, connection, NM_SETTING_COMPARE_FLAG_EXACT));
+	}
+
+	/* A stamp of other files does not match */
+	{
+		gs_unref_variant GVariant *stamp = NULL;
+		const char *files_changed[] = { TEST_IFCFG_WIRED_STATIC, TEST_IFCFG_WIFI_WPA_PSK, NULL };
+
+		stamp = nm_settings_cache_stamp (files_changed);
+		g_assert (!nm_settings_cache_lookup (cache, TEST_IFCFG_WIRED_STATIC, stamp));
+	}
+
+	nm_settings_cache_free (cache);
+	unlink (TEST_CACHE_FILE);
+}
+
 #define TPATH "/settings/plugins/ifcfg-rh/"
 
 NMTST_DEFINE ();
@@ -13346,6 +13421,8 @@ int main (int argc, char **argv)
 	g_test_add_func (TPATH "team/write-port", test_write_team_port);
 	g_test_add_func (TPATH "team/read-port-empty-config", test_read_team_port_empty_config);
 
+	g_test_add_func (TPATH "cache/read", test_read_connection_cache);
+
 	/* Stuff we expect to fail for now */
 	test_write_wired_pppoe ();
 	test_write_vpn ();
@@ -37,8 +37,15 @@
 
 G_DEFINE_TYPE (NMKeyfileConnection, nm_keyfile_connection, NM_TYPE_SETTINGS_CONNECTION)
 
+/* nm_keyfile_connection_new:
+ * @source: if given, the connection to add from memory
+ * @parsed: if given, the connection the caller already read from @full_path
+ * @full_path: the keyfile, read if neither @source nor @parsed is given
+ * @error: error in case of failure
+ */
 NMKeyfileConnection *
 nm_keyfile_connection_new (NMConnection *source,
+                           NMConnection *parsed,
                            const char *full_path,
                            GError **error)
 {
@@ -48,14 +55,19 @@ nm_keyfile_connection_new (NMConnection *source,
 	gboolean update_unsaved = TRUE;
 
 	g_assert (source || full_path);
+	g_assert (!source || !parsed);
 
 	/* If we're given a connection already, prefer that instead of re-reading */
 	if (source)
 		tmp = g_object_ref (source);
 	else {
-		tmp = nm_keyfile_plugin_connection_from_file (full_path, error);
-		if (!tmp)
-			return NULL;
+		if (parsed)
+			tmp = g_object_ref (parsed);
+		else {
+			tmp = nm_keyfile_plugin_connection_from_file (full_path, error);
+			if (!tmp)
+				return NULL;
+		}
 
 		uuid = nm_connection_get_uuid (NM_CONNECTION (tmp));
 		if (!uuid) {
@@ -44,6 +44,7 @@ typedef struct {
 GType nm_keyfile_connection_get_type (void);
 
 NMKeyfileConnection *nm_keyfile_connection_new (NMConnection *source,
+                                                NMConnection *parsed,
                                                 const char *filename,
                                                 GError **error);
 
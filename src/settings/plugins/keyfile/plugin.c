@@ -39,7 +39,9 @@
 
 #include "plugin.h"
 #include "nm-settings-plugin.h"
+#include "nm-settings-cache.h"
 #include "nm-keyfile-connection.h"
+#include "reader.h"
 #include "writer.h"
 #include "utils.h"
 
@@ -51,6 +53,8 @@ G_DEFINE_TYPE_EXTENDED (SettingsPluginKeyfile, settings_plugin_keyfile, G_TYPE_O
 
 #define SETTINGS_PLUGIN_KEYFILE_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), SETTINGS_TYPE_PLUGIN_KEYFILE, SettingsPluginKeyfilePrivate))
 
+#define KEYFILE_CACHE_FILE NMSTATEDIR "/keyfile-connections.cache"
+
 typedef struct {
 	GHashTable *connections;  /* uuid::connection */
 
@@ -59,11 +63,26 @@ typedef struct {
 	guint monitor_id;
 
 	NMConfig *config;
+
+	/* loaded on the first read of the connections */
+	NMSettingsCache *cache;
 } SettingsPluginKeyfilePrivate;
 
+/* The cache includes secrets, don't keep them for removed connections */
+static void
+cache_remove_connection (SettingsPluginKeyfile *self, NMSettingsConnection *connection)
+{
+	SettingsPluginKeyfilePrivate *priv = SETTINGS_PLUGIN_KEYFILE_GET_PRIVATE (self);
+	const char *path = nm_settings_connection_get_filename (connection);
+
+	if (priv->cache && path)
+		nm_settings_cache_remove (priv->cache, path);
+}
+
 static void
 connection_removed_cb (NMSettingsConnection *obj, gpointer user_data)
 {
+	cache_remove_connection (user_data, obj);
 	g_hash_table_remove (SETTINGS_PLUGIN_KEYFILE_GET_PRIVATE (user_data)->connections,
 	                     nm_connection_get_uuid (NM_CONNECTION (obj)));
 }
@@ -85,6 +104,7 @@ remove_connection (SettingsPluginKeyfile *self, NMKeyfileConnection *connection)
 	removed = g_hash_table_remove (SETTINGS_PLUGIN_KEYFILE_GET_PRIVATE (self)->connections,
 	                               nm_connection_get_uuid (NM_CONNECTION (connection)));
 	nm_settings_connection_signal_remove (NM_SETTINGS_CONNECTION (connection));
+	cache_remove_connection (self, NM_SETTINGS_CONNECTION (connection));
 	g_object_unref (connection);
 
 	g_return_if_fail (removed);
@@ -112,6 +132,8 @@ find_by_path (SettingsPluginKeyfile *self, const char *path)
  * @source: if %NULL, this re-reads the connection from @full_path
  *   and updates it. When passing @source, this adds a connection from
  *   memory.
+ * @parsed: (allow-none): the connection already read from @full_path,
+ *   to avoid reading it again. Only valid without @source.
  * @full_path: the filename of the keyfile to be loaded
  * @connection: an existing connection that might be updated.
  *   If given, @connection must be an existing connection that is currently
@@ -141,6 +163,7 @@ find_by_path (SettingsPluginKeyfile *self, const char *path)
 static NMKeyfileConnection *
 update_connection (SettingsPluginKeyfile *self,
                    NMConnection *source,
+                   NMConnection *parsed,
                    const char *full_path,
                    NMKeyfileConnection *connection,
                    gboolean protect_existing_connection,
@@ -159,7 +182,7 @@ update_connection (SettingsPluginKeyfile *self,
 	if (full_path)
 		nm_log_dbg (LOGD_SETTINGS, "keyfile: loading from file \"%s\"...", full_path);
 
-	connection_new = nm_keyfile_connection_new (source, full_path, &local);
+	connection_new = nm_keyfile_connection_new (source, parsed, full_path, &local);
 	if (!connection_new) {
 		/* Error; remove the connection */
 		if (source)
@@ -301,7 +324,7 @@ dir_changed (GFileMonitor *monitor,
 	case G_FILE_MONITOR_EVENT_CREATED:
 	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
 		if (exists)
-			update_connection (SETTINGS_PLUGIN_KEYFILE (config), NULL, full_path, connection, TRUE, NULL, NULL);
+			update_connection (SETTINGS_PLUGIN_KEYFILE (config), NULL, NULL, full_path, connection, TRUE, NULL, NULL);
 		break;
 	default:
 		break;
@@ -387,6 +410,100 @@ _sort_paths (const char **f1, const char **f2, GHashTable *paths)
 	return strcmp (*f1, *f2);
 }
 
+/* Below that many files, starting the threads costs more than it saves */
+#define PARSE_PARALLEL_MIN_FILES 32
+#define PARSE_MAX_THREADS        8
+
+typedef struct {
+	const char *path;
+	GVariant *stamp;
+	NMConnection *connection;
+	gboolean cached;
+	GPtrArray *warnings;
+	GError *error;
+} ParseData;
+
+static void
+parse_file_thread (gpointer data, gpointer user_data)
+{
+	ParseData *parse = data;
+
+	parse->connection = nm_keyfile_plugin_connection_from_file_full (parse->path, &parse->warnings, &parse->error);
+}
+
+/* Takes the connections of @filenames that did not change from @cache and
+ * reads and parses the others, in a pool of worker threads if there are
+ * enough of them, and waits until all are done. Returns the results in the
+ * order of @filenames. */
+static ParseData *
+parse_files (GPtrArray *filenames, NMSettingsCache *cache)
+{
+	ParseData *parsed;
+	GThreadPool *pool = NULL;
+	GError *error = NULL;
+	long n_threads = 0;
+	guint i, n_changed = 0;
+
+	parsed = g_new0 (ParseData, filenames->len);
+	for (i = 0; i < filenames->len; i++) {
+		const char *files[] = { filenames->pdata[i], NULL };
+
+		parsed[i].path = filenames->pdata[i];
+		parsed[i].stamp = nm_settings_cache_stamp (files);
+		parsed[i].connection = nm_settings_cache_lookup (cache, parsed[i].path, parsed[i].stamp);
+		if (parsed[i].connection)
+			parsed[i].cached = TRUE;
+		else
+			n_changed++;
+	}
+
+	if (n_changed >= PARSE_PARALLEL_MIN_FILES) {
+		n_threads = MIN (sysconf (_SC_NPROCESSORS_ONLN), PARSE_MAX_THREADS);
+		if (n_threads >= 2) {
+			nm_keyfile_plugin_reader_init_threads ();
+
+			pool = g_thread_pool_new (parse_file_thread, NULL, n_threads, TRUE, &error);
+			if (!pool) {
+				nm_log_warn (LOGD_SETTINGS, "keyfile: cannot start threads to read connections: %s",
+				             error->message);
+				g_clear_error (&error);
+			}
+		}
+	}
+
+	for (i = 0; i < filenames->len; i++) {
+		if (parsed[i].cached)
+			continue;
+		if (pool)
+			g_thread_pool_push (pool, &parsed[i], NULL);
+		else
+			parse_file_thread (&parsed[i], NULL);
+	}
+
+	if (pool) {
+		g_thread_pool_free (pool, FALSE, TRUE);
+		nm_log_dbg (LOGD_SETTINGS, "keyfile: parsed %u files in %ld threads", n_changed, n_threads);
+	}
+	nm_log_dbg (LOGD_SETTINGS, "keyfile: took %u of %u connections from the cache",
+	            filenames->len - n_changed, filenames->len);
+	return parsed;
+}
+
+static void
+parse_files_free (ParseData *parsed, guint len)
+{
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		g_variant_unref (parsed[i].stamp);
+		g_clear_object (&parsed[i].connection);
+		if (parsed[i].warnings)
+			g_ptr_array_unref (parsed[i].warnings);
+		g_clear_error (&parsed[i].error);
+	}
+	g_free (parsed);
+}
+
 static void
 read_connections (NMSettingsPlugin *config)
 {
@@ -402,6 +519,7 @@ read_connections (NMSettingsPlugin *config)
 	guint i;
 	GPtrArray *filenames;
 	GHashTable *paths;
+	ParseData *parsed;
 
 	dir = g_dir_open (nm_keyfile_plugin_get_path (), 0, &error);
 	if (!dir) {
@@ -433,13 +551,33 @@ read_connections (NMSettingsPlugin *config)
 	g_ptr_array_sort_with_data (filenames, (GCompareDataFunc) _sort_paths, paths);
 	g_hash_table_destroy (paths);
 
+	/* Parsing dominates with many files; skip the files that did not
+	 * change since the last time, parse the others concurrently and then
+	 * add the connections in the order from above. */
+	if (!priv->cache)
+		priv->cache = nm_settings_cache_new (KEYFILE_CACHE_FILE);
+	parsed = parse_files (filenames, priv->cache);
+
 	for (i = 0; i < filenames->len; i++) {
-		connection = update_connection (self, NULL, filenames->pdata[i], NULL, FALSE, alive_connections, NULL);
+		/* If parsing failed, update_connection() reads the file again
+		 * to log the error and remove a connection that was loaded from it. */
+		if (parsed[i].connection && !parsed[i].cached) {
+			nm_keyfile_plugin_log_warnings (parsed[i].warnings);
+			nm_settings_cache_add (priv->cache, parsed[i].path, parsed[i].stamp, parsed[i].connection);
+		}
+
+		connection = update_connection (self, NULL, parsed[i].connection, filenames->pdata[i], NULL, FALSE, alive_connections, NULL);
 		if (connection)
 			g_hash_table_add (alive_connections, connection);
 	}
+	parse_files_free (parsed, filenames->len);
 	g_ptr_array_free (filenames, TRUE);
 
+	if (!nm_settings_cache_write (priv->cache, &error)) {
+		nm_log_dbg (LOGD_SETTINGS, "keyfile: cannot write connection cache: %s", error->message);
+		g_clear_error (&error);
+	}
+
 	g_hash_table_iter_init (&iter, priv->connections);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &connection)) {
 		if (   !g_hash_table_contains (alive_connections, connection)
@@ -489,7 +627,7 @@ load_connection (NMSettingsPlugin *config,
 	if (nm_keyfile_plugin_utils_should_ignore_file (filename + dir_len + 1))
 		return FALSE;
 
-	connection = update_connection (self, NULL, filename, find_by_path (self, filename), TRUE, NULL, NULL);
+	connection = update_connection (self, NULL, NULL, filename, find_by_path (self, filename), TRUE, NULL, NULL);
 
 	return (connection != NULL);
 }
@@ -513,7 +651,7 @@ add_connection (NMSettingsPlugin *config,
 		if (!nm_keyfile_plugin_write_connection (connection, NULL, FALSE, &path, error))
 			return NULL;
 	}
-	return NM_SETTINGS_CONNECTION (update_connection (self, connection, path, NULL, FALSE, NULL, error));
+	return NM_SETTINGS_CONNECTION (update_connection (self, connection, NULL, path, NULL, FALSE, NULL, error));
 }
 
 static GSList *
@@ -604,6 +742,8 @@ dispose (GObject *object)
 		g_clear_object (&priv->config);
 	}
 
+	g_clear_pointer (&priv->cache, nm_settings_cache_free);
+
 	G_OBJECT_CLASS (settings_plugin_keyfile_parent_class)->dispose (object);
 }
 
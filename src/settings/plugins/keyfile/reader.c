@@ -26,8 +26,10 @@
 #include "reader.h"
 
 #include "nm-default.h"
+#include "nm-core-internal.h"
 #include "nm-keyfile-internal.h"
 #include "NetworkManagerUtils.h"
+#include "crypto.h"
 
 static const char *
 _fmt_warn (const char *group, NMSetting *setting, const char *property_name, const char *message, char **out_message)
@@ -54,6 +56,20 @@ _fmt_warn (const char *group, NMSetting *setting, const char *property_name, con
 		return message;
 }
 
+typedef struct {
+	NMLogLevel level;
+	char *message;
+} ReadWarning;
+
+static void
+read_warning_free (ReadWarning *warning)
+{
+	g_free (warning->message);
+	g_slice_free (ReadWarning, warning);
+}
+
+/* @user_data: if not %NULL, a #GPtrArray to collect the warnings in
+ * instead of logging them, see nm_keyfile_plugin_connection_from_file_full(). */
 static gboolean
 _handler_read (GKeyFile *keyfile,
                NMConnection *connection,
@@ -64,8 +80,10 @@ _handler_read (GKeyFile *keyfile,
 {
 	if (type == NM_KEYFILE_READ_TYPE_WARN) {
 		NMKeyfileReadTypeDataWarn *warn_data = type_data;
+		GPtrArray *warnings = user_data;
 		NMLogLevel level;
 		char *message_free = NULL;
+		const char *message;
 
 		if (warn_data->severity > NM_KEYFILE_WARN_SEVERITY_WARN)
 			level = LOGL_ERR;
@@ -76,18 +94,27 @@ _handler_read (GKeyFile *keyfile,
 		else
 			level = LOGL_INFO;
 
-		nm_log (level, LOGD_SETTINGS, "keyfile: %s",
-		        _fmt_warn (warn_data->group, warn_data->setting,
-		                   warn_data->property_name, warn_data->message,
-		                   &message_free));
+		message = _fmt_warn (warn_data->group, warn_data->setting,
+		                     warn_data->property_name, warn_data->message,
+		                     &message_free);
+		if (warnings) {
+			ReadWarning *warning = g_slice_new (ReadWarning);
+
+			warning->level = level;
+			warning->message = message_free ? message_free : g_strdup (message);
+			g_ptr_array_add (warnings, warning);
+			return TRUE;
+		}
+
+		nm_log (level, LOGD_SETTINGS, "keyfile: %s", message);
 		g_free (message_free);
 		return TRUE;
 	}
 	return FALSE;
 }
 
-NMConnection *
-nm_keyfile_plugin_connection_from_file (const char *filename, GError **error)
+static NMConnection *
+_connection_from_file (const char *filename, GPtrArray *warnings, GError **error)
 {
 	GKeyFile *key_file;
 	struct stat statbuf;
@@ -120,7 +147,7 @@ nm_keyfile_plugin_connection_from_file (const char *filename, GError **error)
 	if (!g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, error))
 		goto out;
 
-	connection = nm_keyfile_read (key_file, filename, NULL, _handler_read, NULL, error);
+	connection = nm_keyfile_read (key_file, filename, NULL, _handler_read, warnings, error);
 	if (!connection)
 		goto out;
 
@@ -139,3 +166,95 @@ out:
 	return connection;
 }
 
+NMConnection *
+nm_keyfile_plugin_connection_from_file (const char *filename, GError **error)
+{
+	return _connection_from_file (filename, NULL, error);
+}
+
+/**
+ * nm_keyfile_plugin_connection_from_file_full:
+ * @filename: the keyfile to read
+ * @out_warnings: (out): the warnings while reading @filename, to be
+ *   logged with nm_keyfile_plugin_log_warnings()
+ * @error: error in case of failure
+ *
+ * Like nm_keyfile_plugin_connection_from_file(), but doesn't log; it
+ * may be called from other threads after nm_keyfile_plugin_reader_init_threads().
+ *
+ * Returns: the normalized connection read from @filename
+ */
+NMConnection *
+nm_keyfile_plugin_connection_from_file_full (const char *filename,
+                                             GPtrArray **out_warnings,
+                                             GError **error)
+{
+	GPtrArray *warnings;
+
+	g_return_val_if_fail (out_warnings, NULL);
+
+	warnings = g_ptr_array_new_with_free_func ((GDestroyNotify) read_warning_free);
+	*out_warnings = warnings;
+	return _connection_from_file (filename, warnings, error);
+}
+
+void
+nm_keyfile_plugin_log_warnings (GPtrArray *warnings)
+{
+	guint i;
+
+	for (i = 0; warnings && i < warnings->len; i++) {
+		ReadWarning *warning = warnings->pdata[i];
+
+		nm_log (warning->level, LOGD_SETTINGS, "keyfile: %s", warning->message);
+	}
+}
+
+/**
+ * nm_keyfile_plugin_reader_init_threads:
+ *
+ * Initializes the state that reading keyfiles initializes lazily and
+ * without locking: the registry of setting types, the crypto library and
+ * the testing flags. Must be called on the main thread before calling
+ * nm_keyfile_plugin_connection_from_file_full() from other threads.
+ */
+void
+nm_keyfile_plugin_reader_init_threads (void)
+{
+	static gboolean initialized = FALSE;
+
+	if (initialized)
+		return;
+
+	g_type_ensure (NM_TYPE_SETTING_802_1X);
+	g_type_ensure (NM_TYPE_SETTING_ADSL);
+	g_type_ensure (NM_TYPE_SETTING_BLUETOOTH);
+	g_type_ensure (NM_TYPE_SETTING_BOND);
+	g_type_ensure (NM_TYPE_SETTING_BRIDGE);
+	g_type_ensure (NM_TYPE_SETTING_BRIDGE_PORT);
+	g_type_ensure (NM_TYPE_SETTING_CDMA);
+	g_type_ensure (NM_TYPE_SETTING_CONNECTION);
+	g_type_ensure (NM_TYPE_SETTING_DCB);
+	g_type_ensure (NM_TYPE_SETTING_GENERIC);
+	g_type_ensure (NM_TYPE_SETTING_GSM);
+	g_type_ensure (NM_TYPE_SETTING_INFINIBAND);
+	g_type_ensure (NM_TYPE_SETTING_IP4_CONFIG);
+	g_type_ensure (NM_TYPE_SETTING_IP6_CONFIG);
+	g_type_ensure (NM_TYPE_SETTING_OLPC_MESH);
+	g_type_ensure (NM_TYPE_SETTING_PPP);
+	g_type_ensure (NM_TYPE_SETTING_PPPOE);
+	g_type_ensure (NM_TYPE_SETTING_SERIAL);
+	g_type_ensure (NM_TYPE_SETTING_TEAM);
+	g_type_ensure (NM_TYPE_SETTING_TEAM_PORT);
+	g_type_ensure (NM_TYPE_SETTING_VLAN);
+	g_type_ensure (NM_TYPE_SETTING_VPN);
+	g_type_ensure (NM_TYPE_SETTING_WIMAX);
+	g_type_ensure (NM_TYPE_SETTING_WIRED);
+	g_type_ensure (NM_TYPE_SETTING_WIRELESS);
+	g_type_ensure (NM_TYPE_SETTING_WIRELESS_SECURITY);
+
+	crypto_init (NULL);
+	nm_utils_get_testing ();
+
+	initialized = TRUE;
+}
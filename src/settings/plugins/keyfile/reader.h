@@ -28,4 +28,12 @@
 
 NMConnection *nm_keyfile_plugin_connection_from_file (const char *filename, GError **error);
 
+void nm_keyfile_plugin_reader_init_threads (void);
+
+NMConnection *nm_keyfile_plugin_connection_from_file_full (const char *filename,
+                                                           GPtrArray **out_warnings,
+                                                           GError **error);
+
+void nm_keyfile_plugin_log_warnings (GPtrArray *warnings);
+
 #endif /* _KEYFILE_PLUGIN_READER_H */
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <string.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -34,6 +35,7 @@
 #include "reader.h"
 #include "writer.h"
 #include "utils.h"
+#include "nm-settings-cache.h"
 
 #include "nm-test-utils.h"
 
@@ -400,6 +402,56 @@ add_one_ip_route (NMSettingIPConfig *s_ip,
 	nm_ip_route_unref (route);
 }
 
+#define N_READ_THREADS 4
+
+typedef struct {
+	NMConnection *connection;
+	GPtrArray *warnings;
+} ReadThreadData;
+
+static void
+read_full_thread (gpointer data, gpointer user_data)
+{
+	ReadThreadData *read = data;
+	GError *error = NULL;
+
+	read->connection = nm_keyfile_plugin_connection_from_file_full (TEST_WIRED_FILE, &read->warnings, &error);
+	g_assert_no_error (error);
+}
+
+static void
+test_read_wired_connection_threads (void)
+{
+	gs_unref_object NMConnection *connection = NULL;
+	gs_unref_ptrarray GPtrArray *warnings = NULL;
+	ReadThreadData read[N_READ_THREADS * 4] = { { 0 } };
+	GThreadPool *pool;
+	GError *error = NULL;
+	guint i;
+
+	nm_keyfile_plugin_reader_init_threads ();
+
+	/* The warnings are returned instead of logged */
+	connection = nm_keyfile_plugin_connection_from_file_full (TEST_WIRED_FILE, &warnings, &error);
+	g_assert_no_error (error);
+	g_assert (connection);
+	g_assert_cmpint (warnings->len, ==, 14);
+
+	pool = g_thread_pool_new (read_full_thread, NULL, N_READ_THREADS, TRUE, &error);
+	g_assert_no_error (error);
+	for (i = 0; i < G_N_ELEMENTS (read); i++)
+		g_thread_pool_push (pool, &read[i], NULL);
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	for (i = 0; i < G_N_ELEMENTS (read); i++) {
+		g_assert (read[i].connection);
+		g_assert (nm_connection_compare (read[i].connection, connection, NM_SETTING_COMPARE_FLAG_EXACT));
+		g_assert_cmpint (read[i].warnings->len, ==, warnings->len);
+		g_object_unref (read[i].connection);
+		g_ptr_array_unref (read[i].warnings);
+	}
+}
+
 
 static void
 test_write_wired_connection (void)
@@ -3548,6 +3600,154 @@ test_nm_keyfile_plugin_utils_escape_filename (void)
 
 /*****************************************************************************/
 
+#define TEST_CACHE_FILE TEST_SCRATCH_DIR "/keyfile-connections.cache"
+
+static NMConnection *
+_cache_read_file (const char *filename)
+{
+	gs_unref_ptrarray GPtrArray *warnings = NULL;
+	NMConnection *connection;
+	GError *error = NULL;
+
+	/* Only the connection matters; collect the warnings instead of logging */
+	connection = nm_keyfile_plugin_connection_from_file_full (filename, &warnings, &error);
+	g_assert_no_error (error);
+	g_assert (connection);
+	return connection;
+}
+
+/* Whether the cache file has an up-to-date entry for @path */
+static gboolean
+_cache_file_has (const char *path)
+{
+	const char *stamp_files[] = { path, NULL };
+	gs_unref_variant GVariant *stamp = nm_settings_cache_stamp (stamp_files);
+	gs_unref_object NMConnection *cached = NULL;
+	NMSettingsCache *cache;
+
+	cache = nm_settings_cache_new (TEST_CACHE_FILE);
+	cached = nm_settings_cache_lookup (cache, path, stamp);
+	nm_settings_cache_free (cache);
+	return !!cached;
+}
+
+static void
+test_read_connection_cache (void)
+{
+	static const char *const files[] = {
+		TEST_WIRED_FILE,
+		TEST_WIRELESS_FILE,
+		TEST_GSM_FILE,
+		TEST_WIRED_TLS_NEW_FILE,
+		TEST_INFINIBAND_FILE,
+		TEST_BRIDGE_MAIN_FILE,
+		TEST_KEYFILES_DIR"/Test_Enum_Property",
+	};
+	const char *changed_file = TEST_SCRATCH_DIR "/Test_Cache_Changed";
+	NMSettingsCache *cache;
+	GError *error = NULL;
+	struct stat st;
+	guint i;
+
+	unlink (TEST_CACHE_FILE);
+
+	/* Fill the cache with what the reader returns */
+	cache = nm_settings_cache_new (TEST_CACHE_FILE);
+	for (i = 0; i < G_N_ELEMENTS (files); i++) {
+		const char *stamp_files[] = { files[i], NULL };
+		gs_unref_variant GVariant *stamp = nm_settings_cache_stamp (stamp_files);
+		gs_unref_object NMConnection *connection = NULL;
+
+		g_assert (!nm_settings_cache_lookup (cache, files[i], stamp));
+		connection = _cache_read_file (files[i]);
+		nm_settings_cache_add (cache, files[i], stamp, connection);
+	}
+	g_assert (nm_settings_cache_write (cache, &error));
+	g_assert_no_error (error);
+	nm_settings_cache_free (cache);
+
+	/* The cache holds secrets */
+	g_assert_cmpint (stat (TEST_CACHE_FILE, &st), ==, 0);
+	g_assert_cmpint (st.st_mode & 0777, ==, 0600);
+
+	/* ...and returns the same connections after loading it again */
+	cache = nm_settings_cache_new (TEST_CACHE_FILE);
+	for (i = 0; i < G_N_ELEMENTS (files); i++) {
+		const char *stamp_files[] = { files[i], NULL };
+		gs_unref_variant GVariant *stamp = nm_settings_cache_stamp (stamp_files);
+		gs_unref_object NMConnection *cached = NULL;
+		gs_unref_object NMConnection *connection = NULL;
+
+		cached = nm_settings_cache_lookup (cache, files[i], stamp);
+		g_assert (cached);
+		connection = _cache_read_file (files[i]);
+		g_assert (nm_connection_compare (cached, connection, NM_SETTING_COMPARE_FLAG_EXACT));
+	}
+
+	/* A changed file is a miss */
+	{
+		const char *stamp_files[] = { changed_file, NULL };
+		gs_unref_variant GVariant *stamp = NULL;
+		gs_unref_variant GVariant *stamp_changed = NULL;
+		gs_unref_object NMConnection *connection = NULL;
+		gs_unref_object NMConnection *cached = NULL;
+
+		g_assert (g_file_set_contents (changed_file, "[connection]\n", -1, &error));
+		g_assert_no_error (error);
+		stamp = nm_settings_cache_stamp (stamp_files);
+		connection = _cache_read_file (TEST_WIRED_FILE);
+		nm_settings_cache_add (cache, changed_file, stamp, connection);
+
+		cached = nm_settings_cache_lookup (cache, changed_file, stamp);
+		g_assert (cached);
+
+		g_assert (g_file_set_contents (changed_file, "[connection]\nid=changed\n", -1, &error));
+		g_assert_no_error (error);
+		stamp_changed = nm_settings_cache_stamp (stamp_files);
+		g_assert (!nm_settings_cache_lookup (cache, changed_file, stamp_changed));
+		unlink (changed_file);
+	}
+
+	g_assert (nm_settings_cache_write (cache, &error));
+	g_assert_no_error (error);
+	nm_settings_cache_free (cache);
+
+	/* Removing entries rewrites the file once without them, keeping the others */
+	cache = nm_settings_cache_new (TEST_CACHE_FILE);
+	g_assert (nm_settings_cache_remove (cache, TEST_WIRELESS_FILE));
+	g_assert (!nm_settings_cache_remove (cache, TEST_WIRELESS_FILE));
+	g_assert (nm_settings_cache_remove (cache, TEST_GSM_FILE));
+	g_assert (_cache_file_has (TEST_WIRELESS_FILE));
+	while (g_main_context_iteration (NULL, FALSE))
+		;
+	g_assert (!_cache_file_has (TEST_WIRELESS_FILE));
+	g_assert (!_cache_file_has (TEST_GSM_FILE));
+	nm_settings_cache_free (cache);
+
+	cache = nm_settings_cache_new (TEST_CACHE_FILE);
+	for (i = 0; i < G_N_ELEMENTS (files); i++) {
+		const char *stamp_files[] = { files[i], NULL };
+		gs_unref_variant GVariant *stamp = nm_settings_cache_stamp (stamp_files);
+		gs_unref_object NMConnection *cached = NULL;
+
+		cached = nm_settings_cache_lookup (cache, files[i], stamp);
+		if (!strcmp (files[i], TEST_WIRELESS_FILE) || !strcmp (files[i], TEST_GSM_FILE))
+			g_assert (!cached);
+		else
+			g_assert (cached);
+	}
+
+	/* ...and pending removals are written when the cache goes away */
+	g_assert (nm_settings_cache_remove (cache, TEST_WIRED_FILE));
+	nm_settings_cache_free (cache);
+
+	g_assert (!_cache_file_has (TEST_WIRED_FILE));
+	g_assert (_cache_file_has (TEST_INFINIBAND_FILE));
+	unlink (TEST_CACHE_FILE);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -3557,6 +3757,7 @@ int main (int argc, char **argv)
 
 	/* The tests */
 	g_test_add_func ("/keyfile/test_read_valid_wired_connection ", test_read_valid_wired_connection);
+	g_test_add_func ("/keyfile/test_read_wired_connection_threads", test_read_wired_connection_threads);
 	g_test_add_func ("/keyfile/test_write_wired_connection ", test_write_wired_connection);
 
 	g_test_add_func ("/keyfile/test_read_ip6_wired_connection ", test_read_ip6_wired_connection);
@@ -3622,6 +3823,8 @@ int main (int argc, char **argv)
 
 	g_test_add_func ("/keyfile/test_nm_keyfile_plugin_utils_escape_filename ", test_nm_keyfile_plugin_utils_escape_filename);
 
+	g_test_add_func ("/keyfile/test_read_connection_cache", test_read_connection_cache);
+
 	return g_test_run ();
 }
 
@@ -34,10 +34,25 @@
 #include "dhcp-protocol.h"
 #include "socket-util.h"
 
-int dhcp_network_bind_raw_socket(int index, union sockaddr_union *link,
-                                 uint32_t xid, const uint8_t *mac_addr,
-                                 size_t mac_addr_len, uint16_t arp_type);
 int dhcp_network_bind_udp_socket(be32_t address, uint16_t port);
+
+/* Packet sockets shared by all clients with the same hardware type. Replies
+   are dispatched by interface index and transaction id, so that running
+   many clients does not cost one socket, filter and event source each. */
+typedef struct DHCPRawListener DHCPRawListener;
+
+typedef int (*dhcp_raw_listener_cb_t)(DHCPRawListener *listener,
+                                      DHCPMessage *message, size_t len,
+                                      void *userdata);
+
+int dhcp_network_raw_listener_new(sd_event *event, int index,
+                                  union sockaddr_union *link, uint32_t xid,
+                                  const uint8_t *mac_addr, size_t mac_addr_len,
+                                  uint16_t arp_type, dhcp_raw_listener_cb_t cb,
+                                  void *userdata, DHCPRawListener **ret);
+DHCPRawListener *dhcp_network_raw_listener_free(DHCPRawListener *listener);
+int dhcp_network_raw_listener_get_fd(DHCPRawListener *listener);
+
 int dhcp_network_send_raw_socket(int s, const union sockaddr_union *link,
                                  const void *packet, size_t len);
 int dhcp_network_send_udp_socket(int s, be32_t address, uint16_t port,
@@ -67,6 +67,8 @@ struct sd_dhcp_lease {
         bool have_broadcast;
         be32_t broadcast;
 
+        bool rapid_commit;
+
         struct in_addr *dns;
         size_t dns_size;
 
@@ -25,20 +25,134 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <linux/filter.h>
 #include <linux/if_infiniband.h>
 #include <linux/if_packet.h>
 
+#include "alloc-util.h"
 #include "dhcp-internal.h"
 #include "fd-util.h"
+#include "hashmap.h"
 #include "socket-util.h"
 
-static int _bind_raw_socket(int ifindex, union sockaddr_union *link,
-                            uint32_t xid, const uint8_t *mac_addr,
-                            size_t mac_addr_len,
-                            const uint8_t *bcast_addr,
-                            const struct ether_addr *eth_mac,
-                            uint16_t arp_type, uint8_t dhcp_hlen) {
+int dhcp_network_bind_udp_socket(be32_t address, uint16_t port) {
+        union sockaddr_union src = {
+                .in.sin_family = AF_INET,
+                .in.sin_port = htobe16(port),
+                .in.sin_addr.s_addr = address,
+        };
+        _cleanup_close_ int s = -1;
+        int r, on = 1, tos = IPTOS_CLASS_CS6;
+
+        s = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (s < 0)
+                return -errno;
+
+        r = setsockopt(s, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+        if (r < 0)
+                return -errno;
+
+        r = setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (r < 0)
+                return -errno;
+
+        if (address == INADDR_ANY) {
+                r = setsockopt(s, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on));
+                if (r < 0)
+                        return -errno;
+
+                r = setsockopt(s, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+                if (r < 0)
+                        return -errno;
+        } else {
+                r = setsockopt(s, IPPROTO_IP, IP_FREEBIND, &on, sizeof(on));
+                if (r < 0)
+                        return -errno;
+        }
+
+        r = bind(s, &src.sa, sizeof(src.in));
+        if (r < 0)
+                return -errno;
+
+        r = s;
+        s = -1;
+
+        return r;
+}
+
+int dhcp_network_send_raw_socket(int s, const union sockaddr_union *link,
+                                 const void *packet, size_t len) {
+        int r;
+
+        assert(link);
+        assert(packet);
+        assert(len);
+
+        r = sendto(s, packet, len, 0, &link->sa, sizeof(link->ll));
+        if (r < 0)
+                return -errno;
+
+        return 0;
+}
+
+int dhcp_network_send_udp_socket(int s, be32_t address, uint16_t port,
+                                 const void *packet, size_t len) {
+        union sockaddr_union dest = {
+                .in.sin_family = AF_INET,
+                .in.sin_port = htobe16(port),
+                .in.sin_addr.s_addr = address,
+        };
+        int r;
+
+        assert(s >= 0);
+        assert(packet);
+        assert(len);
+
+        r = sendto(s, packet, len, 0, &dest.sa, sizeof(dest.in));
+        if (r < 0)
+                return -errno;
+
+        return 0;
+}
+
+/* Replies read per wakeup of a shared socket before going back to the
+   event loop. */
+#define DHCP_RAW_BATCH 64
+#define DHCP_RAW_BUFFER_SIZE 65536
+
+typedef struct DHCPRawSocket {
+        unsigned n_ref;
+        uint16_t arp_type;
+        int fd;
+        sd_event *event;
+        sd_event_source *receive_message;
+        Hashmap *listeners;
+        uint8_t *buf;
+} DHCPRawSocket;
+
+struct DHCPRawListener {
+        DHCPRawSocket *socket;
+        uint64_t key;
+        struct ether_addr eth_mac;
+        dhcp_raw_listener_cb_t cb;
+        void *userdata;
+};
+
+/* one for Ethernet, one for InfiniBand */
+static DHCPRawSocket *raw_sockets[2];
+
+static inline uint64_t raw_listener_key(int index, uint32_t xid) {
+        return ((uint64_t) (uint32_t) index << 32) | xid;
+}
+
+static DHCPRawSocket **raw_socket_slot(uint16_t arp_type) {
+        return &raw_sockets[arp_type == ARPHRD_INFINIBAND ? 1 : 0];
+}
+
+static int _open_shared_raw_socket(uint16_t arp_type, uint8_t dhcp_hlen) {
+        /* Same as the per-client filter, except that the transaction id
+           and the hardware address are checked when dispatching. */
         struct sock_filter filter[] = {
                 BPF_STMT(BPF_LD + BPF_W + BPF_LEN, 0),                                 /* A <- packet length */
                 BPF_JUMP(BPF_JMP + BPF_JGE + BPF_K, sizeof(DHCPPacket), 1, 0),         /* packet >= DHCPPacket ? */
@@ -66,21 +180,6 @@ static int _bind_raw_socket(int ifindex, union sockaddr_union *link,
                 BPF_STMT(BPF_LD + BPF_B + BPF_ABS, offsetof(DHCPPacket, dhcp.hlen)),   /* A <- MAC address length */
                 BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, dhcp_hlen, 1, 0),                  /* address length == dhcp_hlen ? */
                 BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
-                BPF_STMT(BPF_LD + BPF_W + BPF_ABS, offsetof(DHCPPacket, dhcp.xid)),    /* A <- client identifier */
-                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, xid, 1, 0),                        /* client identifier == xid ? */
-                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
-                BPF_STMT(BPF_LD + BPF_IMM, htobe32(*((unsigned int *) eth_mac))),                     /* A <- 4 bytes of client's MAC */
-                BPF_STMT(BPF_MISC + BPF_TAX, 0),                                                       /* X <- A */
-                BPF_STMT(BPF_LD + BPF_W + BPF_ABS, offsetof(DHCPPacket, dhcp.chaddr)),                 /* A <- 4 bytes of MAC from dhcp.chaddr */
-                BPF_STMT(BPF_ALU + BPF_XOR + BPF_X, 0),                                                /* A xor X */
-                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, 0, 1, 0),                                          /* A == 0 ? */
-                BPF_STMT(BPF_RET + BPF_K, 0),                                                          /* ignore */
-                BPF_STMT(BPF_LD + BPF_IMM, htobe16(*((unsigned short *) (((char *) eth_mac) + 4)))),   /* A <- remainder of client's MAC */
-                BPF_STMT(BPF_MISC + BPF_TAX, 0),                                                       /* X <- A */
-                BPF_STMT(BPF_LD + BPF_H + BPF_ABS, offsetof(DHCPPacket, dhcp.chaddr) + 4),             /* A <- remainder of MAC from dhcp.chaddr */
-                BPF_STMT(BPF_ALU + BPF_XOR + BPF_X, 0),                                                /* A xor X */
-                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, 0, 1, 0),                                          /* A == 0 ? */
-                BPF_STMT(BPF_RET + BPF_K, 0),                                                          /* ignore */
                 BPF_STMT(BPF_LD + BPF_W + BPF_ABS, offsetof(DHCPPacket, dhcp.magic)),  /* A <- DHCP magic cookie */
                 BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, DHCP_MAGIC_COOKIE, 1, 0),          /* cookie == DHCP magic cookie ? */
                 BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
@@ -90,12 +189,15 @@ static int _bind_raw_socket(int ifindex, union sockaddr_union *link,
                 .len = ELEMENTSOF(filter),
                 .filter = filter
         };
+        union sockaddr_union link = {
+                .ll.sll_family = AF_PACKET,
+                .ll.sll_protocol = htons(ETH_P_IP),
+                /* all interfaces */
+                .ll.sll_ifindex = 0,
+        };
         _cleanup_close_ int s = -1;
         int r, on = 1;
 
-        assert(ifindex > 0);
-        assert(link);
-
         s = socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
         if (s < 0)
                 return -errno;
@@ -108,14 +210,7 @@ static int _bind_raw_socket(int ifindex, union sockaddr_union *link,
         if (r < 0)
                 return -errno;
 
-        link->ll.sll_family = AF_PACKET;
-        link->ll.sll_protocol = htons(ETH_P_IP);
-        link->ll.sll_ifindex = ifindex;
-        link->ll.sll_hatype = htons(arp_type);
-        link->ll.sll_halen = mac_addr_len;
-        memcpy(link->ll.sll_addr, bcast_addr, mac_addr_len);
-
-        r = bind(s, &link->sa, sizeof(link->ll));
+        r = bind(s, &link.sa, sizeof(link.ll));
         if (r < 0)
                 return -errno;
 
@@ -125,9 +220,176 @@ static int _bind_raw_socket(int ifindex, union sockaddr_union *link,
         return r;
 }
 
-int dhcp_network_bind_raw_socket(int ifindex, union sockaddr_union *link,
-                                 uint32_t xid, const uint8_t *mac_addr,
-                                 size_t mac_addr_len, uint16_t arp_type) {
+static void raw_socket_unref(DHCPRawSocket *rs) {
+        if (!rs)
+                return;
+
+        assert(rs->n_ref >= 1);
+        rs->n_ref--;
+
+        if (rs->n_ref > 0)
+                return;
+
+        if (*raw_socket_slot(rs->arp_type) == rs)
+                *raw_socket_slot(rs->arp_type) = NULL;
+
+        rs->receive_message = sd_event_source_unref(rs->receive_message);
+        rs->fd = asynchronous_close(rs->fd);
+        sd_event_unref(rs->event);
+        hashmap_free(rs->listeners);
+        free(rs->buf);
+        free(rs);
+}
+
+static void raw_socket_dispatch(DHCPRawSocket *rs, size_t len,
+                                const struct sockaddr_ll *sll, bool checksum) {
+        DHCPPacket *packet = (DHCPPacket *) rs->buf;
+        DHCPRawListener *listener;
+        uint64_t key;
+        int r;
+
+        if (len < sizeof(DHCPPacket))
+                return;
+
+        /* our own requests on their way out */
+        if (sll->sll_pkttype == PACKET_OUTGOING)
+                return;
+
+        key = raw_listener_key(sll->sll_ifindex, be32toh(packet->dhcp.xid));
+        listener = hashmap_get(rs->listeners, &key);
+        if (!listener)
+                return;
+
+        if (memcmp(packet->dhcp.chaddr, &listener->eth_mac, ETH_ALEN) != 0)
+                return;
+
+        r = dhcp_packet_verify_headers(packet, len, checksum);
+        if (r < 0)
+                return;
+
+        /* the listener may be freed from the callback */
+        listener->cb(listener, &packet->dhcp, len - DHCP_IP_UDP_SIZE,
+                     listener->userdata);
+}
+
+static int raw_socket_receive_message(sd_event_source *s, int fd,
+                                      uint32_t revents, void *userdata) {
+        DHCPRawSocket *rs = userdata;
+        unsigned i;
+
+        assert(rs);
+
+        /* keep the socket and its buffer around while listeners go away */
+        rs->n_ref++;
+
+        for (i = 0; i < DHCP_RAW_BATCH && rs->n_ref > 1; i++) {
+                uint8_t cmsgbuf[CMSG_LEN(sizeof(struct tpacket_auxdata))];
+                union sockaddr_union sa = {};
+                struct iovec iov = {
+                        .iov_base = rs->buf,
+                        .iov_len = DHCP_RAW_BUFFER_SIZE,
+                };
+                struct msghdr msg = {
+                        .msg_name = &sa,
+                        .msg_namelen = sizeof(sa.ll),
+                        .msg_iov = &iov,
+                        .msg_iovlen = 1,
+                        .msg_control = cmsgbuf,
+                        .msg_controllen = sizeof(cmsgbuf),
+                };
+                struct cmsghdr *cmsg;
+                bool checksum = true;
+                ssize_t len;
+
+                len = recvmsg(fd, &msg, MSG_DONTWAIT);
+                if (len < 0) {
+                        if (errno != EAGAIN && errno != EINTR)
+                                log_debug("DHCP: could not receive message from shared raw socket: %m");
+                        break;
+                }
+
+                if (msg.msg_flags & MSG_TRUNC)
+                        continue;
+
+                CMSG_FOREACH(cmsg, &msg) {
+                        if (cmsg->cmsg_level == SOL_PACKET &&
+                            cmsg->cmsg_type == PACKET_AUXDATA &&
+                            cmsg->cmsg_len == CMSG_LEN(sizeof(struct tpacket_auxdata))) {
+                                struct tpacket_auxdata *aux = (struct tpacket_auxdata*)CMSG_DATA(cmsg);
+
+                                checksum = !(aux->tp_status & TP_STATUS_CSUMNOTREADY);
+                                break;
+                        }
+                }
+
+                raw_socket_dispatch(rs, len, &sa.ll, checksum);
+        }
+
+        raw_socket_unref(rs);
+
+        /* errors of individual clients must not remove the shared source */
+        return 0;
+}
+
+static int raw_socket_get(sd_event *event, uint16_t arp_type, uint8_t dhcp_hlen,
+                          DHCPRawSocket **ret) {
+        DHCPRawSocket **slot = raw_socket_slot(arp_type);
+        DHCPRawSocket *rs;
+        int r;
+
+        if (*slot) {
+                if ((*slot)->event != event)
+                        return -EINVAL;
+
+                (*slot)->n_ref++;
+                *ret = *slot;
+                return 0;
+        }
+
+        rs = new0(DHCPRawSocket, 1);
+        if (!rs)
+                return -ENOMEM;
+
+        rs->n_ref = 1;
+        rs->arp_type = arp_type;
+        rs->fd = -1;
+        rs->event = sd_event_ref(event);
+
+        rs->buf = malloc(DHCP_RAW_BUFFER_SIZE);
+        rs->listeners = hashmap_new(&uint64_hash_ops);
+        if (!rs->buf || !rs->listeners) {
+                r = -ENOMEM;
+                goto fail;
+        }
+
+        r = _open_shared_raw_socket(arp_type, dhcp_hlen);
+        if (r < 0)
+                goto fail;
+        rs->fd = r;
+
+        r = sd_event_add_io(event, &rs->receive_message, rs->fd, EPOLLIN,
+                            raw_socket_receive_message, rs);
+        if (r < 0)
+                goto fail;
+
+        r = sd_event_source_set_description(rs->receive_message, "dhcp4-shared-receive-message");
+        if (r < 0)
+                goto fail;
+
+        *slot = rs;
+        *ret = rs;
+        return 0;
+
+fail:
+        raw_socket_unref(rs);
+        return r;
+}
+
+int dhcp_network_raw_listener_new(sd_event *event, int index,
+                                  union sockaddr_union *link, uint32_t xid,
+                                  const uint8_t *mac_addr, size_t mac_addr_len,
+                                  uint16_t arp_type, dhcp_raw_listener_cb_t cb,
+                                  void *userdata, DHCPRawListener **ret) {
         static const uint8_t eth_bcast[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
         /* Default broadcast address for IPoIB */
         static const uint8_t ib_bcast[] = {
@@ -135,103 +397,82 @@ int dhcp_network_bind_raw_socket(int ifindex, union sockaddr_union *link,
                 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
                 0xff, 0xff, 0xff, 0xff
           };
-        struct ether_addr eth_mac = { { 0, 0, 0, 0, 0, 0 } };
+        DHCPRawListener *listener;
         const uint8_t *bcast_addr = NULL;
         uint8_t dhcp_hlen = 0;
+        int r;
 
+        assert_return(index > 0, -EINVAL);
+        assert_return(link, -EINVAL);
         assert_return(mac_addr_len > 0, -EINVAL);
+        assert_return(cb, -EINVAL);
+        assert_return(ret, -EINVAL);
+
+        listener = new0(DHCPRawListener, 1);
+        if (!listener)
+                return -ENOMEM;
 
         if (arp_type == ARPHRD_ETHER) {
-                assert_return(mac_addr_len == ETH_ALEN, -EINVAL);
-                memcpy(&eth_mac, mac_addr, ETH_ALEN);
+                if (mac_addr_len != ETH_ALEN) {
+                        free(listener);
+                        return -EINVAL;
+                }
+                memcpy(&listener->eth_mac, mac_addr, ETH_ALEN);
                 bcast_addr = eth_bcast;
                 dhcp_hlen = ETH_ALEN;
         } else if (arp_type == ARPHRD_INFINIBAND) {
-                assert_return(mac_addr_len == INFINIBAND_ALEN, -EINVAL);
+                if (mac_addr_len != INFINIBAND_ALEN) {
+                        free(listener);
+                        return -EINVAL;
+                }
                 bcast_addr = ib_bcast;
-        } else
+        } else {
+                free(listener);
                 return -EINVAL;
+        }
 
-        return _bind_raw_socket(ifindex, link, xid, mac_addr, mac_addr_len,
-                                bcast_addr, &eth_mac, arp_type, dhcp_hlen);
-}
-
-int dhcp_network_bind_udp_socket(be32_t address, uint16_t port) {
-        union sockaddr_union src = {
-                .in.sin_family = AF_INET,
-                .in.sin_port = htobe16(port),
-                .in.sin_addr.s_addr = address,
-        };
-        _cleanup_close_ int s = -1;
-        int r, on = 1, tos = IPTOS_CLASS_CS6;
-
-        s = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
-        if (s < 0)
-                return -errno;
-
-        r = setsockopt(s, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
-        if (r < 0)
-                return -errno;
-
-        r = setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
-        if (r < 0)
-                return -errno;
-
-        if (address == INADDR_ANY) {
-                r = setsockopt(s, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on));
-                if (r < 0)
-                        return -errno;
+        listener->key = raw_listener_key(index, xid);
+        listener->cb = cb;
+        listener->userdata = userdata;
 
-                r = setsockopt(s, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
-                if (r < 0)
-                        return -errno;
-        } else {
-                r = setsockopt(s, IPPROTO_IP, IP_FREEBIND, &on, sizeof(on));
-                if (r < 0)
-                        return -errno;
+        r = raw_socket_get(event, arp_type, dhcp_hlen, &listener->socket);
+        if (r < 0) {
+                free(listener);
+                return r;
         }
 
-        r = bind(s, &src.sa, sizeof(src.in));
-        if (r < 0)
-                return -errno;
+        r = hashmap_put(listener->socket->listeners, &listener->key, listener);
+        if (r < 0) {
+                raw_socket_unref(listener->socket);
+                free(listener);
+                return r;
+        }
 
-        r = s;
-        s = -1;
+        /* where to send requests to */
+        link->ll.sll_family = AF_PACKET;
+        link->ll.sll_protocol = htons(ETH_P_IP);
+        link->ll.sll_ifindex = index;
+        link->ll.sll_hatype = htons(arp_type);
+        link->ll.sll_halen = mac_addr_len;
+        memcpy(link->ll.sll_addr, bcast_addr, mac_addr_len);
 
-        return r;
+        *ret = listener;
+        return 0;
 }
 
-int dhcp_network_send_raw_socket(int s, const union sockaddr_union *link,
-                                 const void *packet, size_t len) {
-        int r;
+DHCPRawListener *dhcp_network_raw_listener_free(DHCPRawListener *listener) {
+        if (!listener)
+                return NULL;
 
-        assert(link);
-        assert(packet);
-        assert(len);
+        hashmap_remove(listener->socket->listeners, &listener->key);
+        raw_socket_unref(listener->socket);
+        free(listener);
 
-        r = sendto(s, packet, len, 0, &link->sa, sizeof(link->ll));
-        if (r < 0)
-                return -errno;
-
-        return 0;
+        return NULL;
 }
 
-int dhcp_network_send_udp_socket(int s, be32_t address, uint16_t port,
-                                 const void *packet, size_t len) {
-        union sockaddr_union dest = {
-                .in.sin_family = AF_INET,
-                .in.sin_port = htobe16(port),
-                .in.sin_addr.s_addr = address,
-        };
-        int r;
-
-        assert(s >= 0);
-        assert(packet);
-        assert(len);
-
-        r = sendto(s, packet, len, 0, &dest.sa, sizeof(dest.in));
-        if (r < 0)
-                return -errno;
+int dhcp_network_raw_listener_get_fd(DHCPRawListener *listener) {
+        assert_return(listener, -EINVAL);
 
-        return 0;
+        return listener->socket->fd;
 }
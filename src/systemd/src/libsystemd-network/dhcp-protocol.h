@@ -139,6 +139,7 @@ enum {
         DHCP_OPTION_REBINDING_T2_TIME           = 59,
         DHCP_OPTION_VENDOR_CLASS_IDENTIFIER     = 60,
         DHCP_OPTION_CLIENT_IDENTIFIER           = 61,
+        DHCP_OPTION_RAPID_COMMIT                = 80,
         DHCP_OPTION_FQDN                        = 81,
         DHCP_OPTION_NEW_POSIX_TIMEZONE          = 100,
         DHCP_OPTION_NEW_TZDB_TIMEZONE           = 101,
@@ -56,7 +56,9 @@ struct sd_dhcp_client {
         int fd;
         union sockaddr_union link;
         sd_event_source *receive_message;
+        DHCPRawListener *raw_listener;
         bool request_broadcast;
+        bool rapid_commit;
         uint8_t *req_opts;
         size_t req_opts_allocated;
         size_t req_opts_size;
@@ -113,8 +115,9 @@ static const uint8_t default_req_opts[] = {
         DHCP_OPTION_DOMAIN_NAME_SERVER,
 };
 
-static int client_receive_message_raw(sd_event_source *s, int fd,
-                                      uint32_t revents, void *userdata);
+static int client_receive_message_raw(DHCPRawListener *listener,
+                                      DHCPMessage *message, size_t len,
+                                      void *userdata);
 static int client_receive_message_udp(sd_event_source *s, int fd,
                                       uint32_t revents, void *userdata);
 static void client_stop(sd_dhcp_client *client, int error);
@@ -137,6 +140,14 @@ int sd_dhcp_client_set_request_broadcast(sd_dhcp_client *client, int broadcast)
         return 0;
 }
 
+int sd_dhcp_client_set_rapid_commit(sd_dhcp_client *client, int rapid_commit) {
+        assert_return(client, -EINVAL);
+
+        client->rapid_commit = !!rapid_commit;
+
+        return 0;
+}
+
 int sd_dhcp_client_set_request_option(sd_dhcp_client *client, uint8_t option) {
         size_t i;
 
@@ -373,6 +384,8 @@ static int client_initialize(sd_dhcp_client *client) {
 
         client->fd = asynchronous_close(client->fd);
 
+        client->raw_listener = dhcp_network_raw_listener_free(client->raw_listener);
+
         client->timeout_resend = sd_event_source_unref(client->timeout_resend);
 
         client->timeout_t1 = sd_event_source_unref(client->timeout_t1);
@@ -569,8 +582,8 @@ static int dhcp_client_send_raw(sd_dhcp_client *client, DHCPPacket *packet,
         dhcp_packet_append_ip_headers(packet, INADDR_ANY, DHCP_PORT_CLIENT,
                                       INADDR_BROADCAST, DHCP_PORT_SERVER, len);
 
-        return dhcp_network_send_raw_socket(client->fd, &client->link,
-                                            packet, len);
+        return dhcp_network_send_raw_socket(dhcp_network_raw_listener_get_fd(client->raw_listener),
+                                            &client->link, packet, len);
 }
 
 static int client_send_discover(sd_dhcp_client *client) {
@@ -601,6 +614,14 @@ static int client_send_discover(sd_dhcp_client *client) {
                         return r;
         }
 
+        /* RFC 4039: let the server skip the OFFER/REQUEST exchange */
+        if (client->rapid_commit) {
+                r = dhcp_option_append(&discover->dhcp, optlen, &optoffset, 0,
+                                       DHCP_OPTION_RAPID_COMMIT, 0, NULL);
+                if (r < 0)
+                        return r;
+        }
+
         if (client->hostname) {
                 /* According to RFC 4702 "clients that send the Client FQDN option in
                    their messages MUST NOT also send the Host Name option". Just send
@@ -979,14 +1000,6 @@ error:
 
 }
 
-static int client_initialize_events(sd_dhcp_client *client,
-                                    sd_event_io_handler_t io_callback) {
-        client_initialize_io_events(client, io_callback);
-        client_initialize_time_events(client);
-
-        return 0;
-}
-
 static int client_start(sd_dhcp_client *client) {
         int r;
 
@@ -994,25 +1007,32 @@ static int client_start(sd_dhcp_client *client) {
         assert_return(client->event, -EINVAL);
         assert_return(client->index > 0, -EINVAL);
         assert_return(client->fd < 0, -EBUSY);
+        assert_return(!client->raw_listener, -EBUSY);
         assert_return(client->xid == 0, -EINVAL);
         assert_return(client->state == DHCP_STATE_INIT ||
                       client->state == DHCP_STATE_INIT_REBOOT, -EBUSY);
 
-        client->xid = random_u32();
-
-        r = dhcp_network_bind_raw_socket(client->index, &client->link,
-                                         client->xid, client->mac_addr,
-                                         client->mac_addr_len, client->arp_type);
+        do {
+                client->xid = random_u32();
+
+                r = dhcp_network_raw_listener_new(client->event, client->index,
+                                                  &client->link, client->xid,
+                                                  client->mac_addr,
+                                                  client->mac_addr_len,
+                                                  client->arp_type,
+                                                  client_receive_message_raw,
+                                                  client, &client->raw_listener);
+        } while (r == -EEXIST);
         if (r < 0) {
                 client_stop(client, r);
                 return r;
         }
-        client->fd = r;
 
         if (client->state == DHCP_STATE_INIT || client->state == DHCP_STATE_INIT_REBOOT)
                 client->start_time = now(clock_boottime_or_monotonic());
 
-        return client_initialize_events(client, client_receive_message_raw);
+        /* replies arrive through the shared raw socket */
+        return client_initialize_time_events(client);
 }
 
 static int client_timeout_expire(sd_event_source *s, uint64_t usec,
@@ -1040,20 +1060,24 @@ static int client_timeout_t2(sd_event_source *s, uint64_t usec, void *userdata)
 
         client->receive_message = sd_event_source_unref(client->receive_message);
         client->fd = asynchronous_close(client->fd);
+        client->raw_listener = dhcp_network_raw_listener_free(client->raw_listener);
 
         client->state = DHCP_STATE_REBINDING;
         client->attempt = 1;
 
-        r = dhcp_network_bind_raw_socket(client->index, &client->link,
-                                         client->xid, client->mac_addr,
-                                         client->mac_addr_len, client->arp_type);
+        r = dhcp_network_raw_listener_new(client->event, client->index,
+                                          &client->link, client->xid,
+                                          client->mac_addr,
+                                          client->mac_addr_len,
+                                          client->arp_type,
+                                          client_receive_message_raw,
+                                          client, &client->raw_listener);
         if (r < 0) {
                 client_stop(client, r);
                 return 0;
         }
-        client->fd = r;
 
-        return client_initialize_events(client, client_receive_message_raw);
+        return client_initialize_time_events(client);
 }
 
 static int client_timeout_t1(sd_event_source *s, uint64_t usec,
@@ -1160,6 +1184,11 @@ static int client_handle_ack(sd_dhcp_client *client, DHCPMessage *ack,
                 return -ENOMSG;
         }
 
+        if (client->state == DHCP_STATE_SELECTING && !lease->rapid_commit) {
+                log_dhcp_client(client, "received ACK without rapid commit option, ignoring");
+                return -ENOMSG;
+        }
+
         lease->next_server = ack->siaddr;
 
         lease->address = ack->yiaddr;
@@ -1360,10 +1389,54 @@ static int client_set_lease_timeouts(sd_dhcp_client *client) {
         return 0;
 }
 
+static int client_enter_bound(sd_dhcp_client *client, int ack_event) {
+        int r, notify_event = 0;
+
+        client->timeout_resend =
+                sd_event_source_unref(client->timeout_resend);
+        client->receive_message =
+                sd_event_source_unref(client->receive_message);
+        client->fd = asynchronous_close(client->fd);
+        client->raw_listener = dhcp_network_raw_listener_free(client->raw_listener);
+
+        if (IN_SET(client->state, DHCP_STATE_SELECTING,
+                   DHCP_STATE_REQUESTING, DHCP_STATE_REBOOTING))
+                notify_event = SD_DHCP_CLIENT_EVENT_IP_ACQUIRE;
+        else if (ack_event != SD_DHCP_CLIENT_EVENT_IP_ACQUIRE)
+                notify_event = ack_event;
+
+        client->state = DHCP_STATE_BOUND;
+        client->attempt = 1;
+
+        client->last_addr = client->lease->address;
+
+        r = client_set_lease_timeouts(client);
+        if (r < 0) {
+                log_dhcp_client(client, "could not set lease timeouts");
+                return r;
+        }
+
+        r = dhcp_network_bind_udp_socket(client->lease->address,
+                                         DHCP_PORT_CLIENT);
+        if (r < 0) {
+                log_dhcp_client(client, "could not bind UDP socket");
+                return r;
+        }
+
+        client->fd = r;
+
+        client_initialize_io_events(client, client_receive_message_udp);
+
+        if (notify_event)
+                client_notify(client, notify_event);
+
+        return 0;
+}
+
 static int client_handle_message(sd_dhcp_client *client, DHCPMessage *message,
                                  int len) {
         DHCP_CLIENT_DONT_DESTROY(client);
-        int r = 0, notify_event = 0;
+        int r = 0;
 
         assert(client);
         assert(client->event);
@@ -1372,6 +1445,18 @@ static int client_handle_message(sd_dhcp_client *client, DHCPMessage *message,
         switch (client->state) {
         case DHCP_STATE_SELECTING:
 
+                if (client->rapid_commit) {
+                        /* RFC 4039: the server may answer the DISCOVER
+                           with an ACK right away */
+                        r = client_handle_ack(client, message, len);
+                        if (r >= 0) {
+                                r = client_enter_bound(client, r);
+                                if (r < 0)
+                                        goto error;
+                                return 0;
+                        }
+                }
+
                 r = client_handle_offer(client, message, len);
                 if (r >= 0) {
 
@@ -1410,46 +1495,10 @@ static int client_handle_message(sd_dhcp_client *client, DHCPMessage *message,
 
                 r = client_handle_ack(client, message, len);
                 if (r >= 0) {
-                        client->timeout_resend =
-                                sd_event_source_unref(client->timeout_resend);
-                        client->receive_message =
-                                sd_event_source_unref(client->receive_message);
-                        client->fd = asynchronous_close(client->fd);
-
-                        if (IN_SET(client->state, DHCP_STATE_REQUESTING,
-                                   DHCP_STATE_REBOOTING))
-                                notify_event = SD_DHCP_CLIENT_EVENT_IP_ACQUIRE;
-                        else if (r != SD_DHCP_CLIENT_EVENT_IP_ACQUIRE)
-                                notify_event = r;
-
-                        client->state = DHCP_STATE_BOUND;
-                        client->attempt = 1;
-
-                        client->last_addr = client->lease->address;
-
-                        r = client_set_lease_timeouts(client);
-                        if (r < 0) {
-                                log_dhcp_client(client, "could not set lease timeouts");
-                                goto error;
-                        }
-
-                        r = dhcp_network_bind_udp_socket(client->lease->address,
-                                                         DHCP_PORT_CLIENT);
-                        if (r < 0) {
-                                log_dhcp_client(client, "could not bind UDP socket");
+                        r = client_enter_bound(client, r);
+                        if (r < 0)
                                 goto error;
-                        }
-
-                        client->fd = r;
-
-                        client_initialize_io_events(client, client_receive_message_udp);
-
-                        if (notify_event) {
-                                client_notify(client, notify_event);
-                                if (client->state == DHCP_STATE_STOPPED)
-                                        return 0;
-                        }
-
+                        return 0;
                 } else if (r == -EADDRNOTAVAIL) {
                         /* got a NAK, let's restart the client */
                         client->timeout_resend =
@@ -1583,66 +1632,17 @@ static int client_receive_message_udp(sd_event_source *s, int fd,
         return client_handle_message(client, message, len);
 }
 
-static int client_receive_message_raw(sd_event_source *s, int fd,
-                                      uint32_t revents, void *userdata) {
+static int client_receive_message_raw(DHCPRawListener *listener,
+                                      DHCPMessage *message, size_t len,
+                                      void *userdata) {
         sd_dhcp_client *client = userdata;
-        _cleanup_free_ DHCPPacket *packet = NULL;
-        uint8_t cmsgbuf[CMSG_LEN(sizeof(struct tpacket_auxdata))];
-        struct iovec iov = {};
-        struct msghdr msg = {
-                .msg_iov = &iov,
-                .msg_iovlen = 1,
-                .msg_control = cmsgbuf,
-                .msg_controllen = sizeof(cmsgbuf),
-        };
-        struct cmsghdr *cmsg;
-        bool checksum = true;
-        int buflen = 0, len, r;
 
-        assert(s);
+        assert(listener);
         assert(client);
 
-        r = ioctl(fd, FIONREAD, &buflen);
-        if (r < 0)
-                return r;
-
-        if (buflen < 0)
-                /* this can't be right */
-                return -EIO;
-
-        packet = malloc0(buflen);
-        if (!packet)
-                return -ENOMEM;
-
-        iov.iov_base = packet;
-        iov.iov_len = buflen;
-
-        len = recvmsg(fd, &msg, 0);
-        if (len < 0) {
-                log_dhcp_client(client, "could not receive message from raw "
-                                "socket: %m");
-                return 0;
-        } else if ((size_t)len < sizeof(DHCPPacket))
-                return 0;
-
-        CMSG_FOREACH(cmsg, &msg) {
-                if (cmsg->cmsg_level == SOL_PACKET &&
-                    cmsg->cmsg_type == PACKET_AUXDATA &&
-                    cmsg->cmsg_len == CMSG_LEN(sizeof(struct tpacket_auxdata))) {
-                        struct tpacket_auxdata *aux = (struct tpacket_auxdata*)CMSG_DATA(cmsg);
-
-                        checksum = !(aux->tp_status & TP_STATUS_CSUMNOTREADY);
-                        break;
-                }
-        }
-
-        r = dhcp_packet_verify_headers(packet, len, checksum);
-        if (r < 0)
-                return 0;
-
-        len -= DHCP_IP_UDP_SIZE;
-
-        return client_handle_message(client, &packet->dhcp, len);
+        /* the shared socket already matched the transaction id and
+           verified the IP and UDP headers */
+        return client_handle_message(client, message, len);
 }
 
 int sd_dhcp_client_start(sd_dhcp_client *client) {
@@ -472,6 +472,10 @@ int dhcp_lease_parse_options(uint8_t code, uint8_t len, const void *option, void
 
         switch(code) {
 
+        case DHCP_OPTION_RAPID_COMMIT:
+                lease->rapid_commit = true;
+                break;
+
         case DHCP_OPTION_IP_ADDRESS_LEASE_TIME:
                 r = lease_parse_u32(option, len, &lease->lifetime, 1);
                 if (r < 0)
@@ -0,0 +1,277 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* bench-autoconnect.c - Measure autoconnect candidate selection
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+/* Usage: bench-autoconnect [NUM_DEVICES NUM_PROFILES]...
+ *
+ * For each pair of sizes (default 10x100, 100x1000 and 500x5000) creates
+ * that many Ethernet devices on the fake platform and in-memory profiles,
+ * a third of them wired and bound to one of the devices, a third Wi-Fi and
+ * a third bridges, and prints the time per device to find the compatible
+ * profiles the way the policy does when autoconnecting: once checking all
+ * profiles and once only the candidates NMSettings prefilters. The keyfile
+ * plugin reads an empty temporary directory, so the profiles of the system
+ * don't affect the numbers.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <nm-setting-connection.h>
+#include <nm-setting-wireless.h>
+
+#include "nm-default.h"
+#include "NetworkManagerUtils.h"
+#include "nm-config.h"
+#include "nm-bus-manager.h"
+#include "nm-fake-platform.h"
+#include "nm-device-ethernet.h"
+#include "nm-settings.h"
+#include "nm-settings-connection.h"
+
+#include "nm-test-utils.h"
+
+/******************************************************************/
+
+static char *tmpdir;
+static char *keyfile_dir;
+static char *config_file;
+
+static void
+_config_setup (void)
+{
+	char *args[] = {
+		"bench-autoconnect",
+		"--config", NULL,
+		"--config-dir", "/nonexistent",
+		"--system-config-dir", "/nonexistent",
+		"--intern-config", "/dev/null",
+		"--plugins", "keyfile",
+	};
+	char **argv = args;
+	int argc = G_N_ELEMENTS (args);
+	gs_free char *config = NULL;
+	NMConfigCmdLineOptions *cli;
+	GOptionContext *context;
+	GError *error = NULL;
+	gboolean success;
+
+	tmpdir = g_dir_make_tmp ("bench-autoconnect-XXXXXX", &error);
+	g_assert_no_error (error);
+	keyfile_dir = g_build_filename (tmpdir, "system-connections", NULL);
+	g_assert_cmpint (mkdir (keyfile_dir, 0755), ==, 0);
+	config_file = g_build_filename (tmpdir, "NetworkManager.conf", NULL);
+	config = g_strdup_printf ("[keyfile]\npath=%s\n", keyfile_dir);
+	success = g_file_set_contents (config_file, config, -1, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+	args[2] = config_file;
+
+	cli = nm_config_cmd_line_options_new ();
+	context = g_option_context_new (NULL);
+	nm_config_cmd_line_options_add_to_entries (cli, context);
+	success = g_option_context_parse (context, &argc, &argv, NULL);
+	g_assert (success);
+	g_option_context_free (context);
+
+	nm_config_setup (cli, NULL, &error);
+	g_assert_no_error (error);
+	nm_config_cmd_line_options_free (cli);
+}
+
+static void
+_config_cleanup (void)
+{
+	unlink (config_file);
+	rmdir (keyfile_dir);
+	rmdir (tmpdir);
+	g_free (config_file);
+	g_free (keyfile_dir);
+	g_free (tmpdir);
+}
+
+static NMConnection *
+_new_profile (guint i, guint n_devices)
+{
+	NMConnection *connection;
+	NMSettingConnection *s_con;
+	gs_free char *id = NULL;
+	gs_free char *iface = NULL;
+	GBytes *ssid;
+
+	id = g_strdup_printf ("profile-%u", i);
+
+	switch (i % 3) {
+	case 0:
+		connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRED_SETTING_NAME, &s_con);
+		iface = g_strdup_printf ("bench%u", (i / 3) % n_devices);
+		break;
+	case 1:
+		connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRELESS_SETTING_NAME, &s_con);
+		ssid = g_bytes_new (id, strlen (id));
+		g_object_set (nm_connection_get_setting_wireless (connection),
+		              NM_SETTING_WIRELESS_SSID, ssid,
+		              NULL);
+		g_bytes_unref (ssid);
+		break;
+	default:
+		connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_BRIDGE_SETTING_NAME, &s_con);
+		iface = g_strdup_printf ("br%u", i);
+		break;
+	}
+
+	g_object_set (s_con, NM_SETTING_CONNECTION_INTERFACE_NAME, iface, NULL);
+	nmtst_connection_normalize (connection);
+	return connection;
+}
+
+static guint
+_find_compatible (NMDevice *device, NMSettingsConnection *const*connections, guint len)
+{
+	guint i, n = 0;
+
+	for (i = 0; i < len; i++) {
+		if (nm_device_check_connection_compatible (device, (NMConnection *) connections[i]))
+			n++;
+	}
+	return n;
+}
+
+static void
+bench_autoconnect (NMSettings *settings, guint n_devices, guint n_profiles)
+{
+	gs_unref_ptrarray GPtrArray *devices = NULL;
+	gs_unref_ptrarray GPtrArray *profiles = NULL;
+	gs_free guint *n_compatible = NULL;
+	NMSettingsConnection *const*connections;
+	NMTstBench b;
+	guint i, len, n_candidates = 0;
+
+	devices = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; i < n_devices; i++) {
+		gs_free char *iface = g_strdup_printf ("bench%u", i);
+
+		g_ptr_array_add (devices, g_object_new (NM_TYPE_DEVICE_ETHERNET,
+		                                        NM_DEVICE_IFACE, iface,
+		                                        NM_DEVICE_TYPE_DESC, "Ethernet",
+		                                        NM_DEVICE_DEVICE_TYPE, NM_DEVICE_TYPE_ETHERNET,
+		                                        NULL));
+	}
+
+	for (i = 0; i < n_profiles; i++) {
+		gs_unref_object NMConnection *connection = _new_profile (i, n_devices);
+		GError *error = NULL;
+
+		nm_settings_add_connection (settings, connection, FALSE, &error);
+		g_assert_no_error (error);
+	}
+
+	n_compatible = g_new0 (guint, n_devices);
+
+	nmtst_bench_start (&b, "all profiles", n_devices, "device");
+	for (i = 0; i < n_devices; i++) {
+		connections = nm_settings_get_connections_sorted (settings, &len);
+		n_compatible[i] = _find_compatible (devices->pdata[i], connections, len);
+	}
+	nmtst_bench_stop (&b);
+
+	nmtst_bench_start (&b, "prefiltered candidates", n_devices, "device");
+	for (i = 0; i < n_devices; i++) {
+		gs_unref_ptrarray GPtrArray *candidates = NULL;
+
+		candidates = nm_settings_get_autoconnect_candidates (settings, devices->pdata[i]);
+		n_candidates += candidates->len;
+		g_assert_cmpint (_find_compatible (devices->pdata[i],
+		                                   (NMSettingsConnection *const*) candidates->pdata,
+		                                   candidates->len),
+		                 ==, n_compatible[i]);
+	}
+	nmtst_bench_stop (&b);
+	nmtst_bench_print ("candidates per device", (double) n_candidates / n_devices, NULL);
+
+	/* remove the profiles again for the next run */
+	connections = nm_settings_get_connections_sorted (settings, &len);
+	profiles = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; i < len; i++) {
+		if (g_str_has_prefix (nm_settings_connection_get_id (connections[i]), "profile-"))
+			g_ptr_array_add (profiles, g_object_ref (connections[i]));
+	}
+	for (i = 0; i < profiles->len; i++)
+		nm_settings_connection_signal_remove (profiles->pdata[i]);
+}
+
+/******************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	static const guint default_sizes[] = { 10, 100, 100, 1000, 500, 5000 };
+	gs_free guint *sizes = NULL;
+	NMSettings *settings;
+	GError *error = NULL;
+	guint n_sizes, i;
+
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	if (argc > 1) {
+		if ((argc - 1) % 2) {
+			g_printerr ("expected pairs of NUM_DEVICES NUM_PROFILES\n");
+			return 1;
+		}
+		n_sizes = argc - 1;
+		sizes = g_new (guint, n_sizes);
+		for (i = 0; i < n_sizes; i++) {
+			sizes[i] = _nm_utils_ascii_str_to_int64 (argv[i + 1], 10, 1, G_MAXINT32, 0);
+			if (!sizes[i]) {
+				g_printerr ("invalid size '%s'\n", argv[i + 1]);
+				return 1;
+			}
+		}
+	} else {
+		n_sizes = G_N_ELEMENTS (default_sizes);
+		sizes = g_memdup (default_sizes, sizeof (default_sizes));
+	}
+
+	/* Don't connect to the bus; NMSettings only needs the singleton */
+	nm_bus_manager_setup (g_object_new (NM_TYPE_BUS_MANAGER, NULL));
+	nm_fake_platform_setup ();
+	_config_setup ();
+
+	/* nm_settings_start() releases @settings on failure */
+	settings = nm_settings_new ();
+	if (!nm_settings_start (settings, &error)) {
+		g_printerr ("failed to start settings: %s\n", error->message);
+		_config_cleanup ();
+		return 77;
+	}
+
+	for (i = 0; i < n_sizes; i += 2) {
+		g_print ("%u devices, %u profiles:\n", sizes[i], sizes[i + 1]);
+		bench_autoconnect (settings, sizes[i], sizes[i + 1]);
+	}
+
+	g_object_unref (settings);
+	_config_cleanup ();
+	return 0;
+}
@@ -0,0 +1,200 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include "nm-default-route-manager.c"
+
+#include "nm-fake-platform.h"
+
+#include "nm-test-utils.h"
+
+/*****************************************************************************/
+
+static void
+_entry_randomize (Entry *entry)
+{
+	entry->route.rx.metric = nmtst_get_rand_int () % 5;
+	entry->never_default = nmtst_get_rand_int () % 4 == 0;
+	entry->synced = nmtst_get_rand_int () % 2;
+}
+
+static void
+test_reposition (void)
+{
+	guint run, i;
+
+	for (run = 0; run < 500; run++) {
+		gs_unref_ptrarray GPtrArray *entries = NULL;
+		gs_unref_ptrarray GPtrArray *expected = NULL;
+		guint n = nmtst_get_rand_int () % 20 + 1;
+		guint idx;
+
+		entries = g_ptr_array_new_with_free_func (g_free);
+		for (i = 0; i < n; i++) {
+			Entry *entry = g_new0 (Entry, 1);
+
+			_entry_randomize (entry);
+			g_ptr_array_add (entries, entry);
+		}
+		g_ptr_array_sort_with_data (entries, _sort_entries_cmp, NULL);
+
+		idx = nmtst_get_rand_int () % n;
+		_entry_randomize (entries->pdata[idx]);
+
+		/* the expected result is a stable re-sort of the whole list */
+		expected = g_ptr_array_sized_new (n);
+		for (i = 0; i < n; i++)
+			g_ptr_array_add (expected, entries->pdata[i]);
+		g_ptr_array_sort_with_data (expected, _sort_entries_cmp, NULL);
+
+		_entries_reposition (entries, idx);
+
+		g_assert_cmpint (entries->len, ==, n);
+		for (i = 0; i < n; i++)
+			g_assert (entries->pdata[i] == expected->pdata[i]);
+	}
+}
+
+/*****************************************************************************/
+
+static int
+_link_add (const char *name)
+{
+	NMPlatformLink link;
+
+	g_assert_cmpint (nm_platform_dummy_add (NM_PLATFORM_GET, name, &link), ==, NM_PLATFORM_ERROR_SUCCESS);
+	g_assert_cmpint (link.ifindex, >, 0);
+	return link.ifindex;
+}
+
+static Entry *
+_entry_add (NMDefaultRouteManager *self, int ifindex, guint32 metric)
+{
+	GPtrArray *entries = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self)->entries_ip4;
+	Entry *entry;
+
+	entry = g_slice_new0 (Entry);
+	entry->source.object = g_object_new (G_TYPE_OBJECT, NULL);
+	entry->route.rx.ifindex = ifindex;
+	entry->route.rx.source = NM_IP_CONFIG_SOURCE_USER;
+	entry->route.rx.metric = metric;
+	entry->synced = TRUE;
+
+	g_ptr_array_add (entries, entry);
+	_entry_at_idx_update (&vtable_ip4, self, entries->len - 1, NULL);
+	return entry;
+}
+
+static void
+_entry_set_metric (NMDefaultRouteManager *self, Entry *entry, guint32 metric)
+{
+	GPtrArray *entries = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self)->entries_ip4;
+	Entry old_entry;
+	guint idx;
+
+	g_assert (_entry_find_by_source (entries, entry->source.pointer, &idx) == entry);
+
+	old_entry = *entry;
+	entry->route.rx.metric = metric;
+	_entry_at_idx_update (&vtable_ip4, self, idx, &old_entry);
+}
+
+/* checks the order of the entries, their effective metrics and that the
+ * platform has exactly these default routes. */
+static void
+_assert_entries (NMDefaultRouteManager *self, guint n, ...)
+{
+	GPtrArray *entries = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self)->entries_ip4;
+	gs_unref_array GArray *routes = NULL;
+	va_list ap;
+	guint i;
+
+	routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+	g_assert_cmpint (routes->len, ==, n);
+	g_assert_cmpint (entries->len, ==, n);
+
+	va_start (ap, n);
+	for (i = 0; i < n; i++) {
+		Entry *entry = va_arg (ap, Entry *);
+		guint32 effective_metric = va_arg (ap, guint32);
+
+		g_assert (entries->pdata[i] == entry);
+		g_assert_cmpint (entry->effective_metric, ==, effective_metric);
+		g_assert (nm_platform_ip4_route_get (NM_PLATFORM_GET, entry->route.rx.ifindex, 0, 0, effective_metric));
+	}
+	va_end (ap);
+}
+
+static void
+test_resync (void)
+{
+	gs_unref_object NMDefaultRouteManager *self = NULL;
+	Entry *e0, *e1, *e2;
+	int ifindex0, ifindex1, ifindex2;
+
+	ifindex0 = _link_add ("nm-test-dev0");
+	ifindex1 = _link_add ("nm-test-dev1");
+	ifindex2 = _link_add ("nm-test-dev2");
+
+	self = g_object_new (NM_TYPE_DEFAULT_ROUTE_MANAGER, NULL);
+
+	/* entries with equal metrics keep the order in which they were added
+	 * and get increasing effective metrics. */
+	e0 = _entry_add (self, ifindex0, 100);
+	e1 = _entry_add (self, ifindex1, 100);
+	e2 = _entry_add (self, ifindex2, 100);
+	_assert_entries (self, 3, e0, 100, e1, 101, e2, 102);
+
+	_entry_set_metric (self, e1, 50);
+	_assert_entries (self, 3, e1, 50, e0, 100, e2, 101);
+
+	_entry_set_metric (self, e1, 200);
+	_assert_entries (self, 3, e0, 100, e2, 101, e1, 200);
+
+	/* moving back to the same metric puts the entry behind its equals. */
+	_entry_set_metric (self, e1, 100);
+	_assert_entries (self, 3, e0, 100, e2, 101, e1, 102);
+
+	_entry_set_metric (self, e0, 101);
+	_assert_entries (self, 3, e2, 100, e1, 101, e0, 102);
+
+	_entry_at_idx_remove (&vtable_ip4, self, 1);
+	_assert_entries (self, 2, e2, 100, e0, 101);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	/* _LOG2D() expects devices or VPN connections as sources, which the
+	 * entries here don't have. Don't log debug messages. */
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	nm_fake_platform_setup ();
+
+	g_test_add_func ("/default-route-manager/reposition", test_reposition);
+	g_test_add_func ("/default-route-manager/resync", test_resync);
+
+	return g_test_run ();
+}
@@ -855,6 +855,176 @@ test_nm_multi_index (void)
 
 /*******************************************/
 
+/* Ids whose hash only depends on @key modulo _mik_hash_mod, to force
+ * collisions in the open addressing table. */
+typedef struct {
+	union {
+		NMMultiIndexId id_base;
+		guint key;
+	};
+} NMMultiIndexIdKey;
+
+#define MIK_NUM_KEYS   40
+#define MIK_NUM_VALUES 100
+
+static guint _mik_hash_mod;
+
+static guint
+_mik_hash (const NMMultiIndexIdKey *id)
+{
+	return id->key % _mik_hash_mod;
+}
+
+static gboolean
+_mik_equal (const NMMultiIndexIdKey *a, const NMMultiIndexIdKey *b)
+{
+	return a->key == b->key;
+}
+
+static NMMultiIndexIdKey *
+_mik_clone (const NMMultiIndexIdKey *id)
+{
+	return g_memdup (id, sizeof (*id));
+}
+
+static void
+_mik_destroy (NMMultiIndexIdKey *id)
+{
+	g_free (id);
+}
+
+/* Compares @index with @present, which tells for each key and value
+ * whether the index should contain it. */
+static void
+_mik_check (const NMMultiIndex *index, gboolean present[MIK_NUM_KEYS][MIK_NUM_VALUES])
+{
+	NMMultiIndexIdKey id;
+	void *const*values;
+	guint key, v, len, n, n_groups = 0;
+
+	for (key = 0; key < MIK_NUM_KEYS; key++) {
+		id.key = key;
+		values = nm_multi_index_lookup (index, &id.id_base, &len);
+
+		n = 0;
+		for (v = 0; v < MIK_NUM_VALUES; v++) {
+			if (present[key][v])
+				n++;
+			g_assert_cmpint (nm_multi_index_contains (index, &id.id_base, GUINT_TO_POINTER (v + 1)), ==, present[key][v]);
+		}
+		g_assert_cmpint (len, ==, n);
+		if (!n) {
+			g_assert (!values);
+			continue;
+		}
+
+		n_groups++;
+		g_assert (values[len] == NULL);
+		for (v = 0; v < len; v++) {
+			guint value = GPOINTER_TO_UINT (values[v]);
+
+			g_assert (value >= 1 && value <= MIK_NUM_VALUES);
+			g_assert (present[key][value - 1]);
+		}
+	}
+	g_assert_cmpint (nm_multi_index_get_num_groups (index), ==, n_groups);
+}
+
+static void
+_mik_set (NMMultiIndex *index, gboolean present[MIK_NUM_KEYS][MIK_NUM_VALUES], guint key, guint v, gboolean add)
+{
+	NMMultiIndexIdKey id;
+
+	id.key = key;
+	if (add)
+		g_assert_cmpint (nm_multi_index_add (index, &id.id_base, GUINT_TO_POINTER (v + 1)), ==, !present[key][v]);
+	else
+		g_assert_cmpint (nm_multi_index_remove (index, &id.id_base, GUINT_TO_POINTER (v + 1)), ==, present[key][v]);
+	present[key][v] = add;
+}
+
+static void
+_mik_test_run (guint hash_mod)
+{
+	NMMultiIndex *index;
+	gboolean present[MIK_NUM_KEYS][MIK_NUM_VALUES] = { { 0 } };
+	GRand *rand = nmtst_get_rand ();
+	guint key, v, i;
+
+	_mik_hash_mod = hash_mod;
+	index = nm_multi_index_new ((NMMultiIndexFuncHash) _mik_hash,
+	                            (NMMultiIndexFuncEqual) _mik_equal,
+	                            (NMMultiIndexFuncClone) _mik_clone,
+	                            (NMMultiIndexFuncDestroy) _mik_destroy);
+
+	/* one value per key, the table grows several times */
+	for (key = 0; key < MIK_NUM_KEYS; key++) {
+		_mik_set (index, present, key, key, TRUE);
+		_mik_check (index, present);
+	}
+
+	/* removing the last value of a key drops its group. The other groups
+	 * of the probe sequence must stay reachable. */
+	for (key = 0; key < MIK_NUM_KEYS; key += 3) {
+		_mik_set (index, present, key, key, FALSE);
+		_mik_check (index, present);
+	}
+
+	/* the freed slots are used again */
+	for (key = 0; key < MIK_NUM_KEYS; key += 3) {
+		_mik_set (index, present, key, key + 1, TRUE);
+		_mik_check (index, present);
+	}
+
+	/* a group large enough to get a position table, emptied in random
+	 * order. This moves the last value into the gap every time. */
+	for (v = 0; v < MIK_NUM_VALUES; v++)
+		_mik_set (index, present, 5, v, TRUE);
+	_mik_check (index, present);
+	for (i = 0; i < 3 * MIK_NUM_VALUES; i++) {
+		v = g_rand_int_range (rand, 0, MIK_NUM_VALUES);
+		_mik_set (index, present, 5, v, !!g_rand_int_range (rand, 0, 2));
+		_mik_check (index, present);
+	}
+	for (v = 0; v < MIK_NUM_VALUES; v++) {
+		_mik_set (index, present, 5, v, FALSE);
+		_mik_check (index, present);
+	}
+	_mik_set (index, present, 5, 0, TRUE);
+	_mik_check (index, present);
+
+	/* random operations on all keys */
+	for (i = 0; i < 20 * MIK_NUM_KEYS; i++) {
+		key = g_rand_int_range (rand, 0, MIK_NUM_KEYS);
+		v = g_rand_int_range (rand, 0, 20);
+		_mik_set (index, present, key, v, !!g_rand_int_range (rand, 0, 2));
+		_mik_check (index, present);
+	}
+
+	/* emptying the index shrinks the table again */
+	for (key = 0; key < MIK_NUM_KEYS; key++) {
+		for (v = 0; v < MIK_NUM_VALUES; v++) {
+			if (present[key][v])
+				_mik_set (index, present, key, v, FALSE);
+		}
+		_mik_check (index, present);
+	}
+	g_assert_cmpint (nm_multi_index_get_num_groups (index), ==, 0);
+
+	nm_multi_index_free (index);
+}
+
+static void
+test_nm_multi_index_collisions (void)
+{
+	/* all ids collide, some collide, hardly any collide */
+	_mik_test_run (1);
+	_mik_test_run (7);
+	_mik_test_run (G_MAXUINT);
+}
+
+/*******************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -867,6 +1037,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/general/nm_utils_array_remove_at_indexes", test_nm_utils_array_remove_at_indexes);
 	g_test_add_func ("/general/nm_ethernet_address_is_valid", test_nm_ethernet_address_is_valid);
 	g_test_add_func ("/general/nm_multi_index", test_nm_multi_index);
+	g_test_add_func ("/general/nm_multi_index/collisions", test_nm_multi_index_collisions);
 
 	return g_test_run ();
 }
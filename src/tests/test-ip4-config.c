@@ -340,6 +340,214 @@ test_merge_subtract_mss_mtu (void)
 	g_object_unref (cfg3);
 }
 
+static void
+_shared_mutate (NMIP4Config *config, int mutation)
+{
+	gs_unref_object NMIP4Config *other = nm_ip4_config_new (1);
+	NMPlatformIP4Address addr;
+	NMPlatformIP4Route route;
+
+	addr_init (&addr, "192.168.1.10", "1.2.3.4", 24);
+	nm_ip4_config_add_address (other, &addr);
+	route_new (&route, "172.16.0.0", 16, "192.168.1.1");
+	nm_ip4_config_add_route (other, &route);
+
+	addr_init (&addr, "10.99.0.1", NULL, 16);
+	route_new (&route, "10.98.0.0", 16, "10.99.0.254");
+
+	switch (mutation) {
+	case 0:
+		nm_ip4_config_add_address (config, &addr);
+		break;
+	case 1:
+		nm_ip4_config_del_address (config, 0);
+		break;
+	case 2:
+		nm_ip4_config_reset_addresses (config);
+		break;
+	case 3:
+		nm_ip4_config_add_route (config, &route);
+		break;
+	case 4:
+		nm_ip4_config_del_route (config, 0);
+		break;
+	case 5:
+		nm_ip4_config_reset_routes (config);
+		break;
+	case 6:
+		nm_ip4_config_subtract (config, other);
+		break;
+	case 7:
+		nm_ip4_config_intersect (config, other);
+		break;
+	case 8:
+		nm_ip4_config_add_address (other, &addr);
+		nm_ip4_config_add_route (other, &route);
+		nm_ip4_config_merge (config, other, NM_IP_CONFIG_MERGE_DEFAULT);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+}
+
+static void
+test_shared_arrays (void)
+{
+	int mutation, mutate_copy, via_replace;
+
+	/* nm_ip4_config_replace() and merging into an empty config share the
+	 * address and route arrays. Whichever side is modified afterwards must
+	 * diverge from the other one. */
+	for (mutation = 0; mutation < 9; mutation++) {
+		for (mutate_copy = 0; mutate_copy < 2; mutate_copy++) {
+			for (via_replace = 0; via_replace < 2; via_replace++) {
+				gs_unref_object NMIP4Config *orig = build_test_config ();
+				gs_unref_object NMIP4Config *expected = build_test_config ();
+				gs_unref_object NMIP4Config *copy = NULL;
+
+				if (via_replace)
+					copy = nmtst_ip4_config_clone (orig);
+				else {
+					copy = nm_ip4_config_new (1);
+					nm_ip4_config_merge (copy, orig, NM_IP_CONFIG_MERGE_DEFAULT);
+				}
+				g_assert (nm_ip4_config_get_address (copy, 0) == nm_ip4_config_get_address (orig, 0));
+				g_assert (nm_ip4_config_get_route (copy, 0) == nm_ip4_config_get_route (orig, 0));
+
+				_shared_mutate (mutate_copy ? copy : orig, mutation);
+
+				g_assert (!nm_ip4_config_equal (copy, orig));
+				g_assert (nm_ip4_config_equal (mutate_copy ? orig : copy, expected));
+			}
+		}
+	}
+}
+
+static void
+test_replace_shared (void)
+{
+	gs_unref_object NMIP4Config *orig = build_test_config ();
+	gs_unref_object NMIP4Config *copy = nmtst_ip4_config_clone (orig);
+	gboolean relevant_changes;
+
+	/* replacing a config with one that shares its arrays changes nothing */
+	relevant_changes = TRUE;
+	g_assert (!nm_ip4_config_replace (copy, orig, &relevant_changes));
+	g_assert (!relevant_changes);
+	g_assert (nm_ip4_config_get_address (copy, 0) == nm_ip4_config_get_address (orig, 0));
+
+	/* once diverged, replacing is a relevant change again and shares anew */
+	nm_ip4_config_del_address (copy, 0);
+	relevant_changes = FALSE;
+	g_assert (nm_ip4_config_replace (copy, orig, &relevant_changes));
+	g_assert (relevant_changes);
+	g_assert (nm_ip4_config_equal (copy, orig));
+	g_assert (nm_ip4_config_get_address (copy, 0) == nm_ip4_config_get_address (orig, 0));
+	g_assert (nm_ip4_config_get_route (copy, 0) == nm_ip4_config_get_route (orig, 0));
+
+	relevant_changes = TRUE;
+	g_assert (!nm_ip4_config_replace (copy, orig, &relevant_changes));
+	g_assert (!relevant_changes);
+}
+
+/*******************************************/
+
+/* More entries than IDX_MIN_LEN, so that lookups go through the index. */
+#define LARGE_N 40
+
+static void
+_large_add (NMIP4Config *config, guint from, guint to, NMIPConfigSource source)
+{
+	NMPlatformIP4Address addr;
+	NMPlatformIP4Route route;
+	char buf[INET_ADDRSTRLEN];
+	guint i;
+
+	for (i = from; i < to; i++) {
+		addr_init (&addr, nm_sprintf_buf (buf, "10.1.%u.1", i), NULL, 24);
+		addr.source = source;
+		nm_ip4_config_add_address (config, &addr);
+
+		route_new (&route, nm_sprintf_buf (buf, "10.2.%u.0", i), 24, "10.1.0.254");
+		nm_ip4_config_add_route (config, &route);
+	}
+}
+
+static void
+_large_check (NMIP4Config *config, guint from, guint to)
+{
+	char buf[INET_ADDRSTRLEN];
+	guint i, j;
+
+	g_assert_cmpint (nm_ip4_config_get_num_addresses (config), ==, to - from);
+	g_assert_cmpint (nm_ip4_config_get_num_routes (config), ==, to - from);
+
+	/* search linearly, independent of the index */
+	for (i = 0; i < 2 * LARGE_N; i++) {
+		guint32 address = addr_to_num (nm_sprintf_buf (buf, "10.1.%u.1", i));
+		guint32 network = addr_to_num (nm_sprintf_buf (buf, "10.2.%u.0", i));
+		gboolean has_address = FALSE, has_route = FALSE;
+
+		for (j = 0; j < nm_ip4_config_get_num_addresses (config); j++) {
+			if (nm_ip4_config_get_address (config, j)->address == address)
+				has_address = TRUE;
+		}
+		for (j = 0; j < nm_ip4_config_get_num_routes (config); j++) {
+			if (nm_ip4_config_get_route (config, j)->network == network)
+				has_route = TRUE;
+		}
+		g_assert_cmpint (has_address, ==, i >= from && i < to);
+		g_assert_cmpint (has_route, ==, i >= from && i < to);
+	}
+}
+
+static void
+test_large_configs (void)
+{
+	gs_unref_object NMIP4Config *a = nm_ip4_config_new (1);
+	gs_unref_object NMIP4Config *b = nm_ip4_config_new (1);
+	gs_unref_object NMIP4Config *merged = NULL;
+	gs_unref_object NMIP4Config *subtracted = NULL;
+	gs_unref_object NMIP4Config *intersected = NULL;
+	gs_unref_object NMIP4Config *replaced = NULL;
+
+	_large_add (a, 0, LARGE_N, NM_IP_CONFIG_SOURCE_KERNEL);
+	_large_check (a, 0, LARGE_N);
+
+	/* duplicates update the existing entries */
+	_large_add (a, 0, LARGE_N, NM_IP_CONFIG_SOURCE_USER);
+	_large_check (a, 0, LARGE_N);
+	g_assert_cmpint (nm_ip4_config_get_address (a, LARGE_N - 1)->source, ==, NM_IP_CONFIG_SOURCE_USER);
+
+	_large_add (b, LARGE_N / 2, LARGE_N + LARGE_N / 2, NM_IP_CONFIG_SOURCE_KERNEL);
+
+	merged = nmtst_ip4_config_clone (a);
+	nm_ip4_config_merge (merged, b, NM_IP_CONFIG_MERGE_DEFAULT);
+	_large_check (merged, 0, LARGE_N + LARGE_N / 2);
+
+	subtracted = nmtst_ip4_config_clone (a);
+	nm_ip4_config_subtract (subtracted, b);
+	_large_check (subtracted, 0, LARGE_N / 2);
+
+	intersected = nmtst_ip4_config_clone (a);
+	nm_ip4_config_intersect (intersected, b);
+	_large_check (intersected, LARGE_N / 2, LARGE_N);
+
+	/* deleting shifts the entries, the index must not point past them */
+	nm_ip4_config_del_address (a, 0);
+	nm_ip4_config_del_route (a, 0);
+	_large_add (a, 0, LARGE_N, NM_IP_CONFIG_SOURCE_KERNEL);
+	_large_check (a, 0, LARGE_N);
+
+	replaced = nm_ip4_config_new (1);
+	nm_ip4_config_replace (replaced, b, NULL);
+	_large_add (replaced, LARGE_N / 2, LARGE_N + LARGE_N / 2, NM_IP_CONFIG_SOURCE_KERNEL);
+	_large_check (replaced, LARGE_N / 2, LARGE_N + LARGE_N / 2);
+	nm_ip4_config_subtract (replaced, a);
+	_large_check (replaced, LARGE_N, LARGE_N + LARGE_N / 2);
+	_large_check (b, LARGE_N / 2, LARGE_N + LARGE_N / 2);
+}
+
 /*******************************************/
 
 NMTST_DEFINE ();
@@ -354,6 +562,9 @@ main (int argc, char **argv)
 	g_test_add_func ("/ip4-config/add-address-with-source", test_add_address_with_source);
 	g_test_add_func ("/ip4-config/add-route-with-source", test_add_route_with_source);
 	g_test_add_func ("/ip4-config/merge-subtract-mss-mtu", test_merge_subtract_mss_mtu);
+	g_test_add_func ("/ip4-config/shared-arrays", test_shared_arrays);
+	g_test_add_func ("/ip4-config/replace-shared", test_replace_shared);
+	g_test_add_func ("/ip4-config/large-configs", test_large_configs);
 
 	return g_test_run ();
 }
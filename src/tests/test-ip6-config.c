@@ -322,6 +322,233 @@ test_nm_ip6_config_addresses_sort (void)
 
 /*******************************************/
 
+static NMIP6Config *
+build_shared_test_config (void)
+{
+	NMIP6Config *config = build_test_config ();
+
+	/* out of order, so that sorting changes the array */
+	nm_ip6_config_add_address (config, nmtst_platform_ip6_address_full ("fe80::1", NULL, 64, 0, NM_IP_CONFIG_SOURCE_KERNEL, 0, 0, 0, 0));
+	nm_ip6_config_add_address (config, nmtst_platform_ip6_address_full ("2001:abba::1", NULL, 64, 0, NM_IP_CONFIG_SOURCE_USER, 0, 0, 0, 0));
+	return config;
+}
+
+static void
+_shared_mutate (NMIP6Config *config, int mutation)
+{
+	gs_unref_object NMIP6Config *other = nm_ip6_config_new (1);
+
+	nm_ip6_config_add_address (other, nmtst_platform_ip6_address ("abcd:1234:4321::cdde", "1:2:3:4::5", 64));
+	nm_ip6_config_add_route (other, nmtst_platform_ip6_route ("2001:abba::", 16, "2001:abba::2234"));
+
+	switch (mutation) {
+	case 0:
+		nm_ip6_config_add_address (config, nmtst_platform_ip6_address ("2001:beef::1", NULL, 64));
+		break;
+	case 1:
+		nm_ip6_config_del_address (config, 0);
+		break;
+	case 2:
+		nm_ip6_config_reset_addresses (config);
+		break;
+	case 3:
+		g_assert (nm_ip6_config_addresses_sort (config, NM_SETTING_IP6_CONFIG_PRIVACY_DISABLED));
+		break;
+	case 4:
+		nm_ip6_config_add_route (config, nmtst_platform_ip6_route ("2001:beef::", 32, "2001:abba::1"));
+		break;
+	case 5:
+		nm_ip6_config_del_route (config, 0);
+		break;
+	case 6:
+		nm_ip6_config_reset_routes (config);
+		break;
+	case 7:
+		nm_ip6_config_subtract (config, other);
+		break;
+	case 8:
+		nm_ip6_config_intersect (config, other);
+		break;
+	case 9:
+		nm_ip6_config_add_address (other, nmtst_platform_ip6_address ("2001:beef::1", NULL, 64));
+		nm_ip6_config_add_route (other, nmtst_platform_ip6_route ("2001:beef::", 32, "2001:abba::1"));
+		nm_ip6_config_merge (config, other, NM_IP_CONFIG_MERGE_DEFAULT);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+}
+
+static void
+test_shared_arrays (void)
+{
+	int mutation, mutate_copy, via_replace;
+
+	/* nm_ip6_config_replace() and merging into an empty config share the
+	 * address and route arrays. Whichever side is modified afterwards must
+	 * diverge from the other one. */
+	for (mutation = 0; mutation < 10; mutation++) {
+		for (mutate_copy = 0; mutate_copy < 2; mutate_copy++) {
+			for (via_replace = 0; via_replace < 2; via_replace++) {
+				gs_unref_object NMIP6Config *orig = build_shared_test_config ();
+				gs_unref_object NMIP6Config *expected = build_shared_test_config ();
+				gs_unref_object NMIP6Config *copy = NULL;
+
+				if (via_replace)
+					copy = nmtst_ip6_config_clone (orig);
+				else {
+					copy = nm_ip6_config_new (1);
+					nm_ip6_config_merge (copy, orig, NM_IP_CONFIG_MERGE_DEFAULT);
+				}
+				g_assert (nm_ip6_config_get_address (copy, 0) == nm_ip6_config_get_address (orig, 0));
+				g_assert (nm_ip6_config_get_route (copy, 0) == nm_ip6_config_get_route (orig, 0));
+
+				_shared_mutate (mutate_copy ? copy : orig, mutation);
+
+				g_assert (!nm_ip6_config_equal (copy, orig));
+				g_assert (nm_ip6_config_equal (mutate_copy ? orig : copy, expected));
+			}
+		}
+	}
+}
+
+static void
+test_shared_arrays_sort (void)
+{
+	gs_unref_object NMIP6Config *orig = build_shared_test_config ();
+	gs_unref_object NMIP6Config *copy = NULL;
+
+	g_assert (nm_ip6_config_addresses_sort (orig, NM_SETTING_IP6_CONFIG_PRIVACY_DISABLED));
+	copy = nmtst_ip6_config_clone (orig);
+
+	/* sorting in the same order neither changes nor unshares the array */
+	g_assert (!nm_ip6_config_addresses_sort (copy, NM_SETTING_IP6_CONFIG_PRIVACY_DISABLED));
+	g_assert (nm_ip6_config_get_address (copy, 0) == nm_ip6_config_get_address (orig, 0));
+	g_assert (nm_ip6_config_equal (copy, orig));
+}
+
+static void
+test_replace_shared (void)
+{
+	gs_unref_object NMIP6Config *orig = build_shared_test_config ();
+	gs_unref_object NMIP6Config *copy = nmtst_ip6_config_clone (orig);
+	gboolean relevant_changes;
+
+	/* replacing a config with one that shares its arrays changes nothing */
+	relevant_changes = TRUE;
+	g_assert (!nm_ip6_config_replace (copy, orig, &relevant_changes));
+	g_assert (!relevant_changes);
+	g_assert (nm_ip6_config_get_address (copy, 0) == nm_ip6_config_get_address (orig, 0));
+
+	/* once diverged, replacing is a relevant change again and shares anew */
+	nm_ip6_config_del_route (copy, 0);
+	relevant_changes = FALSE;
+	g_assert (nm_ip6_config_replace (copy, orig, &relevant_changes));
+	g_assert (relevant_changes);
+	g_assert (nm_ip6_config_equal (copy, orig));
+	g_assert (nm_ip6_config_get_address (copy, 0) == nm_ip6_config_get_address (orig, 0));
+	g_assert (nm_ip6_config_get_route (copy, 0) == nm_ip6_config_get_route (orig, 0));
+
+	relevant_changes = TRUE;
+	g_assert (!nm_ip6_config_replace (copy, orig, &relevant_changes));
+	g_assert (!relevant_changes);
+}
+
+/*******************************************/
+
+/* More entries than IDX_MIN_LEN, so that lookups go through the index. */
+#define LARGE_N 40
+
+static void
+_large_add (NMIP6Config *config, guint from, guint to, NMIPConfigSource source)
+{
+	char buf[INET6_ADDRSTRLEN];
+	guint i;
+
+	for (i = from; i < to; i++) {
+		nm_ip6_config_add_address (config, nmtst_platform_ip6_address_full (nm_sprintf_buf (buf, "2001:db8:%x::1", i), NULL, 64,
+		                                                                    0, source, 0, 0, 0, 0));
+		nm_ip6_config_add_route (config, nmtst_platform_ip6_route (nm_sprintf_buf (buf, "2001:db8:100:%x::", i), 64, "2001:db8::fe"));
+	}
+}
+
+static void
+_large_check (NMIP6Config *config, guint from, guint to)
+{
+	char buf[INET6_ADDRSTRLEN];
+	guint i, j;
+
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (config), ==, to - from);
+	g_assert_cmpint (nm_ip6_config_get_num_routes (config), ==, to - from);
+
+	/* search linearly, independent of the index */
+	for (i = 0; i < 2 * LARGE_N; i++) {
+		struct in6_addr address = *nmtst_inet6_from_string (nm_sprintf_buf (buf, "2001:db8:%x::1", i));
+		struct in6_addr network = *nmtst_inet6_from_string (nm_sprintf_buf (buf, "2001:db8:100:%x::", i));
+		gboolean has_address = FALSE, has_route = FALSE;
+
+		for (j = 0; j < nm_ip6_config_get_num_addresses (config); j++) {
+			if (IN6_ARE_ADDR_EQUAL (&nm_ip6_config_get_address (config, j)->address, &address))
+				has_address = TRUE;
+		}
+		for (j = 0; j < nm_ip6_config_get_num_routes (config); j++) {
+			if (IN6_ARE_ADDR_EQUAL (&nm_ip6_config_get_route (config, j)->network, &network))
+				has_route = TRUE;
+		}
+		g_assert_cmpint (has_address, ==, i >= from && i < to);
+		g_assert_cmpint (has_route, ==, i >= from && i < to);
+	}
+}
+
+static void
+test_large_configs (void)
+{
+	gs_unref_object NMIP6Config *a = nm_ip6_config_new (1);
+	gs_unref_object NMIP6Config *b = nm_ip6_config_new (1);
+	gs_unref_object NMIP6Config *merged = NULL;
+	gs_unref_object NMIP6Config *subtracted = NULL;
+	gs_unref_object NMIP6Config *intersected = NULL;
+	gs_unref_object NMIP6Config *replaced = NULL;
+
+	_large_add (a, 0, LARGE_N, NM_IP_CONFIG_SOURCE_KERNEL);
+	_large_check (a, 0, LARGE_N);
+
+	/* duplicates update the existing entries */
+	_large_add (a, 0, LARGE_N, NM_IP_CONFIG_SOURCE_USER);
+	_large_check (a, 0, LARGE_N);
+	g_assert_cmpint (nm_ip6_config_get_address (a, LARGE_N - 1)->source, ==, NM_IP_CONFIG_SOURCE_USER);
+
+	_large_add (b, LARGE_N / 2, LARGE_N + LARGE_N / 2, NM_IP_CONFIG_SOURCE_KERNEL);
+
+	merged = nmtst_ip6_config_clone (a);
+	nm_ip6_config_merge (merged, b, NM_IP_CONFIG_MERGE_DEFAULT);
+	_large_check (merged, 0, LARGE_N + LARGE_N / 2);
+
+	subtracted = nmtst_ip6_config_clone (a);
+	nm_ip6_config_subtract (subtracted, b);
+	_large_check (subtracted, 0, LARGE_N / 2);
+
+	intersected = nmtst_ip6_config_clone (a);
+	nm_ip6_config_intersect (intersected, b);
+	_large_check (intersected, LARGE_N / 2, LARGE_N);
+
+	/* deleting shifts the entries, the index must not point past them */
+	nm_ip6_config_del_address (a, 0);
+	nm_ip6_config_del_route (a, 0);
+	_large_add (a, 0, LARGE_N, NM_IP_CONFIG_SOURCE_KERNEL);
+	_large_check (a, 0, LARGE_N);
+
+	replaced = nm_ip6_config_new (1);
+	nm_ip6_config_replace (replaced, b, NULL);
+	_large_add (replaced, LARGE_N / 2, LARGE_N + LARGE_N / 2, NM_IP_CONFIG_SOURCE_KERNEL);
+	_large_check (replaced, LARGE_N / 2, LARGE_N + LARGE_N / 2);
+	nm_ip6_config_subtract (replaced, a);
+	_large_check (replaced, LARGE_N, LARGE_N + LARGE_N / 2);
+	_large_check (b, LARGE_N / 2, LARGE_N + LARGE_N / 2);
+}
+
+/*******************************************/
+
 NMTST_DEFINE();
 
 int
@@ -334,6 +561,10 @@ main (int argc, char **argv)
 	g_test_add_func ("/ip6-config/add-address-with-source", test_add_address_with_source);
 	g_test_add_func ("/ip6-config/add-route-with-source", test_add_route_with_source);
 	g_test_add_func ("/ip6-config/test_nm_ip6_config_addresses_sort", test_nm_ip6_config_addresses_sort);
+	g_test_add_func ("/ip6-config/shared-arrays", test_shared_arrays);
+	g_test_add_func ("/ip6-config/shared-arrays-sort", test_shared_arrays_sort);
+	g_test_add_func ("/ip6-config/replace-shared", test_replace_shared);
+	g_test_add_func ("/ip6-config/large-configs", test_large_configs);
 
 	return g_test_run ();
 }
@@ -863,6 +863,61 @@ test_ip4_full_sync (test_fixture *fixture, gconstpointer user_data)
 	nm_log_dbg (LOGD_CORE, "TEST test_ip4_full_sync(): done");
 }
 
+static void
+test_ip4_resync (test_fixture *fixture, gconstpointer user_data)
+{
+	const NMPlatformVTableRoute *vtable = &nm_platform_vtable_route_v4;
+	gs_unref_array GArray *routes = g_array_new (FALSE, FALSE, sizeof (NMPlatformIP4Route));
+	NMPlatformIP4Route r01, r02, r03;
+
+	nm_log_dbg (LOGD_CORE, "TEST start test_ip4_resync(): start");
+
+	r01 = *nmtst_platform_ip4_route_full ("12.3.4.0", 24, NULL,
+	                                      fixture->ifindex0, NM_IP_CONFIG_SOURCE_USER,
+	                                      100, 0, RT_SCOPE_LINK, NULL);
+	r02 = *nmtst_platform_ip4_route_full ("13.4.5.6", 32, "12.3.4.1",
+	                                      fixture->ifindex0, NM_IP_CONFIG_SOURCE_USER,
+	                                      100, 0, RT_SCOPE_UNIVERSE, NULL);
+	r03 = *nmtst_platform_ip4_route_full ("14.5.6.7", 32, "12.3.4.1",
+	                                      fixture->ifindex0, NM_IP_CONFIG_SOURCE_USER,
+	                                      110, 0, RT_SCOPE_UNIVERSE, NULL);
+	g_array_set_size (routes, 2);
+	g_array_index (routes, NMPlatformIP4Route, 0) = r01;
+	g_array_index (routes, NMPlatformIP4Route, 1) = r02;
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes, TRUE, TRUE));
+
+	_assert_route_check (vtable, TRUE,  (const NMPlatformIPXRoute *) &r01);
+	_assert_route_check (vtable, TRUE,  (const NMPlatformIPXRoute *) &r02);
+
+	/* nothing changed. */
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes, TRUE, TRUE));
+
+	_assert_route_check (vtable, TRUE,  (const NMPlatformIPXRoute *) &r01);
+	_assert_route_check (vtable, TRUE,  (const NMPlatformIPXRoute *) &r02);
+
+	/* a route removed outside of route manager is restored by the next sync,
+	 * even if the known routes didn't change. */
+	vtable->route_delete (NM_PLATFORM_GET, fixture->ifindex0, (const NMPlatformIPXRoute *) &r02);
+	_assert_route_check (vtable, FALSE, (const NMPlatformIPXRoute *) &r02);
+
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes, TRUE, TRUE));
+
+	_assert_route_check (vtable, TRUE,  (const NMPlatformIPXRoute *) &r01);
+	_assert_route_check (vtable, TRUE,  (const NMPlatformIPXRoute *) &r02);
+
+	/* likewise, a route added outside of route manager is removed by the next full sync. */
+	vtable->route_add (NM_PLATFORM_GET, 0, (const NMPlatformIPXRoute *) &r03, -1);
+	_assert_route_check (vtable, TRUE,  (const NMPlatformIPXRoute *) &r03);
+
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes, TRUE, TRUE));
+
+	_assert_route_check (vtable, TRUE,  (const NMPlatformIPXRoute *) &r01);
+	_assert_route_check (vtable, TRUE,  (const NMPlatformIPXRoute *) &r02);
+	_assert_route_check (vtable, FALSE, (const NMPlatformIPXRoute *) &r03);
+
+	nm_log_dbg (LOGD_CORE, "TEST test_ip4_resync(): done");
+}
+
 /*****************************************************************************/
 
 static void
@@ -917,4 +972,5 @@ setup_tests (void)
 	g_test_add ("/route-manager/ip6", test_fixture, NULL, fixture_setup, test_ip6, fixture_teardown);
 
 	g_test_add ("/route-manager/ip4-full-sync", test_fixture, NULL, fixture_setup, test_ip4_full_sync, fixture_teardown);
+	g_test_add ("/route-manager/ip4-resync", test_fixture, NULL, fixture_setup, test_ip4_resync, fixture_teardown);
 }
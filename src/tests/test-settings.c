@@ -0,0 +1,423 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <nm-setting-connection.h>
+#include <nm-setting-wired.h>
+#include <nm-setting-wireless.h>
+
+#include "nm-default.h"
+#include "nm-config.h"
+#include "nm-bus-manager.h"
+#include "nm-fake-platform.h"
+#include "nm-settings.h"
+#include "nm-settings-connection.h"
+#include "nm-device-ethernet.h"
+
+#include "nm-test-utils.h"
+
+static NMSettings *settings;
+
+/* the connections added by the tests, to compare the indexes with */
+static GPtrArray *expected;
+
+static const char *const ifaces[] = { "eth0", "eth1", "eth2", NULL };
+static const char *const types[] = { NM_SETTING_WIRED_SETTING_NAME, NM_SETTING_WIRELESS_SETTING_NAME };
+
+/*******************************************/
+
+static NMSettingConnection *
+_s_con (NMSettingsConnection *connection)
+{
+	return nm_connection_get_setting_connection (NM_CONNECTION (connection));
+}
+
+/* The autoconnect order, computed from the connections as they are now */
+static int
+_cmp_autoconnect_order (NMSettingsConnection *a, NMSettingsConnection *b)
+{
+	gboolean ac_a = nm_setting_connection_get_autoconnect (_s_con (a));
+	gboolean ac_b = nm_setting_connection_get_autoconnect (_s_con (b));
+	guint64 ts_a = 0, ts_b = 0;
+	int prio_a, prio_b;
+
+	if (ac_a != ac_b)
+		return ac_a ? -1 : 1;
+	if (ac_a) {
+		prio_a = nm_setting_connection_get_autoconnect_priority (_s_con (a));
+		prio_b = nm_setting_connection_get_autoconnect_priority (_s_con (b));
+		if (prio_a != prio_b)
+			return prio_a > prio_b ? -1 : 1;
+	}
+	nm_settings_connection_get_timestamp (a, &ts_a);
+	nm_settings_connection_get_timestamp (b, &ts_b);
+	if (ts_a != ts_b)
+		return ts_a > ts_b ? -1 : 1;
+	return 0;
+}
+
+/* Checks that @list holds exactly the connections of @expected that
+ * @filter accepts, in autoconnect order. */
+static void
+_check_list (GSList *list, gboolean (*filter) (NMSettingsConnection *, const char *), const char *arg)
+{
+	GSList *iter;
+	guint i, n = 0;
+
+	for (i = 0; i < expected->len; i++) {
+		if (filter (expected->pdata[i], arg)) {
+			g_assert (g_slist_find (list, expected->pdata[i]));
+			n++;
+		}
+	}
+	g_assert_cmpint (g_slist_length (list), ==, n);
+
+	for (iter = list; iter && iter->next; iter = iter->next)
+		g_assert_cmpint (_cmp_autoconnect_order (iter->data, iter->next->data), <=, 0);
+}
+
+static gboolean
+_filter_all (NMSettingsConnection *connection, const char *arg)
+{
+	return TRUE;
+}
+
+static gboolean
+_filter_iface (NMSettingsConnection *connection, const char *iface)
+{
+	return !g_strcmp0 (nm_connection_get_interface_name (NM_CONNECTION (connection)), iface);
+}
+
+static gboolean
+_filter_type (NMSettingsConnection *connection, const char *type)
+{
+	return !g_strcmp0 (nm_connection_get_connection_type (NM_CONNECTION (connection)), type);
+}
+
+static void
+_check_indexes (void)
+{
+	NMSettingsConnection *const*sorted;
+	GSList *list;
+	guint i, len;
+
+	sorted = nm_settings_get_connections_sorted (settings, &len);
+	g_assert_cmpint (len, ==, expected->len);
+	for (i = 0; i + 1 < len; i++)
+		g_assert_cmpint (_cmp_autoconnect_order (sorted[i], sorted[i + 1]), <=, 0);
+
+	list = nm_settings_get_connections (settings);
+	_check_list (list, _filter_all, NULL);
+	for (i = 0; i < len; i++)
+		g_assert (g_slist_nth_data (list, i) == sorted[i]);
+	g_slist_free (list);
+
+	for (i = 0; i < expected->len; i++) {
+		NMSettingsConnection *connection = expected->pdata[i];
+
+		g_assert (nm_settings_has_connection (settings, connection));
+		g_assert (nm_settings_get_connection_by_uuid (settings, nm_settings_connection_get_uuid (connection)) == connection);
+	}
+
+	for (i = 0; ifaces[i]; i++) {
+		list = nm_settings_get_connections_by_iface (settings, ifaces[i]);
+		_check_list (list, _filter_iface, ifaces[i]);
+		g_slist_free (list);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (types); i++) {
+		list = nm_settings_get_connections_by_type (settings, types[i]);
+		_check_list (list, _filter_type, types[i]);
+		g_slist_free (list);
+	}
+}
+
+/*******************************************/
+
+static NMSettingsConnection *
+_add_connection (guint i)
+{
+	gs_unref_object NMConnection *connection = NULL;
+	NMSettingsConnection *added;
+	NMSettingConnection *s_con;
+	gs_free char *id = NULL;
+	GError *error = NULL;
+	GBytes *ssid;
+
+	id = g_strdup_printf ("test-settings-%u", i);
+	connection = nmtst_create_minimal_connection (id, NULL, types[i % G_N_ELEMENTS (types)], &s_con);
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_INTERFACE_NAME, ifaces[i % G_N_ELEMENTS (ifaces)],
+	              NM_SETTING_CONNECTION_AUTOCONNECT, (i % 5) != 0,
+	              NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, (int) (i % 7) - 3,
+	              NULL);
+	if (nm_connection_get_setting_wireless (connection)) {
+		ssid = g_bytes_new (id, strlen (id));
+		g_object_set (nm_connection_get_setting_wireless (connection),
+		              NM_SETTING_WIRELESS_SSID, ssid,
+		              NULL);
+		g_bytes_unref (ssid);
+	}
+	nmtst_connection_normalize (connection);
+
+	added = nm_settings_add_connection (settings, connection, FALSE, &error);
+	g_assert_no_error (error);
+	g_assert (added);
+
+	nm_settings_connection_update_timestamp (added, 1000 + (i % 4), FALSE);
+	g_ptr_array_add (expected, added);
+	return added;
+}
+
+static void
+_remove_connection (guint i)
+{
+	NMSettingsConnection *connection = expected->pdata[i];
+	gs_free char *uuid = g_strdup (nm_settings_connection_get_uuid (connection));
+
+	g_ptr_array_remove_index (expected, i);
+	nm_settings_connection_signal_remove (connection);
+
+	g_assert (!nm_settings_get_connection_by_uuid (settings, uuid));
+}
+
+static void
+test_index_and_order (void)
+{
+	NMSettingsConnection *connection;
+	guint i;
+
+	expected = g_ptr_array_new ();
+
+	for (i = 0; i < 30; i++)
+		_add_connection (i);
+	_check_indexes ();
+
+	for (i = 0; i < expected->len; i += 3) {
+		connection = expected->pdata[i];
+		g_object_set (_s_con (connection),
+		              NM_SETTING_CONNECTION_AUTOCONNECT,
+		              !nm_setting_connection_get_autoconnect (_s_con (connection)),
+		              NULL);
+		_check_indexes ();
+	}
+
+	for (i = 1; i < expected->len; i += 3) {
+		connection = expected->pdata[i];
+		g_object_set (_s_con (connection),
+		              NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, (int) (i % 11) - 5,
+		              NULL);
+		_check_indexes ();
+	}
+
+	for (i = 2; i < expected->len; i += 3) {
+		nm_settings_connection_update_timestamp (expected->pdata[i], 2000 + i, FALSE);
+		_check_indexes ();
+	}
+
+	for (i = 0; i < expected->len; i += 4) {
+		connection = expected->pdata[i];
+		g_object_set (_s_con (connection),
+		              NM_SETTING_CONNECTION_INTERFACE_NAME, ifaces[(i + 1) % G_N_ELEMENTS (ifaces)],
+		              NULL);
+		_check_indexes ();
+	}
+
+	/* connections that compare equal in the sort order */
+	for (i = 0; i < 6; i++) {
+		connection = _add_connection (100);
+		nm_settings_connection_update_timestamp (connection, 5000, FALSE);
+	}
+	_check_indexes ();
+
+	while (expected->len) {
+		_remove_connection (expected->len / 2);
+		_check_indexes ();
+	}
+
+	g_ptr_array_unref (expected);
+}
+
+/*******************************************/
+
+static NMSettingsConnection *
+_add_wired (const char *id, const char *mac, const char *const *subchannels)
+{
+	gs_unref_object NMConnection *connection = NULL;
+	NMSettingsConnection *added;
+	GError *error = NULL;
+
+	connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+	g_object_set (nm_connection_get_setting_wired (connection),
+	              NM_SETTING_WIRED_MAC_ADDRESS, mac,
+	              NM_SETTING_WIRED_S390_SUBCHANNELS, subchannels,
+	              NULL);
+	nmtst_connection_normalize (connection);
+
+	added = nm_settings_add_connection (settings, connection, FALSE, &error);
+	g_assert_no_error (error);
+	g_assert (added);
+	return added;
+}
+
+static gboolean
+_candidates_contain (NMDevice *device, NMSettingsConnection *connection)
+{
+	gs_unref_ptrarray GPtrArray *candidates = NULL;
+	guint i;
+
+	candidates = nm_settings_get_autoconnect_candidates (settings, device);
+	for (i = 0; i < candidates->len; i++) {
+		if (candidates->pdata[i] == connection)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+test_candidates_hw_address (void)
+{
+	static const guint8 mac[ETH_ALEN] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+	static const char *const subchannels[] = { "0.0.8000", "0.0.8001", "0.0.8002", NULL };
+	gs_unref_object NMDevice *device = NULL;
+	NMSettingsConnection *same_mac, *other_mac, *s390;
+	NMPlatformLink plink;
+	GError *error = NULL;
+
+	g_assert_cmpint (nm_platform_bridge_add (NM_PLATFORM_GET, "eth9", mac, sizeof (mac), &plink), ==, NM_PLATFORM_ERROR_SUCCESS);
+	device = g_object_new (NM_TYPE_DEVICE_ETHERNET,
+	                       NM_DEVICE_IFACE, "eth9",
+	                       NM_DEVICE_TYPE_DESC, "Ethernet",
+	                       NM_DEVICE_DEVICE_TYPE, NM_DEVICE_TYPE_ETHERNET,
+	                       NULL);
+	g_assert (nm_device_realize (device, &plink, &error));
+	g_assert_no_error (error);
+	g_assert (nm_utils_hwaddr_matches (nm_device_get_compatible_hw_address (device), -1, mac, sizeof (mac)));
+
+	same_mac = _add_wired ("test-settings-same-mac", "00:11:22:33:44:55", NULL);
+	other_mac = _add_wired ("test-settings-other-mac", "00:11:22:33:44:66", NULL);
+
+	/* s390 devices are matched by their subchannels and not by the MAC
+	 * address, so the prefilter can't drop such a connection. */
+	s390 = _add_wired ("test-settings-s390", "00:11:22:33:44:66", subchannels);
+
+	g_assert (_candidates_contain (device, same_mac));
+	g_assert (!_candidates_contain (device, other_mac));
+	g_assert (_candidates_contain (device, s390));
+
+	g_assert (nm_device_check_connection_compatible (device, NM_CONNECTION (same_mac)));
+	g_assert (!nm_device_check_connection_compatible (device, NM_CONNECTION (other_mac)));
+
+	nm_settings_connection_signal_remove (same_mac);
+	nm_settings_connection_signal_remove (other_mac);
+	nm_settings_connection_signal_remove (s390);
+	nm_platform_link_delete (NM_PLATFORM_GET, plink.ifindex);
+}
+
+/*******************************************/
+
+static char *tmpdir;
+static char *keyfile_dir;
+static char *config_file;
+
+static void
+_config_setup (void)
+{
+	char *args[] = {
+		"test-settings",
+		"--config", NULL,
+		"--config-dir", "/nonexistent",
+		"--system-config-dir", "/nonexistent",
+		"--intern-config", "/dev/null",
+		"--plugins", "keyfile",
+	};
+	char **argv = args;
+	int argc = G_N_ELEMENTS (args);
+	gs_free char *config = NULL;
+	NMConfigCmdLineOptions *cli;
+	GOptionContext *context;
+	GError *error = NULL;
+	gboolean success;
+
+	/* keep the keyfile plugin away from the system connections */
+	tmpdir = g_dir_make_tmp ("test-settings-XXXXXX", &error);
+	g_assert_no_error (error);
+	keyfile_dir = g_build_filename (tmpdir, "system-connections", NULL);
+	g_assert_cmpint (mkdir (keyfile_dir, 0755), ==, 0);
+	config_file = g_build_filename (tmpdir, "NetworkManager.conf", NULL);
+	config = g_strdup_printf ("[keyfile]\npath=%s\n", keyfile_dir);
+	success = g_file_set_contents (config_file, config, -1, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+	args[2] = config_file;
+
+	cli = nm_config_cmd_line_options_new ();
+	context = g_option_context_new (NULL);
+	nm_config_cmd_line_options_add_to_entries (cli, context);
+	success = g_option_context_parse (context, &argc, &argv, NULL);
+	g_assert (success);
+	g_option_context_free (context);
+
+	nm_config_setup (cli, NULL, &error);
+	g_assert_no_error (error);
+	nm_config_cmd_line_options_free (cli);
+}
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	GError *error = NULL;
+	int result;
+
+	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
+
+	/* Don't connect to the bus; NMSettings only needs the singleton */
+	nm_bus_manager_setup (g_object_new (NM_TYPE_BUS_MANAGER, NULL));
+	nm_fake_platform_setup ();
+	_config_setup ();
+
+	/* nm_settings_start() releases @settings on failure */
+	settings = nm_settings_new ();
+	if (!nm_settings_start (settings, &error))
+		g_error ("failed to start settings: %s", error->message);
+
+	g_test_add_func ("/settings/index-and-order", test_index_and_order);
+	g_test_add_func ("/settings/candidates-hw-address", test_candidates_hw_address);
+
+	result = g_test_run ();
+
+	g_object_unref (settings);
+
+	unlink (config_file);
+	rmdir (keyfile_dir);
+	rmdir (tmpdir);
+	g_free (config_file);
+	g_free (keyfile_dir);
+	g_free (tmpdir);
+
+	return result;
+}